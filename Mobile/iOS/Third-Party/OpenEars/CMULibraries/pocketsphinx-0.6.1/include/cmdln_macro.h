@@ -127,6 +127,14 @@
       ARG_BOOLEAN,                                                                              \
       "no",                                                                                     \
       "Compute all senone scores in every frame (can be faster when there are many senones)" }, \
+{ "-scorethreads",                                                                              \
+      ARG_INT32,                                                                                \
+      "0",                                                                                      \
+      "Number of extra threads for senone scoring (with -compallsen, also scores ahead)" },     \
+{ "-scorebatch",                                                                                \
+      ARG_INT32,                                                                                \
+      "1",                                                                                      \
+      "Frames to score at once with -compallsen (more latency, less memory traffic)" },         \
 { "-fwdtree",                                                                                   \
       ARG_BOOLEAN,                                                                              \
       "yes",                                                                                    \
@@ -90,6 +90,34 @@ typedef struct ps_seg_s ps_seg_t;
 POCKETSPHINX_EXPORT
 ps_decoder_t *ps_init(cmd_ln_t *config);
 
+/**
+ * Initialize a decoder sharing the models of another one.
+ *
+ * This creates a decoder for another audio stream, using the
+ * acoustic model, dictionary, language models and grammars of
+ * <code>other</code> rather than loading them again.  The two
+ * decoders have their own front end and search, and each can be
+ * used by a different thread at the same time.  The models are freed
+ * along with the last decoder using them.
+ *
+ * Changing a shared model is not safe while any other decoder is
+ * using it, and this includes adding words with ps_add_word().
+ * ps_update_mllr() fails for decoders sharing an acoustic model.
+ * Loading a new dictionary or language model with ps_load_dict() or
+ * ps_update_lmset(), or calling ps_reinit(), only affects the decoder
+ * it is called on.
+ *
+ * The models are reference counted without any locking, so decoders
+ * sharing them must not be created or freed by several threads at
+ * once.
+ *
+ * @param other Decoder whose models will be shared.  It must not be
+ *              decoding anything while this is called.
+ * @return Newly created decoder, or NULL on failure.
+ */
+POCKETSPHINX_EXPORT
+ps_decoder_t *ps_init_shared(ps_decoder_t *other);
+
 /**
  * Reinitialize the decoder with updated configuration.
  *
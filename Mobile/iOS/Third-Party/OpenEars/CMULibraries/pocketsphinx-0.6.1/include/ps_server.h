@@ -0,0 +1,150 @@
+/* -*- c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/* ====================================================================
+ * Copyright (c) 2010 Carnegie Mellon University.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer. 
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This work was supported in part by funding from the Defense Advanced 
+ * Research Projects Agency and the National Science Foundation of the 
+ * United States of America, and the CMU Sphinx Speech Consortium.
+ *
+ * THIS SOFTWARE IS PROVIDED BY CARNEGIE MELLON UNIVERSITY ``AS IS'' AND 
+ * ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL CARNEGIE MELLON UNIVERSITY
+ * NOR ITS EMPLOYEES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ====================================================================
+ *
+ */
+
+/**
+ * @file ps_server.h Decoding many audio streams on a pool of threads
+ */
+
+#ifndef __PS_SERVER_H__
+#define __PS_SERVER_H__
+
+/* SphinxBase headers. */
+#include <cmd_ln.h>
+#include <prim_type.h>
+
+/* PocketSphinx headers. */
+#include <pocketsphinx_export.h>
+#include <pocketsphinx.h>
+
+/**
+ * Decoding server object.
+ *
+ * This loads the models once and decodes any number of audio streams
+ * with them, using a fixed number of threads.  Each stream has a
+ * decoder of its own (see ps_init_shared()), and whenever new audio
+ * arrives for a stream it is decoded by the next free thread.
+ */
+typedef struct ps_server_s ps_server_t;
+
+/**
+ * Audio stream being decoded by a server.
+ */
+typedef struct ps_stream_s ps_stream_t;
+
+/**
+ * Function called when an utterance in a stream has been decoded.
+ *
+ * This is called from one of the server's threads, with the decoder
+ * for the stream, on which ps_get_hyp(), ps_seg_iter() and so on can
+ * be used to get the results.  No other stream can be decoded by
+ * that thread until it returns.
+ */
+typedef void (*ps_stream_cb_t)(ps_stream_t *stream, ps_decoder_t *ps,
+                               void *user_data);
+
+/**
+ * Initialize a decoding server.
+ *
+ * Streams are decoded by the server's threads rather than scoring
+ * each one on several threads, so -scorethreads is set to 0.
+ *
+ * @note The server retains ownership of the pointer
+ * <code>config</code>, so you must not attempt to free it manually.
+ *
+ * @param config Decoder configuration, as for ps_init().
+ * @param n_threads Number of threads to decode streams on.
+ * @return Newly created server, or NULL on failure.
+ */
+POCKETSPHINX_EXPORT
+ps_server_t *ps_server_init(cmd_ln_t *config, int n_threads);
+
+/**
+ * Stop a decoding server and free it.
+ *
+ * Any streams which are still open are closed without finishing
+ * their current utterances.
+ */
+POCKETSPHINX_EXPORT
+void ps_server_free(ps_server_t *server);
+
+/**
+ * Open a new audio stream on a server.
+ *
+ * @param cb Function to call with the results of each utterance.
+ * @param user_data Passed to <code>cb</code>.
+ * @return Newly created stream, or NULL on failure.
+ */
+POCKETSPHINX_EXPORT
+ps_stream_t *ps_stream_open(ps_server_t *server, ps_stream_cb_t cb,
+                            void *user_data);
+
+/**
+ * Queue audio to be decoded in a stream.
+ *
+ * This copies the data and returns immediately, starting a new
+ * utterance if there is none in progress.
+ *
+ * @param data Audio data (16-bit linear PCM, at the sampling rate
+ *             given by -samprate).
+ * @param n_samples Number of samples in <code>data</code>.
+ * @return 0 for success, <0 on error.
+ */
+POCKETSPHINX_EXPORT
+int ps_stream_write(ps_stream_t *stream, int16 const *data, size_t n_samples);
+
+/**
+ * End the current utterance in a stream.
+ *
+ * Once the audio queued before this has been decoded, the stream's
+ * callback is called with the results.
+ *
+ * @return 0 for success, <0 on error.
+ */
+POCKETSPHINX_EXPORT
+int ps_stream_end_utt(ps_stream_t *stream);
+
+/**
+ * Close a stream.
+ *
+ * Audio that was already queued is still decoded (and the callback
+ * called for utterances that were ended) before the stream is freed,
+ * so it should not be used after this.
+ */
+POCKETSPHINX_EXPORT
+void ps_stream_close(ps_stream_t *stream);
+
+#endif /* __PS_SERVER_H__ */
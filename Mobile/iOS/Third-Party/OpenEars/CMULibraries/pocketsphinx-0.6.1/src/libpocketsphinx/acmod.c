@@ -52,6 +52,7 @@
 #include <string.h>
 #include <byteorder.h>
 #include <feat.h>
+#include <sbthread.h>
 
 /* Local headers. */
 #include "cmdln_macro.h"
@@ -73,6 +74,53 @@ static const arg_t feat_defn[] = {
 
 static int32 acmod_flags2list(acmod_t *acmod);
 static int32 acmod_process_mfcbuf(acmod_t *acmod);
+static int acmod_init_buffers(acmod_t *acmod);
+
+/**
+ * Smallest number of senones worth handing to another thread.
+ */
+#define ACMOD_MIN_BLOCK 256
+
+/**
+ * Number of senones scored in every frame of a batch before moving on
+ * to the next ones.  Their mixture weights should stay in cache
+ * between frames.
+ */
+#define ACMOD_BATCH_BLOCK 256
+
+/**
+ * Senone scoring thread.
+ */
+typedef struct acmod_worker_s {
+    acmod_t *acmod;
+    sbthread_t *thread;
+    sbevent_t *start;       /**< Signalled when there is a job to do. */
+    sbevent_t *done;        /**< Signalled when it is done. */
+    int exit;               /**< Exit instead of doing a job. */
+
+    /* The job is either a whole frame, if feat is non-NULL, a block
+     * of senones in every frame of a batch, if batch is non-NULL, or
+     * a block of senones in a frame being scored by another thread. */
+    mfcc_t **feat;          /**< Features for a whole frame. */
+    int16 **batch;          /**< Senone scores for each frame of a batch. */
+    int32 n_frames;         /**< Number of frames in the batch. */
+    int32 *batch_best;      /**< Best score found in each of them. */
+    int16 *senscr;          /**< Senone scores to fill in. */
+    uint8 *senone_active;   /**< Deltas of senones to score. */
+    int32 n_senone_active;  /**< Number of senones to score. */
+    int32 first_sen;        /**< First senone (or base for deltas). */
+    int32 frame;            /**< Frame index. */
+    int32 best;             /**< Best score found. */
+} acmod_worker_t;
+
+/**
+ * Pool of senone scoring threads.
+ */
+typedef struct acmod_pool_s {
+    acmod_worker_t *workers;
+    int n_workers;
+    int ahead;              /**< Is the first worker scoring next_frame? */
+} acmod_pool_t;
 
 static int
 acmod_init_am(acmod_t *acmod)
@@ -221,6 +269,275 @@ acmod_feat_mismatch(acmod_t *acmod, feat_t *fcb)
     return FALSE;
 }
 
+/**
+ * Score a frame, splitting the senones between this thread and the
+ * workers from first_worker on.
+ */
+static void
+acmod_score_split(acmod_t *acmod, int16 *senscr,
+                  uint8 *senone_active, int32 n_senone_active,
+                  mfcc_t **feat, int32 frame, int first_worker)
+{
+    acmod_pool_t *pool = acmod->pool;
+    int32 compallsen = acmod->compallsen;
+    int32 i, j, n_blocks, start, sen, best;
+
+    memset(senscr, 0, bin_mdef_n_sen(acmod->mdef) * sizeof(*senscr));
+    ps_mgau_frame_prep(acmod->mgau, senone_active, n_senone_active,
+                       feat, frame, compallsen);
+    if (compallsen)
+        n_senone_active = bin_mdef_n_sen(acmod->mdef);
+
+    /* One block for this thread and one for each worker, unless that
+     * would make them too small to be worth it. */
+    n_blocks = pool->n_workers - first_worker + 1;
+    if (n_blocks > n_senone_active / ACMOD_MIN_BLOCK)
+        n_blocks = n_senone_active / ACMOD_MIN_BLOCK;
+    if (n_blocks < 1)
+        n_blocks = 1;
+
+    /* Keep the first block and hand out the rest.  Since the active
+     * senones are deltas, each block also needs the senone ID that
+     * precedes it. */
+    start = n_senone_active / n_blocks;
+    sen = 0;
+    if (!compallsen)
+        for (j = 0; j < start; ++j)
+            sen += senone_active[j];
+    for (i = 1; i < n_blocks; ++i) {
+        acmod_worker_t *w = pool->workers + first_worker + i - 1;
+        int32 end = (int32)((int64)n_senone_active * (i + 1) / n_blocks);
+
+        w->feat = NULL;
+        w->senscr = senscr;
+        w->senone_active = compallsen ? NULL : senone_active + start;
+        w->n_senone_active = end - start;
+        w->first_sen = compallsen ? start : sen;
+        w->frame = frame;
+        sbevent_signal(w->start);
+        if (!compallsen)
+            for (j = start; j < end; ++j)
+                sen += senone_active[j];
+        start = end;
+    }
+    best = ps_mgau_senone_eval(acmod->mgau, senscr, senone_active,
+                               n_senone_active / n_blocks, 0,
+                               frame, compallsen);
+    for (i = 1; i < n_blocks; ++i) {
+        acmod_worker_t *w = pool->workers + first_worker + i - 1;
+
+        sbevent_wait(w->done, -1, 0);
+        if (w->best < best)
+            best = w->best;
+    }
+    if (acmod->mgau->vt->senone_norm)
+        (*acmod->mgau->vt->senone_norm)(acmod->mgau, senscr, best);
+}
+
+/**
+ * Score senones first_sen to last_sen in each frame of a batch, a
+ * block of them at a time.
+ */
+static void
+acmod_batch_eval(acmod_t *acmod, int16 **batch, int32 *best,
+                 int32 first_sen, int32 last_sen,
+                 int32 frame, int32 n_frames)
+{
+    int32 sen, k;
+
+    for (k = 0; k < n_frames; ++k)
+        best[k] = 0x7fffffff;
+    for (sen = first_sen; sen < last_sen; sen += ACMOD_BATCH_BLOCK) {
+        int32 n_sen = last_sen - sen;
+
+        if (n_sen > ACMOD_BATCH_BLOCK)
+            n_sen = ACMOD_BATCH_BLOCK;
+        for (k = 0; k < n_frames; ++k) {
+            int32 b = ps_mgau_senone_eval(acmod->mgau, batch[k], NULL,
+                                          n_sen, sen, frame + k, TRUE);
+            if (b < best[k])
+                best[k] = b;
+        }
+    }
+}
+
+/**
+ * Score all senones in n_frames frames starting at frame_idx, whose
+ * features start at feat_idx, into batch_scores.  The senones are
+ * split between this thread and the workers, if there are any.
+ */
+static void
+acmod_score_batch(acmod_t *acmod, int feat_idx, int frame_idx, int n_frames)
+{
+    acmod_pool_t *pool = acmod->pool;
+    int32 n_sen = bin_mdef_n_sen(acmod->mdef);
+    int32 i, k, n_blocks, start;
+
+    /* The top-N codewords for each frame depend on the previous
+     * frame's, so they are found one frame after another. */
+    for (k = 0; k < n_frames; ++k) {
+        memset(acmod->batch_scores[k], 0,
+               n_sen * sizeof(*acmod->batch_scores[k]));
+        ps_mgau_frame_prep(acmod->mgau, NULL, 0,
+                           acmod->feat_buf[(feat_idx + k) % acmod->n_feat_alloc],
+                           frame_idx + k, TRUE);
+        acmod->batch_frame[k] = frame_idx + k;
+    }
+
+    n_blocks = pool ? pool->n_workers + 1 : 1;
+    if (n_blocks > n_sen / ACMOD_MIN_BLOCK)
+        n_blocks = n_sen / ACMOD_MIN_BLOCK;
+    if (n_blocks < 1)
+        n_blocks = 1;
+    start = n_sen / n_blocks;
+    for (i = 1; i < n_blocks; ++i) {
+        acmod_worker_t *w = pool->workers + i - 1;
+        int32 end = (int32)((int64)n_sen * (i + 1) / n_blocks);
+
+        w->feat = NULL;
+        w->batch = acmod->batch_scores;
+        w->n_frames = n_frames;
+        w->batch_best = acmod->batch_best + i * acmod->n_batch;
+        w->first_sen = start;
+        w->n_senone_active = end - start;
+        w->frame = frame_idx;
+        sbevent_signal(w->start);
+        start = end;
+    }
+    acmod_batch_eval(acmod, acmod->batch_scores, acmod->batch_best,
+                     0, n_sen / n_blocks, frame_idx, n_frames);
+    for (i = 1; i < n_blocks; ++i) {
+        int32 *best = acmod->batch_best + i * acmod->n_batch;
+
+        sbevent_wait(pool->workers[i - 1].done, -1, 0);
+        pool->workers[i - 1].batch = NULL;
+        for (k = 0; k < n_frames; ++k)
+            if (best[k] < acmod->batch_best[k])
+                acmod->batch_best[k] = best[k];
+    }
+    if (acmod->mgau->vt->senone_norm)
+        for (k = 0; k < n_frames; ++k)
+            (*acmod->mgau->vt->senone_norm)(acmod->mgau, acmod->batch_scores[k],
+                                            acmod->batch_best[k]);
+}
+
+static int
+acmod_worker_main(sbthread_t *th)
+{
+    acmod_worker_t *w = sbthread_arg(th);
+
+    while (sbevent_wait(w->start, -1, 0) == 0 && !w->exit) {
+        if (w->feat)
+            acmod_score_split(w->acmod, w->senscr, NULL, 0,
+                              w->feat, w->frame, 1);
+        else if (w->batch)
+            acmod_batch_eval(w->acmod, w->batch, w->batch_best,
+                             w->first_sen,
+                             w->first_sen + w->n_senone_active,
+                             w->frame, w->n_frames);
+        else
+            w->best = ps_mgau_senone_eval(w->acmod->mgau, w->senscr,
+                                          w->senone_active,
+                                          w->n_senone_active,
+                                          w->first_sen, w->frame,
+                                          w->acmod->compallsen);
+        sbevent_signal(w->done);
+    }
+    return 0;
+}
+
+static void
+acmod_pool_free(acmod_pool_t *pool)
+{
+    int i;
+
+    if (pool == NULL)
+        return;
+    for (i = 0; i < pool->n_workers; ++i) {
+        acmod_worker_t *w = pool->workers + i;
+
+        w->exit = TRUE;
+        sbevent_signal(w->start);
+        sbthread_free(w->thread);
+        sbevent_free(w->start);
+        sbevent_free(w->done);
+    }
+    ckd_free(pool->workers);
+    ckd_free(pool);
+}
+
+static acmod_pool_t *
+acmod_pool_init(acmod_t *acmod, int n_workers)
+{
+    acmod_pool_t *pool;
+
+    pool = ckd_calloc(1, sizeof(*pool));
+    pool->workers = ckd_calloc(n_workers, sizeof(*pool->workers));
+    while (pool->n_workers < n_workers) {
+        acmod_worker_t *w = pool->workers + pool->n_workers;
+
+        w->acmod = acmod;
+        if ((w->start = sbevent_init()) == NULL)
+            goto error_out;
+        if ((w->done = sbevent_init()) == NULL) {
+            sbevent_free(w->start);
+            goto error_out;
+        }
+        if ((w->thread = sbthread_start(NULL, acmod_worker_main, w)) == NULL) {
+            sbevent_free(w->start);
+            sbevent_free(w->done);
+            goto error_out;
+        }
+        ++pool->n_workers;
+    }
+    E_INFO("Scoring senones with %d extra threads\n", pool->n_workers);
+    return pool;
+
+error_out:
+    E_ERROR("Failed to start senone scoring thread %d\n", pool->n_workers);
+    acmod_pool_free(pool);
+    return NULL;
+}
+
+/**
+ * Wait for the frame being scored ahead, if any.  Things that change
+ * the feature buffer or the model also discard its scores, and those
+ * of any batch.
+ */
+static void
+acmod_wait_ahead(acmod_t *acmod, int discard)
+{
+    int k;
+
+    if (acmod->pool && acmod->pool->ahead) {
+        sbevent_wait(acmod->pool->workers[0].done, -1, 0);
+        acmod->pool->ahead = FALSE;
+    }
+    if (discard) {
+        acmod->next_frame = -1;
+        for (k = 0; k < acmod->n_batch; ++k)
+            acmod->batch_frame[k] = -1;
+    }
+}
+
+/**
+ * Start scoring the frame after this one while the search is busy
+ * with it.  The scores go into next_scores, which is swapped with
+ * senone_scores once it is that frame's turn, so nothing is copied.
+ */
+static void
+acmod_score_ahead(acmod_t *acmod, int feat_idx, int frame_idx)
+{
+    acmod_worker_t *w = acmod->pool->workers;
+
+    w->feat = acmod->feat_buf[feat_idx];
+    w->senscr = acmod->next_scores;
+    w->frame = frame_idx;
+    acmod->next_frame = frame_idx;
+    acmod->pool->ahead = TRUE;
+    sbevent_signal(w->start);
+}
+
 acmod_t *
 acmod_init(cmd_ln_t *config, logmath_t *lmath, fe_t *fe, feat_t *fcb)
 {
@@ -269,6 +586,56 @@ acmod_init(cmd_ln_t *config, logmath_t *lmath, fe_t *fe, feat_t *fcb)
     if (acmod_init_am(acmod) < 0)
         goto error_out;
 
+    if (acmod_init_buffers(acmod) < 0)
+        goto error_out;
+    return acmod;
+
+error_out:
+    acmod_free(acmod);
+    return NULL;
+}
+
+acmod_t *
+acmod_copy(acmod_t *other, logmath_t *lmath)
+{
+    acmod_t *acmod;
+
+    acmod = ckd_calloc(1, sizeof(*acmod));
+    acmod->config = other->config;
+    acmod->lmath = lmath;
+    acmod->state = ACMOD_IDLE;
+
+    /* Feature computation keeps state (CMN, AGC, the frame counter)
+     * so it can't be shared. */
+    cmd_ln_retain(acmod->config);
+    acmod->fe = fe_init_auto_r(acmod->config);
+    if (acmod->fe == NULL)
+        goto error_out;
+    if (acmod_init_feat(acmod) < 0)
+        goto error_out;
+
+    /* The model parameters can. */
+    acmod->mdef = bin_mdef_retain(other->mdef);
+    acmod->tmat = tmat_retain(other->tmat);
+    if ((acmod->mgau = ps_mgau_copy(other->mgau)) == NULL)
+        goto error_out;
+    if (other->mllr)
+        acmod->mllr = ps_mllr_retain(other->mllr);
+
+    if (acmod_init_buffers(acmod) < 0)
+        goto error_out;
+    return acmod;
+
+error_out:
+    acmod_free(acmod);
+    return NULL;
+}
+
+static int
+acmod_init_buffers(acmod_t *acmod)
+{
+    cmd_ln_t *config = acmod->config;
+    int i;
 
     /* The MFCC buffer needs to be at least as large as the dynamic
      * feature window.  */
@@ -277,8 +644,28 @@ acmod_init(cmd_ln_t *config, logmath_t *lmath, fe_t *fe, feat_t *fcb)
         ckd_calloc_2d(acmod->n_mfc_alloc, acmod->fcb->cepsize,
                       sizeof(**acmod->mfc_buf));
 
-    /* Feature buffer has to be at least as large as MFCC buffer. */
-    acmod->n_feat_alloc = acmod->n_mfc_alloc + cmd_ln_int32_r(config, "-pl_window");
+    /* Frames to score at once, which only works if they don't depend
+     * on the search. */
+    acmod->n_batch = 1;
+    if (cmd_ln_int32_r(config, "-scorebatch") > 1) {
+        if (cmd_ln_boolean_r(config, "-compallsen"))
+            acmod->n_batch = cmd_ln_int32_r(config, "-scorebatch");
+        else
+            E_WARN("-scorebatch requires -compallsen, scoring one frame at a time\n");
+    }
+    acmod->batch_frame = ckd_calloc(acmod->n_batch, sizeof(*acmod->batch_frame));
+    acmod->batch_scores = ckd_calloc(acmod->n_batch, sizeof(*acmod->batch_scores));
+    for (i = 0; i < acmod->n_batch; ++i) {
+        acmod->batch_frame[i] = -1;
+        if (acmod->n_batch > 1)
+            acmod->batch_scores[i] = ckd_calloc(bin_mdef_n_sen(acmod->mdef),
+                                                sizeof(**acmod->batch_scores));
+    }
+
+    /* Feature buffer has to be at least as large as MFCC buffer, and
+     * be able to hold a whole batch. */
+    acmod->n_feat_alloc = acmod->n_mfc_alloc + cmd_ln_int32_r(config, "-pl_window")
+        + acmod->n_batch - 1;
     acmod->feat_buf = feat_array_alloc(acmod->fcb, acmod->n_feat_alloc);
 
     /* Senone computation stuff. */
@@ -289,19 +676,48 @@ acmod_init(cmd_ln_t *config, logmath_t *lmath, fe_t *fe, feat_t *fcb)
                                                      sizeof(*acmod->senone_active));
     acmod->log_zero = logmath_get_zero(acmod->lmath);
     acmod->compallsen = cmd_ln_boolean_r(config, "-compallsen");
-    return acmod;
 
-error_out:
-    acmod_free(acmod);
-    return NULL;
+    /* Threads for senone scoring. */
+    acmod->next_frame = -1;
+    if (cmd_ln_int32_r(config, "-scorethreads") > 0) {
+        if (acmod->mgau->vt->senone_eval == NULL) {
+            E_WARN("%s models cannot be scored on several threads\n",
+                   acmod->mgau->vt->name);
+        }
+        else {
+            acmod->pool = acmod_pool_init(acmod,
+                                          cmd_ln_int32_r(config, "-scorethreads"));
+            if (acmod->pool == NULL)
+                return -1;
+            acmod->next_scores = ckd_calloc(bin_mdef_n_sen(acmod->mdef),
+                                            sizeof(*acmod->next_scores));
+        }
+    }
+    if (acmod->n_batch > 1)
+        acmod->batch_best = ckd_calloc(acmod->n_batch
+                                       * (acmod->pool ? acmod->pool->n_workers + 1 : 1),
+                                       sizeof(*acmod->batch_best));
+    return 0;
 }
 
 void
 acmod_free(acmod_t *acmod)
 {
+    int i;
+
     if (acmod == NULL)
         return;
 
+    acmod_wait_ahead(acmod, TRUE);
+    acmod_pool_free(acmod->pool);
+    ckd_free(acmod->next_scores);
+    if (acmod->batch_scores)
+        for (i = 0; i < acmod->n_batch; ++i)
+            ckd_free(acmod->batch_scores[i]);
+    ckd_free(acmod->batch_scores);
+    ckd_free(acmod->batch_frame);
+    ckd_free(acmod->batch_best);
+
     feat_free(acmod->fcb);
     fe_free(acmod->fe);
 
@@ -334,9 +750,14 @@ acmod_free(acmod_t *acmod)
 ps_mllr_t *
 acmod_update_mllr(acmod_t *acmod, ps_mllr_t *mllr)
 {
+    if (acmod->mgau->refcnt > 1 || acmod->mgau->shared) {
+        E_ERROR("Cannot adapt acoustic model parameters shared with other decoders\n");
+        return NULL;
+    }
     if (acmod->mllr)
         ps_mllr_free(acmod->mllr);
     acmod->mllr = mllr;
+    acmod_wait_ahead(acmod, TRUE);
     ps_mgau_transform(acmod->mgau, mllr);
 
     return mllr;
@@ -368,6 +789,7 @@ acmod_grow_feat_buf(acmod_t *acmod, int nfr)
 {
     mfcc_t ***new_feat_buf;
 
+    acmod_wait_ahead(acmod, TRUE);
     new_feat_buf = feat_array_alloc(acmod->fcb, nfr);
     if (acmod->n_feat_frame || acmod->grow_feat) {
         memcpy(new_feat_buf[0][0], acmod->feat_buf[0][0],
@@ -396,6 +818,7 @@ acmod_set_grow(acmod_t *acmod, int grow_feat)
 int
 acmod_start_utt(acmod_t *acmod)
 {
+    acmod_wait_ahead(acmod, TRUE);
     fe_start_utt(acmod->fe);
     acmod->state = ACMOD_STARTED;
     acmod->n_mfc_frame = 0;
@@ -485,6 +908,7 @@ acmod_process_full_cep(acmod_t *acmod,
     if (acmod->mfcfh)
         acmod_log_mfc(acmod, *inout_cep, *inout_n_frames);
 
+    acmod_wait_ahead(acmod, TRUE);
     /* Resize feat_buf to fit. */
     if (acmod->n_feat_alloc < *inout_n_frames) {
         feat_array_free(acmod->feat_buf);
@@ -764,6 +1188,7 @@ acmod_rewind(acmod_t *acmod)
     /* If the feature buffer is circular, this is not possible. */
     if (acmod->output_frame > acmod->n_feat_alloc)
         return -1;
+    acmod_wait_ahead(acmod, TRUE);
 
     /* Frames consumed + frames available */
     acmod->n_feat_frame = acmod->output_frame + acmod->n_feat_frame;
@@ -777,9 +1202,29 @@ acmod_rewind(acmod_t *acmod)
     return 0;
 }
 
+int
+acmod_n_ready(acmod_t *acmod)
+{
+    int k, n_ready;
+
+    if (acmod->n_batch == 1 || acmod->state == ACMOD_ENDED
+        || acmod->n_feat_frame >= acmod->n_batch)
+        return acmod->n_feat_frame;
+
+    /* Otherwise only what is left of the last batch. */
+    n_ready = 0;
+    for (k = 0; k < acmod->n_batch; ++k)
+        if (acmod->batch_frame[k] >= acmod->output_frame)
+            ++n_ready;
+    return n_ready;
+}
+
 int
 acmod_advance(acmod_t *acmod)
 {
+    /* The frame being scored ahead still needs the old frame index. */
+    acmod_wait_ahead(acmod, FALSE);
+
     /* Advance the output pointers. */
     if (++acmod->feat_outidx == acmod->n_feat_alloc)
         acmod->feat_outidx = 0;
@@ -824,19 +1269,63 @@ acmod_score(acmod_t *acmod,
                 % acmod->n_feat_alloc);
     if (feat_idx < 0) feat_idx += acmod->n_feat_alloc;
 
-    /* Generate scores for the next available frame */
-    ps_mgau_frame_eval(acmod->mgau,
-                       acmod->senone_scores,
-                       acmod->senone_active,
-                       acmod->n_senone_active,
-                       acmod->feat_buf[feat_idx],
-                       frame_idx,
-                       acmod->compallsen);
+    acmod_wait_ahead(acmod, FALSE);
+    if (frame_idx == acmod->next_frame) {
+        /* It has already been scored, just take the scores. */
+        int16 *tmp = acmod->senone_scores;
+        acmod->senone_scores = acmod->next_scores;
+        acmod->next_scores = tmp;
+        acmod->next_frame = -1;
+    }
+    else if (acmod->n_batch > 1 && frame_idx == acmod->output_frame) {
+        int16 *tmp;
+        int k;
+
+        /* Score this frame along with the ones after it, unless that
+         * was already done, and take its scores from the batch. */
+        for (k = 0; k < acmod->n_batch; ++k)
+            if (acmod->batch_frame[k] == frame_idx)
+                break;
+        if (k == acmod->n_batch) {
+            acmod_score_batch(acmod, feat_idx, frame_idx,
+                              acmod->n_feat_frame < acmod->n_batch
+                              ? acmod->n_feat_frame : acmod->n_batch);
+            k = 0;
+        }
+        tmp = acmod->senone_scores;
+        acmod->senone_scores = acmod->batch_scores[k];
+        acmod->batch_scores[k] = tmp;
+        acmod->batch_frame[k] = -1;
+    }
+    else if (acmod->pool) {
+        acmod_score_split(acmod, acmod->senone_scores,
+                          acmod->senone_active,
+                          acmod->n_senone_active,
+                          acmod->feat_buf[feat_idx],
+                          frame_idx, 0);
+    }
+    else {
+        /* Generate scores for the next available frame */
+        ps_mgau_frame_eval(acmod->mgau,
+                           acmod->senone_scores,
+                           acmod->senone_active,
+                           acmod->n_senone_active,
+                           acmod->feat_buf[feat_idx],
+                           frame_idx,
+                           acmod->compallsen);
+    }
 
     if (inout_frame_idx)
         *inout_frame_idx = frame_idx;
     acmod->senscr_frame = frame_idx;
 
+    /* If the next frame doesn't depend on the search, score it while
+     * the search works on this one. */
+    if (acmod->pool && acmod->compallsen && acmod->n_batch == 1
+        && frame_idx == acmod->output_frame && acmod->n_feat_frame > 1)
+        acmod_score_ahead(acmod, (feat_idx + 1) % acmod->n_feat_alloc,
+                          frame_idx + 1);
+
     return acmod->senone_scores;
 }
 
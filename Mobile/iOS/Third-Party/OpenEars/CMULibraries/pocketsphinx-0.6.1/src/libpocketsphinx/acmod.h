@@ -102,11 +102,45 @@ typedef struct ps_mgaufuncs_s {
     int (*transform)(ps_mgau_t *mgau,
                      ps_mllr_t *mllr);
     void (*free)(ps_mgau_t *mgau);
-} ps_mgaufuncs_t;    
+
+    /* The following are optional, and split frame_eval() up so that
+     * senones can be scored on several threads.  frame_prep() does
+     * everything that has to be done once per frame (such as finding
+     * the top-N codewords), after which senone_eval() can be called
+     * concurrently on disjoint sets of senones, accumulating into
+     * senscr which must be zeroed beforehand.  With compallsen, it
+     * scores n_senone_active senones starting at first_sen, otherwise
+     * the senone_active deltas starting from first_sen.  It returns
+     * the best score it found, which is passed to senone_norm() (if
+     * present) once all of them are done. */
+    int (*frame_prep)(ps_mgau_t *mgau,
+                      uint8 *senone_active,
+                      int32 n_senone_active,
+                      mfcc_t ** feat,
+                      int32 frame,
+                      int32 compallsen);
+    int (*senone_eval)(ps_mgau_t *mgau,
+                       int16 *senscr,
+                       uint8 *senone_active,
+                       int32 n_senone_active,
+                       int32 first_sen,
+                       int32 frame,
+                       int32 compallsen);
+    void (*senone_norm)(ps_mgau_t *mgau,
+                        int16 *senscr,
+                        int32 best);
+    /* Create a model that shares the parameters of mgau but keeps its
+     * own per-frame state, so that both can be used at once (on
+     * different threads).  The parameters are freed along with the
+     * last model using them. */
+    ps_mgau_t *(*copy)(ps_mgau_t *mgau);
+} ps_mgaufuncs_t;
 
 struct ps_mgau_s {
     ps_mgaufuncs_t *vt;  /**< vtable of mgau functions. */
     int frame_idx;       /**< frame counter. */
+    int refcnt;          /**< Number of models using these parameters. */
+    ps_mgau_t *shared;   /**< Model owning the parameters, if this is a copy. */
 };
 
 #define ps_mgau_base(mg) ((ps_mgau_t *)(mg))
@@ -117,6 +151,14 @@ struct ps_mgau_s {
     (*ps_mgau_base(mg)->vt->transform)(mg, mllr)
 #define ps_mgau_free(mg)                                  \
     (*ps_mgau_base(mg)->vt->free)(mg)
+#define ps_mgau_frame_prep(mg,senone_active,n_senone_active,feat,frame,compallsen) \
+    (*ps_mgau_base(mg)->vt->frame_prep)                                 \
+    (mg, senone_active, n_senone_active, feat, frame, compallsen)
+#define ps_mgau_senone_eval(mg,senscr,senone_active,n_senone_active,first_sen,frame,compallsen) \
+    (*ps_mgau_base(mg)->vt->senone_eval)                                \
+    (mg, senscr, senone_active, n_senone_active, first_sen, frame, compallsen)
+#define ps_mgau_copy(mg)                                  \
+    (*ps_mgau_base(mg)->vt->copy)(mg)
 
 /**
  * Acoustic model structure.
@@ -181,6 +223,17 @@ struct acmod_s {
     int16 n_feat_alloc; /**< Number of frames allocated in feat_buf */
     int16 n_feat_frame; /**< Number of frames active in feat_buf */
     int16 feat_outidx;  /**< Start of active frames in feat_buf */
+
+    /* Threaded scoring: */
+    struct acmod_pool_s *pool; /**< Scoring threads, or NULL for none. */
+    int16 *next_scores; /**< GMM scores computed ahead for next_frame. */
+    int next_frame;     /**< Frame index for next_scores, or -1. */
+
+    /* Batched scoring: */
+    int n_batch;        /**< Number of frames scored at once. */
+    int16 **batch_scores; /**< GMM scores for the frames of a batch. */
+    int *batch_frame;   /**< Frame index for each of batch_scores, or -1. */
+    int32 *batch_best;  /**< Best scores for each thread and frame. */
 };
 typedef struct acmod_s acmod_t;
 
@@ -202,9 +255,27 @@ typedef struct acmod_s acmod_t;
  */
 acmod_t *acmod_init(cmd_ln_t *config, logmath_t *lmath, fe_t *fe, feat_t *fcb);
 
+/**
+ * Create an acoustic model sharing the parameters of another.
+ *
+ * The model definition, transition matrices, Gaussians and mixture
+ * weights are shared with (and kept alive by) the new object, while
+ * the front end, feature computation and all buffers are its own.
+ * The two can then be used at the same time from different threads.
+ *
+ * @param other Acoustic model to share parameters with.
+ * @param lmath Log-math computation, which must use the same base as
+ *              the one <code>other</code> was created with.
+ * @return a newly initialized acmod_t, or NULL on failure.
+ */
+acmod_t *acmod_copy(acmod_t *other, logmath_t *lmath);
+
 /**
  * Adapt acoustic model using a linear transform.
  *
+ * This is not possible while the parameters are shared with another
+ * acoustic model (see acmod_copy()).
+ *
  * @param mllr The new transform to use, or NULL to update the existing
  *              transform.  The decoder retains ownership of this pointer,
  *              so you should not attempt to free it manually.  Use
@@ -262,6 +333,18 @@ int acmod_end_utt(acmod_t *acmod);
  */
 int acmod_rewind(acmod_t *acmod);
 
+/**
+ * Get the number of frames that can be searched now.
+ *
+ * With -scorebatch, frames are held back until a whole batch of them
+ * can be scored together, or until the end of the utterance.  The
+ * search should only step through this many frames before asking for
+ * more input.
+ *
+ * @return Number of frames ready to be searched.
+ */
+int acmod_n_ready(acmod_t *acmod);
+
 /**
  * Advance the frame index.
  *
@@ -86,14 +86,13 @@ static ps_searchfuncs_t fsg_funcs = {
     /* seg_iter: */ fsg_search_seg_iter,
 };
 
-ps_search_t *
-fsg_search_init(cmd_ln_t *config,
-                acmod_t *acmod,
-                dict_t *dict,
-                dict2pid_t *d2p)
+static fsg_search_t *
+fsg_search_new(cmd_ln_t *config,
+               acmod_t *acmod,
+               dict_t *dict,
+               dict2pid_t *d2p)
 {
     fsg_search_t *fsgs;
-    char const *path;
 
     fsgs = ckd_calloc(1, sizeof(*fsgs));
     ps_search_init(ps_search_base(fsgs), &fsg_funcs, config, acmod, dict, d2p);
@@ -140,6 +139,21 @@ fsg_search_init(cmd_ln_t *config,
            fsgs->beam_orig, fsgs->pbeam_orig, fsgs->wbeam_orig,
            fsgs->wip, fsgs->pip);
 
+    return fsgs;
+}
+
+ps_search_t *
+fsg_search_init(cmd_ln_t *config,
+                acmod_t *acmod,
+                dict_t *dict,
+                dict2pid_t *d2p)
+{
+    fsg_search_t *fsgs;
+    char const *path;
+
+    if ((fsgs = fsg_search_new(config, acmod, dict, d2p)) == NULL)
+        return NULL;
+
     /* Load an FSG if one was specified in config */
     if ((path = cmd_ln_str_r(config, "-fsg"))) {
         fsg_model_t *fsg;
@@ -217,6 +231,37 @@ error_out:
     return NULL;
 }
 
+ps_search_t *
+fsg_search_share(ps_search_t *search,
+                 acmod_t *acmod,
+                 dict_t *dict,
+                 dict2pid_t *d2p)
+{
+    fsg_search_t *other = (fsg_search_t *)search;
+    fsg_search_t *fsgs;
+    hash_iter_t *itor;
+
+    if ((fsgs = fsg_search_new(ps_search_config(other),
+                               acmod, dict, d2p)) == NULL)
+        return NULL;
+
+    /* The grammars were already fixed up by fsg_set_add() and are
+     * only read from now on, so just retain them. */
+    for (itor = hash_table_iter(other->fsgs);
+         itor; itor = hash_table_iter_next(itor)) {
+        fsg_model_t *fsg = (fsg_model_t *) hash_entry_val(itor->ent);
+        hash_table_enter(fsgs->fsgs, hash_entry_key(itor->ent),
+                         fsg_model_retain(fsg));
+        if (fsg == other->fsg)
+            fsgs->fsg = fsg;
+    }
+    if (fsgs->fsg && fsg_search_reinit(ps_search_base(fsgs), dict, d2p) < 0) {
+        fsg_search_free(ps_search_base(fsgs));
+        return NULL;
+    }
+    return ps_search_base(fsgs);
+}
+
 void
 fsg_search_free(ps_search_t *search)
 {
@@ -117,6 +117,17 @@ ps_search_t *fsg_search_init(cmd_ln_t *config,
                              dict_t *dict,
                              dict2pid_t *d2p);
 
+/**
+ * Create a search module using the same grammars as another.
+ *
+ * Grammars are shared rather than copied, so the two can be used by
+ * different threads at once.
+ */
+ps_search_t *fsg_search_share(ps_search_t *other,
+                              acmod_t *acmod,
+                              dict_t *dict,
+                              dict2pid_t *d2p);
+
 /**
  * Deallocate search structure.
  */
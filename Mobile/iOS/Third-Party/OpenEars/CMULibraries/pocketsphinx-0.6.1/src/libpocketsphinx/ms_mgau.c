@@ -75,7 +75,11 @@ static ps_mgaufuncs_t ms_mgau_funcs = {
     "ms",
     &ms_cont_mgau_frame_eval, /* frame_eval */
     &ms_mgau_mllr_transform,  /* transform */
-    &ms_mgau_free             /* free */
+    &ms_mgau_free,            /* free */
+    NULL,                     /* frame_prep */
+    NULL,                     /* senone_eval */
+    NULL,                     /* senone_norm */
+    &ms_mgau_copy             /* copy */
 };
 
 ps_mgau_t *
@@ -88,6 +92,7 @@ ms_mgau_init(cmd_ln_t *config, logmath_t *lmath, bin_mdef_t *mdef)
     senone_t *s;
 
     msg = (ms_mgau_model_t *) ckd_calloc(1, sizeof(ms_mgau_model_t));
+    ps_mgau_base(msg)->refcnt = 1;
     msg->config = config;
     msg->g = NULL;
     msg->s = NULL;
@@ -138,17 +143,48 @@ ms_mgau_init(cmd_ln_t *config, logmath_t *lmath, bin_mdef_t *mdef)
     return mg;
 }
 
+ps_mgau_t *
+ms_mgau_copy(ps_mgau_t * mg)
+{
+    ms_mgau_model_t *other, *msg;
+
+    /* Always share the parameters of the model that owns them. */
+    if (mg->shared)
+        mg = mg->shared;
+    other = (ms_mgau_model_t *)mg;
+
+    msg = (ms_mgau_model_t *) ckd_malloc(sizeof(ms_mgau_model_t));
+    *msg = *other;
+    ps_mgau_base(msg)->frame_idx = 0;
+    ps_mgau_base(msg)->refcnt = 1;
+    ps_mgau_base(msg)->shared = mg;
+    ++mg->refcnt;
+    msg->dist = (gauden_dist_t ***)
+        ckd_calloc_3d(msg->g->n_mgau, msg->g->n_feat, msg->topn,
+                      sizeof(gauden_dist_t));
+    msg->mgau_active = ckd_calloc(msg->g->n_mgau, sizeof(int8));
+    return ps_mgau_base(msg);
+}
+
 void
 ms_mgau_free(ps_mgau_t * mg)
 {
     ms_mgau_model_t *msg = (ms_mgau_model_t *)mg;
     if (msg == NULL)
         return;
+    if (--mg->refcnt > 0)
+        return;
 
-    gauden_free(msg->g);
-    senone_free(msg->s);
     ckd_free_3d((void *) msg->dist);
     ckd_free(msg->mgau_active);
+    /* A copy owns nothing else. */
+    if (mg->shared) {
+        ms_mgau_free(mg->shared);
+        ckd_free(msg);
+        return;
+    }
+    gauden_free(msg->g);
+    senone_free(msg->s);
     ckd_free(msg);
 }
 
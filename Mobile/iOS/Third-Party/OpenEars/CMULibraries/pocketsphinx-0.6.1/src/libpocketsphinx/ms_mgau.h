@@ -128,6 +128,7 @@ typedef struct {
 #define ms_mgau_topn(msg) (msg->topn)
 
 ps_mgau_t* ms_mgau_init(cmd_ln_t *config, logmath_t *lmath, bin_mdef_t *mdef);
+ps_mgau_t* ms_mgau_copy(ps_mgau_t *g);
 void ms_mgau_free(ps_mgau_t *g);
 int32 ms_cont_mgau_frame_eval(ps_mgau_t * msg,
                               int16 *senscr,
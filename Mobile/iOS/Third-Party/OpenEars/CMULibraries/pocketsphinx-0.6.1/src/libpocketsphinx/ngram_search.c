@@ -136,7 +136,8 @@ ngram_search_calc_beams(ngram_search_t *ngs)
 }
 
 ps_search_t *
-ngram_search_init(cmd_ln_t *config,
+ngram_search_init(ngram_model_t *lmset,
+                  cmd_ln_t *config,
 		  acmod_t *acmod,
 		  dict_t *dict,
                   dict2pid_t *d2p)
@@ -149,6 +150,7 @@ ngram_search_init(cmd_ln_t *config,
     ngs->hmmctx = hmm_context_init(bin_mdef_n_emit_state(acmod->mdef),
                                    acmod->tmat->tp, NULL, acmod->mdef->sseq);
     if (ngs->hmmctx == NULL) {
+        ngram_model_free(lmset);
         ps_search_free(ps_search_base(ngs));
         return NULL;
     }
@@ -189,7 +191,10 @@ ngram_search_init(cmd_ln_t *config,
                                           sizeof(**ngs->active_word_list));
 
     /* Load language model(s) */
-    if ((path = cmd_ln_str_r(config, "-lmctl"))) {
+    if (lmset) {
+        ngs->lmset = lmset;
+    }
+    else if ((path = cmd_ln_str_r(config, "-lmctl"))) {
         ngs->lmset = ngram_model_set_read(config, path, acmod->lmath);
         if (ngs->lmset == NULL) {
             E_ERROR("Failed to read language model control file: %s\n",
@@ -358,8 +358,13 @@ typedef struct ngram_search_s ngram_search_t;
 
 /**
  * Initialize the N-Gram search module.
+ *
+ * @param lmset Language model set to use (ownership of which is
+ *              assumed by the search), or NULL to load the ones named
+ *              by -lmctl or -lm in config.
  */
-ps_search_t *ngram_search_init(cmd_ln_t *config,
+ps_search_t *ngram_search_init(ngram_model_t *lmset,
+                               cmd_ln_t *config,
                                acmod_t *acmod,
                                dict_t *dict,
                                dict2pid_t *d2p);
@@ -270,7 +270,7 @@ ps_reinit(ps_decoder_t *ps, cmd_ln_t *config)
 
         if ((ps->d2p = dict2pid_build(ps->acmod->mdef, ps->dict)) == NULL)
             return -1;
-        if ((ngs = ngram_search_init(ps->config, ps->acmod, ps->dict, ps->d2p)) == NULL)
+        if ((ngs = ngram_search_init(NULL, ps->config, ps->acmod, ps->dict, ps->d2p)) == NULL)
             return -1;
         ngs->pls = ps->phone_loop;
         ps->searches = glist_add_ptr(ps->searches, ngs);
@@ -304,6 +304,77 @@ ps_init(cmd_ln_t *config)
     return ps;
 }
 
+ps_decoder_t *
+ps_init_shared(ps_decoder_t *other)
+{
+    ps_decoder_t *ps;
+    gnode_t *gn;
+
+    ps = ckd_calloc(1, sizeof(*ps));
+    ps->refcount = 1;
+    ps->config = cmd_ln_retain(other->config);
+    ps->mfclogdir = other->mfclogdir;
+    ps->rawlogdir = other->rawlogdir;
+    /* Lattices retain the log-math object, so a decoder used on
+     * another thread needs one of its own. */
+    ps->lmath = logmath_init(logmath_get_base(other->lmath), 0,
+                             cmd_ln_boolean_r(ps->config, "-bestpath"));
+
+    /* Acoustic model, with its own front end and buffers. */
+    if ((ps->acmod = acmod_copy(other->acmod, ps->lmath)) == NULL)
+        goto error_out;
+    if (cmd_ln_boolean_r(ps->config, "-fwdflat")
+        && cmd_ln_boolean_r(ps->config, "-fwdtree"))
+        acmod_set_grow(ps->acmod, TRUE);
+
+    /* Dictionary and triphone mappings are only read while decoding. */
+    ps->dict = dict_retain(other->dict);
+    ps->d2p = dict2pid_retain(other->d2p);
+
+    if ((ps->pl_window = other->pl_window)) {
+        if ((ps->phone_loop = phone_loop_search_init(ps->config,
+                                                     ps->acmod, ps->dict)) == NULL)
+            goto error_out;
+        ps->searches = glist_add_ptr(ps->searches, ps->phone_loop);
+    }
+
+    /* Searches have their own state, but share language models and
+     * grammars. */
+    for (gn = other->searches; gn; gn = gnode_next(gn)) {
+        ps_search_t *search = gnode_ptr(gn);
+        ps_search_t *copy;
+
+        if (search == other->phone_loop)
+            continue;
+        if (0 == strcmp(ps_search_name(search), "ngram")) {
+            ngram_model_t *lmset;
+
+            lmset = ngram_model_set_share(((ngram_search_t *)search)->lmset);
+            copy = ngram_search_init(lmset, ps->config,
+                                     ps->acmod, ps->dict, ps->d2p);
+        }
+        else {
+            copy = fsg_search_share(search, ps->acmod, ps->dict, ps->d2p);
+        }
+        if (copy == NULL)
+            goto error_out;
+        copy->pls = ps->phone_loop;
+        ps->searches = glist_add_ptr(ps->searches, copy);
+        if (search == other->search)
+            ps->search = copy;
+    }
+
+    /* Initialize performance timer. */
+    ps->perf.name = "decode";
+    ptmr_init(&ps->perf);
+
+    return ps;
+
+error_out:
+    ps_free(ps);
+    return NULL;
+}
+
 arg_t const *
 ps_args(void)
 {
@@ -394,7 +465,7 @@ ps_update_lmset(ps_decoder_t *ps, ngram_model_t *lmset)
     search = ps_find_search(ps, "ngram");
     if (search == NULL) {
         /* Initialize N-Gram search. */
-        search = ngram_search_init(ps->config, ps->acmod, ps->dict, ps->d2p);
+        search = ngram_search_init(NULL, ps->config, ps->acmod, ps->dict, ps->d2p);
         if (search == NULL)
             return NULL;
         search->pls = ps->phone_loop;
@@ -687,7 +758,7 @@ ps_search_forward(ps_decoder_t *ps)
     int nfr;
 
     nfr = 0;
-    while (ps->acmod->n_feat_frame > 0) {
+    while (acmod_n_ready(ps->acmod) > 0) {
         int k;
         if (ps->phone_loop)
             if ((k = ps_search_step(ps->phone_loop, ps->acmod->output_frame)) < 0)
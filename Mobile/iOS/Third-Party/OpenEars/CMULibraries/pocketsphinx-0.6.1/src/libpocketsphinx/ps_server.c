@@ -0,0 +1,412 @@
+/* -*- c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/* ====================================================================
+ * Copyright (c) 2010 Carnegie Mellon University.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer. 
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This work was supported in part by funding from the Defense Advanced 
+ * Research Projects Agency and the National Science Foundation of the 
+ * United States of America, and the CMU Sphinx Speech Consortium.
+ *
+ * THIS SOFTWARE IS PROVIDED BY CARNEGIE MELLON UNIVERSITY ``AS IS'' AND 
+ * ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL CARNEGIE MELLON UNIVERSITY
+ * NOR ITS EMPLOYEES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ====================================================================
+ *
+ */
+
+/**
+ * @file ps_server.c Decoding many audio streams on a pool of threads
+ */
+
+/* System headers. */
+#include <string.h>
+
+/* SphinxBase headers. */
+#include <ckd_alloc.h>
+#include <err.h>
+#include <sbthread.h>
+
+/* Local headers. */
+#include "ps_server.h"
+
+/**
+ * Thread decoding streams for a server.
+ */
+typedef struct ps_worker_s ps_worker_t;
+struct ps_worker_s {
+    ps_server_t *server;
+    sbthread_t *thread;
+    sbevent_t *wake;        /**< Signalled when there is work (or to exit). */
+    ps_worker_t *next_idle; /**< Next thread waiting for work. */
+};
+
+struct ps_stream_s {
+    ps_server_t *server;
+    ps_decoder_t *ps;       /**< Decoder sharing the server's models. */
+    ps_stream_cb_t cb;
+    void *user_data;
+
+    int16 *in;              /**< Audio queued by ps_stream_write(). */
+    size_t n_in, n_in_alloc;
+    size_t *ends;           /**< Positions in in where utterances end. */
+    int n_ends, n_ends_alloc;
+    int16 *work;            /**< Audio being decoded. */
+    size_t n_work_alloc;
+
+    int in_utt;             /**< Has the decoder started an utterance? */
+    int closing;            /**< Free once the queued audio is decoded. */
+    int queued;             /**< Is it on the ready list? */
+    int busy;               /**< Is a thread decoding it? */
+
+    ps_stream_t *next_ready;
+    ps_stream_t *prev, *next; /**< List of all streams. */
+};
+
+struct ps_server_s {
+    cmd_ln_t *config;       /**< Until the decoder takes it over. */
+    ps_decoder_t *ps;       /**< Decoder owning the models. */
+    ps_worker_t *workers;
+    int n_workers;
+    sbmtx_t *share_mtx;     /**< Held while creating or freeing decoders. */
+
+    /* Everything below is protected by mtx. */
+    sbmtx_t *mtx;
+    ps_stream_t *streams;
+    ps_stream_t *ready, *ready_tail;
+    ps_worker_t *idle;
+    int exiting;
+};
+
+/* Put a stream with something to do on the ready list, if a thread
+ * isn't already going to look at it, and wake up a thread for it.
+ * Must be called with the server locked. */
+static void
+ps_stream_enqueue(ps_stream_t *stream)
+{
+    ps_server_t *server = stream->server;
+    ps_worker_t *w;
+
+    if (stream->busy || stream->queued)
+        return;
+    stream->queued = TRUE;
+    stream->next_ready = NULL;
+    if (server->ready_tail)
+        server->ready_tail->next_ready = stream;
+    else
+        server->ready = stream;
+    server->ready_tail = stream;
+
+    if ((w = server->idle) != NULL) {
+        server->idle = w->next_idle;
+        sbevent_signal(w->wake);
+    }
+}
+
+/* Must be called with the server locked. */
+static ps_stream_t *
+ps_stream_dequeue(ps_server_t *server)
+{
+    ps_stream_t *stream;
+
+    if ((stream = server->ready) == NULL)
+        return NULL;
+    server->ready = stream->next_ready;
+    if (server->ready == NULL)
+        server->ready_tail = NULL;
+    stream->queued = FALSE;
+    stream->busy = TRUE;
+    return stream;
+}
+
+static void
+ps_stream_free(ps_stream_t *stream)
+{
+    ps_server_t *server = stream->server;
+
+    sbmtx_lock(server->mtx);
+    if (stream->prev)
+        stream->prev->next = stream->next;
+    else
+        server->streams = stream->next;
+    if (stream->next)
+        stream->next->prev = stream->prev;
+    sbmtx_unlock(server->mtx);
+
+    sbmtx_lock(server->share_mtx);
+    ps_free(stream->ps);
+    sbmtx_unlock(server->share_mtx);
+    ckd_free(stream->in);
+    ckd_free(stream->ends);
+    ckd_free(stream->work);
+    ckd_free(stream);
+}
+
+/* Decode the audio queued for a stream, up to the end of the first
+ * utterance in it if that was ended. */
+static void
+ps_stream_decode(ps_stream_t *stream)
+{
+    ps_server_t *server = stream->server;
+    size_t n_samples;
+    int i, end_utt, closing;
+
+    sbmtx_lock(server->mtx);
+    end_utt = (stream->n_ends > 0);
+    n_samples = end_utt ? stream->ends[0] : stream->n_in;
+    if (n_samples > stream->n_work_alloc) {
+        stream->n_work_alloc = n_samples;
+        stream->work = ckd_realloc(stream->work,
+                                   n_samples * sizeof(*stream->work));
+    }
+    memcpy(stream->work, stream->in, n_samples * sizeof(*stream->in));
+    memmove(stream->in, stream->in + n_samples,
+            (stream->n_in - n_samples) * sizeof(*stream->in));
+    stream->n_in -= n_samples;
+    if (end_utt) {
+        for (i = 1; i < stream->n_ends; ++i)
+            stream->ends[i - 1] = stream->ends[i] - n_samples;
+        --stream->n_ends;
+    }
+    closing = stream->closing && stream->n_in == 0 && stream->n_ends == 0;
+    sbmtx_unlock(server->mtx);
+
+    if (n_samples > 0) {
+        if (!stream->in_utt) {
+            if (ps_start_utt(stream->ps, NULL) < 0)
+                E_ERROR("Failed to start utterance\n");
+            stream->in_utt = TRUE;
+        }
+        if (ps_process_raw(stream->ps, stream->work, n_samples,
+                           FALSE, FALSE) < 0)
+            E_ERROR("Failed to decode %lu samples\n",
+                    (unsigned long)n_samples);
+    }
+    /* An utterance ended with no audio in it has no results. */
+    if (end_utt && stream->in_utt) {
+        ps_end_utt(stream->ps);
+        stream->in_utt = FALSE;
+        if (stream->cb)
+            (*stream->cb)(stream, stream->ps, stream->user_data);
+    }
+
+    if (closing) {
+        if (stream->in_utt)
+            ps_end_utt(stream->ps);
+        ps_stream_free(stream);
+        return;
+    }
+
+    /* Go back on the list if anything else is queued. */
+    sbmtx_lock(server->mtx);
+    stream->busy = FALSE;
+    if (stream->n_in || stream->n_ends || stream->closing)
+        ps_stream_enqueue(stream);
+    sbmtx_unlock(server->mtx);
+}
+
+static int
+ps_server_worker(sbthread_t *th)
+{
+    ps_worker_t *w = sbthread_arg(th);
+    ps_server_t *server = w->server;
+
+    while (TRUE) {
+        ps_stream_t *stream;
+
+        sbmtx_lock(server->mtx);
+        if (server->exiting) {
+            sbmtx_unlock(server->mtx);
+            break;
+        }
+        if ((stream = ps_stream_dequeue(server)) == NULL) {
+            w->next_idle = server->idle;
+            server->idle = w;
+            sbmtx_unlock(server->mtx);
+            sbevent_wait(w->wake, -1, -1);
+            continue;
+        }
+        sbmtx_unlock(server->mtx);
+        ps_stream_decode(stream);
+    }
+    return 0;
+}
+
+ps_server_t *
+ps_server_init(cmd_ln_t *config, int n_threads)
+{
+    ps_server_t *server;
+    int i;
+
+    server = ckd_calloc(1, sizeof(*server));
+    server->config = config;
+    if ((server->mtx = sbmtx_init()) == NULL
+        || (server->share_mtx = sbmtx_init()) == NULL)
+        goto error_out;
+
+    /* Load the models that all the streams will share. */
+    if (cmd_ln_int32_r(config, "-scorethreads") > 0) {
+        E_INFO("Decoding streams on %d threads instead of -scorethreads\n",
+               n_threads);
+        cmd_ln_set_int32_r(config, "-scorethreads", 0);
+    }
+    /* The decoder owns config from here on, even if this fails. */
+    server->config = NULL;
+    if ((server->ps = ps_init(config)) == NULL)
+        goto error_out;
+
+    if (n_threads < 1)
+        n_threads = 1;
+    server->workers = ckd_calloc(n_threads, sizeof(*server->workers));
+    for (i = 0; i < n_threads; ++i) {
+        ps_worker_t *w = server->workers + i;
+
+        w->server = server;
+        if ((w->wake = sbevent_init()) == NULL)
+            goto error_out;
+        if ((w->thread = sbthread_start(config, ps_server_worker, w)) == NULL) {
+            sbevent_free(w->wake);
+            goto error_out;
+        }
+        ++server->n_workers;
+    }
+    return server;
+
+error_out:
+    ps_server_free(server);
+    return NULL;
+}
+
+void
+ps_server_free(ps_server_t *server)
+{
+    int i;
+
+    if (server == NULL)
+        return;
+
+    if (server->workers) {
+        sbmtx_lock(server->mtx);
+        server->exiting = TRUE;
+        sbmtx_unlock(server->mtx);
+        for (i = 0; i < server->n_workers; ++i)
+            sbevent_signal(server->workers[i].wake);
+        for (i = 0; i < server->n_workers; ++i) {
+            sbthread_wait(server->workers[i].thread);
+            sbthread_free(server->workers[i].thread);
+            sbevent_free(server->workers[i].wake);
+        }
+        ckd_free(server->workers);
+    }
+    while (server->streams)
+        ps_stream_free(server->streams);
+
+    ps_free(server->ps);
+    cmd_ln_free_r(server->config);
+    if (server->mtx)
+        sbmtx_free(server->mtx);
+    if (server->share_mtx)
+        sbmtx_free(server->share_mtx);
+    ckd_free(server);
+}
+
+ps_stream_t *
+ps_stream_open(ps_server_t *server, ps_stream_cb_t cb, void *user_data)
+{
+    ps_stream_t *stream;
+
+    stream = ckd_calloc(1, sizeof(*stream));
+    stream->server = server;
+    stream->cb = cb;
+    stream->user_data = user_data;
+    sbmtx_lock(server->share_mtx);
+    stream->ps = ps_init_shared(server->ps);
+    sbmtx_unlock(server->share_mtx);
+    if (stream->ps == NULL) {
+        ckd_free(stream);
+        return NULL;
+    }
+
+    sbmtx_lock(server->mtx);
+    stream->next = server->streams;
+    if (server->streams)
+        server->streams->prev = stream;
+    server->streams = stream;
+    sbmtx_unlock(server->mtx);
+    return stream;
+}
+
+int
+ps_stream_write(ps_stream_t *stream, int16 const *data, size_t n_samples)
+{
+    ps_server_t *server = stream->server;
+
+    sbmtx_lock(server->mtx);
+    if (stream->closing) {
+        sbmtx_unlock(server->mtx);
+        return -1;
+    }
+    if (stream->n_in + n_samples > stream->n_in_alloc) {
+        stream->n_in_alloc = stream->n_in + n_samples;
+        stream->in = ckd_realloc(stream->in,
+                                 stream->n_in_alloc * sizeof(*stream->in));
+    }
+    memcpy(stream->in + stream->n_in, data, n_samples * sizeof(*data));
+    stream->n_in += n_samples;
+    ps_stream_enqueue(stream);
+    sbmtx_unlock(server->mtx);
+    return 0;
+}
+
+int
+ps_stream_end_utt(ps_stream_t *stream)
+{
+    ps_server_t *server = stream->server;
+
+    sbmtx_lock(server->mtx);
+    if (stream->closing) {
+        sbmtx_unlock(server->mtx);
+        return -1;
+    }
+    if (stream->n_ends == stream->n_ends_alloc) {
+        stream->n_ends_alloc = stream->n_ends_alloc
+            ? stream->n_ends_alloc * 2 : 4;
+        stream->ends = ckd_realloc(stream->ends,
+                                   stream->n_ends_alloc * sizeof(*stream->ends));
+    }
+    stream->ends[stream->n_ends++] = stream->n_in;
+    ps_stream_enqueue(stream);
+    sbmtx_unlock(server->mtx);
+    return 0;
+}
+
+void
+ps_stream_close(ps_stream_t *stream)
+{
+    ps_server_t *server = stream->server;
+
+    sbmtx_lock(server->mtx);
+    stream->closing = TRUE;
+    ps_stream_enqueue(stream);
+    sbmtx_unlock(server->mtx);
+}
@@ -70,7 +70,11 @@ static ps_mgaufuncs_t ptm_mgau_funcs = {
     "ptm",
     &ptm_mgau_frame_eval,      /* frame_eval */
     &ptm_mgau_mllr_transform,  /* transform */
-    &ptm_mgau_free             /* free */
+    &ptm_mgau_free,            /* free */
+    &ptm_mgau_frame_prep,      /* frame_prep */
+    &ptm_mgau_senone_eval,     /* senone_eval */
+    &ptm_mgau_senone_norm,     /* senone_norm */
+    &ptm_mgau_copy             /* copy */
 };
 
 #define COMPUTE_GMM_MAP(_idx)                           \
@@ -161,76 +165,62 @@ static int
 eval_cb(ptm_mgau_t *s, int cb, int feat, mfcc_t *z)
 {
     ptm_topn_t *worst, *best, *topn;
-    mfcc_t *mean;
-    mfcc_t *var, *det, *detP, *detE;
-    int32 i, ceplen;
+    mfcc_t *blk;
+    int32 i, cw, ceplen;
 
     best = topn = s->f->topn[cb][feat];
     worst = topn + (s->max_topn - 1);
-    mean = s->g->mean[cb][feat][0];
-    var = s->g->var[cb][feat][0];
-    det = s->g->det[cb][feat];
-    detE = det + s->g->n_density;
+    blk = s->blocks[cb][feat];
     ceplen = s->g->featlen[feat];
 
-    for (detP = det; detP < detE; ++detP) {
-        mfcc_t diff[4], sqdiff[4], compl[4]; /* diff, diff^2, component likelihood */
-        mfcc_t d, thresh;
-        mfcc_t *obs;
-        ptm_topn_t *cur;
-        int32 cw, j;
-
-        d = *detP;
-        thresh = (mfcc_t) worst->score; /* Avoid int-to-float conversions */
-        obs = z;
-        cw = detP - det;
-
-        /* Unroll the loop starting with the first dimension(s).  In
-         * theory this might be a bit faster if this Gaussian gets
-         * "knocked out" by C0. In practice not. */
-        for (j = 0; (j < ceplen % 4) && (d >= thresh); ++j) {
-            diff[0] = *obs++ - *mean++;
-            sqdiff[0] = MFCCMUL(diff[0], diff[0]);
-            compl[0] = MFCCMUL(sqdiff[0], *var++);
-            d = GMMSUB(d, compl[0]);
-        }
-        /* Now do 4 dimensions at a time.  You'd think that GCC would
-         * vectorize this?  Apparently not.  And it's right, because
-         * that won't make this any faster, at least on x86-64. */
-        for (; j < ceplen && d >= thresh; j += 4) {
-            COMPUTE_GMM_MAP(0);
-            COMPUTE_GMM_MAP(1);
-            COMPUTE_GMM_MAP(2);
-            COMPUTE_GMM_MAP(3);
-            COMPUTE_GMM_REDUCE(0);
-            COMPUTE_GMM_REDUCE(1);
-            COMPUTE_GMM_REDUCE(2);
-            COMPUTE_GMM_REDUCE(3);
-            var += 4;
-            obs += 4;
-            mean += 4;
-        }
-        if (j < ceplen) {
-            /* terminated early, so not in topn */
-            mean += (ceplen - j);
-            var += (ceplen - j);
-            continue;
-        }
-        if (d < thresh)
-            continue;
-        for (i = 0; i < s->max_topn; i++) {
-            /* already there, so don't need to insert */
-            if (topn[i].cw == cw)
-                break;
+    for (cw = 0; cw < s->g->n_density;
+         cw += MGAU_SIMD_WIDTH, blk += MGAU_BLOCK_SIZE(ceplen)) {
+        mfcc_t dist[MGAU_SIMD_WIDTH];
+        int32 k, n_cw;
+
+        /* Each codeword in the block is "knocked out" as soon as it
+         * falls below the worst of the top-N, and the block as soon
+         * as all of them have. */
+        mgau_dist_block(blk, z, ceplen, (mfcc_t) worst->score, dist);
+        n_cw = MIN(MGAU_SIMD_WIDTH, s->g->n_density - cw);
+        for (k = 0; k < n_cw; ++k) {
+            ptm_topn_t *cur;
+            mfcc_t d = dist[k];
+
+            if (d < (mfcc_t) worst->score)
+                continue;
+            for (i = 0; i < s->max_topn; i++) {
+                /* already there, so don't need to insert */
+                if (topn[i].cw == cw + k)
+                    break;
+            }
+            if (i < s->max_topn)
+                continue;       /* already there.  Don't insert */
+            insertion_sort_cb(&cur, worst, best, cw + k, (int32)d);
         }
-        if (i < s->max_topn)
-            continue;       /* already there.  Don't insert */
-        insertion_sort_cb(&cur, worst, best, cw, (int32)d);
     }
 
     return best->score;
 }
 
+static void
+interleave_codebooks(ptm_mgau_t *s)
+{
+    int i, j;
+
+    if (s->blocks == NULL)
+        s->blocks = (mfcc_t ***)ckd_calloc_2d(s->g->n_mgau, s->g->n_feat,
+                                              sizeof(**s->blocks));
+    for (i = 0; i < s->g->n_mgau; ++i) {
+        for (j = 0; j < s->g->n_feat; ++j) {
+            ckd_free(s->blocks[i][j]);
+            s->blocks[i][j] = mgau_interleave(s->g->mean[i][j], s->g->var[i][j],
+                                              s->g->det[i][j], s->g->n_density,
+                                              s->g->featlen[j]);
+        }
+    }
+}
+
 /**
  * Compute top-N densities for active codebooks (and prune)
  */
@@ -318,55 +308,113 @@ ptm_mgau_calc_cb_active(ptm_mgau_t *s, uint8 *senone_active,
     return 0;
 }
 
+/**
+ * Compute the top-N codewords for every active codebook.
+ */
+int
+ptm_mgau_frame_prep(ps_mgau_t *ps,
+                    uint8 *senone_active,
+                    int32 n_senone_active,
+                    mfcc_t ** featbuf, int32 frame,
+                    int32 compallsen)
+{
+    ptm_mgau_t *s = (ptm_mgau_t *)ps;
+    int fast_eval_idx;
+    int i, lastsen;
+
+    /* Find the appropriate frame in the rotating history buffer
+     * corresponding to the requested input frame.  No bounds checking
+     * is done here, which just means you'll get semi-random crap if
+     * you request a frame in the future or one that's too far in the
+     * past.  Since the history buffer is just used for fast match
+     * that might not be fatal. */
+    fast_eval_idx = frame % s->n_fast_hist;
+    s->f = s->hist + fast_eval_idx;
+    /* Compute the top-N codewords for every codebook, unless this
+     * is a past frame, in which case we already have them (we
+     * hope!) */
+    if (frame >= ps_mgau_base(ps)->frame_idx) {
+        ptm_fast_eval_t *lastf;
+        /* Get the previous frame's top-N information (on the
+         * first frame of the input this is just all WORST_DIST,
+         * no harm in that) */
+        if (fast_eval_idx == 0)
+            lastf = s->hist + s->n_fast_hist - 1;
+        else
+            lastf = s->hist + fast_eval_idx - 1;
+        /* Copy in initial top-N info */
+        memcpy(s->f->topn[0][0], lastf->topn[0][0],
+               s->g->n_mgau * s->g->n_feat * s->max_topn * sizeof(ptm_topn_t));
+        /* Generate initial active codebook list (this might not be
+         * necessary) */
+        ptm_mgau_calc_cb_active(s, senone_active, n_senone_active, compallsen);
+        /* Now evaluate top-N, prune, and evaluate remaining codebooks. */
+        ptm_mgau_codebook_eval(s, featbuf, frame);
+        return 0;
+    }
+
+    /* Otherwise senones may now be active whose codebooks weren't
+     * then.  Because senone_active is deltas we can't really "knock
+     * out" senones from pruned codebooks, and in any case, it
+     * wouldn't make any difference to the search code, which doesn't
+     * expect senone_active to change. */
+    if (compallsen)
+        n_senone_active = s->n_sen;
+    for (lastsen = i = 0; i < n_senone_active; ++i) {
+        int sen, f, j, cb;
+
+        if (compallsen)
+            sen = i;
+        else
+            sen = senone_active[i] + lastsen;
+        lastsen = sen;
+        cb = s->sen2cb[sen];
+        if (bitvec_is_set(s->f->mgau_active, cb))
+            continue;
+        for (f = 0; f < s->g->n_feat; ++f)
+            for (j = 0; j < s->max_topn; ++j)
+                s->f->topn[cb][f][j].score = MAX_NEG_ASCR;
+    }
+
+    return 0;
+}
+
 /**
  * Compute senone scores from top-N densities for active codebooks.
  */
-static int
-ptm_mgau_senone_eval(ptm_mgau_t *s, int16 *senone_scores,
+int
+ptm_mgau_senone_eval(ps_mgau_t *ps, int16 *senone_scores,
                      uint8 *senone_active, int32 n_senone_active,
-                     int compall)
+                     int32 first_sen, int32 frame, int32 compall)
 {
+    ptm_mgau_t *s = (ptm_mgau_t *)ps;
+    ptm_fast_eval_t *fe = s->hist + frame % s->n_fast_hist;
     int i, lastsen, bestscore;
 
-    memset(senone_scores, 0, s->n_sen * sizeof(*senone_scores));
     /* FIXME: This is the non-cache-efficient way to do this.  We want
      * to evaluate one codeword at a time but this requires us to have
      * a reverse codebook to senone mapping, which we don't have
      * (yet), since different codebooks have different top-N
      * codewords. */
-    if (compall)
-        n_senone_active = s->n_sen;
     bestscore = 0x7fffffff;
-    for (lastsen = i = 0; i < n_senone_active; ++i) {
+    for (lastsen = first_sen, i = 0; i < n_senone_active; ++i) {
         int sen, f, cb;
         int ascore;
 
         if (compall)
-            sen = i;
+            sen = first_sen + i;
         else
             sen = senone_active[i] + lastsen;
         lastsen = sen;
         cb = s->sen2cb[sen];
 
-        if (bitvec_is_clear(s->f->mgau_active, cb)) {
-            int j;
-            /* Because senone_active is deltas we can't really "knock
-             * out" senones from pruned codebooks, and in any case,
-             * it wouldn't make any difference to the search code,
-             * which doesn't expect senone_active to change. */
-            for (f = 0; f < s->g->n_feat; ++f) {
-                for (j = 0; j < s->max_topn; ++j) {
-                    s->f->topn[cb][f][j].score = MAX_NEG_ASCR;
-                }
-            }
-        }
         /* For each feature, log-sum codeword scores + mixw to get
          * feature density, then sum (multiply) to get ascore */
         ascore = 0;
         for (f = 0; f < s->g->n_feat; ++f) {
             ptm_topn_t *topn;
             int j, fden = 0;
-            topn = s->f->topn[cb][f];
+            topn = fe->topn[cb][f];
             for (j = 0; j < s->max_topn; ++j) {
                 int mixw;
                 /* Find mixture weight for this codeword. */
@@ -391,13 +439,23 @@ ptm_mgau_senone_eval(ptm_mgau_t *s, int16 *senone_scores,
         if (ascore < bestscore) bestscore = ascore;
         senone_scores[sen] = ascore;
     }
-    /* Normalize the scores again (finishing the job we started above
-     * in ptm_mgau_codebook_eval...) */
+
+    return bestscore;
+}
+
+/**
+ * Normalize senone scores by the best one over all active senones
+ * (finishing the job we started in ptm_mgau_codebook_eval...)
+ */
+void
+ptm_mgau_senone_norm(ps_mgau_t *ps, int16 *senone_scores, int32 best)
+{
+    ptm_mgau_t *s = (ptm_mgau_t *)ps;
+    int i;
+
     for (i = 0; i < s->n_sen; ++i) {
-        senone_scores[i] -= bestscore;
+        senone_scores[i] -= best;
     }
-
-    return 0;
 }
 
 /**
@@ -412,40 +470,16 @@ ptm_mgau_frame_eval(ps_mgau_t *ps,
                     int32 compallsen)
 {
     ptm_mgau_t *s = (ptm_mgau_t *)ps;
-    int fast_eval_idx;
+    int bestscore;
 
-    /* Find the appropriate frame in the rotating history buffer
-     * corresponding to the requested input frame.  No bounds checking
-     * is done here, which just means you'll get semi-random crap if
-     * you request a frame in the future or one that's too far in the
-     * past.  Since the history buffer is just used for fast match
-     * that might not be fatal. */
-    fast_eval_idx = frame % s->n_fast_hist;
-    s->f = s->hist + fast_eval_idx;
-    /* Compute the top-N codewords for every codebook, unless this
-     * is a past frame, in which case we already have them (we
-     * hope!) */
-    if (frame >= ps_mgau_base(ps)->frame_idx) {
-        ptm_fast_eval_t *lastf;
-        /* Get the previous frame's top-N information (on the
-         * first frame of the input this is just all WORST_DIST,
-         * no harm in that) */
-        if (fast_eval_idx == 0)
-            lastf = s->hist + s->n_fast_hist - 1;
-        else
-            lastf = s->hist + fast_eval_idx - 1;
-        /* Copy in initial top-N info */
-        memcpy(s->f->topn[0][0], lastf->topn[0][0],
-               s->g->n_mgau * s->g->n_feat * s->max_topn * sizeof(ptm_topn_t));
-        /* Generate initial active codebook list (this might not be
-         * necessary) */
-        ptm_mgau_calc_cb_active(s, senone_active, n_senone_active, compallsen);
-        /* Now evaluate top-N, prune, and evaluate remaining codebooks. */
-        ptm_mgau_codebook_eval(s, featbuf, frame);
-    }
+    memset(senone_scores, 0, s->n_sen * sizeof(*senone_scores));
+    ptm_mgau_frame_prep(ps, senone_active, n_senone_active,
+                        featbuf, frame, compallsen);
     /* Evaluate intersection of active senones and active codebooks. */
-    ptm_mgau_senone_eval(s, senone_scores, senone_active,
-                         n_senone_active, compallsen);
+    bestscore = ptm_mgau_senone_eval(ps, senone_scores, senone_active,
+                                     compallsen ? s->n_sen : n_senone_active,
+                                     0, frame, compallsen);
+    ptm_mgau_senone_norm(ps, senone_scores, bestscore);
 
     return 0;
 }
@@ -588,17 +622,27 @@ read_sendump(ptm_mgau_t *s, bin_mdef_t *mdef, char const *file)
         goto error_out;
     }
 
-    if (do_mmap) {
-            E_INFO("Using memory-mapped I/O for senones\n");
-    }
     offset = ftell(fp);
     fseek(fp, 0, SEEK_END);
     filesize = ftell(fp);
     fseek(fp, offset, SEEK_SET);
 
+    /* Make sure it's all there before pointing into a mapping of it. */
+    n = (n_bits == 4) ? (c + 1) / 2 : c;
+    if (offset + n_clust + (size_t)n_feat * r * n > filesize) {
+        E_ERROR("Dump file %s is truncated (%ld bytes, expected %ld)\n",
+                file, (long)filesize,
+                (long)(offset + n_clust + (size_t)n_feat * r * n));
+        goto error_out;
+    }
+
     /* Allocate memory for pdfs (or memory map them) */
     if (do_mmap) {
-        s->sendump_mmap = mmio_file_read(file);
+        if ((s->sendump_mmap = mmio_file_read(file)) == NULL)
+            E_WARN("Failed to memory-map %s, will read it instead\n", file);
+    }
+    if (s->sendump_mmap) {
+        E_INFO("Using memory-mapped I/O for senones\n");
         /* Get cluster codebook if any. */
         if (n_clust) {
             s->mixw_cb = ((uint8 *) mmio_file_ptr(s->sendump_mmap)) + offset;
@@ -766,6 +810,58 @@ read_mixw(ptm_mgau_t * s, char const *file_name, double SmoothMin)
     return n_sen;
 }
 
+static void
+init_fast_hist(ptm_mgau_t *s)
+{
+    int i;
+
+    /* Allocate fast-match history buffers.  We need enough for the
+     * phoneme lookahead window, plus the current frame, plus one for
+     * good measure? (FIXME: I don't remember why), plus the rest of
+     * a batch of frames scored ahead (see acmod_score()). */
+    s->n_fast_hist = cmd_ln_int32_r(s->config, "-pl_window") + 2;
+    if (cmd_ln_int32_r(s->config, "-scorebatch") > 1)
+        s->n_fast_hist += cmd_ln_int32_r(s->config, "-scorebatch") - 1;
+    s->hist = ckd_calloc(s->n_fast_hist, sizeof(*s->hist));
+    /* s->f will be a rotating pointer into s->hist. */
+    s->f = s->hist;
+    for (i = 0; i < s->n_fast_hist; ++i) {
+        int j, k, m;
+        /* Top-N codewords for every codebook and feature. */
+        s->hist[i].topn = ckd_calloc_3d(s->g->n_mgau, s->g->n_feat,
+                                        s->max_topn, sizeof(ptm_topn_t));
+        /* Initialize them to sane (yet arbitrary) defaults. */
+        for (j = 0; j < s->g->n_mgau; ++j) {
+            for (k = 0; k < s->g->n_feat; ++k) {
+                for (m = 0; m < s->max_topn; ++m) {
+                    s->hist[i].topn[j][k][m].cw = m;
+                    s->hist[i].topn[j][k][m].score = WORST_DIST;
+                }
+            }
+        }
+        /* Active codebook mapping (just codebook, not features,
+           at least not yet) */
+        s->hist[i].mgau_active = bitvec_alloc(s->g->n_mgau);
+        /* Start with them all on, prune them later. */
+        bitvec_set_all(s->hist[i].mgau_active, s->g->n_mgau);
+    }
+
+}
+
+static void
+free_fast_hist(ptm_mgau_t *s)
+{
+    int i;
+
+    if (s->hist == NULL)
+        return;
+    for (i = 0; i < s->n_fast_hist; ++i) {
+        ckd_free_3d(s->hist[i].topn);
+        bitvec_free(s->hist[i].mgau_active);
+    }
+    ckd_free(s->hist);
+}
+
 ps_mgau_t *
 ptm_mgau_init(acmod_t *acmod)
 {
@@ -775,6 +871,7 @@ ptm_mgau_init(acmod_t *acmod)
     int i;
 
     s = ckd_calloc(1, sizeof(*s));
+    ps_mgau_base(s)->refcnt = 1;
     s->config = acmod->config;
 
     s->lmath = logmath_retain(acmod->lmath);
@@ -826,6 +923,7 @@ ptm_mgau_init(acmod_t *acmod)
             goto error_out;
         }
     }
+    interleave_codebooks(s);
     s->ds_ratio = cmd_ln_int32_r(s->config, "-ds");
     s->max_topn = cmd_ln_int32_r(s->config, "-topn");
     E_INFO("Maximum top-N: %d\n", s->max_topn);
@@ -836,33 +934,7 @@ ptm_mgau_init(acmod_t *acmod)
     for (i = 0; i < s->n_sen; ++i)
         s->sen2cb[i] = bin_mdef_sen2cimap(acmod->mdef, i);
 
-    /* Allocate fast-match history buffers.  We need enough for the
-     * phoneme lookahead window, plus the current frame, plus one for
-     * good measure? (FIXME: I don't remember why) */
-    s->n_fast_hist = cmd_ln_int32_r(s->config, "-pl_window") + 2;
-    s->hist = ckd_calloc(s->n_fast_hist, sizeof(*s->hist));
-    /* s->f will be a rotating pointer into s->hist. */
-    s->f = s->hist;
-    for (i = 0; i < s->n_fast_hist; ++i) {
-        int j, k, m;
-        /* Top-N codewords for every codebook and feature. */
-        s->hist[i].topn = ckd_calloc_3d(s->g->n_mgau, s->g->n_feat,
-                                        s->max_topn, sizeof(ptm_topn_t));
-        /* Initialize them to sane (yet arbitrary) defaults. */
-        for (j = 0; j < s->g->n_mgau; ++j) {
-            for (k = 0; k < s->g->n_feat; ++k) {
-                for (m = 0; m < s->max_topn; ++m) {
-                    s->hist[i].topn[j][k][m].cw = m;
-                    s->hist[i].topn[j][k][m].score = WORST_DIST;
-                }
-            }
-        }
-        /* Active codebook mapping (just codebook, not features,
-           at least not yet) */
-        s->hist[i].mgau_active = bitvec_alloc(s->g->n_mgau);
-        /* Start with them all on, prune them later. */
-        bitvec_set_all(s->hist[i].mgau_active, s->g->n_mgau);
-    }
+    init_fast_hist(s);
 
     ps = (ps_mgau_t *)s;
     ps->vt = &ptm_mgau_funcs;
@@ -877,13 +949,48 @@ ptm_mgau_mllr_transform(ps_mgau_t *ps,
                             ps_mllr_t *mllr)
 {
     ptm_mgau_t *s = (ptm_mgau_t *)ps;
-    return gauden_mllr_transform(s->g, mllr, s->config);
+    int rv;
+
+    rv = gauden_mllr_transform(s->g, mllr, s->config);
+    interleave_codebooks(s);
+    return rv;
+}
+
+ps_mgau_t *
+ptm_mgau_copy(ps_mgau_t *ps)
+{
+    ptm_mgau_t *other, *s;
+
+    /* Always share the parameters of the model that owns them. */
+    if (ps->shared)
+        ps = ps->shared;
+    other = (ptm_mgau_t *)ps;
+
+    s = ckd_malloc(sizeof(*s));
+    *s = *other;
+    ps_mgau_base(s)->frame_idx = 0;
+    ps_mgau_base(s)->refcnt = 1;
+    ps_mgau_base(s)->shared = ps;
+    ++ps->refcnt;
+    init_fast_hist(s);
+    return ps_mgau_base(s);
 }
 
 void
 ptm_mgau_free(ps_mgau_t *ps)
 {
     ptm_mgau_t *s = (ptm_mgau_t *)ps;
+    int i, j;
+
+    if (--ps->refcnt > 0)
+        return;
+    free_fast_hist(s);
+    /* A copy owns nothing else. */
+    if (ps->shared) {
+        ptm_mgau_free(ps->shared);
+        ckd_free(s);
+        return;
+    }
 
     logmath_free(s->lmath);
     logmath_free(s->lmath_8b);
@@ -893,8 +1000,15 @@ ptm_mgau_free(ps_mgau_t *ps)
     }
     else {
         ckd_free_3d(s->mixw);
+        ckd_free(s->mixw_cb);
     }
     ckd_free(s->sen2cb);
+    if (s->blocks) {
+        for (i = 0; i < s->g->n_mgau; ++i)
+            for (j = 0; j < s->g->n_feat; ++j)
+                ckd_free(s->blocks[i][j]);
+        ckd_free_2d(s->blocks);
+    }
     gauden_free(s->g);
     ckd_free(s);
 }
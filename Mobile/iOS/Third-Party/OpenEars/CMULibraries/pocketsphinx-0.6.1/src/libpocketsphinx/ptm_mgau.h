@@ -69,6 +69,7 @@ struct ptm_mgau_s {
     ps_mgau_t base;     /**< base structure. */
     cmd_ln_t *config;   /**< Configuration parameters */
     gauden_t *g;        /**< Set of Gaussians. */
+    mfcc_t ***blocks;   /**< Codebooks interleaved for eval_cb() (mgau x feature) */
     int32 n_sen;       /**< Number of senones. */
     uint8 *sen2cb;     /**< Senone to codebook mapping. */
     uint8 ***mixw;     /**< Mixture weight distributions by feature, codeword, senone */
@@ -88,6 +89,7 @@ struct ptm_mgau_s {
 };
 
 ps_mgau_t *ptm_mgau_init(acmod_t *acmod);
+ps_mgau_t *ptm_mgau_copy(ps_mgau_t *s);
 void ptm_mgau_free(ps_mgau_t *s);
 int ptm_mgau_frame_eval(ps_mgau_t *s,
                         int16 *senone_scores,
@@ -96,6 +98,22 @@ int ptm_mgau_frame_eval(ps_mgau_t *s,
                         mfcc_t **featbuf,
                         int32 frame,
                         int32 compallsen);
+int ptm_mgau_frame_prep(ps_mgau_t *s,
+                        uint8 *senone_active,
+                        int32 n_senone_active,
+                        mfcc_t **featbuf,
+                        int32 frame,
+                        int32 compallsen);
+int ptm_mgau_senone_eval(ps_mgau_t *s,
+                         int16 *senone_scores,
+                         uint8 *senone_active,
+                         int32 n_senone_active,
+                         int32 first_sen,
+                         int32 frame,
+                         int32 compallsen);
+void ptm_mgau_senone_norm(ps_mgau_t *s,
+                          int16 *senone_scores,
+                          int32 best);
 int ptm_mgau_mllr_transform(ps_mgau_t *s,
                             ps_mllr_t *mllr);
 
@@ -69,7 +69,11 @@ static ps_mgaufuncs_t s2_semi_mgau_funcs = {
     "s2_semi",
     &s2_semi_mgau_frame_eval,      /* frame_eval */
     &s2_semi_mgau_mllr_transform,  /* transform */
-    &s2_semi_mgau_free             /* free */
+    &s2_semi_mgau_free,            /* free */
+    &s2_semi_mgau_frame_prep,      /* frame_prep */
+    &s2_semi_mgau_senone_eval,     /* senone_eval */
+    NULL,                          /* senone_norm */
+    &s2_semi_mgau_copy             /* copy */
 };
 
 struct vqFeature_s {
@@ -120,56 +124,56 @@ static void
 eval_cb(s2_semi_mgau_t *s, int32 feat, mfcc_t *z)
 {
     vqFeature_t *worst, *best, *topn;
-    mfcc_t *mean;
-    mfcc_t *var, *det, *detP, *detE;
-    int32 i, ceplen;
+    mfcc_t *blk;
+    int32 i, cw, ceplen;
 
     best = topn = s->f[feat];
     worst = topn + (s->max_topn - 1);
-    mean = s->means[feat][0];
-    var = s->vars[feat][0];
-    det = s->dets[feat];
-    detE = det + s->n_density;
+    blk = s->blocks[feat];
     ceplen = s->veclen[feat];
 
-    for (detP = det; detP < detE; ++detP) {
-        mfcc_t diff, sqdiff, compl; /* diff, diff^2, component likelihood */
-        mfcc_t d;
-        mfcc_t *obs;
-        vqFeature_t *cur;
-        int32 cw, j;
-
-        d = *detP;
-        obs = z;
-        cw = detP - det;
-        for (j = 0; (j < ceplen) && (d >= worst->score); ++j) {
-            diff = *obs++ - *mean++;
-            sqdiff = MFCCMUL(diff, diff);
-            compl = MFCCMUL(sqdiff, *var);
-            d = GMMSUB(d, compl);
-            ++var;
-        }
-        if (j < ceplen) {
-            /* terminated early, so not in topn */
-            mean += (ceplen - j);
-            var += (ceplen - j);
-            continue;
-        }
-        if ((int32)d < worst->score)
-            continue;
-        for (i = 0; i < s->max_topn; i++) {
-            /* already there, so don't need to insert */
-            if (topn[i].codeword == cw)
-                break;
+    for (cw = 0; cw < s->n_density;
+         cw += MGAU_SIMD_WIDTH, blk += MGAU_BLOCK_SIZE(ceplen)) {
+        mfcc_t dist[MGAU_SIMD_WIDTH];
+        int32 k, n_cw;
+
+        mgau_dist_block(blk, z, ceplen, (mfcc_t)worst->score, dist);
+        n_cw = MIN(MGAU_SIMD_WIDTH, s->n_density - cw);
+        for (k = 0; k < n_cw; ++k) {
+            vqFeature_t *cur;
+            mfcc_t d = dist[k];
+
+            /* worse than the current top-N (or terminated early) */
+            if (d < worst->score || (int32)d < worst->score)
+                continue;
+            for (i = 0; i < s->max_topn; i++) {
+                /* already there, so don't need to insert */
+                if (topn[i].codeword == cw + k)
+                    break;
+            }
+            if (i < s->max_topn)
+                continue;       /* already there.  Don't insert */
+            /* remaining code inserts codeword and dist in correct spot */
+            for (cur = worst - 1; cur >= best && (int32)d >= cur->score; --cur)
+                memcpy(cur + 1, cur, sizeof(vqFeature_t));
+            ++cur;
+            cur->codeword = cw + k;
+            cur->score = (int32)d;
         }
-        if (i < s->max_topn)
-            continue;       /* already there.  Don't insert */
-        /* remaining code inserts codeword and dist in correct spot */
-        for (cur = worst - 1; cur >= best && (int32)d >= cur->score; --cur)
-            memcpy(cur + 1, cur, sizeof(vqFeature_t));
-        ++cur;
-        cur->codeword = cw;
-        cur->score = (int32)d;
+    }
+}
+
+static void
+interleave_codebooks(s2_semi_mgau_t *s)
+{
+    int32 i;
+
+    if (s->blocks == NULL)
+        s->blocks = ckd_calloc(s->n_feat, sizeof(*s->blocks));
+    for (i = 0; i < s->n_feat; ++i) {
+        ckd_free(s->blocks[i]);
+        s->blocks[i] = mgau_interleave(s->means[i], s->vars[i], s->dets[i],
+                                       s->n_density, s->veclen[i]);
     }
 }
 
@@ -207,34 +211,34 @@ mgau_norm(s2_semi_mgau_t *s, int feat)
 }
 
 static int32
-get_scores_8b_feat_6(s2_semi_mgau_t * s, int i,
+get_scores_8b_feat_6(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2, *pid_cw3, *pid_cw4, *pid_cw5;
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
-    pid_cw3 = s->mixw[i][s->f[i][3].codeword];
-    pid_cw4 = s->mixw[i][s->f[i][4].codeword];
-    pid_cw5 = s->mixw[i][s->f[i][5].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
+    pid_cw3 = s->mixw[i][f[3].codeword];
+    pid_cw4 = s->mixw[i][f[4].codeword];
+    pid_cw5 = s->mixw[i][f[5].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int sen = senone_active[j] + l;
-        int32 tmp = pid_cw0[sen] + s->f[i][0].score;
+        int32 tmp = pid_cw0[sen] + f[0].score;
 
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw1[sen] + s->f[i][1].score);
+                               pid_cw1[sen] + f[1].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw2[sen] + s->f[i][2].score);
+                               pid_cw2[sen] + f[2].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw3[sen] + s->f[i][3].score);
+                               pid_cw3[sen] + f[3].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw4[sen] + s->f[i][4].score);
+                               pid_cw4[sen] + f[4].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw5[sen] + s->f[i][5].score);
+                               pid_cw5[sen] + f[5].score);
 
         senone_scores[sen] += tmp;
         l = sen;
@@ -243,31 +247,31 @@ get_scores_8b_feat_6(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_8b_feat_5(s2_semi_mgau_t * s, int i,
+get_scores_8b_feat_5(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2, *pid_cw3, *pid_cw4;
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
-    pid_cw3 = s->mixw[i][s->f[i][3].codeword];
-    pid_cw4 = s->mixw[i][s->f[i][4].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
+    pid_cw3 = s->mixw[i][f[3].codeword];
+    pid_cw4 = s->mixw[i][f[4].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int sen = senone_active[j] + l;
-        int32 tmp = pid_cw0[sen] + s->f[i][0].score;
+        int32 tmp = pid_cw0[sen] + f[0].score;
 
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw1[sen] + s->f[i][1].score);
+                               pid_cw1[sen] + f[1].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw2[sen] + s->f[i][2].score);
+                               pid_cw2[sen] + f[2].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw3[sen] + s->f[i][3].score);
+                               pid_cw3[sen] + f[3].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw4[sen] + s->f[i][4].score);
+                               pid_cw4[sen] + f[4].score);
 
         senone_scores[sen] += tmp;
         l = sen;
@@ -276,28 +280,28 @@ get_scores_8b_feat_5(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_8b_feat_4(s2_semi_mgau_t * s, int i,
+get_scores_8b_feat_4(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2, *pid_cw3;
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
-    pid_cw3 = s->mixw[i][s->f[i][3].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
+    pid_cw3 = s->mixw[i][f[3].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int sen = senone_active[j] + l;
-        int32 tmp = pid_cw0[sen] + s->f[i][0].score;
+        int32 tmp = pid_cw0[sen] + f[0].score;
 
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw1[sen] + s->f[i][1].score);
+                               pid_cw1[sen] + f[1].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw2[sen] + s->f[i][2].score);
+                               pid_cw2[sen] + f[2].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw3[sen] + s->f[i][3].score);
+                               pid_cw3[sen] + f[3].score);
 
         senone_scores[sen] += tmp;
         l = sen;
@@ -306,25 +310,25 @@ get_scores_8b_feat_4(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_8b_feat_3(s2_semi_mgau_t * s, int i,
+get_scores_8b_feat_3(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2;
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int sen = senone_active[j] + l;
-        int32 tmp = pid_cw0[sen] + s->f[i][0].score;
+        int32 tmp = pid_cw0[sen] + f[0].score;
 
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw1[sen] + s->f[i][1].score);
+                               pid_cw1[sen] + f[1].score);
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw2[sen] + s->f[i][2].score);
+                               pid_cw2[sen] + f[2].score);
 
         senone_scores[sen] += tmp;
         l = sen;
@@ -333,22 +337,22 @@ get_scores_8b_feat_3(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_8b_feat_2(s2_semi_mgau_t * s, int i,
+get_scores_8b_feat_2(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1;
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int sen = senone_active[j] + l;
-        int32 tmp = pid_cw0[sen] + s->f[i][0].score;
+        int32 tmp = pid_cw0[sen] + f[0].score;
 
         tmp = fast_logmath_add(s->lmath_8b, tmp,
-                               pid_cw1[sen] + s->f[i][1].score);
+                               pid_cw1[sen] + f[1].score);
 
         senone_scores[sen] += tmp;
         l = sen;
@@ -357,17 +361,17 @@ get_scores_8b_feat_2(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_8b_feat_1(s2_semi_mgau_t * s, int i,
+get_scores_8b_feat_1(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0;
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    for (l = j = 0; j < n_senone_active; j++) {
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int sen = senone_active[j] + l;
-        int32 tmp = pid_cw0[sen] + s->f[i][0].score;
+        int32 tmp = pid_cw0[sen] + f[0].score;
         senone_scores[sen] += tmp;
         l = sen;
     }
@@ -375,22 +379,22 @@ get_scores_8b_feat_1(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_8b_feat_any(s2_semi_mgau_t * s, int i, int topn,
+get_scores_8b_feat_any(s2_semi_mgau_t * s, int i, vqFeature_t *f, int topn,
                        int16 *senone_scores, uint8 *senone_active,
-                       int32 n_senone_active)
+                       int32 n_senone_active, int32 first_sen)
 {
     int32 j, k, l;
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int sen = senone_active[j] + l;
         uint8 *pid_cw;
         int32 tmp;
-        pid_cw = s->mixw[i][s->f[i][0].codeword];
-        tmp = pid_cw[sen] + s->f[i][0].score;
+        pid_cw = s->mixw[i][f[0].codeword];
+        tmp = pid_cw[sen] + f[0].score;
         for (k = 1; k < topn; ++k) {
-            pid_cw = s->mixw[i][s->f[i][k].codeword];
+            pid_cw = s->mixw[i][f[k].codeword];
             tmp = fast_logmath_add(s->lmath_8b, tmp,
-                                   pid_cw[sen] + s->f[i][k].score);
+                                   pid_cw[sen] + f[k].score);
         }
         senone_scores[sen] += tmp;
         l = sen;
@@ -399,48 +403,50 @@ get_scores_8b_feat_any(s2_semi_mgau_t * s, int i, int topn,
 }
 
 static int32
-get_scores_8b_feat(s2_semi_mgau_t * s, int i, int topn,
-                   int16 *senone_scores, uint8 *senone_active, int32 n_senone_active)
+get_scores_8b_feat(s2_semi_mgau_t * s, int i, vqFeature_t *f, int topn,
+                   int16 *senone_scores, uint8 *senone_active, int32 n_senone_active,
+                   int32 first_sen)
 {
     switch (topn) {
     case 6:
-        return get_scores_8b_feat_6(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_8b_feat_6(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 5:
-        return get_scores_8b_feat_5(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_8b_feat_5(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 4:
-        return get_scores_8b_feat_4(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_8b_feat_4(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 3:
-        return get_scores_8b_feat_3(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_8b_feat_3(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 2:
-        return get_scores_8b_feat_2(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_8b_feat_2(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 1:
-        return get_scores_8b_feat_1(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_8b_feat_1(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     default:
-        return get_scores_8b_feat_any(s, i, topn, senone_scores,
-                                      senone_active, n_senone_active);
+        return get_scores_8b_feat_any(s, i, f, topn, senone_scores,
+                                      senone_active, n_senone_active, first_sen);
     }
 }
 
 static int32
-get_scores_8b_feat_all(s2_semi_mgau_t * s, int i, int topn, int16 *senone_scores)
+get_scores_8b_feat_all(s2_semi_mgau_t * s, int i, vqFeature_t *f, int topn,
+                       int16 *senone_scores, int32 first_sen, int32 last_sen)
 {
     int32 j, k;
 
-    for (j = 0; j < s->n_sen; j++) {
+    for (j = first_sen; j < last_sen; j++) {
         uint8 *pid_cw;
         int32 tmp;
-        pid_cw = s->mixw[i][s->f[i][0].codeword];
-        tmp = pid_cw[j] + s->f[i][0].score;
+        pid_cw = s->mixw[i][f[0].codeword];
+        tmp = pid_cw[j] + f[0].score;
         for (k = 1; k < topn; ++k) {
-            pid_cw = s->mixw[i][s->f[i][k].codeword];
+            pid_cw = s->mixw[i][f[k].codeword];
             tmp = fast_logmath_add(s->lmath_8b, tmp,
-                                   pid_cw[j] + s->f[i][k].score);
+                                   pid_cw[j] + f[k].score);
         }
         senone_scores[j] += tmp;
     }
@@ -448,9 +454,9 @@ get_scores_8b_feat_all(s2_semi_mgau_t * s, int i, int topn, int16 *senone_scores
 }
 
 static int32
-get_scores_4b_feat_6(s2_semi_mgau_t * s, int i,
+get_scores_4b_feat_6(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2, *pid_cw3, *pid_cw4, *pid_cw5;
@@ -458,22 +464,22 @@ get_scores_4b_feat_6(s2_semi_mgau_t * s, int i,
 
     /* Precompute scaled densities. */
     for (j = 0; j < 16; ++j) {
-        w_den[0][j] = s->mixw_cb[j] + s->f[i][0].score;
-        w_den[1][j] = s->mixw_cb[j] + s->f[i][1].score;
-        w_den[2][j] = s->mixw_cb[j] + s->f[i][2].score;
-        w_den[3][j] = s->mixw_cb[j] + s->f[i][3].score;
-        w_den[4][j] = s->mixw_cb[j] + s->f[i][4].score;
-        w_den[5][j] = s->mixw_cb[j] + s->f[i][5].score;
-    }
-
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
-    pid_cw3 = s->mixw[i][s->f[i][3].codeword];
-    pid_cw4 = s->mixw[i][s->f[i][4].codeword];
-    pid_cw5 = s->mixw[i][s->f[i][5].codeword];
-
-    for (l = j = 0; j < n_senone_active; j++) {
+        w_den[0][j] = s->mixw_cb[j] + f[0].score;
+        w_den[1][j] = s->mixw_cb[j] + f[1].score;
+        w_den[2][j] = s->mixw_cb[j] + f[2].score;
+        w_den[3][j] = s->mixw_cb[j] + f[3].score;
+        w_den[4][j] = s->mixw_cb[j] + f[4].score;
+        w_den[5][j] = s->mixw_cb[j] + f[5].score;
+    }
+
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
+    pid_cw3 = s->mixw[i][f[3].codeword];
+    pid_cw4 = s->mixw[i][f[4].codeword];
+    pid_cw5 = s->mixw[i][f[5].codeword];
+
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int n = senone_active[j] + l;
         int tmp, cw;
 
@@ -512,9 +518,9 @@ get_scores_4b_feat_6(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_4b_feat_5(s2_semi_mgau_t * s, int i,
+get_scores_4b_feat_5(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2, *pid_cw3, *pid_cw4;
@@ -522,20 +528,20 @@ get_scores_4b_feat_5(s2_semi_mgau_t * s, int i,
 
     /* Precompute scaled densities. */
     for (j = 0; j < 16; ++j) {
-        w_den[0][j] = s->mixw_cb[j] + s->f[i][0].score;
-        w_den[1][j] = s->mixw_cb[j] + s->f[i][1].score;
-        w_den[2][j] = s->mixw_cb[j] + s->f[i][2].score;
-        w_den[3][j] = s->mixw_cb[j] + s->f[i][3].score;
-        w_den[4][j] = s->mixw_cb[j] + s->f[i][4].score;
+        w_den[0][j] = s->mixw_cb[j] + f[0].score;
+        w_den[1][j] = s->mixw_cb[j] + f[1].score;
+        w_den[2][j] = s->mixw_cb[j] + f[2].score;
+        w_den[3][j] = s->mixw_cb[j] + f[3].score;
+        w_den[4][j] = s->mixw_cb[j] + f[4].score;
     }
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
-    pid_cw3 = s->mixw[i][s->f[i][3].codeword];
-    pid_cw4 = s->mixw[i][s->f[i][4].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
+    pid_cw3 = s->mixw[i][f[3].codeword];
+    pid_cw4 = s->mixw[i][f[4].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int n = senone_active[j] + l;
         int tmp, cw;
 
@@ -570,9 +576,9 @@ get_scores_4b_feat_5(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_4b_feat_4(s2_semi_mgau_t * s, int i,
+get_scores_4b_feat_4(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2, *pid_cw3;
@@ -580,18 +586,18 @@ get_scores_4b_feat_4(s2_semi_mgau_t * s, int i,
 
     /* Precompute scaled densities. */
     for (j = 0; j < 16; ++j) {
-        w_den[0][j] = s->mixw_cb[j] + s->f[i][0].score;
-        w_den[1][j] = s->mixw_cb[j] + s->f[i][1].score;
-        w_den[2][j] = s->mixw_cb[j] + s->f[i][2].score;
-        w_den[3][j] = s->mixw_cb[j] + s->f[i][3].score;
+        w_den[0][j] = s->mixw_cb[j] + f[0].score;
+        w_den[1][j] = s->mixw_cb[j] + f[1].score;
+        w_den[2][j] = s->mixw_cb[j] + f[2].score;
+        w_den[3][j] = s->mixw_cb[j] + f[3].score;
     }
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
-    pid_cw3 = s->mixw[i][s->f[i][3].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
+    pid_cw3 = s->mixw[i][f[3].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int n = senone_active[j] + l;
         int tmp, cw;
 
@@ -622,9 +628,9 @@ get_scores_4b_feat_4(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_4b_feat_3(s2_semi_mgau_t * s, int i,
+get_scores_4b_feat_3(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1, *pid_cw2;
@@ -632,16 +638,16 @@ get_scores_4b_feat_3(s2_semi_mgau_t * s, int i,
 
     /* Precompute scaled densities. */
     for (j = 0; j < 16; ++j) {
-        w_den[0][j] = s->mixw_cb[j] + s->f[i][0].score;
-        w_den[1][j] = s->mixw_cb[j] + s->f[i][1].score;
-        w_den[2][j] = s->mixw_cb[j] + s->f[i][2].score;
+        w_den[0][j] = s->mixw_cb[j] + f[0].score;
+        w_den[1][j] = s->mixw_cb[j] + f[1].score;
+        w_den[2][j] = s->mixw_cb[j] + f[2].score;
     }
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
-    pid_cw2 = s->mixw[i][s->f[i][2].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
+    pid_cw2 = s->mixw[i][f[2].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int n = senone_active[j] + l;
         int tmp, cw;
 
@@ -668,9 +674,9 @@ get_scores_4b_feat_3(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_4b_feat_2(s2_semi_mgau_t * s, int i,
+get_scores_4b_feat_2(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0, *pid_cw1;
@@ -678,14 +684,14 @@ get_scores_4b_feat_2(s2_semi_mgau_t * s, int i,
 
     /* Precompute scaled densities. */
     for (j = 0; j < 16; ++j) {
-        w_den[0][j] = s->mixw_cb[j] + s->f[i][0].score;
-        w_den[1][j] = s->mixw_cb[j] + s->f[i][1].score;
+        w_den[0][j] = s->mixw_cb[j] + f[0].score;
+        w_den[1][j] = s->mixw_cb[j] + f[1].score;
     }
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
-    pid_cw1 = s->mixw[i][s->f[i][1].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
+    pid_cw1 = s->mixw[i][f[1].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int n = senone_active[j] + l;
         int tmp, cw;
 
@@ -708,9 +714,9 @@ get_scores_4b_feat_2(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_4b_feat_1(s2_semi_mgau_t * s, int i,
+get_scores_4b_feat_1(s2_semi_mgau_t * s, int i, vqFeature_t *f,
                      int16 *senone_scores, uint8 *senone_active,
-                     int32 n_senone_active)
+                     int32 n_senone_active, int32 first_sen)
 {
     int32 j, l;
     uint8 *pid_cw0;
@@ -718,12 +724,12 @@ get_scores_4b_feat_1(s2_semi_mgau_t * s, int i,
 
     /* Precompute scaled densities. */
     for (j = 0; j < 16; ++j) {
-        w_den[j] = s->mixw_cb[j] + s->f[i][0].score;
+        w_den[j] = s->mixw_cb[j] + f[0].score;
     }
 
-    pid_cw0 = s->mixw[i][s->f[i][0].codeword];
+    pid_cw0 = s->mixw[i][f[0].codeword];
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int n = senone_active[j] + l;
         int tmp, cw;
 
@@ -742,31 +748,31 @@ get_scores_4b_feat_1(s2_semi_mgau_t * s, int i,
 }
 
 static int32
-get_scores_4b_feat_any(s2_semi_mgau_t * s, int i, int topn,
+get_scores_4b_feat_any(s2_semi_mgau_t * s, int i, vqFeature_t *f, int topn,
                        int16 *senone_scores, uint8 *senone_active,
-                       int32 n_senone_active)
+                       int32 n_senone_active, int32 first_sen)
 {
     int32 j, k, l;
 
-    for (l = j = 0; j < n_senone_active; j++) {
+    for (l = first_sen, j = 0; j < n_senone_active; j++) {
         int n = senone_active[j] + l;
         int tmp, cw;
         uint8 *pid_cw;
     
-        pid_cw = s->mixw[i][s->f[i][0].codeword];
+        pid_cw = s->mixw[i][f[0].codeword];
         if (n & 1)
             cw = pid_cw[n/2] >> 4;
         else
             cw = pid_cw[n/2] & 0x0f;
-        tmp = s->mixw_cb[cw] + s->f[i][0].score;
+        tmp = s->mixw_cb[cw] + f[0].score;
         for (k = 1; k < topn; ++k) {
-            pid_cw = s->mixw[i][s->f[i][k].codeword];
+            pid_cw = s->mixw[i][f[k].codeword];
             if (n & 1)
                 cw = pid_cw[n/2] >> 4;
             else
                 cw = pid_cw[n/2] & 0x0f;
             tmp = fast_logmath_add(s->lmath_8b, tmp,
-                                   s->mixw_cb[cw] + s->f[i][k].score);
+                                   s->mixw_cb[cw] + f[k].score);
         }
         senone_scores[n] += tmp;
         l = n;
@@ -775,48 +781,58 @@ get_scores_4b_feat_any(s2_semi_mgau_t * s, int i, int topn,
 }
 
 static int32
-get_scores_4b_feat(s2_semi_mgau_t * s, int i, int topn,
-                   int16 *senone_scores, uint8 *senone_active, int32 n_senone_active)
+get_scores_4b_feat(s2_semi_mgau_t * s, int i, vqFeature_t *f, int topn,
+                   int16 *senone_scores, uint8 *senone_active, int32 n_senone_active,
+                   int32 first_sen)
 {
     switch (topn) {
     case 6:
-        return get_scores_4b_feat_6(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_4b_feat_6(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 5:
-        return get_scores_4b_feat_5(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_4b_feat_5(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 4:
-        return get_scores_4b_feat_4(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_4b_feat_4(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 3:
-        return get_scores_4b_feat_3(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_4b_feat_3(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 2:
-        return get_scores_4b_feat_2(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_4b_feat_2(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     case 1:
-        return get_scores_4b_feat_1(s, i, senone_scores,
-                                    senone_active, n_senone_active);
+        return get_scores_4b_feat_1(s, i, f, senone_scores,
+                                    senone_active, n_senone_active, first_sen);
     default:
-        return get_scores_4b_feat_any(s, i, topn, senone_scores,
-                                      senone_active, n_senone_active);
+        return get_scores_4b_feat_any(s, i, f, topn, senone_scores,
+                                      senone_active, n_senone_active, first_sen);
     }
 }
 
 static int32
-get_scores_4b_feat_all(s2_semi_mgau_t * s, int i, int topn, int16 *senone_scores)
+get_scores_4b_feat_all(s2_semi_mgau_t * s, int i, vqFeature_t *f, int topn,
+                       int16 *senone_scores, int32 first_sen, int32 last_sen)
 {
     int32 j, k;
 
-    for (j = 0; j < s->n_sen; j++) {
+    for (j = first_sen; j < last_sen; j++) {
         uint8 *pid_cw;
-        int32 tmp;
-        pid_cw = s->mixw[i][s->f[i][0].codeword];
-        tmp = pid_cw[j] + s->f[i][0].score;
+        int32 tmp, cw;
+        pid_cw = s->mixw[i][f[0].codeword];
+        if (j & 1)
+            cw = pid_cw[j/2] >> 4;
+        else
+            cw = pid_cw[j/2] & 0x0f;
+        tmp = s->mixw_cb[cw] + f[0].score;
         for (k = 1; k < topn; ++k) {
-            pid_cw = s->mixw[i][s->f[i][k].codeword];
+            pid_cw = s->mixw[i][f[k].codeword];
+            if (j & 1)
+                cw = pid_cw[j/2] >> 4;
+            else
+                cw = pid_cw[j/2] & 0x0f;
             tmp = fast_logmath_add(s->lmath_8b, tmp,
-                                   pid_cw[j] + s->f[i][k].score);
+                                   s->mixw_cb[cw] + f[k].score);
         }
         senone_scores[j] += tmp;
     }
@@ -824,56 +840,101 @@ get_scores_4b_feat_all(s2_semi_mgau_t * s, int i, int topn, int16 *senone_scores
 }
 
 /*
- * Compute senone scores for the active senones.
+ * Compute the top-N codewords for each feature stream.
  */
-int32
-s2_semi_mgau_frame_eval(ps_mgau_t *ps,
-                        int16 *senone_scores,
+int
+s2_semi_mgau_frame_prep(ps_mgau_t *ps,
                         uint8 *senone_active,
                         int32 n_senone_active,
-			mfcc_t ** featbuf, int32 frame,
-			int32 compallsen)
+                        mfcc_t ** featbuf, int32 frame,
+                        int32 compallsen)
 {
     s2_semi_mgau_t *s = (s2_semi_mgau_t *)ps;
     int i, topn_idx;
 
-    memset(senone_scores, 0, s->n_sen * sizeof(*senone_scores));
     /* No bounds checking is done here, which just means you'll get
      * semi-random crap if you request a frame in the future or one
      * that's too far in the past. */
     topn_idx = frame % s->n_topn_hist;
     s->f = s->topn_hist[topn_idx];
+    /* For past frames this will already be computed. */
+    if (frame < ps_mgau_base(ps)->frame_idx)
+        return 0;
+    for (i = 0; i < s->n_feat; ++i) {
+        vqFeature_t **lastf;
+        if (topn_idx == 0)
+            lastf = s->topn_hist[s->n_topn_hist-1];
+        else
+            lastf = s->topn_hist[topn_idx-1];
+        memcpy(s->f[i], lastf[i], sizeof(vqFeature_t) * s->max_topn);
+        mgau_dist(s, frame, i, featbuf[i]);
+        s->topn_hist_n[topn_idx][i] = mgau_norm(s, i);
+    }
+
+    return 0;
+}
+
+/*
+ * Accumulate scores for some of the senones in a frame from the top-N
+ * codewords that s2_semi_mgau_frame_prep() found for it.
+ */
+int
+s2_semi_mgau_senone_eval(ps_mgau_t *ps,
+                         int16 *senone_scores,
+                         uint8 *senone_active,
+                         int32 n_senone_active,
+                         int32 first_sen, int32 frame,
+                         int32 compallsen)
+{
+    s2_semi_mgau_t *s = (s2_semi_mgau_t *)ps;
+    vqFeature_t **f = s->topn_hist[frame % s->n_topn_hist];
+    uint8 *topn = s->topn_hist_n[frame % s->n_topn_hist];
+    int i;
+
     for (i = 0; i < s->n_feat; ++i) {
-        /* For past frames this will already be computed. */
-        if (frame >= ps_mgau_base(ps)->frame_idx) {
-            vqFeature_t **lastf;
-            if (topn_idx == 0)
-                lastf = s->topn_hist[s->n_topn_hist-1];
-            else
-                lastf = s->topn_hist[topn_idx-1];
-            memcpy(s->f[i], lastf[i], sizeof(vqFeature_t) * s->max_topn);
-            mgau_dist(s, frame, i, featbuf[i]);
-            s->topn_hist_n[topn_idx][i] = mgau_norm(s, i);
-        }
         if (s->mixw_cb) {
             if (compallsen)
-                get_scores_4b_feat_all(s, i, s->topn_hist_n[topn_idx][i], senone_scores);
+                get_scores_4b_feat_all(s, i, f[i], topn[i], senone_scores,
+                                       first_sen, first_sen + n_senone_active);
             else
-                get_scores_4b_feat(s, i, s->topn_hist_n[topn_idx][i], senone_scores,
-                                   senone_active, n_senone_active);
+                get_scores_4b_feat(s, i, f[i], topn[i], senone_scores,
+                                   senone_active, n_senone_active, first_sen);
         }
         else {
             if (compallsen)
-                get_scores_8b_feat_all(s, i, s->topn_hist_n[topn_idx][i], senone_scores);
+                get_scores_8b_feat_all(s, i, f[i], topn[i], senone_scores,
+                                       first_sen, first_sen + n_senone_active);
             else
-                get_scores_8b_feat(s, i, s->topn_hist_n[topn_idx][i], senone_scores,
-                                   senone_active, n_senone_active);
+                get_scores_8b_feat(s, i, f[i], topn[i], senone_scores,
+                                   senone_active, n_senone_active, first_sen);
         }
     }
 
     return 0;
 }
 
+/*
+ * Compute senone scores for the active senones.
+ */
+int32
+s2_semi_mgau_frame_eval(ps_mgau_t *ps,
+                        int16 *senone_scores,
+                        uint8 *senone_active,
+                        int32 n_senone_active,
+			mfcc_t ** featbuf, int32 frame,
+			int32 compallsen)
+{
+    s2_semi_mgau_t *s = (s2_semi_mgau_t *)ps;
+
+    memset(senone_scores, 0, s->n_sen * sizeof(*senone_scores));
+    s2_semi_mgau_frame_prep(ps, senone_active, n_senone_active,
+                            featbuf, frame, compallsen);
+    if (compallsen)
+        n_senone_active = s->n_sen;
+    return s2_semi_mgau_senone_eval(ps, senone_scores, senone_active,
+                                    n_senone_active, 0, frame, compallsen);
+}
+
 static int32
 read_sendump(s2_semi_mgau_t *s, bin_mdef_t *mdef, char const *file)
 {
@@ -1012,17 +1073,27 @@ read_sendump(s2_semi_mgau_t *s, bin_mdef_t *mdef, char const *file)
         goto error_out;
     }
 
-    if (do_mmap) {
-            E_INFO("Using memory-mapped I/O for senones\n");
-    }
     offset = ftell(fp);
     fseek(fp, 0, SEEK_END);
     filesize = ftell(fp);
     fseek(fp, offset, SEEK_SET);
 
+    /* Make sure it's all there before pointing into a mapping of it. */
+    n = (n_bits == 4) ? (c + 1) / 2 : c;
+    if (offset + n_clust + (size_t)n_feat * r * n > filesize) {
+        E_ERROR("Dump file %s is truncated (%ld bytes, expected %ld)\n",
+                file, (long)filesize,
+                (long)(offset + n_clust + (size_t)n_feat * r * n));
+        goto error_out;
+    }
+
     /* Allocate memory for pdfs (or memory map them) */
     if (do_mmap) {
-        s->sendump_mmap = mmio_file_read(file);
+        if ((s->sendump_mmap = mmio_file_read(file)) == NULL)
+            E_WARN("Failed to memory-map %s, will read it instead\n", file);
+    }
+    if (s->sendump_mmap) {
+        E_INFO("Using memory-mapped I/O for senones\n");
         /* Get cluster codebook if any. */
         if (n_clust) {
             s->mixw_cb = ((uint8 *) mmio_file_ptr(s->sendump_mmap)) + offset;
@@ -1220,6 +1291,33 @@ split_topn(char const *str, uint8 *out, int nfeat)
 }
 
 
+static void
+init_topn_hist(s2_semi_mgau_t *s)
+{
+    int i;
+
+    /* Top-N scores from recent frames, and from the rest of a batch
+     * of frames scored ahead (see acmod_score()). */
+    s->n_topn_hist = cmd_ln_int32_r(s->config, "-pl_window") + 2;
+    if (cmd_ln_int32_r(s->config, "-scorebatch") > 1)
+        s->n_topn_hist += cmd_ln_int32_r(s->config, "-scorebatch") - 1;
+    s->topn_hist = (vqFeature_t ***)
+        ckd_calloc_3d(s->n_topn_hist, s->n_feat, s->max_topn,
+                      sizeof(***s->topn_hist));
+    s->topn_hist_n = ckd_calloc_2d(s->n_topn_hist, s->n_feat,
+                                   sizeof(**s->topn_hist_n));
+    for (i = 0; i < s->n_topn_hist; ++i) {
+        int j;
+        for (j = 0; j < s->n_feat; ++j) {
+            int k;
+            for (k = 0; k < s->max_topn; ++k) {
+                s->topn_hist[i][j][k].score = WORST_DIST;
+                s->topn_hist[i][j][k].codeword = k;
+            }
+        }
+    }
+}
+
 ps_mgau_t *
 s2_semi_mgau_init(acmod_t *acmod)
 {
@@ -1229,6 +1327,7 @@ s2_semi_mgau_init(acmod_t *acmod)
     int i;
 
     s = ckd_calloc(1, sizeof(*s));
+    ps_mgau_base(s)->refcnt = 1;
     s->config = acmod->config;
 
     s->lmath = logmath_retain(acmod->lmath);
@@ -1272,6 +1371,7 @@ s2_semi_mgau_init(acmod_t *acmod)
         }
     }
     s->n_density = s->g->n_density;
+    interleave_codebooks(s);
     /* Read mixture weights */
     if ((sendump_path = cmd_ln_str_r(s->config, "-sendump"))) {
         if (read_sendump(s, acmod->mdef, sendump_path) < 0) {
@@ -1297,23 +1397,7 @@ s2_semi_mgau_init(acmod_t *acmod)
     }
     E_INFOCONT("\n");
 
-    /* Top-N scores from recent frames */
-    s->n_topn_hist = cmd_ln_int32_r(s->config, "-pl_window") + 2;
-    s->topn_hist = (vqFeature_t ***)
-        ckd_calloc_3d(s->n_topn_hist, s->n_feat, s->max_topn,
-                      sizeof(***s->topn_hist));
-    s->topn_hist_n = ckd_calloc_2d(s->n_topn_hist, s->n_feat,
-                                   sizeof(**s->topn_hist_n));
-    for (i = 0; i < s->n_topn_hist; ++i) {
-        int j;
-        for (j = 0; j < s->n_feat; ++j) {
-            int k;
-            for (k = 0; k < s->max_topn; ++k) {
-                s->topn_hist[i][j][k].score = WORST_DIST;
-                s->topn_hist[i][j][k].codeword = k;
-            }
-        }
-    }
+    init_topn_hist(s);
 
     ps = (ps_mgau_t *)s;
     ps->vt = &s2_semi_mgau_funcs;
@@ -1328,13 +1412,52 @@ s2_semi_mgau_mllr_transform(ps_mgau_t *ps,
                             ps_mllr_t *mllr)
 {
     s2_semi_mgau_t *s = (s2_semi_mgau_t *)ps;
-    return gauden_mllr_transform(s->g, mllr, s->config);
+    int rv;
+
+    rv = gauden_mllr_transform(s->g, mllr, s->config);
+    s->means = s->g->mean[0];
+    s->vars = s->g->var[0];
+    s->dets = s->g->det[0];
+    interleave_codebooks(s);
+    return rv;
+}
+
+ps_mgau_t *
+s2_semi_mgau_copy(ps_mgau_t *ps)
+{
+    s2_semi_mgau_t *other, *s;
+
+    /* Always share the parameters of the model that owns them. */
+    if (ps->shared)
+        ps = ps->shared;
+    other = (s2_semi_mgau_t *)ps;
+
+    s = ckd_malloc(sizeof(*s));
+    *s = *other;
+    ps_mgau_base(s)->frame_idx = 0;
+    ps_mgau_base(s)->refcnt = 1;
+    ps_mgau_base(s)->shared = ps;
+    ++ps->refcnt;
+    init_topn_hist(s);
+    return ps_mgau_base(s);
 }
 
 void
 s2_semi_mgau_free(ps_mgau_t *ps)
 {
     s2_semi_mgau_t *s = (s2_semi_mgau_t *)ps;
+    int32 i;
+
+    if (--ps->refcnt > 0)
+        return;
+    ckd_free_2d(s->topn_hist_n);
+    ckd_free_3d((void **)s->topn_hist);
+    /* A copy owns nothing else. */
+    if (ps->shared) {
+        s2_semi_mgau_free(ps->shared);
+        ckd_free(s);
+        return;
+    }
 
     logmath_free(s->lmath);
     logmath_free(s->lmath_8b);
@@ -1344,10 +1467,14 @@ s2_semi_mgau_free(ps_mgau_t *ps)
     }
     else {
         ckd_free_3d(s->mixw);
+        ckd_free(s->mixw_cb);
+    }
+    if (s->blocks) {
+        for (i = 0; i < s->n_feat; ++i)
+            ckd_free(s->blocks[i]);
+        ckd_free(s->blocks);
     }
     gauden_free(s->g);
     ckd_free(s->topn_beam);
-    ckd_free_2d(s->topn_hist_n);
-    ckd_free_3d((void **)s->topn_hist);
     ckd_free(s);
 }
@@ -64,6 +64,7 @@ struct s2_semi_mgau_s {
     mfcc_t  ***means;	/* mean vectors foreach feature, density */
     mfcc_t  ***vars;	/* inverse var vectors foreach feature, density */
     mfcc_t  **dets;	/* det values foreach cb, feature */
+    mfcc_t  **blocks;	/* codebooks interleaved for eval_cb(), foreach feature */
 
     uint8 ***mixw;     /* mixture weight distributions */
     mmio_file_t *sendump_mmap;/* memory map for mixw (or NULL if not mmap) */
@@ -89,6 +90,7 @@ struct s2_semi_mgau_s {
 };
 
 ps_mgau_t *s2_semi_mgau_init(acmod_t *acmod);
+ps_mgau_t *s2_semi_mgau_copy(ps_mgau_t *s);
 void s2_semi_mgau_free(ps_mgau_t *s);
 int s2_semi_mgau_frame_eval(ps_mgau_t *s,
                             int16 *senone_scores,
@@ -97,6 +99,19 @@ int s2_semi_mgau_frame_eval(ps_mgau_t *s,
                             mfcc_t **featbuf,
                             int32 frame,
                             int32 compallsen);
+int s2_semi_mgau_frame_prep(ps_mgau_t *s,
+                            uint8 *senone_active,
+                            int32 n_senone_active,
+                            mfcc_t **featbuf,
+                            int32 frame,
+                            int32 compallsen);
+int s2_semi_mgau_senone_eval(ps_mgau_t *s,
+                             int16 *senone_scores,
+                             uint8 *senone_active,
+                             int32 n_senone_active,
+                             int32 first_sen,
+                             int32 frame,
+                             int32 compallsen);
 int s2_semi_mgau_mllr_transform(ps_mgau_t *s,
                                 ps_mllr_t *mllr);
 
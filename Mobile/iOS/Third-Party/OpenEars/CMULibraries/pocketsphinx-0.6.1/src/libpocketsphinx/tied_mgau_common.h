@@ -45,6 +45,8 @@
 
 #include <logmath.h>
 #include <fixpoint.h>
+#include <ckd_alloc.h>
+#include <fe.h>
 
 #define MGAU_MIXW_VERSION	"1.0"   /* Sphinx-3 file format version for mixw */
 #define MGAU_PARAM_VERSION	"1.0"   /* Sphinx-3 file format version for mean/var */
@@ -67,6 +69,58 @@
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #endif
 
+/*
+ * Codebooks are evaluated MGAU_SIMD_WIDTH codewords at a time, one
+ * codeword per vector lane.  Every lane does exactly the arithmetic
+ * that the scalar code does for its codeword, in the same order, so
+ * the distances, and hence the top-N, do not depend on which of these
+ * is used.  Define MGAU_GENERIC to use the portable code only.
+ *
+ * In fixed-point, GMMSUB() is what compilers make of it: they fold
+ * (a)-(b) > (a) to (b) < 0, so a negative component gives INT_MIN and
+ * anything else wraps around.  The vector code does the same.
+ */
+#if defined(MGAU_GENERIC)
+#elif defined(FIXED_POINT)
+#if defined(__AVX2__)
+#define MGAU_SIMD_AVX2
+#define MGAU_SIMD_WIDTH 8
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MGAU_SIMD_NEON
+#define MGAU_SIMD_WIDTH 4
+#endif
+#else /* !FIXED_POINT */
+#if defined(__AVX__)
+#define MGAU_SIMD_AVX
+#define MGAU_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MGAU_SIMD_SSE2
+#define MGAU_SIMD_WIDTH 4
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MGAU_SIMD_NEON
+#define MGAU_SIMD_WIDTH 4
+#endif
+#endif /* !FIXED_POINT */
+
+#ifndef MGAU_SIMD_WIDTH
+#define MGAU_SIMD_WIDTH 1
+#endif
+
+#if defined(MGAU_SIMD_AVX) || defined(MGAU_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(MGAU_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(MGAU_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Number of values in one block of an interleaved codebook: the
+ * determinants of MGAU_SIMD_WIDTH codewords, then for each dimension
+ * their means followed by their inverse variances.
+ */
+#define MGAU_BLOCK_SIZE(ceplen) ((1 + 2 * (ceplen)) * MGAU_SIMD_WIDTH)
+
 
 #if defined(__STDC_VERSION__) && (__STDC_VERSION__ == 199901L)
 #define LOGMATH_INLINE static inline
@@ -121,4 +175,212 @@ fast_logmath_add(logmath_t *lmath, int mlx, int mly)
     return r - (((uint8 *)t->table)[d]);
 }
 
+/**
+ * Lay out a codebook in blocks of MGAU_SIMD_WIDTH codewords for
+ * mgau_dist_block().  The last block is padded with zeros.
+ *
+ * @param mean Means for each codeword
+ * @param var Precomputed inverse variances for each codeword
+ * @param det Precomputed determinants for each codeword
+ * @return Newly allocated blocks, to be freed with ckd_free()
+ */
+LOGMATH_INLINE mfcc_t *
+mgau_interleave(mfcc_t **mean, mfcc_t **var, mfcc_t *det,
+                int32 n_density, int32 ceplen)
+{
+    mfcc_t *blocks, *blk;
+    int32 n_block, cw, i, j;
+
+    n_block = (n_density + MGAU_SIMD_WIDTH - 1) / MGAU_SIMD_WIDTH;
+    blocks = ckd_calloc(n_block * MGAU_BLOCK_SIZE(ceplen), sizeof(*blocks));
+    for (blk = blocks, cw = 0; cw < n_density;
+         cw += MGAU_SIMD_WIDTH, blk += MGAU_BLOCK_SIZE(ceplen)) {
+        for (i = 0; i < MGAU_SIMD_WIDTH && cw + i < n_density; ++i) {
+            blk[i] = det[cw + i];
+            for (j = 0; j < ceplen; ++j) {
+                blk[(1 + 2 * j) * MGAU_SIMD_WIDTH + i] = mean[cw + i][j];
+                blk[(2 + 2 * j) * MGAU_SIMD_WIDTH + i] = var[cw + i][j];
+            }
+        }
+    }
+    return blocks;
+}
+
+/**
+ * Compute the distances of one block of codewords from an observation.
+ *
+ * As in the scalar code, a codeword is no longer evaluated once it is
+ * worse than thresh, and its distance is left where it was at that
+ * point.  The block is finished as soon as all of them are.
+ */
+LOGMATH_INLINE void
+mgau_dist_block_generic(mfcc_t const *blk, mfcc_t const *z, int32 ceplen,
+                        mfcc_t thresh, mfcc_t *dist)
+{
+    int32 i, j, live;
+
+    for (i = 0; i < MGAU_SIMD_WIDTH; ++i)
+        dist[i] = blk[i];
+    blk += MGAU_SIMD_WIDTH;
+    for (j = 0; j < ceplen; ++j, blk += 2 * MGAU_SIMD_WIDTH) {
+        for (live = i = 0; i < MGAU_SIMD_WIDTH; ++i) {
+            mfcc_t diff, sqdiff, compl; /* diff, diff^2, component likelihood */
+
+            if (!(dist[i] >= thresh))
+                continue;
+            diff = z[j] - blk[i];
+            sqdiff = MFCCMUL(diff, diff);
+            compl = MFCCMUL(sqdiff, blk[MGAU_SIMD_WIDTH + i]);
+            dist[i] = GMMSUB(dist[i], compl);
+            live = 1;
+        }
+        if (!live)
+            break;
+    }
+}
+
+#if defined(MGAU_SIMD_SSE2)
+LOGMATH_INLINE void
+mgau_dist_block(mfcc_t const *blk, mfcc_t const *z, int32 ceplen,
+                mfcc_t thresh, mfcc_t *dist)
+{
+    __m128 d, t, diff, live;
+    int32 j;
+
+    d = _mm_loadu_ps(blk);
+    t = _mm_set1_ps(thresh);
+    for (j = 0, blk += 4; j < ceplen; ++j, blk += 8) {
+        live = _mm_cmpge_ps(d, t);
+        if (!_mm_movemask_ps(live))
+            break;
+        diff = _mm_sub_ps(_mm_set1_ps(z[j]), _mm_loadu_ps(blk));
+        diff = _mm_mul_ps(diff, diff);
+        diff = _mm_sub_ps(d, _mm_mul_ps(diff, _mm_loadu_ps(blk + 4)));
+        d = _mm_or_ps(_mm_and_ps(live, diff), _mm_andnot_ps(live, d));
+    }
+    _mm_storeu_ps(dist, d);
+}
+#elif defined(MGAU_SIMD_AVX)
+LOGMATH_INLINE void
+mgau_dist_block(mfcc_t const *blk, mfcc_t const *z, int32 ceplen,
+                mfcc_t thresh, mfcc_t *dist)
+{
+    __m256 d, t, diff, live;
+    int32 j;
+
+    d = _mm256_loadu_ps(blk);
+    t = _mm256_set1_ps(thresh);
+    for (j = 0, blk += 8; j < ceplen; ++j, blk += 16) {
+        live = _mm256_cmp_ps(d, t, _CMP_GE_OQ);
+        if (!_mm256_movemask_ps(live))
+            break;
+        diff = _mm256_sub_ps(_mm256_set1_ps(z[j]), _mm256_loadu_ps(blk));
+        diff = _mm256_mul_ps(diff, diff);
+        diff = _mm256_sub_ps(d, _mm256_mul_ps(diff, _mm256_loadu_ps(blk + 8)));
+        d = _mm256_blendv_ps(d, diff, live);
+    }
+    _mm256_storeu_ps(dist, d);
+}
+#elif defined(MGAU_SIMD_AVX2)
+/* FIXMUL() of each lane: the low 32 bits of the 64-bit product shifted
+ * down by the radix. */
+LOGMATH_INLINE __m256i
+mgau_fixmul_avx2(__m256i a, __m256i b)
+{
+    __m256i even, odd;
+
+    even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), DEFAULT_RADIX);
+    odd = _mm256_srli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32),
+                                             _mm256_srli_epi64(b, 32)),
+                            DEFAULT_RADIX);
+    return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+}
+
+LOGMATH_INLINE void
+mgau_dist_block(mfcc_t const *blk, mfcc_t const *z, int32 ceplen,
+                mfcc_t thresh, mfcc_t *dist)
+{
+    __m256i d, t, diff, compl, dead;
+    int32 j;
+
+    d = _mm256_loadu_si256((__m256i const *)blk);
+    t = _mm256_set1_epi32(thresh);
+    for (j = 0, blk += 8; j < ceplen; ++j, blk += 16) {
+        dead = _mm256_cmpgt_epi32(t, d);
+        if (_mm256_movemask_epi8(dead) == -1)
+            break;
+        diff = _mm256_sub_epi32(_mm256_set1_epi32(z[j]),
+                                _mm256_loadu_si256((__m256i const *)blk));
+        diff = mgau_fixmul_avx2(diff, diff);
+        compl = mgau_fixmul_avx2(diff, _mm256_loadu_si256((__m256i const *)(blk + 8)));
+        diff = _mm256_blendv_epi8(_mm256_sub_epi32(d, compl),
+                                  _mm256_set1_epi32(INT_MIN),
+                                  _mm256_srai_epi32(compl, 31));
+        d = _mm256_blendv_epi8(diff, d, dead);
+    }
+    _mm256_storeu_si256((__m256i *)dist, d);
+}
+#elif defined(MGAU_SIMD_NEON) && defined(FIXED_POINT)
+LOGMATH_INLINE int32x4_t
+mgau_fixmul_neon(int32x4_t a, int32x4_t b)
+{
+    return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(b)),
+                                    DEFAULT_RADIX),
+                        vshrn_n_s64(vmull_s32(vget_high_s32(a), vget_high_s32(b)),
+                                    DEFAULT_RADIX));
+}
+
+LOGMATH_INLINE void
+mgau_dist_block(mfcc_t const *blk, mfcc_t const *z, int32 ceplen,
+                mfcc_t thresh, mfcc_t *dist)
+{
+    int32x4_t d, t, diff, compl;
+    uint32x4_t live;
+    uint32x2_t any;
+    int32 j;
+
+    d = vld1q_s32(blk);
+    t = vdupq_n_s32(thresh);
+    for (j = 0, blk += 4; j < ceplen; ++j, blk += 8) {
+        live = vcgeq_s32(d, t);
+        any = vorr_u32(vget_low_u32(live), vget_high_u32(live));
+        if (!vget_lane_u64(vreinterpret_u64_u32(any), 0))
+            break;
+        diff = vsubq_s32(vdupq_n_s32(z[j]), vld1q_s32(blk));
+        diff = mgau_fixmul_neon(diff, diff);
+        compl = mgau_fixmul_neon(diff, vld1q_s32(blk + 4));
+        diff = vbslq_s32(vcltq_s32(compl, vdupq_n_s32(0)),
+                         vdupq_n_s32(INT_MIN), vsubq_s32(d, compl));
+        d = vbslq_s32(live, diff, d);
+    }
+    vst1q_s32(dist, d);
+}
+#elif defined(MGAU_SIMD_NEON)
+LOGMATH_INLINE void
+mgau_dist_block(mfcc_t const *blk, mfcc_t const *z, int32 ceplen,
+                mfcc_t thresh, mfcc_t *dist)
+{
+    float32x4_t d, t, diff;
+    uint32x4_t live;
+    uint32x2_t any;
+    int32 j;
+
+    d = vld1q_f32(blk);
+    t = vdupq_n_f32(thresh);
+    for (j = 0, blk += 4; j < ceplen; ++j, blk += 8) {
+        live = vcgeq_f32(d, t);
+        any = vorr_u32(vget_low_u32(live), vget_high_u32(live));
+        if (!vget_lane_u64(vreinterpret_u64_u32(any), 0))
+            break;
+        diff = vsubq_f32(vdupq_n_f32(z[j]), vld1q_f32(blk));
+        diff = vmulq_f32(diff, diff);
+        diff = vsubq_f32(d, vmulq_f32(diff, vld1q_f32(blk + 4)));
+        d = vbslq_f32(live, diff, d);
+    }
+    vst1q_f32(dist, d);
+}
+#else
+#define mgau_dist_block mgau_dist_block_generic
+#endif
+
 #endif /* __TIED_MGAU_COMMON_H__ */
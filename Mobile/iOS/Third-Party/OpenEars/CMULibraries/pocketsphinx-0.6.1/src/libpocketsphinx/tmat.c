@@ -207,6 +207,7 @@ tmat_init(char const *file_name, logmath_t *lmath, float64 tpfloor, int32 brepor
     }
 
     t = (tmat_t *) ckd_calloc(1, sizeof(tmat_t));
+    t->refcnt = 1;
 
     if ((fp = fopen(file_name, "rb")) == NULL)
         E_FATAL_SYSTEM("fopen(%s,rb) failed\n", file_name);
@@ -323,13 +324,20 @@ tmat_report(tmat_t * t)
 
 }
 
+tmat_t *
+tmat_retain(tmat_t * t)
+{
+    ++t->refcnt;
+    return t;
+}
+
 /* 
  *  RAH, Free memory allocated in tmat_init ()
  */
 void
 tmat_free(tmat_t * t)
 {
-    if (t) {
+    if (t && --t->refcnt == 0) {
         if (t->tp)
             ckd_free_3d(t->tp);
         ckd_free(t);
@@ -112,6 +112,7 @@ typedef struct {
     int16 n_tmat;	/**< Number matrices */
     int16 n_state;	/**< Number source states in matrix (only the emitting states);
 			   Number destination states = n_state+1, it includes the exit state */
+    int refcnt;		/**< Reference count. */
 } tmat_t;
 
 
@@ -132,6 +133,12 @@ void tmat_dump (tmat_t *tmat,  /**< In: transition matrix */
     );	
 
 
+/**
+ * Retain a pointer to a transition matrix.
+ */
+tmat_t *tmat_retain(tmat_t *t /**< In: transition matrix */
+    );
+
 /**
  * RAH, add code to remove memory allocated by tmat_init
  */
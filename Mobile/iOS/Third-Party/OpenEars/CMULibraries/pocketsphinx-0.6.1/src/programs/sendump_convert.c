@@ -0,0 +1,278 @@
+/* -*- c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/* ====================================================================
+ * Copyright (c) 2010 Carnegie Mellon University.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer. 
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This work was supported in part by funding from the Defense Advanced 
+ * Research Projects Agency and the National Science Foundation of the 
+ * United States of America, and the CMU Sphinx Speech Consortium.
+ *
+ * THIS SOFTWARE IS PROVIDED BY CARNEGIE MELLON UNIVERSITY ``AS IS'' AND 
+ * ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL CARNEGIE MELLON UNIVERSITY
+ * NOR ITS EMPLOYEES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ====================================================================
+ */
+/**
+ * sendump_convert.c - convert mixture weights to a memory-mappable sendump
+ *
+ * Tied-mixture models normally read their mixture weights from a
+ * sendump file, which holds them already quantized to 8 bits and can
+ * be memory-mapped (see -mmap).  Models which only come with a
+ * mixture_weights file have to be normalized, floored and quantized
+ * every time they are loaded, in memory of their own.  This does that
+ * once and writes the result as a sendump.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <prim_type.h>
+#include <ckd_alloc.h>
+#include <logmath.h>
+#include <bio.h>
+#include <err.h>
+
+#include "hmm.h"
+#include "vector.h"
+#include "tied_mgau_common.h"
+
+#define MIXW_PARAM_VERSION "1.0"
+/* Alignment of the weights in the output file. */
+#define SENDUMP_ALIGN 64
+
+static uint8 ***
+read_mixw(char const *file_name, logmath_t *lmath, double floor,
+          int32 *out_n_sen, int32 *out_n_feat, int32 *out_n_comp)
+{
+    char **argname, **argval;
+    char eofchk;
+    FILE *fp;
+    int32 byteswap, chksum_present;
+    uint32 chksum;
+    float32 *pdf;
+    int32 i, f, c, n;
+    int32 n_sen, n_feat, n_comp, n_err;
+    uint8 ***mixw;
+
+    if ((fp = fopen(file_name, "rb")) == NULL) {
+        E_ERROR_SYSTEM("Failed to open %s", file_name);
+        return NULL;
+    }
+    if (bio_readhdr(fp, &argname, &argval, &byteswap) < 0) {
+        E_ERROR("Failed to read header from %s\n", file_name);
+        fclose(fp);
+        return NULL;
+    }
+    chksum_present = 0;
+    for (i = 0; argname[i]; i++) {
+        if (strcmp(argname[i], "version") == 0) {
+            if (strcmp(argval[i], MIXW_PARAM_VERSION) != 0)
+                E_WARN("Version mismatch(%s): %s, expecting %s\n",
+                       file_name, argval[i], MIXW_PARAM_VERSION);
+        }
+        else if (strcmp(argname[i], "chksum0") == 0) {
+            chksum_present = 1;
+        }
+    }
+    bio_hdrarg_free(argname, argval);
+
+    chksum = 0;
+    if ((bio_fread(&n_sen, sizeof(int32), 1, fp, byteswap, &chksum) != 1)
+        || (bio_fread(&n_feat, sizeof(int32), 1, fp, byteswap, &chksum) != 1)
+        || (bio_fread(&n_comp, sizeof(int32), 1, fp, byteswap, &chksum) != 1)
+        || (bio_fread(&n, sizeof(int32), 1, fp, byteswap, &chksum) != 1)) {
+        E_ERROR("Failed to read dimensions from %s\n", file_name);
+        fclose(fp);
+        return NULL;
+    }
+    if (n != n_sen * n_feat * n_comp) {
+        E_ERROR("%s: #float32s(%d) doesn't match header dimensions: %d x %d x %d\n",
+                file_name, n, n_sen, n_feat, n_comp);
+        fclose(fp);
+        return NULL;
+    }
+
+    /* Quantize exactly as read_mixw() in s2_semi_mgau.c and
+     * ptm_mgau.c would, transposing to codeword-major order. */
+    mixw = ckd_calloc_3d(n_feat, n_comp, n_sen, sizeof(***mixw));
+    pdf = ckd_calloc(n_comp, sizeof(*pdf));
+    n_err = 0;
+    for (i = 0; i < n_sen; i++) {
+        for (f = 0; f < n_feat; f++) {
+            if (bio_fread(pdf, sizeof(float32), n_comp,
+                          fp, byteswap, &chksum) != n_comp) {
+                E_ERROR("Failed to read mixture weights from %s\n", file_name);
+                ckd_free(pdf);
+                ckd_free_3d(mixw);
+                fclose(fp);
+                return NULL;
+            }
+            if (vector_sum_norm(pdf, n_comp) <= 0.0)
+                n_err++;
+            vector_floor(pdf, n_comp, floor);
+            vector_sum_norm(pdf, n_comp);
+            for (c = 0; c < n_comp; c++) {
+                int32 qscr;
+
+                qscr = -logmath_log(lmath, pdf[c]);
+                if ((qscr > MAX_NEG_MIXW) || (qscr < 0))
+                    qscr = MAX_NEG_MIXW;
+                mixw[f][c][i] = qscr;
+            }
+        }
+    }
+    if (n_err > 0)
+        E_ERROR("Weight normalization failed for %d senones\n", n_err);
+    ckd_free(pdf);
+
+    if (chksum_present)
+        bio_verify_chksum(fp, byteswap, chksum);
+    if (fread(&eofchk, 1, 1, fp) == 1)
+        E_WARN("More data than expected in %s\n", file_name);
+    fclose(fp);
+
+    *out_n_sen = n_sen;
+    *out_n_feat = n_feat;
+    *out_n_comp = n_comp;
+    return mixw;
+}
+
+static int
+write_string(FILE *fp, char const *str, int32 len)
+{
+    if (fwrite(&len, sizeof(len), 1, fp) != 1)
+        return -1;
+    if (len && fwrite(str, 1, len, fp) != (size_t)len)
+        return -1;
+    return 0;
+}
+
+static int
+write_sendump(char const *file_name, uint8 ***mixw,
+              int32 n_sen, int32 n_feat, int32 n_comp)
+{
+    static char const title[] =
+        "mixture weights converted by pocketsphinx_sendump_convert";
+    char header[3][64], pad[SENDUMP_ALIGN];
+    FILE *fp;
+    long offset;
+    int32 hlen, i;
+
+    sprintf(header[0], "feature_count %d", n_feat);
+    sprintf(header[1], "mixture_count %d", n_comp);
+    sprintf(header[2], "model_count %d", n_sen);
+
+    /* The format has no room for padding other than in a header
+     * string, so pad the first one (with NULs) such that the weights
+     * will start on an aligned boundary when the file is mapped. */
+    offset = 4 + sizeof(title) + 4;
+    for (i = 0; i < 3; ++i)
+        offset += 4 + strlen(header[i]) + 1;
+    offset += 4 + 2 * 4;
+    hlen = 1 + (SENDUMP_ALIGN - (offset + 1) % SENDUMP_ALIGN) % SENDUMP_ALIGN;
+    memset(pad, 0, sizeof(pad));
+
+    if ((fp = fopen(file_name, "wb")) == NULL) {
+        E_ERROR_SYSTEM("Failed to open %s for writing", file_name);
+        return -1;
+    }
+    if (write_string(fp, title, sizeof(title)) < 0
+        || write_string(fp, pad, hlen) < 0)
+        goto error_out;
+    for (i = 0; i < 3; ++i)
+        if (write_string(fp, header[i], strlen(header[i]) + 1) < 0)
+            goto error_out;
+    /* End of header strings, then #rows and #columns. */
+    if (write_string(fp, NULL, 0) < 0
+        || fwrite(&n_comp, sizeof(n_comp), 1, fp) != 1
+        || fwrite(&n_sen, sizeof(n_sen), 1, fp) != 1)
+        goto error_out;
+    if (ftell(fp) % SENDUMP_ALIGN != 0)
+        E_WARN("Mixture weights in %s are not aligned\n", file_name);
+    /* The weights are contiguous, as allocated by ckd_calloc_3d(). */
+    if (fwrite(mixw[0][0], 1, (size_t)n_feat * n_comp * n_sen, fp)
+        != (size_t)n_feat * n_comp * n_sen)
+        goto error_out;
+    if (fclose(fp) != 0) {
+        E_ERROR_SYSTEM("Failed to write %s", file_name);
+        return -1;
+    }
+    return 0;
+
+error_out:
+    E_ERROR_SYSTEM("Failed to write %s", file_name);
+    fclose(fp);
+    return -1;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *infile, *outfile;
+    /* These are float32 in the decoder's configuration, and must be
+     * rounded the same way to get the same weights. */
+    float32 logbase = 1.0001f, floor = 0.0000001f;
+    logmath_t *lmath;
+    uint8 ***mixw;
+    int32 n_sen, n_feat, n_comp;
+
+    while (argc > 3 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-logbase") == 0)
+            logbase = (float32)atof(argv[2]);
+        else if (strcmp(argv[1], "-mixwfloor") == 0)
+            floor = (float32)atof(argv[2]);
+        else
+            break;
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s [-logbase BASE] [-mixwfloor FLOOR] "
+                "MIXTURE_WEIGHTS SENDUMP\n", argv[0]);
+        return 1;
+    }
+    infile = argv[1];
+    outfile = argv[2];
+
+    /* Same log table as the decoder uses to quantize them. */
+    if ((lmath = logmath_init(logbase, SENSCR_SHIFT, TRUE)) == NULL) {
+        fprintf(stderr, "Failed to initialize log math for base %f\n",
+                logbase);
+        return 1;
+    }
+    if ((mixw = read_mixw(infile, lmath, floor,
+                          &n_sen, &n_feat, &n_comp)) == NULL) {
+        fprintf(stderr, "Failed to read mixture weights from %s\n", infile);
+        return 1;
+    }
+    if (write_sendump(outfile, mixw, n_sen, n_feat, n_comp) < 0) {
+        fprintf(stderr, "Failed to write sendump to %s\n", outfile);
+        return 1;
+    }
+    ckd_free_3d(mixw);
+    logmath_free(lmath);
+
+    return 0;
+}
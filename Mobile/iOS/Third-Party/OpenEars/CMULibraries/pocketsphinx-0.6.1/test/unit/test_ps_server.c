@@ -0,0 +1,120 @@
+#include <pocketsphinx.h>
+#include <ps_server.h>
+#include <sbthread.h>
+#include <ckd_alloc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test_macros.h"
+
+#define N_STREAMS 4
+#define N_UTTS 2
+
+static sbmtx_t *mtx;
+static sbevent_t *done;
+static int n_done;
+static char *hyps[N_STREAMS][N_UTTS];
+
+static void
+utt_done(ps_stream_t *stream, ps_decoder_t *ps, void *user_data)
+{
+	char **h = user_data;
+	char const *hyp, *uttid;
+	int32 score;
+	int i;
+
+	hyp = ps_get_hyp(ps, &score, &uttid);
+	sbmtx_lock(mtx);
+	for (i = 0; i < N_UTTS; ++i) {
+		if (h[i] == NULL) {
+			h[i] = ckd_salloc(hyp ? hyp : "");
+			break;
+		}
+	}
+	if (++n_done == N_STREAMS * N_UTTS)
+		sbevent_signal(done);
+	sbmtx_unlock(mtx);
+}
+
+int
+main(int argc, char *argv[])
+{
+	ps_decoder_t *ps;
+	ps_server_t *server;
+	ps_stream_t *streams[N_STREAMS];
+	cmd_ln_t *config;
+	FILE *rawfh;
+	int16 *data;
+	long nsamps;
+	char *ref;
+	char const *hyp, *uttid;
+	int32 score;
+	int i, j;
+	size_t pos;
+
+	TEST_ASSERT(config =
+		    cmd_ln_init(NULL, ps_args(), TRUE,
+				"-hmm", MODELDIR "/hmm/en_US/hub4wsj_sc_8k",
+				"-lm", MODELDIR "/lm/en/turtle.DMP",
+				"-dict", MODELDIR "/lm/en/turtle.dic",
+				"-input_endian", "little",
+				"-samprate", "16000", NULL));
+
+	TEST_ASSERT(rawfh = fopen(DATADIR "/goforward.raw", "rb"));
+	fseek(rawfh, 0, SEEK_END);
+	nsamps = ftell(rawfh) / sizeof(*data);
+	fseek(rawfh, 0, SEEK_SET);
+	data = ckd_calloc(nsamps, sizeof(*data));
+	TEST_EQUAL(nsamps, fread(data, sizeof(*data), nsamps, rawfh));
+	fclose(rawfh);
+
+	/* Decode it once on its own. */
+	TEST_ASSERT(ps = ps_init(cmd_ln_retain(config)));
+	TEST_EQUAL(0, ps_start_utt(ps, NULL));
+	TEST_ASSERT(ps_process_raw(ps, data, nsamps, FALSE, TRUE) > 0);
+	TEST_EQUAL(0, ps_end_utt(ps));
+	TEST_ASSERT(hyp = ps_get_hyp(ps, &score, &uttid));
+	ref = ckd_salloc(hyp);
+	printf("REF: %s\n", ref);
+	ps_free(ps);
+
+	/* Then several times at once, in pieces. */
+	mtx = sbmtx_init();
+	done = sbevent_init();
+	TEST_ASSERT(server = ps_server_init(config, 2));
+	for (i = 0; i < N_STREAMS; ++i)
+		TEST_ASSERT(streams[i] = ps_stream_open(server, utt_done, hyps[i]));
+	for (j = 0; j < N_UTTS; ++j) {
+		for (pos = 0; pos < nsamps; pos += 1234) {
+			size_t n = nsamps - pos < 1234 ? nsamps - pos : 1234;
+			for (i = 0; i < N_STREAMS; ++i)
+				TEST_EQUAL(0, ps_stream_write(streams[i],
+							      data + pos, n));
+		}
+		for (i = 0; i < N_STREAMS; ++i)
+			TEST_EQUAL(0, ps_stream_end_utt(streams[i]));
+	}
+	for (i = 0; i < N_STREAMS; ++i)
+		ps_stream_close(streams[i]);
+	sbmtx_lock(mtx);
+	while (n_done < N_STREAMS * N_UTTS) {
+		sbmtx_unlock(mtx);
+		sbevent_wait(done, -1, -1);
+		sbmtx_lock(mtx);
+	}
+	sbmtx_unlock(mtx);
+	ps_server_free(server);
+
+	for (i = 0; i < N_STREAMS; ++i) {
+		for (j = 0; j < N_UTTS; ++j) {
+			printf("%d.%d: %s\n", i, j, hyps[i][j]);
+			TEST_EQUAL(0, strcmp(ref, hyps[i][j]));
+			ckd_free(hyps[i][j]);
+		}
+	}
+	sbevent_free(done);
+	sbmtx_free(mtx);
+	ckd_free(ref);
+	ckd_free(data);
+	return 0;
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <pocketsphinx.h>
+#include <logmath.h>
+#include <profile.h>
+
+#include "acmod.h"
+#include "s2_semi_mgau.h"
+#include "tied_mgau_common.h"
+#include "test_macros.h"
+
+#define N_PASSES 10
+
+/* Evaluate every codebook block for the current frame with both the
+ * vector and the portable code, and check that they agree. */
+static void
+check_blocks(s2_semi_mgau_t *s, mfcc_t **feat)
+{
+	int f, cw;
+
+	for (f = 0; f < s->n_feat; ++f) {
+		mfcc_t *blk = s->blocks[f];
+		for (cw = 0; cw < s->n_density;
+		     cw += MGAU_SIMD_WIDTH, blk += MGAU_BLOCK_SIZE(s->veclen[f])) {
+			mfcc_t dist[MGAU_SIMD_WIDTH], ref[MGAU_SIMD_WIDTH];
+			mfcc_t thresh;
+
+			/* All the way through... */
+			thresh = (mfcc_t)WORST_DIST;
+			mgau_dist_block(blk, feat[f], s->veclen[f], thresh, dist);
+			mgau_dist_block_generic(blk, feat[f], s->veclen[f], thresh, ref);
+			TEST_EQUAL(0, memcmp(dist, ref, sizeof(dist)));
+			/* ...and stopping early for some of them. */
+			thresh = ref[0];
+			mgau_dist_block(blk, feat[f], s->veclen[f], thresh, dist);
+			mgau_dist_block_generic(blk, feat[f], s->veclen[f], thresh, ref);
+			TEST_EQUAL(0, memcmp(dist, ref, sizeof(dist)));
+		}
+	}
+}
+
+/* Score every frame both one at a time and in batches, and check that
+ * they agree. */
+static void
+check_batch(acmod_t *acmod, acmod_t *batch)
+{
+	int n_sen = bin_mdef_n_sen(acmod->mdef);
+
+	TEST_EQUAL(0, acmod_rewind(acmod));
+	TEST_EQUAL(0, acmod_rewind(batch));
+	TEST_EQUAL(acmod->n_feat_frame, batch->n_feat_frame);
+	while (acmod->n_feat_frame > 0) {
+		int16 const *senscr, *batchscr;
+		TEST_ASSERT(senscr = acmod_score(acmod, NULL));
+		TEST_ASSERT(batchscr = acmod_score(batch, NULL));
+		TEST_EQUAL(0, memcmp(senscr, batchscr, n_sen * sizeof(*senscr)));
+		acmod_advance(acmod);
+		acmod_advance(batch);
+	}
+}
+
+/* Time full evaluation of every codebook for every frame, leaving the
+ * distances for the last one in dist. */
+static double
+time_blocks(acmod_t *acmod, int n_frames, int generic, mfcc_t *dist)
+{
+	s2_semi_mgau_t *s = (s2_semi_mgau_t *)acmod->mgau;
+	ptmr_t t;
+	int i, j, f, cw;
+
+	ptmr_init(&t);
+	ptmr_start(&t);
+	for (i = 0; i < N_PASSES; ++i) {
+		for (j = 0; j < n_frames; ++j) {
+			mfcc_t **feat = acmod->feat_buf[j];
+			mfcc_t *out = dist;
+			for (f = 0; f < s->n_feat; ++f) {
+				mfcc_t *blk = s->blocks[f];
+				for (cw = 0; cw < s->n_density;
+				     cw += MGAU_SIMD_WIDTH, blk += MGAU_BLOCK_SIZE(s->veclen[f]),
+					     out += MGAU_SIMD_WIDTH) {
+					if (generic)
+						mgau_dist_block_generic(blk, feat[f], s->veclen[f],
+									(mfcc_t)WORST_DIST, out);
+					else
+						mgau_dist_block(blk, feat[f], s->veclen[f],
+								(mfcc_t)WORST_DIST, out);
+				}
+			}
+		}
+	}
+	ptmr_stop(&t);
+	return t.t_cpu;
+}
+
+int
+main(int argc, char *argv[])
+{
+	acmod_t *acmod, *batch;
+	logmath_t *lmath;
+	cmd_ln_t *config;
+	FILE *rawfh;
+	int16 *buf;
+	int16 const *bptr;
+	size_t nsamps, n_samps;
+	ptmr_t t;
+	double frate, vec_time, gen_time;
+	mfcc_t *dist, *ref;
+	int i, n_frames, n_dist;
+
+	lmath = logmath_init(1.0001, 0, 0);
+	config = cmd_ln_init(NULL, ps_args(), TRUE,
+			     "-featparams", MODELDIR "/hmm/en_US/hub4wsj_sc_8k/feat.params",
+			     "-mdef", MODELDIR "/hmm/en_US/hub4wsj_sc_8k/mdef",
+			     "-mean", MODELDIR "/hmm/en_US/hub4wsj_sc_8k/means",
+			     "-var", MODELDIR "/hmm/en_US/hub4wsj_sc_8k/variances",
+			     "-tmat", MODELDIR "/hmm/en_US/hub4wsj_sc_8k/transition_matrices",
+			     "-sendump", MODELDIR "/hmm/en_US/hub4wsj_sc_8k/sendump",
+			     "-compallsen", "true",
+			     "-tmatfloor", "0.0001",
+			     "-mixwfloor", "0.001",
+			     "-varfloor", "0.0001",
+			     "-mmap", "no",
+			     "-topn", "4",
+			     "-ds", "1",
+			     "-input_endian", "little",
+			     "-samprate", "16000", NULL);
+	TEST_ASSERT(config);
+	TEST_ASSERT(acmod = acmod_init(config, lmath, NULL, NULL));
+	TEST_EQUAL(0, strcmp(acmod->mgau->vt->name, "s2_semi"));
+	frate = cmd_ln_int32_r(config, "-frate");
+
+	/* Compute features for the whole utterance. */
+	TEST_ASSERT(rawfh = fopen(DATADIR "/goforward.raw", "rb"));
+	fseek(rawfh, 0, SEEK_END);
+	n_samps = nsamps = ftell(rawfh) / sizeof(*buf);
+	fseek(rawfh, 0, SEEK_SET);
+	buf = ckd_calloc(nsamps, sizeof(*buf));
+	TEST_EQUAL(nsamps, fread(buf, sizeof(*buf), nsamps, rawfh));
+	fclose(rawfh);
+	bptr = buf;
+	TEST_EQUAL(0, acmod_start_utt(acmod));
+	TEST_ASSERT((n_frames = acmod_process_raw(acmod, &bptr, &nsamps, TRUE)) > 0);
+	TEST_EQUAL(0, acmod_end_utt(acmod));
+
+	/* The same again, to be scored in batches. */
+	cmd_ln_set_int32_r(config, "-scorebatch", 8);
+	TEST_ASSERT(batch = acmod_init(config, lmath, NULL, NULL));
+	TEST_EQUAL(8, batch->n_batch);
+	bptr = buf;
+	nsamps = n_samps;
+	TEST_EQUAL(0, acmod_start_utt(batch));
+	TEST_EQUAL(n_frames, acmod_process_raw(batch, &bptr, &nsamps, TRUE));
+	TEST_EQUAL(0, acmod_end_utt(batch));
+	check_batch(acmod, batch);
+
+	for (i = 0; i < n_frames; ++i)
+		check_blocks((s2_semi_mgau_t *)acmod->mgau, acmod->feat_buf[i]);
+
+	/* Acoustic scoring as the decoder does it, on a single core. */
+	ptmr_init(&t);
+	ptmr_start(&t);
+	for (i = 0; i < N_PASSES; ++i) {
+		TEST_EQUAL(0, acmod_rewind(acmod));
+		while (acmod->n_feat_frame > 0) {
+			TEST_ASSERT(acmod_score(acmod, NULL));
+			acmod_advance(acmod);
+		}
+	}
+	ptmr_stop(&t);
+	printf("Scored %d frames in %.3f sec: %.0f frames/sec (%.1f xRT) per core\n",
+	       N_PASSES * n_frames, t.t_cpu, N_PASSES * n_frames / t.t_cpu,
+	       N_PASSES * n_frames / t.t_cpu / frate);
+
+	/* The codebooks alone. */
+	n_dist = ((s2_semi_mgau_t *)acmod->mgau)->n_feat
+		* (((s2_semi_mgau_t *)acmod->mgau)->n_density + MGAU_SIMD_WIDTH);
+	dist = ckd_calloc(n_dist, sizeof(*dist));
+	ref = ckd_calloc(n_dist, sizeof(*ref));
+	vec_time = time_blocks(acmod, n_frames, FALSE, dist);
+	gen_time = time_blocks(acmod, n_frames, TRUE, ref);
+	TEST_EQUAL(0, memcmp(dist, ref, n_dist * sizeof(*dist)));
+	printf("Codebooks (%d-wide): %.0f frames/sec, portable: %.0f frames/sec\n",
+	       MGAU_SIMD_WIDTH, N_PASSES * n_frames / vec_time,
+	       N_PASSES * n_frames / gen_time);
+
+	ckd_free(dist);
+	ckd_free(ref);
+	ckd_free(buf);
+	acmod_free(batch);
+	acmod_free(acmod);
+	logmath_free(lmath);
+	cmd_ln_free_r(config);
+	return 0;
+}
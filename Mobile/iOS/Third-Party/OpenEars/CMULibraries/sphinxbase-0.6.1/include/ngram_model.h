@@ -150,6 +150,25 @@ char const *ngram_type_to_str(int type);
 SPHINXBASE_EXPORT
 ngram_model_t *ngram_model_retain(ngram_model_t *model);
 
+/**
+ * Retain an N-Gram model for use by several threads at once.
+ *
+ * Scoring some types of models updates a cache inside them (see
+ * ngram_model_flush()), so only one thread can use such a model at a
+ * time.  This retains the model and stops it from using that cache,
+ * after which it can be scored from any number of threads.  Changing
+ * it (adding words, applying weights) is still not safe while any of
+ * them are using it.
+ *
+ * Language model sets cannot be shared this way, as they keep state
+ * of their own.  Use ngram_model_set_share() to create another set
+ * of the same shared models instead.
+ *
+ * @return Pointer to retained model.
+ */
+SPHINXBASE_EXPORT
+ngram_model_t *ngram_model_share(ngram_model_t *model);
+
 /**
  * Release memory associated with an N-Gram model.
  *
@@ -553,6 +572,21 @@ ngram_model_t *ngram_model_set_read(cmd_ln_t *config,
                                     const char *lmctlfile,
                                     logmath_t *lmath);
 
+/**
+ * Create a language model set sharing the models of another one.
+ *
+ * The new set has the same models, names, interpolation weights and
+ * current model as <code>set</code>, with each model retained using
+ * ngram_model_share().  Each of the two sets can then be used by a
+ * different thread, and selecting a model or mapping words in one of
+ * them does not affect the other.
+ *
+ * @param set Language model set to share models with.
+ * @return newly created language model set.
+ */
+SPHINXBASE_EXPORT
+ngram_model_t *ngram_model_set_share(ngram_model_t *set);
+
 /**
  * Returns the number of language models in a set.
  */
@@ -97,18 +97,13 @@ lm3g_bg_score(NGRAM_MODEL_TYPE *model,
 }
 
 static void
-load_tginfo(NGRAM_MODEL_TYPE *model, int32 lw1, int32 lw2)
+find_tginfo(NGRAM_MODEL_TYPE *model, tginfo_t *tginfo, int32 lw1, int32 lw2)
 {
     int32 i, n, b, t;
     bigram_t *bg;
-    tginfo_t *tginfo;
 
-    /* First allocate space for tg information for bg lw1,lw2 */
-    tginfo = (tginfo_t *) listelem_malloc(model->lm3g.le);
     tginfo->w1 = lw1;
     tginfo->tg = NULL;
-    tginfo->next = model->lm3g.tginfo[lw2];
-    model->lm3g.tginfo[lw2] = tginfo;
 
     /* Locate bigram lw1,lw2 */
     b = model->lm3g.unigrams[lw1].bigrams;
@@ -133,6 +128,55 @@ load_tginfo(NGRAM_MODEL_TYPE *model, int32 lw1, int32 lw2)
     }
 }
 
+static void
+load_tginfo(NGRAM_MODEL_TYPE *model, int32 lw1, int32 lw2)
+{
+    tginfo_t *tginfo;
+
+    /* First allocate space for tg information for bg lw1,lw2 */
+    tginfo = (tginfo_t *) listelem_malloc(model->lm3g.le);
+    tginfo->next = model->lm3g.tginfo[lw2];
+    model->lm3g.tginfo[lw2] = tginfo;
+    find_tginfo(model, tginfo, lw1, lw2);
+}
+
+/**
+ * Find the trigrams for bigram lw1,lw2.  These are normally cached,
+ * but if other threads may be using the cache at the same time they
+ * are found anew and stored in shared_tginfo.
+ */
+static tginfo_t *
+lookup_tginfo(NGRAM_MODEL_TYPE *model, tginfo_t *shared_tginfo,
+              int32 lw1, int32 lw2)
+{
+    tginfo_t *tginfo, *prev_tginfo;
+
+    if (model->base.flags & NGRAM_SHARED) {
+        find_tginfo(model, shared_tginfo, lw1, lw2);
+        return shared_tginfo;
+    }
+
+    prev_tginfo = NULL;
+    for (tginfo = model->lm3g.tginfo[lw2]; tginfo; tginfo = tginfo->next) {
+        if (tginfo->w1 == lw1)
+            break;
+        prev_tginfo = tginfo;
+    }
+
+    if (!tginfo) {
+        load_tginfo(model, lw1, lw2);
+        tginfo = model->lm3g.tginfo[lw2];
+    }
+    else if (prev_tginfo) {
+        prev_tginfo->next = tginfo->next;
+        tginfo->next = model->lm3g.tginfo[lw2];
+        model->lm3g.tginfo[lw2] = tginfo;
+    }
+
+    tginfo->used = 1;
+    return tginfo;
+}
+
 /* Similar to find_bg */
 static int32
 find_tg(trigram_t * tg, int32 n, int32 w)
@@ -162,29 +206,12 @@ lm3g_tg_score(NGRAM_MODEL_TYPE *model, int32 lw1,
     ngram_model_t *base = &model->base;
     int32 i, n, score;
     trigram_t *tg;
-    tginfo_t *tginfo, *prev_tginfo;
+    tginfo_t *tginfo, shared_tginfo;
 
     if ((base->n < 3) || (lw1 < 0) || (lw2 < 0))
         return (lm3g_bg_score(model, lw2, lw3, n_used));
 
-    prev_tginfo = NULL;
-    for (tginfo = model->lm3g.tginfo[lw2]; tginfo; tginfo = tginfo->next) {
-        if (tginfo->w1 == lw1)
-            break;
-        prev_tginfo = tginfo;
-    }
-
-    if (!tginfo) {
-        load_tginfo(model, lw1, lw2);
-        tginfo = model->lm3g.tginfo[lw2];
-    }
-    else if (prev_tginfo) {
-        prev_tginfo->next = tginfo->next;
-        tginfo->next = model->lm3g.tginfo[lw2];
-        model->lm3g.tginfo[lw2] = tginfo;
-    }
-
-    tginfo->used = 1;
+    tginfo = lookup_tginfo(model, &shared_tginfo, lw1, lw2);
 
     /* Trigrams for w1,w2 now pointed to by tginfo */
     n = tginfo->n_tg;
@@ -311,28 +338,10 @@ lm3g_template_iter(ngram_model_t *base, int32 wid,
     }
     else if (n_hist == 2) {
         int32 i, n;
-        tginfo_t *tginfo, *prev_tginfo;
-        /* Find the trigram, as in tg_score above (duplicate code...) */
+        tginfo_t *tginfo, shared_tginfo;
+        /* Find the trigram, as in tg_score above */
         itor->ug = model->lm3g.unigrams + history[1];
-        prev_tginfo = NULL;
-        for (tginfo = model->lm3g.tginfo[history[0]];
-             tginfo; tginfo = tginfo->next) {
-            if (tginfo->w1 == history[1])
-                break;
-            prev_tginfo = tginfo;
-        }
-
-        if (!tginfo) {
-            load_tginfo(model, history[1], history[0]);
-            tginfo = model->lm3g.tginfo[history[0]];
-        }
-        else if (prev_tginfo) {
-            prev_tginfo->next = tginfo->next;
-            tginfo->next = model->lm3g.tginfo[history[0]];
-            model->lm3g.tginfo[history[0]] = tginfo;
-        }
-
-        tginfo->used = 1;
+        tginfo = lookup_tginfo(model, &shared_tginfo, history[1], history[0]);
 
         /* Trigrams for w1,w2 now pointed to by tginfo */
         n = tginfo->n_tg;
@@ -239,10 +239,21 @@ ngram_model_retain(ngram_model_t *model)
     return model;
 }
 
+ngram_model_t *
+ngram_model_share(ngram_model_t *model)
+{
+    model->flags |= NGRAM_SHARED;
+    return ngram_model_retain(model);
+}
+
 
 void
 ngram_model_flush(ngram_model_t *model)
 {
+    /* Shared models don't cache anything (and other threads may be
+     * using them). */
+    if (model->flags & NGRAM_SHARED)
+        return;
     if (model->funcs && model->funcs->flush)
         (*model->funcs->flush)(model);
 }
@@ -99,6 +99,9 @@ struct ngram_class_s {
 
 #define NGRAM_HASH_SIZE 128
 
+/** Model is scored by several threads at once (see ngram_model_share()). */
+#define NGRAM_SHARED 0x01
+
 #define NGRAM_BASEWID(wid) ((wid)&0xffffff)
 #define NGRAM_CLASSID(wid) (((wid)>>24) & 0x7f)
 #define NGRAM_CLASSWID(wid,classid) (((classid)<<24) | 0x80000000 | (wid))
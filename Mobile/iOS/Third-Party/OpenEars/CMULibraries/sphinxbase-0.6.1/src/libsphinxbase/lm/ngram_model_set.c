@@ -357,6 +357,31 @@ error_out:
     return set;
 }
 
+ngram_model_t *
+ngram_model_set_share(ngram_model_t *base)
+{
+    ngram_model_set_t *set = (ngram_model_set_t *)base;
+    ngram_model_set_t *model;
+    int32 i;
+
+    model = ckd_calloc(1, sizeof(*model));
+    model->n_models = set->n_models;
+    model->cur = set->cur;
+    model->lms = ckd_calloc(set->n_models, sizeof(*model->lms));
+    model->names = ckd_calloc(set->n_models, sizeof(*model->names));
+    model->lweights = ckd_calloc(set->n_models, sizeof(*model->lweights));
+    for (i = 0; i < set->n_models; ++i) {
+        model->lms[i] = ngram_model_share(set->lms[i]);
+        model->names[i] = ckd_salloc(set->names[i]);
+        model->lweights[i] = set->lweights[i];
+    }
+    /* Everything else is per-set state (mostly the word mapping), so
+     * create it anew. */
+    model->maphist = ckd_calloc(base->n - 1, sizeof(*model->maphist));
+    build_widmap(&model->base, base->lmath, base->n);
+    return &model->base;
+}
+
 int32
 ngram_model_set_count(ngram_model_t *base)
 {
@@ -655,8 +655,13 @@ sbevent_wait(sbevent_t *evt, int sec, int nsec)
 
     /* Lock the mutex before we check its signalled state. */
     pthread_mutex_lock(&evt->mtx);
-    /* If it's not signalled, then wait until it is. */
-    if (!evt->signalled)
+    /* If it's not signalled, then wait until it is (waiting forever
+     * has to cope with spurious wakeups). */
+    if (sec == -1) {
+        while (!evt->signalled && rv == 0)
+            rv = pthread_cond_wait(&evt->cond, &evt->mtx);
+    }
+    else if (!evt->signalled)
         rv = cond_timed_wait(&evt->cond, &evt->mtx, sec, nsec);
     /* Set its state to unsignalled if we were successful. */
     if (rv == 0)
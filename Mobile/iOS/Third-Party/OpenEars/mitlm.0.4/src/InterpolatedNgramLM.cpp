@@ -61,6 +61,7 @@ InterpolatedNgramLM::LoadLMs(const vector<SharedPtr<NgramLMBase> > &lms) {
         for (size_t o = 1; o < ngramMaps[l].size(); o++)
             ngramMap[o] = ngramSortMap[o][ngramMaps[l][o]];
         _lms[l]->SetModel(_pModel, vocabMap, ngramMap);
+        _lms[l]->SetThreadPool(_threadPool);
     }
 
     // Allocate and initialize variables.
@@ -73,21 +74,36 @@ InterpolatedNgramLM::LoadLMs(const vector<SharedPtr<NgramLMBase> > &lms) {
     }
     _weights.reset(maxLen);
     _totWeights.reset(maxLen);
+    _ngramStarts.assign(_order + 1, IndexVector());
+    _histStarts.assign(_order + 1, IndexVector());
 
     // Compute 0th order probability.
     _probVectors[0][0] = 0;
 
-    // Compute default parameters.
+    // Compute default parameters and their bounds.
     //    [LM1Params]...[LMlParams] [BiasParams] [Feat2Params]...[FeatlParams]
     _paramStarts.reset(_lms.size() + 1);
-    VectorBuilder<Param> builder;
+    VectorBuilder<Param> builder, minBuilder, maxBuilder;
     for (size_t l = 0; l < _lms.size(); ++l) {
+        size_t numParams = _lms[l]->defParams().length();
         _paramStarts[l] = builder.length();
         builder.append(_lms[l]->defParams());
+        if (_lms[l]->minParams().length() == numParams) {
+            minBuilder.append(_lms[l]->minParams());
+            maxBuilder.append(_lms[l]->maxParams());
+        } else {
+            minBuilder.append(-HUGE_VAL, numParams);
+            maxBuilder.append(HUGE_VAL, numParams);
+        }
     }
     _paramStarts[_lms.size()] = builder.length();
-    builder.append(0, (_lms.size() - 1) * (_tieParamOrder ? 1 : order()));
+    size_t numBiasParams = (_lms.size() - 1) * (_tieParamOrder ? 1 : order());
+    builder.append(0, numBiasParams);
+    minBuilder.append(-HUGE_VAL, numBiasParams);
+    maxBuilder.append(HUGE_VAL, numBiasParams);
     _defParams = builder;
+    _minParams = minBuilder;
+    _maxParams = maxBuilder;
 
     _featureList.resize(lms.size());
 }
@@ -152,6 +168,8 @@ InterpolatedNgramLM::SetInterpolation(Interpolation interpolation,
             _paramDefaults[r] = _defParams;
             _paramMask.reset(numParams, true);
             _defParams.resize(numParams, 1);
+            _minParams.resize(numParams, -HUGE_VAL);
+            _maxParams.resize(numParams, HUGE_VAL);
         }
         break;
     }
@@ -206,6 +224,14 @@ InterpolatedNgramLM::GetMask(vector<BitVector> &probMaskVectors,
     return pMask;
 }
 
+struct InterpolatedNgramLM::EstimateTask {
+    InterpolatedNgramLM *    lm;
+    InterpolatedNgramLMMask *pMask;
+    size_t                   o;
+    vector<Param>            biases;      // Bias param of each LM
+    vector<const Param *>    featParams;  // Feature params of each LM
+};
+
 bool
 InterpolatedNgramLM::Estimate(const ParamVector &params, Mask *pMask) {
     // Map parameters.
@@ -227,196 +253,229 @@ InterpolatedNgramLM::Estimate(const ParamVector &params, Mask *pMask) {
         _lms[l]->Estimate(lmParams, pLMMask ? pLMMask->LMMasks[l].get() : NULL);
     }
 
-    // Interpolate weighted probabilities and normalize backoff weights.
+    // Interpolate weighted probabilities and normalize backoff weights one
+    // order at a time, splitting the n-grams among threads by history so
+    // that each thread sums over its own histories in the serial order.
     ParamVector interpolationParams(_paramDefaults[
         Range(_paramStarts[_lms.size()], _paramDefaults.length())]);
-    if (pLMMask != NULL) {
-        _EstimateProbsMasked(interpolationParams, pLMMask);
-        _EstimateBowsMasked(pLMMask);
-    } else {
-        _EstimateProbs(interpolationParams);
-        _EstimateBows();
-    }
-    return true;
-}
-
-void
-InterpolatedNgramLM::_EstimateProbs(const ParamVector &params) {
-    const Param *pBiasParams = &params[0];
-    const Param *pFeatParams = &params[(_lms.size() - 1) * 
-                                       (_tieParamOrder ? 1 : order())];
+    const Param *pBiasParams = &interpolationParams[0];
+    const Param *pFeatParams = &interpolationParams[
+        (_lms.size() - 1) * (_tieParamOrder ? 1 : order())];
+    EstimateTask task = { this, pLMMask, 0,
+                          vector<Param>(_lms.size()),
+                          vector<const Param *>(_lms.size()) };
     for (size_t o = 1; o <= _order; o++) {
-        Range              r(sizes(o - 1));
-        ProbVector         weights(_weights[r]);
-        ProbVector         totWeights(_totWeights[r]);
-        ProbVector &       probs(_probVectors[o]);
-        const IndexVector &hists(this->hists(o));
-
-        totWeights.set(0);
-        probs.set(0);
+        if (_ngramStarts[o].length() != numThreads() + 1)
+            GetHistRanges(o, numThreads(), _ngramStarts[o], _histStarts[o]);
+
+        // Find the bias and feature parameters of each LM.
         if (_tieParamOrder) {
-            pBiasParams = &params[0];
-            pFeatParams = &params[_lms.size() - 1];
+            pBiasParams = &interpolationParams[0];
+            pFeatParams = &interpolationParams[_lms.size() - 1];
         }
         const Param *pLMFeatParams = pFeatParams;
         for (size_t l = 0; l < _lms.size(); l++) {
             if (_tieParamLM)
                 pFeatParams = pLMFeatParams;
-
-            // Initialize weights with bias.
-            weights.set((l == 0) ? 0 : *pBiasParams++);
-
-            // Compute weights from log-linear combination of features.
-            for (size_t f = 0; f < _featureList[l].size(); f++) {
-                Param param = *pFeatParams++;
-                if (param == 0) continue;
-                // weights += _featureList[l][f][o-1] * param;
-                for (size_t i = 0; i < _probVectors[o-1].length(); ++i)
-                    weights[i] += _featureList[l][f][o-1][i] * param;
-            }
-
-            // Compute component weights and update total weights.
-            // weights = exp(weights);
-            // totWeights += weights;
-            for (size_t i = 0; i < weights.length(); ++i) {
-                weights[i] = exp(weights[i]);
-                totWeights[i] += weights[i];
-            }
-
-            // Interpolate component LM probabilities.
-            //probs += _lms[l]->probs(o) * weights[hists];
-            const ProbVector &lmProbs(_lms[l]->probs(o));
-            for (size_t i = 0; i < probs.length(); ++i)
-                probs[i] += lmProbs[i] * weights[hists[i]];
+            task.biases[l] = (l == 0) ? 0 : *pBiasParams++;
+            task.featParams[l] = pFeatParams;
+            pFeatParams += _featureList[l].size();
         }
-        assert(allTrue(totWeights != 0));
-        assert(!anyTrue(isnan(probs)));
-        assert(allTrue(hists >= 0));
 
-        // Normalize probabilities.
-        //probs /= totWeights[hists];
-        for (size_t i = 0; i < probs.length(); ++i)
-            probs[i] /= totWeights[hists[i]];
-        assert(!anyTrue(isnan(probs)));
+        task.o = o;
+        RunTask(&_RunEstimate, &task);
+        assert(pLMMask != NULL || !anyTrue(isnan(_probVectors[o])));
+        assert(pLMMask != NULL || !anyTrue(isnan(_bowVectors[o - 1])));
     }
+    return true;
 }
 
 void
-InterpolatedNgramLM::_EstimateBows() {
-    for (size_t o = 1; o <= _order; o++) {
-        ProbVector &       bows(_bowVectors[o - 1]);
-        const ProbVector & probs(this->probs(o));
-        const ProbVector & boProbs(this->probs(o - 1));
-        const IndexVector &hists(this->hists(o));
-        const IndexVector &backoffs(this->backoffs(o));
-
-        Range      r(sizes(o - 1));
-        ProbVector numerator(_weights[r]);       // Reuse buffers.
-        ProbVector denominator(_totWeights[r]);  // Reuse buffers.
-        numerator.set(0);
-        denominator.set(0);
+InterpolatedNgramLM::SetThreadPool(const SharedPtr<ThreadPool> &threadPool) {
+    NgramLMBase::SetThreadPool(threadPool);
+    for (size_t l = 0; l < _lms.size(); l++)
+        _lms[l]->SetThreadPool(threadPool);
+}
 
-        for (size_t i = 0; i < probs.length(); ++i) {
-            numerator[hists[i]] += probs[i];
-            denominator[hists[i]] += boProbs[backoffs[i]];
-        }
-        for (size_t i = 0; i < bows.length(); ++i)
-            bows[i] = (1 - numerator[i]) / (1 - denominator[i]);
-        assert(!anyTrue(isnan(bows)));
+void
+InterpolatedNgramLM::_RunEstimate(void *arg, size_t t) {
+    const EstimateTask &task = *static_cast<EstimateTask *>(arg);
+    if (task.pMask != NULL) {
+        task.lm->_EstimateProbsMasked(task, t);
+        task.lm->_EstimateBowsMasked(task.o, task.pMask, t);
+    } else {
+        task.lm->_EstimateProbs(task, t);
+        task.lm->_EstimateBows(task.o, t);
     }
 }
 
+// The methods below estimate order o for the n-grams and histories of range
+// t, using _weights and _totWeights over those histories only.  Workers may
+// not create vector views, so they index the buffers directly or pass their
+// ranges to the kernels of VectorKernels.h.
 void
-InterpolatedNgramLM::_EstimateProbsMasked(const ParamVector &params,
-                                          InterpolatedNgramLMMask *pMask) {
-    assert(pMask != NULL);
-
-    const Param *pBiasParams = &params[0];
-    const Param *pFeatParams = &params[(_lms.size() - 1) * 
-                                       (_tieParamOrder ? 1 : order())];
-    for (size_t o = 1; o <= _order; o++) {
-        Range              r(sizes(o - 1));
-        ProbVector         weights(_weights[r]);
-        ProbVector         totWeights(_totWeights[r]);
-        ProbVector &       probs(_probVectors[o]);
-        const IndexVector &hists(this->hists(o));
-
-        totWeights.set(0);
-        probs.set(0);
-        if (_tieParamOrder) {
-            pBiasParams = &params[0];
-            pFeatParams = &params[_lms.size() - 1];
+InterpolatedNgramLM::_EstimateProbs(const EstimateTask &task, size_t t) {
+    size_t             o = task.o;
+    ProbVector &       weights(_weights);
+    ProbVector &       totWeights(_totWeights);
+    ProbVector &       probs(_probVectors[o]);
+    const IndexVector &hists(this->hists(o));
+    size_t begin = _ngramStarts[o][t], end = _ngramStarts[o][t + 1];
+    size_t histBegin = _histStarts[o][t], histEnd = _histStarts[o][t + 1];
+
+    for (size_t h = histBegin; h < histEnd; ++h)
+        totWeights[h] = 0;
+    for (size_t i = begin; i < end; ++i)
+        probs[i] = 0;
+    size_t numHists = histEnd - histBegin;
+    Prob * pWeights = weights.data() + histBegin;
+    Prob * pTotWeights = totWeights.data() + histBegin;
+    for (size_t l = 0; l < _lms.size(); l++) {
+        // Initialize weights with bias.
+        std::fill_n(pWeights, numHists, task.biases[l]);
+
+        // Compute weights from log-linear combination of features.
+        for (size_t f = 0; f < _featureList[l].size(); f++) {
+            Param param = task.featParams[l][f];
+            if (param == 0) continue;
+            // weights += _featureList[l][f][o-1] * param;
+            const DoubleVector &feature(_featureList[l][f][o-1]);
+            VecMultAdd(feature.data() + histBegin, param, pWeights, numHists);
         }
-        const Param *pLMFeatParams = pFeatParams;
-        for (size_t l = 0; l < _lms.size(); ++l) {
-            if (_tieParamLM)
-                pFeatParams = pLMFeatParams;
 
-            // Initialize weights with bias.
-            weights.set((l == 0) ? 0 : *pBiasParams++);
-
-            // Compute weights from log-linear combination of features.
-            for (size_t f = 0; f < _featureList[l].size(); ++f) {
-                Param param = *pFeatParams++;
-                if (param == 0) continue;
-                for (size_t i = 0; i < _probVectors[o-1].length(); ++i)
-                    if (pMask->WeightMaskVectors[o-1][i])
-                        weights[i] += _featureList[l][f][o-1][i] * param;
-            }
+        // Compute component weights and update total weights.
+        // weights = exp(weights);
+        // totWeights += weights;
+        VecExp(pWeights, pWeights, numHists);
+        VecAdd(pTotWeights, pWeights, pTotWeights, numHists);
+
+        // Interpolate component LM probabilities.
+        //probs += _lms[l]->probs(o) * weights[hists];
+        const ProbVector &lmProbs(_lms[l]->probs(o));
+        for (size_t i = begin; i < end; ++i)
+            probs[i] += lmProbs[i] * weights[hists[i]];
+    }
+    for (size_t h = histBegin; h < histEnd; ++h)
+        assert(totWeights[h] != 0);
+    for (size_t i = begin; i < end; ++i)
+        assert(hists[i] >= 0);
+
+    // Normalize probabilities.
+    //probs /= totWeights[hists];
+    for (size_t i = begin; i < end; ++i)
+        probs[i] /= totWeights[hists[i]];
+}
 
-            // Compute component weights and update total weights.
-            //weights.mask(pMask->WeightMaskVectors[o - 1]) = exp(weights);
-            //totWeights.mask(pMask->WeightMaskVectors[o - 1]) += weights;
-            for (size_t i = 0; i < weights.length(); ++i) {
-                if (pMask->WeightMaskVectors[o-1][i]) {
-                    weights[i] = exp(weights[i]);
-                    totWeights[i] += weights[i];
-                }
-            }
+void
+InterpolatedNgramLM::_EstimateBows(size_t o, size_t t) {
+    ProbVector &       bows(_bowVectors[o - 1]);
+    const ProbVector & probs(this->probs(o));
+    const ProbVector & boProbs(this->probs(o - 1));
+    const IndexVector &hists(this->hists(o));
+    const IndexVector &backoffs(this->backoffs(o));
+    ProbVector &       numerator(_weights);       // Reuse buffers.
+    ProbVector &       denominator(_totWeights);  // Reuse buffers.
+    size_t begin = _ngramStarts[o][t], end = _ngramStarts[o][t + 1];
+    size_t histBegin = _histStarts[o][t], histEnd = _histStarts[o][t + 1];
+
+    for (size_t h = histBegin; h < histEnd; ++h) {
+        numerator[h] = 0;
+        denominator[h] = 0;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        numerator[hists[i]] += probs[i];
+        denominator[hists[i]] += boProbs[backoffs[i]];
+    }
+    for (size_t h = histBegin; h < histEnd; ++h)
+        bows[h] = (1 - numerator[h]) / (1 - denominator[h]);
+}
 
-            // Interpolate component LM probabilities.
-            const ProbVector &lmProbs(_lms[l]->probs(o));
-            for (size_t i = 0; i < probs.length(); ++i)
-                //probs.mask(pMask->ProbMaskVectors[o]) +=
-                //    lmProbs * weights[hists];
-                if (pMask->ProbMaskVectors[o][i])
-                    probs[i] += lmProbs[i] * weights[hists[i]];
+void
+InterpolatedNgramLM::_EstimateProbsMasked(const EstimateTask &task, size_t t) {
+    size_t                   o = task.o;
+    InterpolatedNgramLMMask *pMask = task.pMask;
+    ProbVector &             weights(_weights);
+    ProbVector &             totWeights(_totWeights);
+    ProbVector &             probs(_probVectors[o]);
+    const IndexVector &      hists(this->hists(o));
+    const BitVector &        weightMask(pMask->WeightMaskVectors[o-1]);
+    const BitVector &        probMask(pMask->ProbMaskVectors[o]);
+    size_t begin = _ngramStarts[o][t], end = _ngramStarts[o][t + 1];
+    size_t histBegin = _histStarts[o][t], histEnd = _histStarts[o][t + 1];
+
+    for (size_t h = histBegin; h < histEnd; ++h)
+        totWeights[h] = 0;
+    for (size_t i = begin; i < end; ++i)
+        probs[i] = 0;
+    size_t      numHists = histEnd - histBegin;
+    Prob *      pWeights = weights.data() + histBegin;
+    Prob *      pTotWeights = totWeights.data() + histBegin;
+    const byte *pWeightMask = weightMask.data() + histBegin;
+    for (size_t l = 0; l < _lms.size(); ++l) {
+        // Initialize weights with bias.
+        std::fill_n(pWeights, numHists, task.biases[l]);
+
+        // Compute weights from log-linear combination of features.
+        for (size_t f = 0; f < _featureList[l].size(); ++f) {
+            Param param = task.featParams[l][f];
+            if (param == 0) continue;
+            const DoubleVector &feature(_featureList[l][f][o-1]);
+            VecMultAddMasked(feature.data() + histBegin, param, pWeightMask,
+                             pWeights, numHists);
         }
-        // Normalize probabilities.
-        for (size_t i = 0; i < probs.length(); ++i)
-            if (pMask->ProbMaskVectors[o][i])
-                probs[i] /= totWeights[hists[i]];
+
+        // Compute component weights and update total weights.
+        //weights.mask(pMask->WeightMaskVectors[o - 1]) = exp(weights);
+        //totWeights.mask(pMask->WeightMaskVectors[o - 1]) += weights;
+        VecExpMasked(pWeights, pWeightMask, pWeights, numHists);
+        VecAddMasked(pWeights, pWeightMask, pTotWeights, numHists);
+
+        // Interpolate component LM probabilities.
+        const ProbVector &lmProbs(_lms[l]->probs(o));
+        for (size_t i = begin; i < end; ++i)
+            //probs.mask(pMask->ProbMaskVectors[o]) +=
+            //    lmProbs * weights[hists];
+            if (probMask[i])
+                probs[i] += lmProbs[i] * weights[hists[i]];
     }
+    // Normalize probabilities.
+    for (size_t i = begin; i < end; ++i)
+        if (probMask[i])
+            probs[i] /= totWeights[hists[i]];
 }
 
 void
-InterpolatedNgramLM::_EstimateBowsMasked(InterpolatedNgramLMMask *pMask) {
-    for (size_t o = 1; o <= _order; o++) {
-        ProbVector &       bows(_bowVectors[o - 1]);
-        const ProbVector & probs(this->probs(o));
-        const ProbVector & boProbs(this->probs(o - 1));
-        const IndexVector &hists(this->hists(o));
-        const IndexVector &backoffs(this->backoffs(o));
+InterpolatedNgramLM::_EstimateBowsMasked(size_t o,
+                                         InterpolatedNgramLMMask *pMask,
+                                         size_t t) {
+    ProbVector &       bows(_bowVectors[o - 1]);
+    const ProbVector & probs(this->probs(o));
+    const ProbVector & boProbs(this->probs(o - 1));
+    const IndexVector &hists(this->hists(o));
+    const IndexVector &backoffs(this->backoffs(o));
+    const BitVector &  bowMask(pMask->BowMaskVectors[o-1]);
+    ProbVector &       numerator(_weights);       // Reuse buffers.
+    ProbVector &       denominator(_totWeights);  // Reuse buffers.
+    size_t begin = _ngramStarts[o][t], end = _ngramStarts[o][t + 1];
+    size_t histBegin = _histStarts[o][t], histEnd = _histStarts[o][t + 1];
+
+    for (size_t h = histBegin; h < histEnd; ++h) {
+        numerator[h] = 0;
+        denominator[h] = 0;
+    }
 
-        Range      r(sizes(o - 1));
-        ProbVector numerator(_weights[r]);       // Reuse buffers.
-        ProbVector denominator(_totWeights[r]);  // Reuse buffers.
-        numerator.set(0);
-        denominator.set(0);
-
-        // BitVector m = pMask->BowMaskVectors[o-1][hists];
-        // numerator[hists].masked(m) += probs;
-        // denominator[hists].masked(m) += boProbs[backoffs];
-        for (size_t i = 0; i < probs.length(); ++i) {
-            if (pMask->BowMaskVectors[o-1][hists[i]]) {
-                numerator[hists[i]] += probs[i];
-                denominator[hists[i]] += boProbs[backoffs[i]];
-            }
+    // BitVector m = pMask->BowMaskVectors[o-1][hists];
+    // numerator[hists].masked(m) += probs;
+    // denominator[hists].masked(m) += boProbs[backoffs];
+    for (size_t i = begin; i < end; ++i) {
+        if (bowMask[hists[i]]) {
+            numerator[hists[i]] += probs[i];
+            denominator[hists[i]] += boProbs[backoffs[i]];
         }
-        //bows.masked(pMask->BowMaskVectors[o-1]) = (1 - numerator) /
-        //                                          (1 - denominator);
-        for (size_t i = 0; i < bows.length(); ++i)
-            if (pMask->BowMaskVectors[o-1][i])
-                bows[i] = (1 - numerator[i]) / (1 - denominator[i]);
     }
+    //bows.masked(pMask->BowMaskVectors[o-1]) = (1 - numerator) /
+    //                                          (1 - denominator);
+    for (size_t h = histBegin; h < histEnd; ++h)
+        if (bowMask[h])
+            bows[h] = (1 - numerator[h]) / (1 - denominator[h]);
 }
@@ -67,6 +67,8 @@ protected:
     BitVector                       _paramMask;
     bool                            _tieParamOrder;
     bool                            _tieParamLM;
+    vector<IndexVector>             _ngramStarts;
+    vector<IndexVector>             _histStarts;
 
 public:
     InterpolatedNgramLM(size_t order = 3, 
@@ -83,13 +85,16 @@ public:
     virtual Mask *GetMask(vector<BitVector> &probMaskVectors,
                           vector<BitVector> &bowMaskVectors) const;
     virtual bool  Estimate(const ParamVector &params, Mask *pMask=NULL);
+    virtual void  SetThreadPool(const SharedPtr<ThreadPool> &threadPool);
 
 private:
-    void _EstimateProbs(const ParamVector &params);
-    void _EstimateBows();
-    void _EstimateProbsMasked(const ParamVector &params,
-                              InterpolatedNgramLMMask *pMask);
-    void _EstimateBowsMasked(InterpolatedNgramLMMask *pMask);
+    struct EstimateTask;
+    static void _RunEstimate(void *arg, size_t t);
+    void _EstimateProbs(const EstimateTask &task, size_t t);
+    void _EstimateBows(size_t o, size_t t);
+    void _EstimateProbsMasked(const EstimateTask &task, size_t t);
+    void _EstimateBowsMasked(size_t o, InterpolatedNgramLMMask *pMask,
+                             size_t t);
 };
 
 #endif // INTERPOLATEDNGRAMLM_H
@@ -33,6 +33,8 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
 #include "util/Logger.h"
 #include "NgramLM.h"
 #include "Mask.h"
@@ -95,6 +97,9 @@ void KneserNeySmoothing::Initialize(NgramLM *pLM, size_t order) {
         if (_discParams[i] > i) _discParams[i] = i;
     }
 
+    // Split n-grams among threads on the next Estimate().
+    _ngramStarts.reset(0);
+
     // Set default parameters.
     if (_tuneParams)
         _defParams = _discParams[Range(1, _discParams.length())];
@@ -103,6 +108,15 @@ void KneserNeySmoothing::Initialize(NgramLM *pLM, size_t order) {
 
     // Set n-gram weighting parameters.
     _defParams.resize(_defParams.length() + _pLM->features(order).size(), 0);
+
+    // Set parameter bounds checked by Estimate().
+    size_t numDiscParams = _tuneParams ? _discOrder : 0;
+    _minParams.reset(_defParams.length(), -HUGE_VAL);
+    _maxParams.reset(_defParams.length(), 100);
+    for (size_t i = 0; i < numDiscParams; i++) {
+        _minParams[i] = 0;
+        _maxParams[i] = i + 1;
+    }
 }
 
 void
@@ -131,6 +145,97 @@ KneserNeySmoothing::UpdateMask(NgramLMMask &lmMask) const {
     lmMask.SmoothingMasks[_order] = pSmoothingMask;
 }
 
+// Only n-grams whose adjusted counts change, or whose histories have one
+// that does, or whose backoff probs change, need to be re-estimated.  The
+// discounts stay as they were, even those estimated from count stats.
+void
+KneserNeySmoothing::Update(const vector<CountVector> &deltaVectors,
+                           NgramLMMask &lmMask) {
+    if (_pLM->features(_order).size() > 0)
+        throw std::runtime_error("Cannot update weighted n-grams.");
+
+    const CountVector &counts(_pLM->counts(_order));
+    const CountVector &deltas(deltaVectors[_order]);
+    const IndexVector &hists(_pLM->hists(_order));
+    const IndexVector &backoffs(_pLM->backoffs(_order));
+    size_t             numNgrams = counts.length();
+    BitVector          changed(numNgrams, 0);
+    if (_order < _pLM->order()) {
+        // Left-branch counts change where a higher order n-gram is first seen.
+        const CountVector &hoCounts(_pLM->counts(_order + 1));
+        const CountVector &hoDeltas(deltaVectors[_order + 1]);
+        const IndexVector &hoBackoffs(_pLM->backoffs(_order + 1));
+        BitVector          affected(numNgrams, 0);
+        for (size_t i = 0; i < numNgrams; i++)
+            if (deltas[i] != 0) affected[i] = 1;
+        for (size_t i = 0; i < hoCounts.length(); i++)
+            if (hoDeltas[i] != 0 && hoCounts[i] == hoDeltas[i])
+                affected[hoBackoffs[i]] = 1;
+
+        // Recompute adjusted counts of the affected n-grams as Initialize().
+        vector<NgramIndex> indices;
+        vector<Count>      oldEffCounts;
+        _effCounts.resize(numNgrams, 0);
+        for (size_t i = 0; i < numNgrams; i++)
+            if (affected[i]) {
+                indices.push_back(i);
+                oldEffCounts.push_back(_effCounts[i]);
+                _effCounts[i] = 0;
+            }
+        for (size_t i = 0; i < hoCounts.length(); i++)
+            if (hoCounts[i] > 0 && affected[hoBackoffs[i]])
+                _effCounts[hoBackoffs[i]]++;
+        for (size_t k = 0; k < indices.size(); k++) {
+            NgramIndex i = indices[k];
+            if (_effCounts[i] == 0) _effCounts[i] = counts[i];
+            if (_effCounts[i] != oldEffCounts[k]) changed[i] = 1;
+        }
+    } else {
+        // Counts may have been reallocated.
+        _effCounts.attach(counts);
+        for (size_t i = 0; i < numNgrams; i++)
+            if (deltas[i] != 0) changed[i] = 1;
+    }
+
+    // Recompute inverse history counts where adjusted counts changed.
+    BitVector &histMask(lmMask.BowMaskVectors[_order - 1]);
+    for (size_t i = 0; i < numNgrams; i++)
+        if (changed[i]) histMask[hists[i]] = 1;
+    _invHistCounts.resize(_pLM->sizes(_order - 1), 0);
+    for (size_t h = 0; h < histMask.length(); h++)
+        if (histMask[h]) _invHistCounts[h] = 0;
+    for (size_t i = 0; i < numNgrams; i++)
+        if (histMask[hists[i]]) _invHistCounts[hists[i]] += _effCounts[i];
+    for (size_t h = 0; h < histMask.length(); h++)
+        if (histMask[h] && _invHistCounts[h] != 0)
+            _invHistCounts[h] = (Param)1 / _invHistCounts[h];
+
+    // Re-estimate those histories and the ones with a changed backoff prob.
+    // As in UpdateMask(), re-estimating a prob needs its history's bow, and
+    // so the discounts of all n-grams with that history, which the masked
+    // estimate keeps in the probs vector.  Hence re-estimate them all.
+    BitVector &      probMask(lmMask.ProbMaskVectors[_order]);
+    const BitVector &boProbMask(lmMask.ProbMaskVectors[_order - 1]);
+    for (size_t i = 0; i < numNgrams; i++)
+        if (boProbMask[backoffs[i]]) histMask[hists[i]] = 1;
+    for (size_t i = 0; i < numNgrams; i++)
+        if (histMask[hists[i]]) probMask[i] = 1;
+    KneserNeySmoothingMask *pSmoothingMask = new KneserNeySmoothingMask();
+    pSmoothingMask->DiscMask = histMask[hists];
+    lmMask.SmoothingMasks[_order] = pSmoothingMask;
+
+    // Split n-grams among threads again on the next Estimate().
+    _ngramStarts.reset(0);
+}
+
+struct KneserNeySmoothing::EstimateTask {
+    KneserNeySmoothing *smoothing;
+    const NgramLMMask * pMask;
+    ProbVector *        probs;
+    ProbVector *        bows;
+    const Param *       featParams;
+};
+
 bool
 KneserNeySmoothing::Estimate(const ParamVector &params,
                              const NgramLMMask *pMask,
@@ -155,185 +260,280 @@ KneserNeySmoothing::Estimate(const ParamVector &params,
             return false;
         }
 
-    // Compute n-gram weights and inverse history counts, if necessary.
-    size_t numFeatures = _pLM->features(_order).size();
-    if (numFeatures > 0) {
-        Range r(numDiscParams, numDiscParams + numFeatures);
-        _ComputeWeights(ParamVector(params[r]));
-        _invHistCounts.set(0);
-        BinWeight(_pLM->hists(_order), _effCounts * _ngramWeights,
-                  _invHistCounts);
-        _invHistCounts = CondExpr(_invHistCounts == 0,
-                                  0, (Param)1 / _invHistCounts);
-    }
+    // Split n-grams among the LM's threads, by history so that each thread
+    // sums the backoff weights of its own histories in the serial order.
+    size_t numThreads = _pLM->numThreads();
+    if (_ngramStarts.length() != numThreads + 1)
+        _pLM->GetHistRanges(_order, numThreads, _ngramStarts, _histStarts);
 
     // Estimate probs and bows using optimized methods.
-    if (numFeatures > 0) {
-        if (pMask != NULL)
-            _EstimateWeightedMasked(pMask, probs, bows);
+    EstimateTask task = { this, pMask, &probs, &bows,
+                         params.begin() + numDiscParams };
+    _pLM->RunTask(&_RunEstimate, &task);
+    return true;
+}
+
+void
+KneserNeySmoothing::_RunEstimate(void *arg, size_t t) {
+    EstimateTask &      task = *static_cast<EstimateTask *>(arg);
+    KneserNeySmoothing &s = *task.smoothing;
+    if (s._pLM->features(s._order).size() > 0) {
+        s._ComputeWeights(task.featParams, t);
+        if (task.pMask != NULL)
+            s._EstimateWeightedMasked(task.pMask, *task.probs, *task.bows, t);
         else
-            _EstimateWeighted(probs, bows);
+            s._EstimateWeighted(*task.probs, *task.bows, t);
     } else {
-        if (pMask != NULL)
-            _EstimateMasked(pMask, probs, bows);
+        if (task.pMask != NULL)
+            s._EstimateMasked(task.pMask, *task.probs, *task.bows, t);
         else
-            _Estimate(probs, bows);
+            s._Estimate(*task.probs, *task.bows, t);
     }
-    return true;
 }
 
+// Compute n-gram weights and inverse history counts for range t.
 void
-KneserNeySmoothing::_ComputeWeights(const ParamVector &featParams) {
-    _ngramWeights.set(0);
-    for (size_t f = 0; f < featParams.length(); ++f)
+KneserNeySmoothing::_ComputeWeights(const Param *featParams, size_t t) {
+    const FeatureVectors &features(_pLM->features(_order));
+    const IndexVector &   hists(_pLM->hists(_order));
+    size_t begin = _ngramStarts[t], end = _ngramStarts[t + 1];
+    size_t histBegin = _histStarts[t], histEnd = _histStarts[t + 1];
+
+    // _ngramWeights = exp(sum(features[f] * featParams[f]));
+    for (size_t i = begin; i < end; i++)
+        _ngramWeights[i] = 0;
+    for (size_t f = 0; f < features.size(); ++f)
         if (featParams[f] != 0)
-            _ngramWeights += _pLM->features(_order)[f] * featParams[f];
-    _ngramWeights = exp(_ngramWeights);
+            for (size_t i = begin; i < end; i++)
+                _ngramWeights[i] += features[f][i] * featParams[f];
+    for (size_t i = begin; i < end; i++)
+        _ngramWeights[i] = exp(_ngramWeights[i]);
+
+    // BinWeight(hists, _effCounts * _ngramWeights, _invHistCounts);
+    for (size_t h = histBegin; h < histEnd; h++)
+        _invHistCounts[h] = 0;
+    for (size_t i = begin; i < end; i++)
+        _invHistCounts[hists[i]] += _effCounts[i] * _ngramWeights[i];
+    for (size_t h = histBegin; h < histEnd; h++)
+        if (_invHistCounts[h] != 0)
+            _invHistCounts[h] = (Param)1 / _invHistCounts[h];
 }
 
+// The kernels below estimate the n-grams and histories of range t using
+// plain loops, as workers may not create vector views.  Each computes the
+// same expressions in the same order as its serial equivalent in comments.
 void
-KneserNeySmoothing::_Estimate(ProbVector &probs, ProbVector &bows) {
+KneserNeySmoothing::_Estimate(ProbVector &probs, ProbVector &bows, size_t t) {
     const IndexVector &hists(_pLM->hists(_order));
     const IndexVector &backoffs(_pLM->backoffs(_order));
     const ProbVector & boProbs(_pLM->probs(_order - 1));
+    size_t begin = _ngramStarts[t], end = _ngramStarts[t + 1];
+    size_t histBegin = _histStarts[t], histEnd = _histStarts[t + 1];
 
     // Compute discounts.
+    // discounts = _discParams[min(_effCounts, _discOrder)];
     ProbVector &discounts(probs);  // Reuse probs vector for discounts.
-    discounts = _discParams[min(_effCounts, _discOrder)];
+    for (size_t i = begin; i < end; i++)
+        discounts[i] = _discParams[min(_effCounts[i], (int)_discOrder)];
 
     // Compute backoff weights.
-    bows.set(0);
-    BinWeight(hists, discounts, bows);
-    bows = CondExpr(_invHistCounts == 0, 1, bows * _invHistCounts);
+    // BinWeight(hists, discounts, bows);
+    // bows = CondExpr(_invHistCounts == 0, 1, bows * _invHistCounts);
+    for (size_t h = histBegin; h < histEnd; h++)
+        bows[h] = 0;
+    for (size_t i = begin; i < end; i++)
+        bows[hists[i]] += discounts[i];
+    for (size_t h = histBegin; h < histEnd; h++)
+        bows[h] = (_invHistCounts[h] == 0) ? 1 : bows[h] * _invHistCounts[h];
 
     // Compute interpolated probabilities.
-    if (_order == 1 && !_pLM->vocab().IsFixedVocab())
-        probs = CondExpr(!_effCounts, 0,
-                         (_effCounts - discounts) * _invHistCounts[hists]
-                         + boProbs[backoffs] * bows[hists]);
-    else
-        probs = CondExpr(!_effCounts, 0,
-                         (_effCounts - discounts) * _invHistCounts[hists])
-                + boProbs[backoffs] * bows[hists];
+    // probs = CondExpr(!_effCounts, 0,
+    //                  (_effCounts - discounts) * _invHistCounts[hists])
+    //         + boProbs[backoffs] * bows[hists];
+    // With an open vocab, unigrams with no counts get no backoff prob.
+    bool boZeros = (_order == 1 && !_pLM->vocab().IsFixedVocab());
+    for (size_t i = begin; i < end; i++) {
+        Prob boProb = boProbs[backoffs[i]] * bows[hists[i]];
+        if (_effCounts[i])
+            probs[i] = (_effCounts[i] - discounts[i]) * _invHistCounts[hists[i]]
+                + boProb;
+        else
+            probs[i] = boZeros ? 0 : boProb;
+    }
 }
 
 void
 KneserNeySmoothing::_EstimateMasked(const NgramLMMask *pMask,
-                                    ProbVector &probs, ProbVector &bows) {
+                                    ProbVector &probs, ProbVector &bows,
+                                    size_t t) {
     const IndexVector &hists(_pLM->hists(_order));
     const IndexVector &backoffs(_pLM->backoffs(_order));
     const ProbVector & boProbs(_pLM->probs(_order - 1));
+    size_t begin = _ngramStarts[t], end = _ngramStarts[t + 1];
+    size_t histBegin = _histStarts[t], histEnd = _histStarts[t + 1];
 
     // Compute discounts.
     ProbVector &discounts(probs);  // Reuse probs vector for discounts.
     const BitVector &discMask(((KneserNeySmoothingMask *)
                               pMask->SmoothingMasks[_order].get())->DiscMask);
     assert(discMask.length() == _effCounts.length());
-//    discounts.masked(discMask) = _discParams[min(_effCounts, _discOrder)];
-    for (size_t i = 0; i < _effCounts.length(); i++)
+    for (size_t i = begin; i < end; i++)
         if (discMask[i])
             discounts[i] = _discParams[min(_effCounts[i], (int)_discOrder)];
 
     // Compute backoff weights.
     const BitVector &bowMask(pMask->BowMaskVectors[_order - 1]);
-    MaskedVectorClosure<ProbVector, BitVector> maskedBows(bows.masked(bowMask));
-    maskedBows.set(0);
-    BinWeight(hists, discounts, maskedBows);
-//    maskedBows = CondExpr(_invHistCounts == 0, 1, bows * _invHistCounts);
-    for (size_t i = 0; i < bows.length(); i++)
-        if (bowMask[i]) {
-            if (_invHistCounts[i] == 0)
-                bows[i] = 1;
+    for (size_t h = histBegin; h < histEnd; h++)
+        if (bowMask[h])
+            bows[h] = 0;
+    for (size_t i = begin; i < end; i++)
+        if (bowMask[hists[i]])
+            bows[hists[i]] += discounts[i];
+    for (size_t h = histBegin; h < histEnd; h++)
+        if (bowMask[h]) {
+            if (_invHistCounts[h] == 0)
+                bows[h] = 1;
             else
-                bows[i] *= _invHistCounts[i];
+                bows[h] *= _invHistCounts[h];
         }
 
     // Compute interpolated probabilities.
     const BitVector &probMask(pMask->ProbMaskVectors[_order]);
-    if (_order == 1 && !_pLM->vocab().IsFixedVocab())
-        probs.masked(probMask) =
-            CondExpr(!_effCounts, 0,
-                     (_effCounts - discounts) * _invHistCounts[hists]
-                     + boProbs[backoffs] * bows[hists]);
-    else
-        probs.masked(probMask) =
-            CondExpr(!_effCounts, 0,
-                     (_effCounts - discounts) * _invHistCounts[hists])
-            + boProbs[backoffs] * bows[hists];
+    bool boZeros = (_order == 1 && !_pLM->vocab().IsFixedVocab());
+    for (size_t i = begin; i < end; i++) {
+        if (!probMask[i]) continue;
+        Prob boProb = boProbs[backoffs[i]] * bows[hists[i]];
+        if (_effCounts[i])
+            probs[i] = (_effCounts[i] - discounts[i]) * _invHistCounts[hists[i]]
+                + boProb;
+        else
+            probs[i] = boZeros ? 0 : boProb;
+    }
 }
 
 void
-KneserNeySmoothing::_EstimateWeighted(ProbVector &probs, ProbVector &bows) {
+KneserNeySmoothing::_EstimateWeighted(ProbVector &probs, ProbVector &bows,
+                                      size_t t) {
     const IndexVector &hists(_pLM->hists(_order));
     const IndexVector &backoffs(_pLM->backoffs(_order));
     const ProbVector & boProbs(_pLM->probs(_order - 1));
+    size_t begin = _ngramStarts[t], end = _ngramStarts[t + 1];
+    size_t histBegin = _histStarts[t], histEnd = _histStarts[t + 1];
 
     // Compute discounts.
     ProbVector &discounts(probs);  // Reuse probs vector for discounts.
-    discounts = _discParams[min(_effCounts, _discOrder)];
+    for (size_t i = begin; i < end; i++)
+        discounts[i] = _discParams[min(_effCounts[i], (int)_discOrder)];
 
     // Compute backoff weights.
-    bows.set(0);
-    BinWeight(hists, _ngramWeights * discounts, bows);
-    bows = CondExpr(_invHistCounts == 0, 1, bows * _invHistCounts);
+    // BinWeight(hists, _ngramWeights * discounts, bows);
+    for (size_t h = histBegin; h < histEnd; h++)
+        bows[h] = 0;
+    for (size_t i = begin; i < end; i++)
+        bows[hists[i]] += _ngramWeights[i] * discounts[i];
+    for (size_t h = histBegin; h < histEnd; h++)
+        bows[h] = (_invHistCounts[h] == 0) ? 1 : bows[h] * _invHistCounts[h];
 
     // Compute interpolated probabilities.
-    if (_order == 1 && !_pLM->vocab().IsFixedVocab())
-        probs = CondExpr(!_effCounts, 0,
-                         _ngramWeights * (_effCounts - discounts)
-                         * _invHistCounts[hists]
-                         + boProbs[backoffs] * bows[hists]);
-    else
-        probs = CondExpr(!_effCounts, 0,
-                         _ngramWeights * (_effCounts - discounts)
-                         * _invHistCounts[hists])
-            + boProbs[backoffs] * bows[hists];
+    bool boZeros = (_order == 1 && !_pLM->vocab().IsFixedVocab());
+    for (size_t i = begin; i < end; i++) {
+        Prob boProb = boProbs[backoffs[i]] * bows[hists[i]];
+        if (_effCounts[i])
+            probs[i] = _ngramWeights[i] * (_effCounts[i] - discounts[i])
+                * _invHistCounts[hists[i]] + boProb;
+        else
+            probs[i] = boZeros ? 0 : boProb;
+    }
 }
 
 void
 KneserNeySmoothing::_EstimateWeightedMasked(const NgramLMMask *pMask,
                                             ProbVector &probs,
-                                            ProbVector &bows) {
+                                            ProbVector &bows, size_t t) {
     const IndexVector &hists(_pLM->hists(_order));
     const IndexVector &backoffs(_pLM->backoffs(_order));
     const ProbVector & boProbs(_pLM->probs(_order - 1));
+    size_t begin = _ngramStarts[t], end = _ngramStarts[t + 1];
+    size_t histBegin = _histStarts[t], histEnd = _histStarts[t + 1];
 
     // Compute discounts.
     ProbVector &discounts(probs);  // Reuse probs vector for discounts.
     const BitVector &discMask(((KneserNeySmoothingMask *)
                               pMask->SmoothingMasks[_order].get())->DiscMask);
     assert(discMask.length() == _effCounts.length());
-//    discounts.masked(discMask) = _discParams[min(_effCounts, _discOrder)];
-    for (size_t i = 0; i < _effCounts.length(); i++)
+    for (size_t i = begin; i < end; i++)
         if (discMask[i])
             discounts[i] = _discParams[min(_effCounts[i], (int)_discOrder)];
 
     // Compute backoff weights.
     const BitVector &bowMask(pMask->BowMaskVectors[_order - 1]);
-    MaskedVectorClosure<ProbVector, BitVector> maskedBows(bows.masked(bowMask));
-    maskedBows.set(0);
-    BinWeight(hists, _ngramWeights * discounts, maskedBows);
-//    maskedBows = CondExpr(_invHistCounts == 0, 1, bows * _invHistCounts);
-    for (size_t i = 0; i < bows.length(); i++)
-        if (bowMask[i]) {
-            if (_invHistCounts[i] == 0)
-                bows[i] = 1;
+    for (size_t h = histBegin; h < histEnd; h++)
+        if (bowMask[h])
+            bows[h] = 0;
+    for (size_t i = begin; i < end; i++)
+        if (bowMask[hists[i]])
+            bows[hists[i]] += _ngramWeights[i] * discounts[i];
+    for (size_t h = histBegin; h < histEnd; h++)
+        if (bowMask[h]) {
+            if (_invHistCounts[h] == 0)
+                bows[h] = 1;
             else
-                bows[i] *= _invHistCounts[i];
+                bows[h] *= _invHistCounts[h];
         }
 
     // Compute interpolated probabilities.
     const BitVector &probMask(pMask->ProbMaskVectors[_order]);
-    if (_order == 1 && !_pLM->vocab().IsFixedVocab())
-        probs.masked(probMask) =
-            CondExpr(!_effCounts, 0,
-                     _ngramWeights * (_effCounts - discounts)
-                     * _invHistCounts[hists]
-                     + boProbs[backoffs] * bows[hists]);
-    else
-        probs.masked(probMask) =
-            CondExpr(!_effCounts, 0,
-                     _ngramWeights * (_effCounts - discounts)
-                     * _invHistCounts[hists])
-            + boProbs[backoffs] * bows[hists];
+    bool boZeros = (_order == 1 && !_pLM->vocab().IsFixedVocab());
+    for (size_t i = begin; i < end; i++) {
+        if (!probMask[i]) continue;
+        Prob boProb = boProbs[backoffs[i]] * bows[hists[i]];
+        if (_effCounts[i])
+            probs[i] = _ngramWeights[i] * (_effCounts[i] - discounts[i])
+                * _invHistCounts[hists[i]] + boProb;
+        else
+            probs[i] = boZeros ? 0 : boProb;
+    }
+}
+
+// Back-propagate through the unweighted estimate above, where each discount
+// enters its own prob and its history's bow.  Bows of histories whose counts
+// are all zero are fixed at 1.  The gradient is only nonzero for probs and
+// bows in the mask, so no mask is needed here.
+bool
+KneserNeySmoothing::EstimateGradient(const ProbVector &probGrads,
+                                     const ProbVector &bowGrads,
+                                     ProbVector &boProbGrads,
+                                     ParamVector &paramGrads) const {
+    // Weighting features would need the gradient of the weights.
+    if (_pLM->features(_order).size() > 0)
+        return false;
+
+    const IndexVector &hists(_pLM->hists(_order));
+    const IndexVector &backoffs(_pLM->backoffs(_order));
+    const ProbVector & boProbs(_pLM->probs(_order - 1));
+    const ProbVector & bows(_pLM->bows(_order - 1));
+
+    // Gradient with respect to bows, and on through the backoff term.
+    // histGrads = bowGrads + BinWeight(hists, probGrads * boProbs[backoffs]);
+    // boProbGrads += BinWeight(backoffs, probGrads * bows[hists]);
+    bool boZeros = (_order == 1 && !_pLM->vocab().IsFixedVocab());
+    ProbVector histGrads(bowGrads.length());
+    histGrads = bowGrads;
+    for (size_t i = 0; i < hists.length(); i++) {
+        if (probGrads[i] == 0 || (boZeros && !_effCounts[i])) continue;
+        histGrads[hists[i]] += probGrads[i] * boProbs[backoffs[i]];
+        boProbGrads[backoffs[i]] += probGrads[i] * bows[hists[i]];
+    }
+
+    // Gradient with respect to the discount of each n-gram with counts.
+    if (_tuneParams) {
+        for (size_t i = 0; i < hists.length(); i++) {
+            if (!_effCounts[i]) continue;
+            Prob grad = histGrads[hists[i]] - probGrads[i];
+            if (grad != 0)
+                paramGrads[min(_effCounts[i], (int)_discOrder) - 1] +=
+                    grad * _invHistCounts[hists[i]];
+        }
+    }
+    return true;
 }
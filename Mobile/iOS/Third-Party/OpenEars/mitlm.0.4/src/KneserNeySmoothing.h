@@ -52,6 +52,8 @@ protected:
     ProbVector   _invHistCounts;
     ParamVector  _discParams;
     IntVector    _paramIndices;
+    IndexVector  _ngramStarts;
+    IndexVector  _histStarts;
 
 public:
     KneserNeySmoothing(size_t discOrder=3, bool tuneParams=false)
@@ -60,15 +62,24 @@ public:
     virtual void UpdateMask(NgramLMMask &lmMask) const;
     virtual bool Estimate(const ParamVector &params, const NgramLMMask *pMask,
                           ProbVector &probs, ProbVector &bows);
+    virtual void Update(const vector<CountVector> &deltaVectors,
+                        NgramLMMask &lmMask);
+    virtual bool EstimateGradient(const ProbVector &probGrads,
+                                  const ProbVector &bowGrads,
+                                  ProbVector &boProbGrads,
+                                  ParamVector &paramGrads) const;
 
 protected:
-    void _ComputeWeights(const ParamVector &featParams);
-    void _Estimate(ProbVector &probs, ProbVector &bows);
+    struct EstimateTask;
+    static void _RunEstimate(void *arg, size_t t);
+    void _ComputeWeights(const Param *featParams, size_t t);
+    void _Estimate(ProbVector &probs, ProbVector &bows, size_t t);
     void _EstimateMasked(const NgramLMMask *pMask,
-                         ProbVector &probs, ProbVector &bows);
-    void _EstimateWeighted(ProbVector &probs, ProbVector &bows);
+                         ProbVector &probs, ProbVector &bows, size_t t);
+    void _EstimateWeighted(ProbVector &probs, ProbVector &bows, size_t t);
     void _EstimateWeightedMasked(const NgramLMMask *pMask,
-                                 ProbVector &probs, ProbVector &bows);
+                                 ProbVector &probs, ProbVector &bows,
+                                 size_t t);
 };
 
 #endif // KNESERNEYSMOOTHING_H
@@ -650,9 +650,14 @@ Lattice::_ComputeArcNgramMapping() {
         map.resize(_finalNode, NgramVector::Invalid);
         NgramIndex hist = (o == 1) ? 0 : boMap[0];
         map[0] = ngramVector.Find(hist, Vocab::EndOfSentence);
+        IndexVector hists(_arcWords.length(), 0);
+        IndexVector ngramIndices;
+        if (o > 1)
+            for (size_t i = 0; i < _arcWords.length(); ++i)
+                hists[i] = boMap[_arcStarts[i]];
+        ngramVector.Find(hists, _arcWords, ngramIndices);
         for (size_t i = 0; i < _arcWords.length(); ++i) {
-            NgramIndex hist       = (o == 1) ? 0 : boMap[_arcStarts[i]];
-            NgramIndex ngramIndex = ngramVector.Find(hist, _arcWords[i]);
+            NgramIndex ngramIndex = ngramIndices[i];
             NodeIndex  node       = _arcEnds[i];
             if (node == _finalNode) {
                 // Transition to final node.  Do nothing.
@@ -59,6 +59,7 @@ inline float logAdd(float logX, float logY) {
 
 class Lattice {
     friend class WordErrorRateOptimizer;
+    friend class LatticeBatch;
 
     struct ArcNgramIndex {
         ArcNgramIndex(uint a=0, uint o=0, NgramIndex i=0) :
@@ -0,0 +1,275 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+
+#include <vector>
+#include "LatticeBatch.h"
+
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct LatticeBatch::ScoreTask {
+    LatticeBatch *batch;
+    IntVector *   wers;
+    FloatVector * margins;
+};
+
+LatticeBatch::~LatticeBatch() {
+    for (size_t l = 0; l < _lattices.size(); ++l)
+        delete _lattices[l];
+}
+
+// Add lattice to the batch, which then owns it.  Call Compile() after adding
+// the last one.
+void
+LatticeBatch::Add(Lattice *lattice) {
+    _lattices.push_back(lattice);
+}
+
+void
+LatticeBatch::Compile() {
+    // Lay out the arcs of all lattices back to back.
+    size_t numLattices = _lattices.size();
+    size_t numArcs     = 0;
+    _latticeStarts.reset(numLattices + 1);
+    for (size_t l = 0; l < numLattices; ++l) {
+        _latticeStarts[l] = numArcs;
+        numArcs += _lattices[l]->_arcStarts.length();
+    }
+    _latticeStarts[numLattices] = numArcs;
+
+    // Number the distinct probs, then the distinct bows, used by any arc.
+    // Each arc keeps its terms in the order Lattice::UpdateWeights() sums
+    // them, so both give the same weights.
+    size_t              order = _lm.order();
+    vector<IndexVector> probTerms(order + 1);
+    vector<IndexVector> bowTerms(order);
+    vector<uint>        termOrders;
+    vector<NgramIndex>  termIndices;
+    for (size_t o = 0; o <= order; ++o)
+        probTerms[o].reset(_lm.sizes(o), -1);
+    for (size_t o = 0; o < order; ++o)
+        bowTerms[o].reset(_lm.sizes(o), -1);
+    _arcTermStarts.reset(numArcs + 1, 0);
+    for (size_t l = 0; l < numLattices; ++l) {
+        const Lattice &lattice(*_lattices[l]);
+        for (size_t i = 0; i < lattice._arcProbs.length(); ++i) {
+            const Lattice::ArcNgramIndex &e(lattice._arcProbs[i]);
+            ++_arcTermStarts[_latticeStarts[l] + e.arcIndex + 1];
+            if (probTerms[e.order][e.ngramIndex] == -1) {
+                probTerms[e.order][e.ngramIndex] = termOrders.size();
+                termOrders.push_back(e.order);
+                termIndices.push_back(e.ngramIndex);
+            }
+        }
+    }
+    _numProbTerms = termOrders.size();
+    for (size_t l = 0; l < numLattices; ++l) {
+        const Lattice &lattice(*_lattices[l]);
+        for (size_t i = 0; i < lattice._arcBows.length(); ++i) {
+            const Lattice::ArcNgramIndex &e(lattice._arcBows[i]);
+            ++_arcTermStarts[_latticeStarts[l] + e.arcIndex + 1];
+            if (bowTerms[e.order][e.ngramIndex] == -1) {
+                bowTerms[e.order][e.ngramIndex] = termOrders.size();
+                termOrders.push_back(e.order);
+                termIndices.push_back(e.ngramIndex);
+            }
+        }
+    }
+    _termOrders  = termOrders;
+    _termIndices = termIndices;
+    _termLogs.reset(termOrders.size());
+
+    for (size_t a = 0; a < numArcs; ++a)
+        _arcTermStarts[a + 1] += _arcTermStarts[a];
+    _arcTerms.reset(_arcTermStarts[numArcs]);
+    UIntVector ends(_arcTermStarts[Range(numArcs)], true);
+    for (size_t l = 0; l < numLattices; ++l) {
+        const Lattice &lattice(*_lattices[l]);
+        for (size_t i = 0; i < lattice._arcProbs.length(); ++i) {
+            const Lattice::ArcNgramIndex &e(lattice._arcProbs[i]);
+            _arcTerms[ends[_latticeStarts[l] + e.arcIndex]++] =
+                probTerms[e.order][e.ngramIndex];
+        }
+    }
+    for (size_t l = 0; l < numLattices; ++l) {
+        const Lattice &lattice(*_lattices[l]);
+        for (size_t i = 0; i < lattice._arcBows.length(); ++i) {
+            const Lattice::ArcNgramIndex &e(lattice._arcBows[i]);
+            _arcTerms[ends[_latticeStarts[l] + e.arcIndex]++] =
+                bowTerms[e.order][e.ngramIndex];
+        }
+    }
+
+    // Move the arcs into the arena and leave each lattice with views.  The
+    // lattices may be views into the arena of a previous Compile().
+    NodeVector  arcStarts(numArcs);
+    NodeVector  arcEnds(numArcs);
+    VocabVector arcWords(numArcs);
+    FloatVector arcBaseWeights(numArcs);
+    FloatVector arcWeights(numArcs);
+    for (size_t l = 0; l < numLattices; ++l) {
+        Lattice &lattice(*_lattices[l]);
+        size_t   start = _latticeStarts[l];
+        size_t   len   = _latticeStarts[l + 1] - start;
+        std::copy(lattice._arcStarts.begin(), lattice._arcStarts.end(),
+                  &arcStarts[start]);
+        std::copy(lattice._arcEnds.begin(), lattice._arcEnds.end(),
+                  &arcEnds[start]);
+        std::copy(lattice._arcWords.begin(), lattice._arcWords.end(),
+                  &arcWords[start]);
+        std::copy(lattice._arcBaseWeights.begin(),
+                  lattice._arcBaseWeights.end(), &arcBaseWeights[start]);
+        std::copy(lattice._arcWeights.begin(), lattice._arcWeights.end(),
+                  &arcWeights[start]);
+        lattice._arcStarts.attach(&arcStarts[start], len);
+        lattice._arcEnds.attach(&arcEnds[start], len);
+        lattice._arcWords.attach(&arcWords[start], len);
+        lattice._arcBaseWeights.attach(&arcBaseWeights[start], len);
+        lattice._arcWeights.attach(&arcWeights[start], len);
+    }
+    _arcStarts.swap(arcStarts);
+    _arcEnds.swap(arcEnds);
+    _arcWords.swap(arcWords);
+    _arcBaseWeights.swap(arcBaseWeights);
+    _arcWeights.swap(arcWeights);
+    _threadStarts.reset(0);
+}
+
+// Set the masks of the probs and bows used by the lattices.
+void
+LatticeBatch::GetMasks(vector<BitVector> &probMaskVectors,
+                       vector<BitVector> &bowMaskVectors) const {
+    size_t order = _lm.order();
+    probMaskVectors.resize(order + 1);
+    bowMaskVectors.resize(order);
+    for (size_t o = 0; o <= order; o++)
+        probMaskVectors[o].reset(_lm.sizes(o), false);
+    for (size_t o = 0; o < order; o++)
+        bowMaskVectors[o].reset(_lm.sizes(o), false);
+    for (size_t i = 0; i < _termOrders.length(); ++i) {
+        if (i < _numProbTerms)
+            probMaskVectors[_termOrders[i]][_termIndices[i]] = true;
+        else
+            bowMaskVectors[_termOrders[i]][_termIndices[i]] = true;
+    }
+}
+
+// Update the arc weights of all lattices with current LM probabilities.
+void
+LatticeBatch::UpdateWeights() {
+    _lm.RunTask(&_RunTermLogs, this);
+    _lm.RunTask(&_RunArcWeights, this);
+}
+
+// Set wers to the word errors of the best path through each lattice.
+void
+LatticeBatch::ComputeWER(IntVector &wers) {
+    wers.reset(_lattices.size());
+    ScoreTask task = { this, &wers, NULL };
+    _GetThreadStarts();
+    _lm.RunTask(&_RunComputeWER, &task);
+}
+
+// Set margins to the margin of the oracle path of each lattice.
+void
+LatticeBatch::ComputeMargin(FloatVector &margins) {
+    margins.reset(_lattices.size());
+    ScoreTask task = { this, NULL, &margins };
+    _GetThreadStarts();
+    _lm.RunTask(&_RunComputeMargin, &task);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Split the lattices into a contiguous run for each thread with about the
+// same number of arcs.
+void
+LatticeBatch::_GetThreadStarts() {
+    size_t numThreads = _lm.numThreads();
+    if (_threadStarts.length() == numThreads + 1)
+        return;
+    size_t numLattices = _lattices.size();
+    size_t numArcs     = _latticeStarts[numLattices];
+    _threadStarts.reset(numThreads + 1, 0);
+    for (size_t t = 1; t < numThreads && numLattices > 0; ++t)
+        _threadStarts[t] = std::upper_bound(
+            _latticeStarts.begin(), _latticeStarts.begin() + numLattices,
+            (uint)(numArcs * t / numThreads)) - _latticeStarts.begin() - 1;
+    _threadStarts[numThreads] = numLattices;
+}
+
+void
+LatticeBatch::_RunTermLogs(void *arg, size_t t) {
+    LatticeBatch &b = *static_cast<LatticeBatch *>(arg);
+    size_t numThreads = b._lm.numThreads();
+    size_t numTerms   = b._termLogs.length();
+    size_t end        = numTerms * (t + 1) / numThreads;
+    for (size_t i = numTerms * t / numThreads; i < end; ++i) {
+        b._termLogs[i] = log((i < b._numProbTerms)
+                             ? b._lm.probs(b._termOrders[i])[b._termIndices[i]]
+                             : b._lm.bows(b._termOrders[i])[b._termIndices[i]]);
+    }
+}
+
+void
+LatticeBatch::_RunArcWeights(void *arg, size_t t) {
+    LatticeBatch &b = *static_cast<LatticeBatch *>(arg);
+    size_t numThreads = b._lm.numThreads();
+    size_t numArcs    = b._arcWeights.length();
+    size_t end        = numArcs * (t + 1) / numThreads;
+    for (size_t a = numArcs * t / numThreads; a < end; ++a) {
+        float weight = b._arcBaseWeights[a];
+        for (size_t i = b._arcTermStarts[a]; i < b._arcTermStarts[a + 1]; ++i)
+            weight -= b._termLogs[b._arcTerms[i]];
+        b._arcWeights[a] = weight;
+    }
+}
+
+void
+LatticeBatch::_RunComputeWER(void *arg, size_t t) {
+    ScoreTask    &task = *static_cast<ScoreTask *>(arg);
+    LatticeBatch &b = *task.batch;
+    for (size_t l = b._threadStarts[t]; l < (size_t)b._threadStarts[t + 1]; ++l)
+        (*task.wers)[l] = b._lattices[l]->ComputeWER();
+}
+
+void
+LatticeBatch::_RunComputeMargin(void *arg, size_t t) {
+    ScoreTask    &task = *static_cast<ScoreTask *>(arg);
+    LatticeBatch &b = *task.batch;
+    for (size_t l = b._threadStarts[t]; l < (size_t)b._threadStarts[t + 1]; ++l)
+        (*task.margins)[l] = b._lattices[l]->ComputeMargin();
+}
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef LATTICEBATCH_H
+#define LATTICEBATCH_H
+
+#include <vector>
+#include "Types.h"
+#include "NgramLM.h"
+#include "Lattice.h"
+
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// LatticeBatch holds the lattices of an evaluation set for rescoring them all
+// at once.  Compile() moves the arcs of every lattice into one arena of arc
+// arrays, leaving each lattice with views of its slice, and collects the
+// distinct n-gram probs and bows that the arcs use.  After each LM estimate,
+// UpdateWeights() takes the log of each of those once and sums them into the
+// arc weights in one pass over the arena.  Lattices are then scored in
+// parallel on the thread pool of the LM, each thread taking a contiguous run
+// of lattices with about the same number of arcs.
+//
+class LatticeBatch {
+protected:
+    NgramLMBase &     _lm;
+    vector<Lattice *> _lattices;
+    UIntVector        _latticeStarts;  // First arena arc of each lattice
+    NodeVector        _arcStarts;
+    NodeVector        _arcEnds;
+    VocabVector       _arcWords;
+    FloatVector       _arcBaseWeights;
+    FloatVector       _arcWeights;
+    UIntVector        _arcTermStarts;  // First entry in _arcTerms of each arc
+    UIntVector        _arcTerms;       // Terms summed into each arc weight
+    UIntVector        _termOrders;     // N-gram order of each term
+    IndexVector       _termIndices;    // N-gram index of each term
+    size_t            _numProbTerms;   // Terms before this are probs, bows after
+    DoubleVector      _termLogs;       // Log prob or bow of each term
+    IndexVector       _threadStarts;   // First lattice of each thread
+
+    struct ScoreTask;
+
+public:
+    LatticeBatch(NgramLMBase &lm) : _lm(lm), _numProbTerms(0) { }
+    ~LatticeBatch();
+
+    void   Add(Lattice *lattice);
+    void   Compile();
+    void   GetMasks(vector<BitVector> &probMaskVectors,
+                    vector<BitVector> &bowMaskVectors) const;
+    void   UpdateWeights();
+    void   ComputeWER(IntVector &wers);
+    void   ComputeMargin(FloatVector &margins);
+
+    size_t         size() const                  { return _lattices.size(); }
+    Lattice &      operator[](size_t l)          { return *_lattices[l]; }
+    const Lattice &operator[](size_t l) const    { return *_lattices[l]; }
+
+protected:
+    void        _GetThreadStarts();
+    static void _RunTermLogs(void *arg, size_t t);
+    static void _RunArcWeights(void *arg, size_t t);
+    static void _RunComputeWER(void *arg, size_t t);
+    static void _RunComputeMargin(void *arg, size_t t);
+};
+
+#endif // LATTICEBATCH_H
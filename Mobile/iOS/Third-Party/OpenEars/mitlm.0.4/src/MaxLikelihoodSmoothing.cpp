@@ -74,3 +74,13 @@ MaxLikelihoodSmoothing::Estimate(const ParamVector &params,
     }
     return true;
 }
+
+// Estimate() ignores the mask, so re-estimate everything.
+void
+MaxLikelihoodSmoothing::Update(const vector<CountVector> &deltaVectors,
+                               NgramLMMask &lmMask) {
+    _effCounts.attach(_pLM->counts(_order));
+    _estimated = false;
+    lmMask.ProbMaskVectors[_order].set(1);
+    lmMask.BowMaskVectors[_order - 1].set(1);
+}
@@ -54,6 +54,14 @@ public:
                           const NgramLMMask *pMask,
                           ProbVector &probs,
                           ProbVector &bows);
+    virtual void Update(const vector<CountVector> &deltaVectors,
+                        NgramLMMask &lmMask);
+    // Probs depend on neither params nor backoff probs.
+    virtual bool EstimateGradient(const ProbVector &probGrads,
+                                  const ProbVector &bowGrads,
+                                  ProbVector &boProbGrads,
+                                  ParamVector &paramGrads) const
+    { return true; }
 };
 
 #endif // MAXLIKELIHOODSMOOTHING_H
@@ -66,8 +66,8 @@ NgramLMBase::SaveVocab(ZFile &vocabFile, bool asBinary) const {
 void
 NgramLMBase::SaveLM(ZFile &lmFile, bool asBinary) const {
     if (asBinary) {
-        WriteUInt64(lmFile, MITLMv1);
-        Serialize(lmFile);
+        WriteUInt64(lmFile, MITLMv3);
+        SerializeMapped(lmFile);
     } else
         _pModel->SaveLM(_probVectors, _bowVectors, lmFile);
 }
@@ -93,6 +93,90 @@ NgramLMBase::Deserialize(FILE *inFile) {
         ReadVector(inFile, _bowVectors[o]);
 }
 
+void
+NgramLMBase::SerializeMapped(FILE *outFile) const {
+    WriteHeader(outFile, "NgramLM");
+    _pModel->SerializeMapped(outFile);
+    for (size_t o = 0; o <= order(); ++o)
+        WriteVector(outFile, _probVectors[o]);
+    for (size_t o = 0; o < order(); ++o)
+        WriteVector(outFile, _bowVectors[o]);
+}
+
+// Load the LM as views into inFile, which is kept open for their lifetime.
+void
+NgramLMBase::DeserializeMapped(const SharedPtr<MappedFile> &inFile) {
+    _mappedFile = inFile;
+    MappedFile &in(*_mappedFile);
+    in.VerifyHeader("NgramLM");
+    _pModel->DeserializeMapped(_mappedFile);
+    SetOrder(_pModel->size() - 1);
+    for (size_t o = 0; o <= order(); ++o) {
+        MapVector(in, _probVectors[o]);
+        if (_probVectors[o].length() != sizes(o))
+            throw std::runtime_error("Invalid file format.");
+    }
+    for (size_t o = 0; o < order(); ++o) {
+        MapVector(in, _bowVectors[o]);
+        if (_bowVectors[o].length() != sizes(o))
+            throw std::runtime_error("Invalid file format.");
+    }
+}
+
+void
+NgramLMBase::SetNumThreads(size_t numThreads) {
+    SetThreadPool(SharedPtr<ThreadPool>(
+        numThreads > 1 ? new ThreadPool(numThreads) : NULL));
+}
+
+void
+NgramLMBase::SetThreadPool(const SharedPtr<ThreadPool> &threadPool) {
+    _threadPool = threadPool;
+}
+
+// Split the n-grams of order o into numRanges ranges that share no history,
+// so that each can be estimated on its own thread.  ngramStarts[t] is the
+// first n-gram of range t and histStarts[t] the first history it owns, with
+// the histories of no n-grams going to the range before them.  Both end with
+// an entry for one past the end.  N-grams not sorted by history all go into
+// the first range.
+void
+NgramLMBase::GetHistRanges(size_t o, size_t numRanges,
+                           IndexVector &ngramStarts,
+                           IndexVector &histStarts) const {
+    const IndexVector &hists(this->hists(o));
+    size_t             numNgrams = hists.length();
+    ngramStarts.reset(numRanges + 1, numNgrams);
+    histStarts.reset(numRanges + 1, sizes(o - 1));
+    ngramStarts[0] = 0;
+    histStarts[0] = 0;
+    for (size_t i = 1; i < numNgrams; ++i)
+        if (hists[i] < hists[i - 1])
+            return;
+    for (size_t t = 1; t < numRanges; ++t) {
+        size_t i = numNgrams * t / numRanges;
+        if (i > 0 && i < numNgrams)
+            i = std::upper_bound(&hists[i], &hists[0] + numNgrams,
+                                 hists[i - 1]) - &hists[0];
+        if (i < (size_t)ngramStarts[t - 1])
+            i = ngramStarts[t - 1];
+        if (i < numNgrams) {
+            ngramStarts[t] = i;
+            histStarts[t] = hists[i];
+        }
+    }
+}
+
+// Run task(arg, slot) on each thread of the pool, or only as slot 0 if
+// there is none.
+void
+NgramLMBase::RunTask(ThreadPool::Task task, void *arg) {
+    if (_threadPool.get())
+        _threadPool->Run(task, arg);
+    else
+        task(arg, 0);
+}
+
 void
 NgramLMBase::SetOrder(size_t order) {
     _pModel->SetOrder(order);
@@ -112,6 +196,17 @@ NgramLMBase::Estimate(const ParamVector &params, Mask *pMask) {
     return true;
 }
 
+// Given the gradient of a function with respect to the probs and bows of the
+// last Estimate(), compute its gradient with respect to the params.  Adds to
+// probGrads as it goes.  Return false if the LM cannot, as with weighting
+// features, leaving the caller to approximate it.
+bool
+NgramLMBase::EstimateGradient(vector<ProbVector> &probGrads,
+                              const vector<ProbVector> &bowGrads,
+                              ParamVector &gradient) {
+    return false;
+}
+
 void
 NgramLMBase::SetModel(const SharedPtr<NgramModel> &m,
                       const VocabVector &vocabMap,
@@ -141,7 +236,14 @@ NgramLMBase::SetModel(const SharedPtr<NgramModel> &m,
 
 void
 ArpaNgramLM::LoadLM(ZFile &lmFile) {
-    if (ReadUInt64(lmFile) == MITLMv1) {
+    uint64_t version = ReadUInt64(lmFile);
+    if (version == MITLMv3) {
+        DeserializeMapped(SharedPtr<MappedFile>(new MappedFile(lmFile)));
+    } else if (version == MITLMv2) {
+        // Its index tables hold bare indices, which cannot be mapped as slots.
+        throw std::runtime_error("Unsupported binary LM version. "
+                                 "Save the LM again from ARPA or counts.");
+    } else if (version == MITLMv1) {
         Deserialize(lmFile);
     } else {
         lmFile.ReOpen();
@@ -154,7 +256,10 @@ ArpaNgramLM::LoadLM(ZFile &lmFile) {
 void
 NgramLM::Initialize(const char *vocab, bool useUnknown,
                     const char *text, const char *counts,
-                    const char *smoothingDesc, const char *featureDesc) {
+                    const char *smoothingDesc, const char *featureDesc,
+                    size_t numThreads, size_t memoryBudget) {
+    SetNumThreads(numThreads);
+
     // Read vocabulary.
     if (useUnknown) {
         Logger::Log(1, "Replace unknown words with <unk>...\n");
@@ -174,7 +279,7 @@ NgramLM::Initialize(const char *vocab, bool useUnknown,
         for (size_t i = 0; i < textFiles.size(); i++) {
             Logger::Log(1, "Loading corpus %s...\n", textFiles[i].c_str());
             ZFile corpusZFile(ZFile(textFiles[i].c_str()));
-            LoadCorpus(corpusZFile);
+            LoadCorpus(corpusZFile, false, numThreads, memoryBudget);
             if (corpusFile.length() == 0) corpusFile = textFiles[i].c_str();
         }
     }
@@ -226,8 +331,46 @@ NgramLM::Initialize(const char *vocab, bool useUnknown,
 }
 
 void
-NgramLM::LoadCorpus(ZFile &corpusFile, bool reset) {
-    _pModel->LoadCorpus(_countVectors, corpusFile, reset);
+NgramLM::LoadCorpus(ZFile &corpusFile, bool reset, size_t numThreads,
+                    size_t memoryBudget) {
+    _pModel->LoadCorpus(_countVectors, corpusFile, reset, numThreads,
+                        memoryBudget);
+}
+
+// Add the counts of corpusFile to an estimated LM, and re-estimate with
+// params only the probs and bows that they change.  The existing text is not
+// recounted and the model is not re-sorted: new words and n-grams follow the
+// existing ones.  Return false if params are out of bounds.
+bool
+NgramLM::UpdateCorpus(ZFile &corpusFile, const ParamVector &params) {
+    vector<CountVector> deltaVectors;
+    _pModel->UpdateCorpus(_countVectors, deltaVectors, corpusFile);
+
+    // Extend the estimates to the new n-grams, which are all re-estimated.
+    NgramLMMask mask;
+    mask.ProbMaskVectors.resize(_order + 1);
+    mask.BowMaskVectors.resize(_order);
+    mask.SmoothingMasks.resize(_order + 1);
+    for (size_t o = 0; o <= _order; o++) {
+        _probVectors[o].resize(sizes(o), 0);
+        mask.ProbMaskVectors[o].reset(sizes(o), 0);
+        if (o < _order) {
+            _bowVectors[o].resize(sizes(o), 1);  // For n-grams without children
+            mask.BowMaskVectors[o].reset(sizes(o), 0);
+        }
+    }
+
+    // New words change the 0th order probability, and so every prob.
+    Prob zeroProb = vocab().IsFixedVocab() ? Prob(1.0 / sizes(1))
+        : Prob(1.0 / sum(_countVectors[1] > 0));
+    if (_probVectors[0][0] != zeroProb) {
+        _probVectors[0][0] = zeroProb;
+        mask.ProbMaskVectors[0][0] = 1;
+    }
+
+    for (size_t o = 1; o <= _order; o++)
+        _smoothings[o]->Update(deltaVectors, mask);
+    return Estimate(params, &mask);
 }
 
 void
@@ -301,15 +444,26 @@ NgramLM::SetSmoothingAlgs(const vector<SharedPtr<Smoothing> > &smoothings) {
     else
         _probVectors[0][0] = Prob(1.0 / sum(_countVectors[1] > 0));
 
-    // Compute default parameters.
+    // Compute default parameters and their bounds.
     _paramStarts.reset(_order + 2);
-    VectorBuilder<Param> builder;
+    VectorBuilder<Param> builder, minBuilder, maxBuilder;
     for (size_t o = 1; o <= _order; ++o) {
+        const Smoothing &smoothing(*_smoothings[o]);
+        size_t           numParams = smoothing.defParams().length();
         _paramStarts[o] = builder.length();
-        builder.append(_smoothings[o]->defParams());
+        builder.append(smoothing.defParams());
+        if (smoothing.minParams().length() == numParams) {
+            minBuilder.append(smoothing.minParams());
+            maxBuilder.append(smoothing.maxParams());
+        } else {
+            minBuilder.append(-HUGE_VAL, numParams);
+            maxBuilder.append(HUGE_VAL, numParams);
+        }
     }
     _paramStarts[_order + 1] = builder.length();
     _defParams = builder;
+    _minParams = minBuilder;
+    _maxParams = maxBuilder;
 }
 
 void
@@ -359,6 +513,22 @@ NgramLM::Estimate(const ParamVector &params, Mask *pMask) {
     return true;
 }
 
+bool
+NgramLM::EstimateGradient(vector<ProbVector> &probGrads,
+                          const vector<ProbVector> &bowGrads,
+                          ParamVector &gradient) {
+    // Each order passes the gradient of its probs on to the order below.
+    gradient.reset(_paramStarts[_order+1], 0);
+    for (size_t o = _order; o > 0; o--) {
+        ParamVector paramGrads(gradient[Range(_paramStarts[o],
+                                              _paramStarts[o+1])]);
+        if (!_smoothings[o]->EstimateGradient(probGrads[o], bowGrads[o-1],
+                                              probGrads[o-1], paramGrads))
+            return false;
+    }
+    return true;
+}
+
 void
 NgramLM::SetModel(const SharedPtr<NgramModel> &m,
                   const VocabVector &vocabMap,
@@ -37,6 +37,7 @@
 
 #include <vector>
 #include "util/SharedPtr.h"
+#include "util/ThreadPool.h"
 #include "Types.h"
 #include "Vocab.h"
 #include "NgramModel.h"
@@ -51,11 +52,15 @@ class NgramLMBase {
     friend class PerplexityOptimizer;
 
 protected:
+    SharedPtr<MappedFile> _mappedFile;  // Declared first to outlive its views
     SharedPtr<NgramModel> _pModel;
     size_t                _order;
     vector<ProbVector>    _probVectors;
     vector<ProbVector>    _bowVectors;
     ParamVector           _defParams;
+    ParamVector           _minParams;
+    ParamVector           _maxParams;
+    SharedPtr<ThreadPool> _threadPool;
 
 public:
     NgramLMBase(size_t order = 3);
@@ -66,11 +71,21 @@ public:
     void SaveLM(ZFile &lmFile, bool asBinary=false) const;
     void Serialize(FILE *outFile) const;
     void Deserialize(FILE *inFile);
-
+    void SerializeMapped(FILE *outFile) const;
+    void DeserializeMapped(const SharedPtr<MappedFile> &inFile);
+    void SetNumThreads(size_t numThreads);
+    void GetHistRanges(size_t o, size_t numRanges, IndexVector &ngramStarts,
+                       IndexVector &histStarts) const;
+    void RunTask(ThreadPool::Task task, void *arg);
+
+    virtual void  SetThreadPool(const SharedPtr<ThreadPool> &threadPool);
     virtual void  SetOrder(size_t order);
     virtual Mask *GetMask(vector<BitVector> &probMaskVectors,
                           vector<BitVector> &bowMaskVectors) const;
     virtual bool  Estimate(const ParamVector &params, Mask *pMask=NULL);
+    virtual bool  EstimateGradient(vector<ProbVector> &probGrads,
+                                   const vector<ProbVector> &bowGrads,
+                                   ParamVector &gradient);
     virtual void  SetModel(const SharedPtr<NgramModel> &m,
                            const VocabVector &vocabMap,
                            const vector<IndexVector> &ngramMap);
@@ -85,6 +100,10 @@ public:
     const ProbVector  &probs(size_t o) const    { return _probVectors[o]; }
     const ProbVector  &bows(size_t o) const     { return _bowVectors[o]; }
     const ParamVector &defParams() const        { return _defParams; }
+    const ParamVector &minParams() const        { return _minParams; }
+    const ParamVector &maxParams() const        { return _maxParams; }
+    size_t             numThreads() const
+    { return _threadPool.get() ? _threadPool->size() : 1; }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -109,8 +128,11 @@ public:
                                 _featureList(order + 1) { }
     void Initialize(const char *vocab, bool useUnknown,
                     const char *text, const char *counts,
-                    const char *smoothing, const char *features);
-    void LoadCorpus(ZFile &corpusFile, bool reset=false);
+                    const char *smoothing, const char *features,
+                    size_t numThreads=1, size_t memoryBudget=0);
+    void LoadCorpus(ZFile &corpusFile, bool reset=false,
+                    size_t numThreads=1, size_t memoryBudget=0);
+    bool UpdateCorpus(ZFile &corpusFile, const ParamVector &params);
     void LoadCounts(ZFile &countsFile, bool reset=false);
     void SaveCounts(ZFile &countsFile, bool asBinary=false) const;
     void SaveEffCounts(ZFile &countsFile, bool asBinary=false) const;
@@ -121,6 +143,9 @@ public:
     virtual Mask *GetMask(vector<BitVector> &probMaskVectors,
                           vector<BitVector> &bowMaskVectors) const;
     virtual bool  Estimate(const ParamVector &params, Mask *pMask=NULL);
+    virtual bool  EstimateGradient(vector<ProbVector> &probGrads,
+                                   const vector<ProbVector> &bowGrads,
+                                   ParamVector &gradient);
     virtual void  SetModel(const SharedPtr<NgramModel> &m,
                            const VocabVector &vocabMap,
                            const vector<IndexVector> &ngramMap);
@@ -32,8 +32,12 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
 ////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cstdio>
+#include <deque>
 #include <stdexcept>
 #include <vector>
+#include <pthread.h>
 #include "util/BitOps.h"
 #include "util/FastIO.h"
 #include "util/Logger.h"
@@ -45,6 +49,241 @@ using std::vector;
 
 #define MAXLINE 4096
 
+////////////////////////////////////////////////////////////////////////////////
+// Multi-threaded corpus counting: the reading thread hands out batches of
+// lines, and each worker counts the batches it gets into its own shard of
+// n-grams, using its own vocab unless the model's vocab is fixed.
+//
+// NOTE: RefCounter is not thread-safe.  Workers may only allocate, resize and
+// free vectors that are never shared, so its map is read but not modified.
+
+namespace {
+
+const size_t CorpusBatchSize = 1 << 20;  // Bytes of corpus text per batch
+
+struct CorpusBatch {
+    vector<char>   text;   // NUL-terminated lines
+    vector<size_t> lines;  // Offset of each line in text
+};
+
+class CorpusQueue {
+    pthread_mutex_t           _mutex;
+    pthread_cond_t            _notEmpty;
+    pthread_cond_t            _notFull;
+    std::deque<CorpusBatch *> _batches;
+    size_t                    _capacity;
+    bool                      _closed;
+
+public:
+    CorpusQueue(size_t capacity) : _capacity(capacity), _closed(false) {
+        pthread_mutex_init(&_mutex, NULL);
+        pthread_cond_init(&_notEmpty, NULL);
+        pthread_cond_init(&_notFull, NULL);
+    }
+    ~CorpusQueue() {
+        for (size_t i = 0; i < _batches.size(); ++i)
+            delete _batches[i];
+        pthread_cond_destroy(&_notFull);
+        pthread_cond_destroy(&_notEmpty);
+        pthread_mutex_destroy(&_mutex);
+    }
+
+    // Wait for room and queue the batch.
+    void Push(CorpusBatch *batch) {
+        pthread_mutex_lock(&_mutex);
+        while (_batches.size() >= _capacity)
+            pthread_cond_wait(&_notFull, &_mutex);
+        _batches.push_back(batch);
+        pthread_cond_signal(&_notEmpty);
+        pthread_mutex_unlock(&_mutex);
+    }
+
+    // Wait for the next batch, or return NULL after the last one.
+    CorpusBatch *Pop() {
+        pthread_mutex_lock(&_mutex);
+        while (_batches.empty() && !_closed)
+            pthread_cond_wait(&_notEmpty, &_mutex);
+        CorpusBatch *batch = NULL;
+        if (!_batches.empty()) {
+            batch = _batches.front();
+            _batches.pop_front();
+            pthread_cond_signal(&_notFull);
+        }
+        pthread_mutex_unlock(&_mutex);
+        return batch;
+    }
+
+    void Close() {
+        pthread_mutex_lock(&_mutex);
+        _closed = true;
+        pthread_cond_broadcast(&_notEmpty);
+        pthread_mutex_unlock(&_mutex);
+    }
+};
+
+struct CorpusShard {
+    CorpusQueue &       queue;
+    Vocab               localVocab;
+    Vocab &             vocab;  // Model vocab if fixed, else localVocab
+    vector<NgramVector> vectors;
+    vector<CountVector> countVectors;
+
+    CorpusShard(CorpusQueue &q, Vocab &modelVocab, size_t order)
+        : queue(q), localVocab(),
+          vocab(modelVocab.IsFixedVocab() ? modelVocab : localVocab),
+          vectors(order), countVectors(order) {
+        countVectors[0].resize(1, 0);
+        for (size_t o = 1; o < order; ++o)
+            countVectors[o].resize(1ul<<16, 0);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// External-memory corpus counting: n-grams are counted until the counts fill
+// the memory budget, then sorted and spilled to a temporary file as a run.
+// The runs are merged order by order into the model at the end, so only the
+// distinct n-grams of the whole corpus need to fit in memory at once.
+
+// Sorted n-gram counts spilled to a temporary file.  The n-grams of each order
+// are in the order Vocab::Sort() and NgramVector::Sort() would leave them, and
+// each is stored as its words followed by its count.
+struct CountRun {
+    FILE *         file;
+    vector<long>   offsets;  // File offset of the n-grams of each order
+    vector<size_t> lengths;  // Number of n-grams of each order
+
+    CountRun(size_t order) : file(tmpfile()), offsets(order), lengths(order) {
+        if (file == NULL)
+            throw std::runtime_error("Cannot create temporary file");
+    }
+    ~CountRun() { fclose(file); }
+};
+
+// Reads the n-grams of one order from a run in turn.
+struct RunCursor {
+    FILE *             file;
+    size_t             remaining;
+    vector<VocabIndex> words;
+    Count              count;
+
+    RunCursor(const CountRun &run, size_t order)
+        : file(run.file), remaining(run.lengths[order]), words(order) {
+        if (fseek(file, run.offsets[order], SEEK_SET) != 0)
+            throw std::runtime_error("Read failed.");
+    }
+
+    bool Next() {
+        if (remaining == 0)
+            return false;
+        --remaining;
+        if (fread(&words[0], sizeof(VocabIndex), words.size(), file) !=
+            words.size() || fread(&count, sizeof(Count), 1, file) != 1)
+            throw std::runtime_error("Read failed.");
+        return true;
+    }
+};
+
+// Orders cursors by their current n-gram, in sorted vocab order, so that the
+// heap of cursors yields the lowest n-gram first.
+struct RunCursorCompare {
+    const VocabVector &_sortMap;
+    RunCursorCompare(const VocabVector &sortMap) : _sortMap(sortMap) { }
+    bool operator()(const RunCursor *a, const RunCursor *b) const {
+        for (size_t i = 0; i < a->words.size(); ++i)
+            if (a->words[i] != b->words[i])
+                return _sortMap[a->words[i]] > _sortMap[b->words[i]];
+        return false;
+    }
+};
+
+// Merges the n-grams of one order across all runs.
+class RunMerger {
+    vector<RunCursor *> _heap;
+    RunCursorCompare    _compare;
+
+public:
+    RunMerger(const vector<CountRun *> &runs, size_t order,
+              const VocabVector &sortMap) : _compare(sortMap) {
+        for (size_t r = 0; r < runs.size(); ++r) {
+            RunCursor *cursor = new RunCursor(*runs[r], order);
+            if (cursor->Next())
+                _heap.push_back(cursor);
+            else
+                delete cursor;
+        }
+        std::make_heap(_heap.begin(), _heap.end(), _compare);
+    }
+    ~RunMerger() {
+        for (size_t i = 0; i < _heap.size(); ++i)
+            delete _heap[i];
+    }
+
+    // Read the next n-gram and its count summed across runs.
+    // NOTE: Each run must be read to the end before the next merge.
+    bool Next(vector<VocabIndex> &words, Count &count) {
+        if (_heap.empty())
+            return false;
+        words = _heap.front()->words;
+        count = 0;
+        while (!_heap.empty() && _heap.front()->words == words) {
+            std::pop_heap(_heap.begin(), _heap.end(), _compare);
+            RunCursor *cursor = _heap.back();
+            count += cursor->count;
+            if (cursor->Next()) {
+                std::push_heap(_heap.begin(), _heap.end(), _compare);
+            } else {
+                delete cursor;
+                _heap.pop_back();
+            }
+        }
+        return true;
+    }
+};
+
+// Sort the counted n-grams and write them to a new run.
+CountRun *
+SpillCountRun(const Vocab &vocab, vector<NgramVector> &vectors,
+              vector<CountVector> &countVectors) {
+    VocabVector sortMap, sortIndices(vocab.size());
+    vocab.GetSortMap(sortMap);
+    for (VocabIndex i = 0; i < (VocabIndex)vocab.size(); ++i)
+        sortIndices[sortMap[i]] = i;
+
+    CountRun *         run = new CountRun(vectors.size());
+    vector<VocabIndex> words(vectors.size());
+    IndexVector        ngramMap(1, 0), boNgramMap;
+    try {
+        for (size_t o = 0; o < vectors.size(); ++o) {
+            // Sorting maps the words to their sorted indices.
+            boNgramMap.swap(ngramMap);
+            if (vectors[o].Sort(sortMap, boNgramMap, ngramMap))
+                NgramModel::ApplySort(ngramMap, countVectors[o]);
+            if (o == 0)
+                continue;
+
+            const CountVector &counts = countVectors[o];
+            run->offsets[o] = ftell(run->file);
+            run->lengths[o] = vectors[o].size();
+            for (NgramIndex i = 0; i < (NgramIndex)vectors[o].size(); ++i) {
+                NgramIndex index = i;
+                for (size_t j = o; j > 0; --j) {
+                    words[j - 1] = sortIndices[vectors[j].words()[index]];
+                    index = vectors[j].hists()[index];
+                }
+                if (fwrite(&words[0], sizeof(VocabIndex), o, run->file) != o ||
+                    fwrite(&counts[i], sizeof(Count), 1, run->file) != 1)
+                    throw std::runtime_error("Write failed.");
+            }
+        }
+    } catch (...) {
+        delete run;
+        throw;
+    }
+    return run;
+}
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 NgramModel::NgramModel(size_t order) {
@@ -71,7 +310,8 @@ NgramModel::SaveVocab(ZFile &vocabFile, bool asBinary) const {
 
 void
 NgramModel::LoadCorpus(vector<CountVector> &countVectors,
-                       ZFile &corpusFile, bool reset) {
+                       ZFile &corpusFile, bool reset, size_t numThreads,
+                       size_t memoryBudget) {
     if (corpusFile == NULL) throw std::invalid_argument("Invalid file");
 
     // Resize vectors and allocate counts.
@@ -86,47 +326,16 @@ NgramModel::LoadCorpus(vector<CountVector> &countVectors,
     }
 
     // Accumulate counts for each n-gram in corpus file.
-    char line[MAXLINE];
-    vector<VocabIndex> words(256);
-    vector<NgramIndex> hists(size(), -1);
-    while (getline(corpusFile, line, MAXLINE)) {
-        if (strncmp(line, "<DOC ", 5) == 0 || strcmp(line, "</DOC>") == 0)
-            continue;
-
-        // Lookup vocabulary indices for each word in the line.
-        words.clear();
-        words.push_back(Vocab::EndOfSentence);
-        char *p = &line[0];
-        while (*p != '\0') {
-            while (isspace(*p)) ++p;  // Skip consecutive spaces.
-            const char *token = p;
-            while (*p != 0 && !isspace(*p))  ++p;
-            size_t len = p - token;
-            if (*p != 0) *p++ = 0;
-            words.push_back(_vocab.Add(token, len));
-        }
-        words.push_back(Vocab::EndOfSentence);
-
-        // Add each order n-gram.
-        hists[1] = _vectors[1].Add(0, Vocab::EndOfSentence);
-        for (size_t i = 1; i < words.size(); ++i) {
-            VocabIndex word = words[i];
-            NgramIndex hist = 0;
-            for (size_t j = 1; j < std::min(i + 2, size()); ++j) {
-                if (word != Vocab::Invalid && hist != NgramVector::Invalid) {
-                    bool       newNgram;
-                    NgramIndex index = _vectors[j].Add(hist, word, &newNgram);
-                    if (newNgram && (size_t)index >= countVectors[j].length())
-                        countVectors[j].resize(countVectors[j].length() * 2, 0);
-                    countVectors[j][index]++;
-                    hist     = hists[j];
-                    hists[j] = index;
-                } else {
-                    hist     = hists[j];
-                    hists[j] = NgramVector::Invalid;
-                }
-            }
-        }
+    if (memoryBudget > 0) {
+        _LoadCorpusRuns(countVectors, corpusFile, memoryBudget);
+    } else if (numThreads > 1) {
+        _LoadCorpusShards(countVectors, corpusFile, numThreads);
+    } else {
+        char line[MAXLINE];
+        vector<VocabIndex> words(256);
+        vector<NgramIndex> hists(size(), -1);
+        while (getline(corpusFile, line, MAXLINE))
+            _CountLine(line, _vocab, _vectors, countVectors, words, hists);
     }
 
     // Add remaining vocabulary, if necessary.
@@ -150,6 +359,58 @@ NgramModel::LoadCorpus(vector<CountVector> &countVectors,
     _ComputeBackoffs();
 }
 
+// Add the counts of corpusFile to countVectors, returning the added counts in
+// deltaVectors.  Unlike LoadCorpus(), the model is not sorted afterwards, so
+// existing words and n-grams keep their indices and new ones are appended.
+void
+NgramModel::UpdateCorpus(vector<CountVector> &countVectors,
+                         vector<CountVector> &deltaVectors,
+                         ZFile &corpusFile) {
+    if (corpusFile == NULL) throw std::invalid_argument("Invalid file");
+    if (_mappedFile.get() != NULL)
+        throw std::runtime_error("Cannot update a memory-mapped model.");
+
+    // Count the corpus on its own.
+    vector<size_t> oldSizes(size());
+    deltaVectors.resize(size());
+    deltaVectors[0].reset(1, 0);
+    for (size_t o = 1; o < size(); ++o) {
+        oldSizes[o] = _vectors[o].size();
+        deltaVectors[o].reset(std::max(1ul<<16, nextPowerOf2(oldSizes[o])), 0);
+    }
+    char line[MAXLINE];
+    vector<VocabIndex> words(256);
+    vector<NgramIndex> hists(size(), -1);
+    while (getline(corpusFile, line, MAXLINE))
+        _CountLine(line, _vocab, _vectors, deltaVectors, words, hists);
+
+    // Add remaining vocabulary, if necessary.
+    if (_vectors[1].size() != _vocab.size())
+        for (VocabIndex i = 0; i < (VocabIndex)_vocab.size(); ++i)
+            _vectors[1].Add(0, i);
+
+    // Add the counts, and find the backoffs of the new n-grams.
+    countVectors.resize(size());
+    for (size_t o = 1; o < size(); ++o) {
+        size_t len = _vectors[o].size();
+        _vectors[o]._UpdateViews();
+        deltaVectors[o].resize(len);
+        countVectors[o].resize(len, 0);
+        countVectors[o] += deltaVectors[o];
+        _backoffVectors[o].resize(len, 0);
+    }
+    for (size_t o = 2; o < size(); ++o) {
+        const VocabVector &words(_vectors[o].words());
+        const IndexVector &hists(_vectors[o].hists());
+        IndexVector &      backoffs(_backoffVectors[o]);
+        for (size_t i = oldSizes[o]; i < _vectors[o].size(); ++i) {
+            NgramIndex hist = (o == 2) ? 0 : _backoffVectors[o-1][hists[i]];
+            backoffs[i] = _vectors[o-1].Find(hist, words[i]);
+            assert(backoffs[i] != NgramVector::Invalid);
+        }
+    }
+}
+
 void
 NgramModel::LoadCounts(vector<CountVector> &countVectors,
                        ZFile &countsFile, bool reset) {
@@ -784,6 +1045,38 @@ NgramModel::Deserialize(FILE *inFile) {
     _ComputeBackoffs();
 }
 
+// Unlike Serialize(), also store the backoffs, so that DeserializeMapped() can
+// use every vector in place within the file without computing anything.
+void
+NgramModel::SerializeMapped(FILE *outFile) const {
+    WriteHeader(outFile, "NgramModel");
+    _vocab.SerializeMapped(outFile);
+    WriteUInt64(outFile, size());
+    for (unsigned int i = 0; i < size(); i++)
+        _vectors[i].SerializeMapped(outFile);
+    for (unsigned int i = 0; i < size(); i++)
+        WriteVector(outFile, _backoffVectors[i]);
+}
+
+void
+NgramModel::DeserializeMapped(const SharedPtr<MappedFile> &inFile) {
+    _mappedFile = inFile;
+    MappedFile &in(*_mappedFile);
+    in.VerifyHeader("NgramModel");
+    _vocab.DeserializeMapped(in);
+    size_t order = in.ReadUInt64();
+    if (order == 0)
+        throw std::runtime_error("Invalid file format.");
+    SetOrder(order - 1);
+    for (unsigned int i = 0; i < size(); i++)
+        _vectors[i].DeserializeMapped(in);
+    for (unsigned int i = 0; i < size(); i++) {
+        MapVector(in, _backoffVectors[i]);
+        if (_backoffVectors[i].length() != _vectors[i].size())
+            throw std::runtime_error("Invalid file format.");
+    }
+}
+
 template <class T>
 void
 NgramModel::ApplySort(const IndexVector &ngramMap,
@@ -806,6 +1099,238 @@ NgramModel::_Find(const VocabIndex *words, size_t wordsLen) const {
     return index;
 }
 
+// Count the corpus in runs of at most memoryBudget bytes of n-gram counts,
+// spilling each run to disk, then merge the runs into the model.
+// NOTE: Only counting is bounded.  The merged n-grams and counts, and the
+//       smoothing and LM built from them, are held in memory as usual.
+// NOTE: Runs are counted on this thread only.
+void
+NgramModel::_LoadCorpusRuns(vector<CountVector> &countVectors,
+                            ZFile &corpusFile, size_t memoryBudget) {
+    // Give each order an equal share of the budget.  Each n-gram takes up to
+    // 2.5 index table slots, plus its word, hist and count.
+    size_t ngramBytes = sizeof(NgramSlot) * 5 / 2 + sizeof(VocabIndex) +
+                        sizeof(NgramIndex) + sizeof(Count);
+    size_t capacity   = std::max((size_t)1 << 10,
+                                 memoryBudget / ngramBytes / (size() - 1));
+
+    // Count until an order is nearly full, leaving room for the last line.
+    vector<CountRun *>  runs;
+    vector<NgramVector> vectors;
+    vector<CountVector> runCountVectors;
+    char                line[MAXLINE];
+    vector<VocabIndex>  words(256);
+    vector<NgramIndex>  hists(size(), -1);
+    bool                more = true;
+    try {
+        while (more) {
+            vector<NgramVector>(size()).swap(vectors);
+            vector<CountVector>(size()).swap(runCountVectors);
+            vectors[0].Add(0, 0);
+            runCountVectors[0].resize(1, 0);
+            for (size_t o = 1; o < size(); ++o) {
+                vectors[o].Reserve(capacity);
+                runCountVectors[o].resize(capacity, 0);
+            }
+
+            bool full = false;
+            while (!full && (more = getline(corpusFile, line, MAXLINE))) {
+                _CountLine(line, _vocab, vectors, runCountVectors, words, hists);
+                for (size_t o = 1; o < size() && !full; ++o)
+                    full = (vectors[o].size() >= capacity - capacity / 8);
+            }
+
+            // The last run also holds every vocab word, so that LoadCorpus()
+            // adds none to the model after the merge.
+            if (!more) {
+                CountVector &counts = runCountVectors[1];
+                for (VocabIndex i = 0; i < (VocabIndex)_vocab.size(); ++i) {
+                    NgramIndex index = vectors[1].Add(0, i);
+                    if ((size_t)index >= counts.length())
+                        counts.resize(counts.length() * 2, 0);
+                }
+            }
+            runs.push_back(SpillCountRun(_vocab, vectors, runCountVectors));
+            Logger::Log(2, "Spilled count run %lu.\n", runs.size());
+        }
+        vector<NgramVector>().swap(vectors);
+        vector<CountVector>().swap(runCountVectors);
+
+        // Merge each order in sorted order, so that all n-grams sharing a
+        // history are merged in turn.  The first pass counts the distinct
+        // n-grams to reserve the vectors and counts exactly.
+        Logger::Log(1, "Merging %lu count runs...\n", runs.size());
+        VocabVector sortMap;
+        _vocab.GetSortMap(sortMap);
+        for (size_t o = 1; o < size(); ++o) {
+            Count  count;
+            size_t numNgrams = 0;
+            for (RunMerger merger(runs, o, sortMap); merger.Next(words, count);)
+                ++numNgrams;
+            size_t newCapacity = _vectors[o].size() + numNgrams;
+            if (newCapacity > _vectors[o]._words.length())
+                _vectors[o].Reserve(newCapacity);
+            if (newCapacity > countVectors[o].length())
+                countVectors[o].resize(newCapacity, 0);
+
+            NgramIndex         hist = 0;
+            vector<VocabIndex> histWords;
+            RunMerger          merger(runs, o, sortMap);
+            while (merger.Next(words, count)) {
+                if (o > 1 && (histWords.empty() ||
+                              !std::equal(histWords.begin(), histWords.end(),
+                                          words.begin()))) {
+                    histWords.assign(words.begin(), words.begin() + o - 1);
+                    hist = _Find(&histWords[0], o - 1);
+                    assert(hist != NgramVector::Invalid);
+                }
+                NgramIndex index = _vectors[o].Add(hist, words[o - 1]);
+                countVectors[o][index] += count;
+            }
+        }
+    } catch (...) {
+        for (size_t r = 0; r < runs.size(); ++r)
+            delete runs[r];
+        throw;
+    }
+    for (size_t r = 0; r < runs.size(); ++r)
+        delete runs[r];
+}
+
+// Add each order n-gram of the corpus line to the vectors and counts.
+void
+NgramModel::_CountLine(char *line, Vocab &vocab, vector<NgramVector> &vectors,
+                       vector<CountVector> &countVectors,
+                       vector<VocabIndex> &words, vector<NgramIndex> &hists) {
+    if (strncmp(line, "<DOC ", 5) == 0 || strcmp(line, "</DOC>") == 0)
+        return;
+
+    // Lookup vocabulary indices for each word in the line.
+    words.clear();
+    words.push_back(Vocab::EndOfSentence);
+    char *p = &line[0];
+    while (*p != '\0') {
+        while (isspace(*p)) ++p;  // Skip consecutive spaces.
+        const char *token = p;
+        while (*p != 0 && !isspace(*p))  ++p;
+        size_t len = p - token;
+        if (*p != 0) *p++ = 0;
+        words.push_back(vocab.Add(token, len));
+    }
+    words.push_back(Vocab::EndOfSentence);
+
+    // Add each order n-gram.
+    hists[1] = vectors[1].Add(0, Vocab::EndOfSentence);
+    for (size_t i = 1; i < words.size(); ++i) {
+        VocabIndex word = words[i];
+        NgramIndex hist = 0;
+        for (size_t j = 1; j < std::min(i + 2, vectors.size()); ++j) {
+            if (word != Vocab::Invalid && hist != NgramVector::Invalid) {
+                bool       newNgram;
+                NgramIndex index = vectors[j].Add(hist, word, &newNgram);
+                if (newNgram && (size_t)index >= countVectors[j].length())
+                    countVectors[j].resize(countVectors[j].length() * 2, 0);
+                countVectors[j][index]++;
+                hist     = hists[j];
+                hists[j] = index;
+            } else {
+                hist     = hists[j];
+                hists[j] = NgramVector::Invalid;
+            }
+        }
+    }
+}
+
+void *
+NgramModel::_CountCorpusShard(void *shard) {
+    CorpusShard &       s = *static_cast<CorpusShard *>(shard);
+    vector<VocabIndex> words(256);
+    vector<NgramIndex> hists(s.vectors.size(), -1);
+    CorpusBatch *       batch;
+    while ((batch = s.queue.Pop()) != NULL) {
+        for (size_t i = 0; i < batch->lines.size(); ++i)
+            _CountLine(&batch->text[batch->lines[i]], s.vocab, s.vectors,
+                       s.countVectors, words, hists);
+        delete batch;
+    }
+    return NULL;
+}
+
+// Count the corpus on numThreads threads, then merge the shards in order.
+// LoadCorpus sorts the vocab and n-grams afterwards, so the model and counts
+// do not depend on which lines each thread counted.
+void
+NgramModel::_LoadCorpusShards(vector<CountVector> &countVectors,
+                              ZFile &corpusFile, size_t numThreads) {
+    CorpusQueue           queue(2 * numThreads);
+    vector<CorpusShard *> shards;
+    vector<pthread_t>     threads(numThreads);
+    for (size_t t = 0; t < numThreads; ++t)
+        shards.push_back(new CorpusShard(queue, _vocab, size()));
+    size_t numStarted = 0;
+    while (numStarted < numThreads &&
+           pthread_create(&threads[numStarted], NULL, &_CountCorpusShard,
+                          shards[numStarted]) == 0)
+        ++numStarted;
+
+    if (numStarted == numThreads) {
+        char         line[MAXLINE];
+        CorpusBatch *batch = new CorpusBatch();
+        while (getline(corpusFile, line, MAXLINE)) {
+            batch->lines.push_back(batch->text.size());
+            batch->text.insert(batch->text.end(), line,
+                               line + strlen(line) + 1);
+            if (batch->text.size() >= CorpusBatchSize) {
+                queue.Push(batch);
+                batch = new CorpusBatch();
+            }
+        }
+        queue.Push(batch);
+    }
+    queue.Close();
+    for (size_t t = 0; t < numStarted; ++t)
+        pthread_join(threads[t], NULL);
+    if (numStarted != numThreads) {
+        for (size_t t = 0; t < numThreads; ++t)
+            delete shards[t];
+        throw std::runtime_error("Cannot create thread");
+    }
+
+    // Add each shard's n-grams to the model, order by order, mapping shard
+    // word and history indices to the model's.
+    VocabVector vocabMap;
+    IndexVector ngramMap, histMap;
+    for (size_t t = 0; t < numThreads; ++t) {
+        CorpusShard &shard = *shards[t];
+        bool         mapWords = (&shard.vocab != &_vocab);
+        if (mapWords) {
+            vocabMap.reset(shard.vocab.size());
+            for (VocabIndex i = 0; i < (VocabIndex)shard.vocab.size(); ++i)
+                vocabMap[i] = _vocab.Add(shard.vocab[i],
+                                         shard.vocab.wordlen(i));
+        }
+        ngramMap.reset(1, 0);
+        for (size_t o = 1; o < size(); ++o) {
+            const NgramVector &ngrams = shard.vectors[o];
+            const CountVector &counts = shard.countVectors[o];
+            histMap.swap(ngramMap);
+            ngramMap.reset(ngrams.size());
+            for (NgramIndex i = 0; i < (NgramIndex)ngrams.size(); ++i) {
+                VocabIndex word = mapWords ? vocabMap[ngrams._words[i]]
+                                           : ngrams._words[i];
+                bool       newNgram;
+                NgramIndex index = _vectors[o].Add(histMap[ngrams._hists[i]],
+                                                   word, &newNgram);
+                if (newNgram && (size_t)index >= countVectors[o].length())
+                    countVectors[o].resize(countVectors[o].length() * 2, 0);
+                countVectors[o][index] += counts[i];
+                ngramMap[i] = index;
+            }
+        }
+        delete shards[t];
+    }
+}
+
 void
 NgramModel::_ComputeBackoffs() {
     // Assign unique backoff of 0 to unigrams.
@@ -816,9 +1341,8 @@ NgramModel::_ComputeBackoffs() {
     // Compute backoffs for bigram via vocabulary lookup.
     if (size() > 2) {
         IndexVector &backoffs(_backoffVectors[2]);
-        backoffs.resize(_vectors[2].size());
-        for (NgramIndex i = 0; i < (NgramIndex)backoffs.length(); ++i)
-            backoffs[i] = _vectors[1].Find(0, _vectors[2]._words[i]);
+        IndexVector  hists(_vectors[2].size(), 0);
+        _vectors[1].Find(hists, _vectors[2].words(), backoffs);
         assert(allTrue(backoffs != NgramVector::Invalid));
     }
 
@@ -826,10 +1350,8 @@ NgramModel::_ComputeBackoffs() {
     for (size_t o = 3; o < size(); o++) {
         IndexVector &loBackoffs(_backoffVectors[o - 1]);
         IndexVector &backoffs(_backoffVectors[o]);
-        backoffs.resize(_vectors[o].size());
-        for (NgramIndex i = 0; i < (NgramIndex)backoffs.length(); ++i)
-            backoffs[i] = _vectors[o-1].Find(loBackoffs[_vectors[o]._hists[i]],
-                                             _vectors[o]._words[i]);
+        IndexVector  hists(loBackoffs[_vectors[o].hists()]);
+        _vectors[o-1].Find(hists, _vectors[o].words(), backoffs);
         assert(allTrue(backoffs != NgramVector::Invalid));
     }
 }
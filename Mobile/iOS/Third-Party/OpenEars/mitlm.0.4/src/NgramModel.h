@@ -37,6 +37,7 @@
 
 #include <vector>
 #include "util/ZFile.h"
+#include "util/SharedPtr.h"
 #include "Types.h"
 #include "Vocab.h"
 #include "NgramVector.h"
@@ -53,6 +54,7 @@ using std::vector;
 //
 class NgramModel {
 protected:
+    SharedPtr<MappedFile> _mappedFile;  // Declared first to outlive its views
     Vocab               _vocab;
     vector<NgramVector> _vectors;
     vector<IndexVector> _backoffVectors;
@@ -64,7 +66,10 @@ public:
     void   LoadVocab(ZFile &vocabFile);
     void   SaveVocab(ZFile &vocabFile, bool asBinary=false) const;
     void   LoadCorpus(vector<CountVector> &countVectors,
-                      ZFile &corpusFile, bool reset=false);
+                      ZFile &corpusFile, bool reset=false,
+                      size_t numThreads=1, size_t memoryBudget=0);
+    void   UpdateCorpus(vector<CountVector> &countVectors,
+                        vector<CountVector> &deltaVectors, ZFile &corpusFile);
     void   LoadCounts(vector<CountVector> &countVectors,
                       ZFile &countsFile, bool reset=false);
     void   SaveCounts(const vector<CountVector> &countVectors,
@@ -92,6 +97,8 @@ public:
     void   SortModel(VocabVector &vocabMap, vector<IndexVector> &ngramMap);
     void   Serialize(FILE *outFile) const;
     void   Deserialize(FILE *inFile);
+    void   SerializeMapped(FILE *outFile) const;
+    void   DeserializeMapped(const SharedPtr<MappedFile> &inFile);
 
     template <class T>
     static void ApplySort(const IndexVector &ngramMap, DenseVector<T> &data,
@@ -107,6 +114,16 @@ public:
 
 protected:
     NgramIndex _Find(const VocabIndex *words, size_t wordsLen) const;
+    static void _CountLine(char *line, Vocab &vocab,
+                           vector<NgramVector> &vectors,
+                           vector<CountVector> &countVectors,
+                           vector<VocabIndex> &words,
+                           vector<NgramIndex> &hists);
+    static void *_CountCorpusShard(void *shard);
+    void       _LoadCorpusShards(vector<CountVector> &countVectors,
+                                 ZFile &corpusFile, size_t numThreads);
+    void       _LoadCorpusRuns(vector<CountVector> &countVectors,
+                               ZFile &corpusFile, size_t memoryBudget);
     void       _ComputeBackoffs();
     void       _LoadFrequency(vector<DoubleVector> &freqVectors,
                               ZFile &corpusFile, size_t maxSize=0) const;
@@ -70,23 +70,39 @@ NgramVector::NgramVector(const NgramVector &v) {
             throw std::runtime_error("Copying NgramVector");
         _words    = v._words;
         _hists    = v._hists;
-        _indices  = v._indices;
+        _slots    = v._slots;
         _hashMask = v._hashMask;
     } else
         _Reindex(1);
 }
 
 // Return associated index of the value, or -1 if not found.
-// In case of collision, apply quadratic probing.
 NgramIndex
 NgramVector::Find(NgramIndex hist, VocabIndex word) const {
-    size_t     skip = 0;
-    NgramIndex pos = SuperFastHash(hist, word) & _hashMask;
-    NgramIndex index;
-    while ((index = _indices[pos]) != Invalid &&
-           !(_words[index] == word && _hists[index] == hist))
-        pos = (pos + ++skip) & _hashMask;
-    return index;
+    return _FindSlot(SuperFastHash(hist, word) & _hashMask, hist, word)->Index;
+}
+
+// Return the associated index of each value in hists and words, or -1 if not
+// found.  The slots of a batch of values are prefetched before probing any of
+// them, so that their cache misses overlap instead of following one another.
+void
+NgramVector::Find(const IndexVector &hists, const VocabVector &words,
+                  IndexVector &indices) const {
+    assert(hists.length() == words.length());
+    const size_t batchSize = 16;
+    NgramIndex   pos[batchSize];
+    indices.reset(words.length());
+    for (size_t i = 0; i < words.length(); i += batchSize) {
+        size_t n = std::min(batchSize, words.length() - i);
+        for (size_t j = 0; j < n; ++j) {
+            pos[j] = SuperFastHash(hists[i + j], words[i + j]) & _hashMask;
+#ifdef __GNUC__
+            __builtin_prefetch(&_slots[pos[j]]);
+#endif
+        }
+        for (size_t j = 0; j < n; ++j)
+            indices[i + j] = _FindSlot(pos[j], hists[i + j], words[i + j])->Index;
+    }
 }
 
 // Add value to the hash vector and return the associated index.
@@ -95,40 +111,40 @@ NgramIndex
 NgramVector::Add(NgramIndex hist, VocabIndex word) {
     assert(hist != Invalid);
     assert(word != Invalid);
-    NgramIndex *pIndex = _FindIndex(hist, word);
-    if (*pIndex == Invalid) {
+    NgramSlot *pSlot = _FindSlot(hist, word);
+    if (pSlot->Index == Invalid) {
         // Increase index table size as needed.
         if (size() >= _words.length()) {
             Reserve(std::max((size_t)1<<16,
                              _words.length()*2));  // Double capacity.
-            pIndex = _FindIndex(hist, word);  // Update iterator for new index.
+            pSlot = _FindSlot(hist, word);  // Update iterator for new index.
         }
-        *pIndex = _length;
+        *pSlot = NgramSlot(hist, word, _length);
         _words[_length] = word;
         _hists[_length] = hist;
         _length++;
     }
-    return *pIndex;
+    return pSlot->Index;
 }
 
 NgramIndex
 NgramVector::Add(NgramIndex hist, VocabIndex word, bool *outNew) {
     assert(hist != Invalid);
     assert(word != Invalid);
-    NgramIndex *pIndex = _FindIndex(hist, word);
-    *outNew = (*pIndex == Invalid);
+    NgramSlot *pSlot = _FindSlot(hist, word);
+    *outNew = (pSlot->Index == Invalid);
     if (*outNew) {
         // Increase index table size as needed.
         if (size() >= _words.length()) {
             Reserve(std::max((size_t)1<<16, _words.length()*2));  // Double capacity.
-            pIndex = _FindIndex(hist, word);  // Update iterator for new index.
+            pSlot = _FindSlot(hist, word);  // Update iterator for new index.
         }
-        *pIndex = _length;
+        *pSlot = NgramSlot(hist, word, _length);
         _words[_length] = word;
         _hists[_length] = hist;
         _length++;
     }
-    return *pIndex;
+    return pSlot->Index;
 }
 
 void
@@ -173,13 +189,8 @@ bool NgramVector::Sort(const VocabVector &vocabMap,
     _hists.swap(newHists);
 
     // Rebuild index map.
-    _Reindex(_indices.length());
-
-    // Build truncated view into words and hists.
-    Range r(_length);
-    _wordsView.attach(_words[r]);
-    _histsView.attach(_hists[r]);
-
+    _Reindex(_slots.length());
+    _UpdateViews();
     return true;
 }
 
@@ -203,32 +214,70 @@ NgramVector::Deserialize(FILE *inFile) {
     _histsView.attach(_hists);
 }
 
-// Return the iterator to the position of the value.
-// If value is not found, return the position to insert the value.
+void
+NgramVector::SerializeMapped(FILE *outFile) const {
+    Range r(_length);
+    WriteVector(outFile, _words[r]);
+    WriteVector(outFile, _hists[r]);
+    WriteVector(outFile, _slots);
+}
+
+void
+NgramVector::DeserializeMapped(MappedFile &inFile) {
+    MapVector(inFile, _words);
+    MapVector(inFile, _hists);
+    MapVector(inFile, _slots);
+    _length   = _words.length();
+    _hashMask = _slots.length() - 1;
+    if (_hists.length() != _length || _slots.length() <= _length ||
+        !isPowerOf2(_slots.length()))
+        throw std::runtime_error("Invalid file format.");
+
+    _wordsView.attach(_words);
+    _histsView.attach(_hists);
+}
+
+// Return the slot of the value, starting from its hash position pos.
+// If value is not found, return the empty slot to insert the value in.
 // In case of collision, apply quadratic probing.
 // NOTE: This function assumes the index table is not full.
-NgramIndex *
-NgramVector::_FindIndex(NgramIndex hist, VocabIndex word) {
-    size_t     skip = 0;
-    NgramIndex pos = SuperFastHash(hist, word) & _hashMask;
-    NgramIndex index;
-    while ((index = _indices[pos]) != Invalid &&
-           !(_words[index] == word && _hists[index] == hist))
+const NgramSlot *
+NgramVector::_FindSlot(NgramIndex pos, NgramIndex hist,
+                       VocabIndex word) const {
+    size_t           skip = 0;
+    const NgramSlot *p;
+    while ((p = &_slots[pos])->Index != Invalid &&
+           !(p->Word == word && p->Hist == hist))
         pos = (pos + ++skip) & _hashMask;
-    return &_indices[pos];
+    return p;
+}
+
+NgramSlot *
+NgramVector::_FindSlot(NgramIndex hist, VocabIndex word) {
+    const NgramVector *v = this;
+    return const_cast<NgramSlot *>(
+        v->_FindSlot(SuperFastHash(hist, word) & _hashMask, hist, word));
 }
 
 // Resize index table to the specified capacity.
 void
 NgramVector::_Reindex(size_t indexSize) {
     assert(indexSize >= size() && isPowerOf2(indexSize));
-    _indices.reset(indexSize, Invalid);
+    _slots.reset(indexSize, NgramSlot());
     _hashMask = indexSize - 1;
     for (NgramIndex i = 0; i < (NgramIndex)size(); i++) {
         size_t     skip = 0;
         NgramIndex pos  = SuperFastHash(_hists[i], _words[i]) & _hashMask;
-        while (_indices[pos] != Invalid)
+        while (_slots[pos].Index != Invalid)
             pos = (pos + ++skip) & _hashMask;
-        _indices[pos] = i;
+        _slots[pos] = NgramSlot(_hists[i], _words[i], i);
     }
 }
+
+// Build truncated view into words and hists, which Add() does not extend.
+void
+NgramVector::_UpdateViews() {
+    Range r(_length);
+    _wordsView.attach(_words[r]);
+    _histsView.attach(_hists[r]);
+}
@@ -37,22 +37,36 @@
 
 #include "Types.h"
 
+////////////////////////////////////////////////////////////////////////////////
+
+struct NgramSlot {
+    NgramSlot(NgramIndex hist = 0, VocabIndex word = 0, NgramIndex index = -1)
+        : Hist(hist), Word(word), Index(index) { }
+    NgramIndex Hist;             // History index of the n-gram
+    VocabIndex Word;             // Target word of the n-gram
+    NgramIndex Index;            // Index of the n-gram, or -1 if unused
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // NgramVector represents the n-gram structure within a particular order of the
 // n-gram trie.  For each n-gram, it stores the index of the history n-gram in
 // the lower-order NgramVector and the index corresponding to the target word.
 // The n-grams can be accessed by index.  Lookup of the n-gram index can be
-// performed in constant time.
+// performed in constant time.  Each index table slot stores its n-gram inline,
+// so a lookup reads one slot per probe instead of also reading the words and
+// hists it points to.
 //
 class NgramVector {
     friend class NgramModel;
     friend class NgramIndexCompare;
 
 protected:
+    typedef DenseVector<NgramSlot> SlotVector;
+
     size_t              _length;
     VocabVector         _words;
     IndexVector         _hists;
-    IndexVector         _indices;   // Index table mapping value to index
+    SlotVector          _slots;     // Index table mapping value to index
     size_t              _hashMask;  // Hash mask: hashIndex = hash & hashMask
     mutable VocabVector _wordsView;
     mutable IndexVector _histsView;
@@ -63,6 +77,8 @@ public:
     NgramVector();
     NgramVector(const NgramVector &v);
     NgramIndex Find(NgramIndex hist, VocabIndex word) const;
+    void       Find(const IndexVector &hists, const VocabVector &words,
+                    IndexVector &indices) const;
     NgramIndex Add(NgramIndex hist, VocabIndex word);
     NgramIndex Add(NgramIndex hist, VocabIndex word, bool *outNew);
     void       Reserve(size_t capacity);
@@ -70,15 +86,20 @@ public:
                     IndexVector &ngramMap);
     void       Serialize(FILE *outFile) const;
     void       Deserialize(FILE *inFile);
+    void       SerializeMapped(FILE *outFile) const;
+    void       DeserializeMapped(MappedFile &inFile);
 
     size_t             size() const     { return _length; }
-    size_t             capacity() const { return _indices.length(); }
+    size_t             capacity() const { return _slots.length(); }
     const VocabVector &words() const    { return _wordsView; }
     const IndexVector &hists() const    { return _histsView; }
 
 protected:
-    NgramIndex *_FindIndex(NgramIndex hist, VocabIndex word);
+    const NgramSlot *_FindSlot(NgramIndex pos, NgramIndex hist,
+                               VocabIndex word) const;
+    NgramSlot       *_FindSlot(NgramIndex hist, VocabIndex word);
     void        _Reindex(size_t indexSize);
+    void        _UpdateViews();
 };
 
 #endif // NGRAMVECTOR_H
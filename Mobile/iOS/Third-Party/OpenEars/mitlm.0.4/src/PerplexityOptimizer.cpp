@@ -58,6 +58,7 @@ PerplexityOptimizer::LoadCorpus(ZFile &corpusFile) {
 double
 PerplexityOptimizer::ComputeEntropy(const ParamVector &params) {
     // Estimate model.
+    _params.reset(0);
     if (!_lm.Estimate(params, _mask))
         return 7;  // Out of bounds.  Corresponds to perplexity = 1100.
 
@@ -105,8 +106,48 @@ PerplexityOptimizer::ComputeEntropy(const ParamVector &params) {
 	bool somebool =  d != d;  /**I changed this for OpenEars -- HLW*/
 	
 	
+    if (!somebool)
+        _params = params;
     return somebool ? 7 : entropy;} /**I changed this for OpenEars -- HLW*/
 
+// Compute the gradient of the entropy at params, from the estimate that
+// ComputeEntropy(params) just made.  Return false if the LM cannot, so that
+// the optimizer approximates it instead.
+bool
+PerplexityOptimizer::ComputeEntropyGradient(const ParamVector &params,
+                                            ParamVector &gradient) {
+    if (_params.length() != params.length())
+        return false;
+    for (size_t i = 0; i < params.length(); i++)
+        if (_params[i] != params[i])
+            return false;
+
+    // d entropy / d prob = -count / (prob * numWords), likewise for bows.
+    // Zero probs are excluded from the entropy, so get no gradient.
+    double scale = -1.0 / (_numWords - _numZeroProbs);
+    vector<ProbVector> probGrads(_lm.order() + 1);
+    vector<ProbVector> bowGrads(_lm.order());
+    for (size_t o = 0; o <= _lm.order(); o++) {
+        const ProbVector &probs(_lm.probs(o));
+        probGrads[o].reset(probs.length(), 0);
+        if (o > _order) continue;
+        const CountVector &counts(_probCountVectors[o]);
+        for (size_t i = 0; i < counts.length(); i++)
+            if (counts[i] > 0 && probs[i] != 0)
+                probGrads[o][i] = scale * counts[i] / probs[i];
+    }
+    for (size_t o = 0; o < _lm.order(); o++) {
+        const ProbVector &bows(_lm.bows(o));
+        bowGrads[o].reset(bows.length(), 0);
+        if (o >= _order) continue;
+        const CountVector &counts(_bowCountVectors[o]);
+        for (size_t i = 0; i < counts.length(); i++)
+            if (counts[i] > 0)
+                bowGrads[o][i] = scale * counts[i] / bows[i];
+    }
+    return _lm.EstimateGradient(probGrads, bowGrads, gradient);
+}
+
 double
 PerplexityOptimizer::Optimize(ParamVector &params, Optimization technique) {
     _numCalls = 0;
@@ -118,12 +159,17 @@ PerplexityOptimizer::Optimize(ParamVector &params, Optimization technique) {
     case PowellOptimization:
         minEntropy = MinimizePowell(func, params, numIter);
         break;
- //   case LBFGSOptimization:/**Removed for OpenEars -- HLW*/
-//        minEntropy = MinimizeLBFGS(func, params, numIter);/**Removed for OpenEars -- HLW*/
-//        break;/**Removed for OpenEars -- HLW*/
-//    case LBFGSBOptimization:/**Removed for OpenEars -- HLW*/
-//        minEntropy = MinimizeLBFGSB(func, params, numIter);/**Removed for OpenEars -- HLW*/
-//        break;/**Removed for OpenEars -- HLW*/
+    case LBFGSOptimization:
+        minEntropy = MinimizeLBFGS(func, params, numIter);
+        break;
+    case LBFGSBOptimization:
+        // Keep to the bounds the LM checks, if it has them for every param.
+        if (_lm.minParams().length() == params.length())
+            minEntropy = MinimizeLBFGSB(func, params, _lm.minParams(),
+                                        _lm.maxParams(), numIter);
+        else
+            minEntropy = MinimizeLBFGSB(func, params, numIter);
+        break;
     default:
         throw std::runtime_error("Unsupported optimization technique.");
     }
@@ -55,6 +55,7 @@ protected:
     size_t              _numCalls;
     double              _totLogProb;
     SharedPtr<Mask>     _mask;
+    ParamVector         _params;     // Params of the last estimate, if valid
 
     class ComputeEntropyFunc {
         PerplexityOptimizer &_obj;
@@ -62,6 +63,8 @@ protected:
         ComputeEntropyFunc(PerplexityOptimizer &obj) : _obj(obj) { }
         double operator()(const ParamVector &params)
         { _obj._numCalls++; return _obj.ComputeEntropy(params); }
+        bool Gradient(const ParamVector &params, ParamVector &gradient)
+        { return _obj.ComputeEntropyGradient(params, gradient); }
     };
 
 public:
@@ -71,6 +74,8 @@ public:
     void   SetOrder(size_t order) { _order = order; }
     void   LoadCorpus(ZFile &corpusFile);
     double ComputeEntropy(const ParamVector &params);
+    bool   ComputeEntropyGradient(const ParamVector &params,
+                                  ParamVector &gradient);
     double ComputePerplexity(const ParamVector &params)
     { return exp(ComputeEntropy(params)); }
     double Optimize(ParamVector &params,
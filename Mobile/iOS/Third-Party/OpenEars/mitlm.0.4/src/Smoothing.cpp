@@ -58,3 +58,11 @@ Smoothing::Create(const char *smoothing) {
     } else
         return NULL;
 }
+
+bool
+Smoothing::EstimateGradient(const ProbVector &probGrads,
+                            const ProbVector &bowGrads,
+                            ProbVector &boProbGrads,
+                            ParamVector &paramGrads) const {
+    return false;
+}
@@ -48,6 +48,8 @@ class NgramLM;
 class Smoothing {
 protected:
     ParamVector _defParams;
+    ParamVector _minParams;  // Bounds of each param, if any
+    ParamVector _maxParams;
     CountVector _effCounts;
     Smoothing() { }
 
@@ -58,7 +60,23 @@ public:
     virtual bool Estimate(const ParamVector &params, const NgramLMMask *pMask,
                           ProbVector &probs, ProbVector &bows) = 0;
 
+    // After the counts in deltaVectors were added to the LM, update the
+    // statistics they change.  Mark in lmMask the probs and bows to
+    // re-estimate, given the probs marked in the lower orders.
+    virtual void Update(const vector<CountVector> &deltaVectors,
+                        NgramLMMask &lmMask) = 0;
+
+    // Given the gradient of a function with respect to the probs and bows of
+    // the last Estimate(), add its gradient with respect to the params and
+    // the backoff probs.  Return false if not supported.
+    virtual bool EstimateGradient(const ProbVector &probGrads,
+                                  const ProbVector &bowGrads,
+                                  ProbVector &boProbGrads,
+                                  ParamVector &paramGrads) const;
+
     const ParamVector &defParams() const { return _defParams; }
+    const ParamVector &minParams() const { return _minParams; }
+    const ParamVector &maxParams() const { return _maxParams; }
     const CountVector &effCounts() const { return _effCounts; }
 
 public:
@@ -0,0 +1,429 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "util/FastIO.h"
+#include "util/BitOps.h"
+#include "TrieNgramLM.h"
+
+using std::pair;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void
+PackedVector::Reset(size_t length, size_t bits) {
+    assert(bits > 0 && bits < 64);
+    _length = length;
+    _bits   = bits;
+    _mask   = ((uint64_t)1 << bits) - 1;
+    _data.reset((length * bits + 63) / 64, 0);
+}
+
+void
+PackedVector::Set(size_t i, uint64_t value) {
+    assert(i < _length && value <= _mask);
+    size_t bit  = i * _bits;
+    size_t word = bit >> 6;
+    size_t off  = bit & 63;
+    _data[word] = (_data[word] & ~(_mask << off)) | (value << off);
+    if (off + _bits > 64) {
+        size_t shift = 64 - off;
+        _data[word + 1] = (_data[word + 1] & ~(_mask >> shift)) |
+                          (value >> shift);
+    }
+}
+
+void
+PackedVector::Serialize(FILE *outFile) const {
+    WriteUInt64(outFile, _length);
+    WriteUInt64(outFile, _bits);
+    WriteVector(outFile, _data);
+}
+
+void
+PackedVector::Deserialize(FILE *inFile) {
+    _length = ReadUInt64(inFile);
+    _bits   = ReadUInt64(inFile);
+    if (_bits == 0 || _bits >= 64)
+        throw std::runtime_error("Invalid file format.");
+    _mask   = ((uint64_t)1 << _bits) - 1;
+    ReadVector(inFile, _data);
+    if (_data.length() != (_length * _bits + 63) / 64)
+        throw std::runtime_error("Invalid file format.");
+}
+
+void
+PackedVector::DeserializeMapped(MappedFile &inFile) {
+    _length = inFile.ReadUInt64();
+    _bits   = inFile.ReadUInt64();
+    if (_bits == 0 || _bits >= 64)
+        throw std::runtime_error("Invalid file format.");
+    _mask   = ((uint64_t)1 << _bits) - 1;
+    MapVector(inFile, _data);
+    if (_data.length() != (_length * _bits + 63) / 64)
+        throw std::runtime_error("Invalid file format.");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const NgramIndex TrieNgramLM::Invalid = (NgramIndex)-1;
+
+// Build the trie from lm, quantizing log probabilities and backoff weights of
+// each order to at most the given number of bits.
+void
+TrieNgramLM::Build(const NgramLMBase &lm, size_t bits) {
+    if (bits < 1 || bits > 16)
+        throw std::invalid_argument("Quantization bits must be 1 to 16.");
+    _mappedFile = NULL;
+    _order = lm.order();
+    _bits  = bits;
+    _wordVectors.resize(_order + 1);
+    _childStarts.resize(_order + 1);
+    _probCodes.resize(_order + 1);
+    _bowCodes.resize(_order + 1);
+    _probCodebooks.resize(_order + 1);
+    _bowCodebooks.resize(_order + 1);
+
+    VocabIndex maxWord = 0;
+    for (size_t o = 1; o <= _order; ++o)
+        if (lm.sizes(o) > 0)
+            maxWord = std::max(maxWord, max(lm.words(o)));
+    size_t wordBits = std::max(1UL, __fls(maxWord));
+
+    // Order each n-gram by the trie position of its history, then its word.
+    // ngramOrder maps trie position to n-gram index; positions the reverse.
+    vector<IndexVector> ngramOrders(_order + 1);
+    vector<IndexVector> positions(_order + 1);
+    vector<BitVector>   hasChildren(_order + 1);
+    ngramOrders[0].reset(1, 0);
+    positions[0].reset(1, 0);
+    _wordVectors[0].Reset(1, 1);
+    for (size_t o = 1; o <= _order; ++o) {
+        const VocabVector &words(lm.words(o));
+        const IndexVector &hists(lm.hists(o));
+        const IndexVector &histPositions(positions[o - 1]);
+        size_t numNgrams = lm.sizes(o);
+
+        vector<pair<uint64_t, NgramIndex> > keys(numNgrams);
+        for (size_t i = 0; i < numNgrams; ++i)
+            keys[i] = pair<uint64_t, NgramIndex>(
+                ((uint64_t)histPositions[hists[i]] << 32) | (uint)words[i],
+                (NgramIndex)i);
+        std::sort(keys.begin(), keys.end());
+
+        IndexVector &ngramOrder(ngramOrders[o]);
+        ngramOrder.reset(numNgrams);
+        positions[o].reset(numNgrams);
+        _wordVectors[o].Reset(numNgrams, wordBits);
+        for (size_t p = 0; p < numNgrams; ++p) {
+            ngramOrder[p] = keys[p].second;
+            positions[o][keys[p].second] = p;
+            _wordVectors[o].Set(p, words[keys[p].second]);
+        }
+
+        // Children of each history start where the previous history's end.
+        size_t      numHists = lm.sizes(o - 1);
+        IndexVector starts(numHists + 1, 0);
+        for (size_t p = 0; p < numNgrams; ++p)
+            ++starts[histPositions[hists[ngramOrder[p]]] + 1];
+        for (size_t h = 0; h < numHists; ++h)
+            starts[h + 1] += starts[h];
+        _childStarts[o - 1].Reset(numHists + 1,
+                                  std::max(1UL, __fls(numNgrams)));
+        hasChildren[o - 1].reset(numHists);
+        for (size_t h = 0; h < numHists; ++h)
+            hasChildren[o - 1][h] = (starts[h + 1] > starts[h]);
+        for (size_t h = 0; h <= numHists; ++h)
+            _childStarts[o - 1].Set(h, starts[h]);
+    }
+    _childStarts[_order] = PackedVector();
+
+    // Only the backoff weights of n-grams with children are ever used.
+    for (size_t o = 0; o <= _order; ++o) {
+        _Quantize(lm.probs(o), ngramOrders[o], bits,
+                  _probCodes[o], _probCodebooks[o]);
+        if (o < _order)
+            _Quantize(lm.bows(o), ngramOrders[o], bits,
+                      _bowCodes[o], _bowCodebooks[o], &hasChildren[o]);
+        else {
+            _bowCodes[o] = PackedVector();
+            _bowCodebooks[o].reset(0);
+        }
+    }
+
+    // Unigrams usually cover the whole vocab, so a word is its own position.
+    _denseUnigrams = true;
+    for (size_t p = 0; p < sizes(1) && _denseUnigrams; ++p)
+        _denseUnigrams = (_wordVectors[1][p] == p);
+}
+
+// Return the natural log probability of words[numWords-1] given the words
+// before it, backing off to shorter histories as the LM it was built from.
+LProb
+TrieNgramLM::LogProb(const VocabIndex *words, size_t numWords) const {
+    assert(numWords > 0);
+    if (numWords > _order) {
+        words   += numWords - _order;
+        numWords = _order;
+    }
+    VocabIndex target = words[numWords - 1];
+    LProb      logBows = 0;
+    for (size_t i = 0; i < numWords; ++i) {
+        size_t     histOrder = numWords - 1 - i;
+        NgramIndex hist = Find(words + i, histOrder);
+        if (hist == Invalid)
+            continue;
+        NgramIndex index = _FindChild(histOrder, hist, target);
+        if (index != Invalid)
+            return logBows + logProb(histOrder + 1, index);
+        logBows += logBow(histOrder, hist);
+    }
+    return logBows + logProb(0, 0);
+}
+
+// Return the trie position of the n-gram in the order numWords, or Invalid.
+NgramIndex
+TrieNgramLM::Find(const VocabIndex *words, size_t numWords) const {
+    NgramIndex index = 0;
+    for (size_t o = 0; o < numWords && index != Invalid; ++o)
+        index = _FindChild(o, index, words[o]);
+    return index;
+}
+
+void
+TrieNgramLM::Serialize(FILE *outFile) const {
+    WriteHeader(outFile, "TrieNgramLM");
+    WriteUInt64(outFile, _order);
+    WriteUInt64(outFile, _bits);
+    WriteUInt64(outFile, _denseUnigrams);
+    for (size_t o = 0; o <= _order; ++o) {
+        _wordVectors[o].Serialize(outFile);
+        _probCodes[o].Serialize(outFile);
+        WriteVector(outFile, _probCodebooks[o]);
+    }
+    for (size_t o = 0; o < _order; ++o) {
+        _childStarts[o].Serialize(outFile);
+        _bowCodes[o].Serialize(outFile);
+        WriteVector(outFile, _bowCodebooks[o]);
+    }
+}
+
+void
+TrieNgramLM::Deserialize(FILE *inFile) {
+    VerifyHeader(inFile, "TrieNgramLM");
+    _mappedFile    = NULL;
+    _order         = ReadUInt64(inFile);
+    _bits          = ReadUInt64(inFile);
+    _denseUnigrams = ReadUInt64(inFile);
+    _wordVectors.assign(_order + 1, PackedVector());
+    _childStarts.assign(_order + 1, PackedVector());
+    _probCodes.assign(_order + 1, PackedVector());
+    _bowCodes.assign(_order + 1, PackedVector());
+    _probCodebooks.assign(_order + 1, FloatVector());
+    _bowCodebooks.assign(_order + 1, FloatVector());
+    for (size_t o = 0; o <= _order; ++o) {
+        _wordVectors[o].Deserialize(inFile);
+        _probCodes[o].Deserialize(inFile);
+        ReadVector(inFile, _probCodebooks[o]);
+    }
+    for (size_t o = 0; o < _order; ++o) {
+        _childStarts[o].Deserialize(inFile);
+        _bowCodes[o].Deserialize(inFile);
+        ReadVector(inFile, _bowCodebooks[o]);
+    }
+}
+
+// Load the LM as views into inFile, which is kept open for their lifetime.
+void
+TrieNgramLM::DeserializeMapped(const SharedPtr<MappedFile> &inFile) {
+    _mappedFile = inFile;
+    MappedFile &in(*_mappedFile);
+    in.VerifyHeader("TrieNgramLM");
+    _order         = in.ReadUInt64();
+    _bits          = in.ReadUInt64();
+    _denseUnigrams = in.ReadUInt64();
+    _wordVectors.assign(_order + 1, PackedVector());
+    _childStarts.assign(_order + 1, PackedVector());
+    _probCodes.assign(_order + 1, PackedVector());
+    _bowCodes.assign(_order + 1, PackedVector());
+    _probCodebooks.assign(_order + 1, FloatVector());
+    _bowCodebooks.assign(_order + 1, FloatVector());
+    for (size_t o = 0; o <= _order; ++o) {
+        _wordVectors[o].DeserializeMapped(in);
+        _probCodes[o].DeserializeMapped(in);
+        MapVector(in, _probCodebooks[o]);
+    }
+    for (size_t o = 0; o < _order; ++o) {
+        _childStarts[o].DeserializeMapped(in);
+        _bowCodes[o].DeserializeMapped(in);
+        MapVector(in, _bowCodebooks[o]);
+    }
+}
+
+// Return the bytes taken by the n-gram data, excluding the vocab.
+size_t
+TrieNgramLM::MemoryUsage() const {
+    size_t bytes = 0;
+    for (size_t o = 0; o <= _order; ++o) {
+        bytes += _wordVectors[o].bytes() + _childStarts[o].bytes();
+        bytes += _probCodes[o].bytes() + _bowCodes[o].bytes();
+        bytes += (_probCodebooks[o].length() + _bowCodebooks[o].length()) *
+                 sizeof(float);
+    }
+    return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Return the trie position of the child of hist in order o with the given
+// word, or Invalid.
+NgramIndex
+TrieNgramLM::_FindChild(size_t o, NgramIndex hist, VocabIndex word) const {
+    if (word < 0)
+        return Invalid;
+    size_t lo = _childStarts[o][hist];
+    size_t hi = _childStarts[o][hist + 1];
+    if (o == 0 && _denseUnigrams)
+        return (size_t)word < hi ? word : Invalid;
+    const PackedVector &words(_wordVectors[o + 1]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (words[mid] < (uint64_t)word)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < _childStarts[o][hist + 1] && words[lo] == (uint64_t)word) ?
+        (NgramIndex)lo : Invalid;
+}
+
+// Quantize the log of values into codes, stored in the trie order given by
+// ngramOrder.  Sorted values are split into bins of equal population, which
+// are then refined by Lloyd's algorithm so that outliers, such as the log
+// probability of <s>, do not skew a whole bin.  Zero values keep a code of
+// their own, and orders with few distinct values are represented exactly.  If mask is given, only
+// the values it selects shape the bins, but all values are encoded.
+void
+TrieNgramLM::_Quantize(const ProbVector &values, const IndexVector &ngramOrder,
+                       size_t bits, PackedVector &codes, FloatVector &codebook,
+                       const BitVector *mask) {
+    size_t        numValues = ngramOrder.length();
+    vector<float> logValues(numValues);
+    vector<float> sorted;
+    for (size_t p = 0; p < numValues; ++p) {
+        logValues[p] = log(values[ngramOrder[p]]);
+        if (mask == NULL || (*mask)[p])
+            sorted.push_back(logValues[p]);
+    }
+    if (sorted.empty())
+        sorted.push_back(0);
+    std::sort(sorted.begin(), sorted.end());
+    size_t numSorted = sorted.size();
+    size_t numZero = 0;
+    while (numZero < numSorted && std::isinf(sorted[numZero]))
+        ++numZero;
+    size_t numCodes = ((size_t)1 << bits) - (numZero > 0);
+
+    vector<float> centers;
+    if (numZero > 0)
+        centers.push_back(sorted[0]);
+    size_t numFinite = numSorted - numZero;
+    size_t numDistinct = 0;
+    for (size_t i = numZero; i < numSorted && numDistinct <= numCodes; ++i)
+        if (i == numZero || sorted[i] != sorted[i - 1])
+            ++numDistinct;
+    size_t end = numZero;
+    for (size_t c = 0; c < numCodes && numFinite > 0; ++c) {
+        size_t begin;
+        if (numDistinct <= numCodes) {
+            // Each distinct value is its own bin.
+            begin = end;
+            while (end < numSorted && sorted[end] == sorted[begin])
+                ++end;
+        } else {
+            begin = numZero + numFinite * c / numCodes;
+            end   = numZero + numFinite * (c + 1) / numCodes;
+        }
+        if (end == begin)
+            continue;
+        double total = 0;
+        for (size_t i = begin; i < end; ++i)
+            total += sorted[i];
+        centers.push_back((float)(total / (end - begin)));
+    }
+
+    // Move each center to the mean of the values nearest it until stable.
+    size_t first = (numZero > 0);
+    for (size_t iter = 0; iter < MaxLloydIters &&
+                          numDistinct > numCodes; ++iter) {
+        bool   changed = false;
+        size_t c = first;
+        for (size_t i = numZero; i < numSorted;) {
+            while (c + 1 < centers.size() &&
+                   sorted[i] - centers[c] > centers[c + 1] - sorted[i])
+                ++c;
+            double total = 0;
+            size_t count = 0;
+            for (; i < numSorted && (c + 1 == centers.size() ||
+                   sorted[i] - centers[c] <= centers[c + 1] - sorted[i]); ++i) {
+                total += sorted[i];
+                ++count;
+            }
+            float center = (float)(total / count);
+            changed = changed || (center != centers[c]);
+            centers[c++] = center;
+        }
+        if (!changed)
+            break;
+    }
+    std::sort(centers.begin(), centers.end());
+    codebook.reset(centers.size());
+    std::copy(centers.begin(), centers.end(), codebook.begin());
+
+    // Encode each value as its nearest center, zeros included.
+    codes.Reset(numValues, std::max(1UL, __fls(centers.size() - 1)));
+    for (size_t p = 0; p < numValues; ++p) {
+        float  v = logValues[p];
+        size_t c = std::lower_bound(centers.begin(), centers.end(), v) -
+                   centers.begin();
+        if (c == centers.size() ||
+            (c > 0 && v - centers[c - 1] < centers[c] - v))
+            --c;
+        codes.Set(p, c);
+    }
+}
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TRIENGRAMLM_H
+#define TRIENGRAMLM_H
+
+#include <vector>
+#include <stdint.h>
+#include "util/SharedPtr.h"
+#include "util/MappedFile.h"
+#include "Types.h"
+#include "NgramLM.h"
+
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// PackedVector stores unsigned integers of a fixed bit width back to back in
+// 64-bit words.  An element may straddle two words.
+//
+class PackedVector {
+protected:
+    DenseVector<uint64_t> _data;
+    size_t                _length;
+    size_t                _bits;
+    uint64_t              _mask;
+
+public:
+    PackedVector() : _length(0), _bits(0), _mask(0) { }
+    void   Reset(size_t length, size_t bits);
+    void   Set(size_t i, uint64_t value);
+    void   Serialize(FILE *outFile) const;
+    void   Deserialize(FILE *inFile);
+    void   DeserializeMapped(MappedFile &inFile);
+
+    size_t length() const { return _length; }
+    size_t bits() const   { return _bits; }
+    size_t bytes() const  { return _data.length() * sizeof(uint64_t); }
+
+    uint64_t operator[](size_t i) const {
+        size_t   bit  = i * _bits;
+        size_t   word = bit >> 6;
+        size_t   off  = bit & 63;
+        uint64_t v    = _data[word] >> off;
+        if (off + _bits > 64)
+            v |= _data[word + 1] << (64 - off);
+        return v & _mask;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// TrieNgramLM is a compact, read-only copy of a trained n-gram LM for use on
+// devices with little memory.  Each order is sorted by history and then word,
+// so the children of an n-gram form a contiguous range of the next order that
+// is found by binary search on the word.  Words and child offsets are packed
+// into as few bits as their largest value needs, and log probabilities and
+// backoff weights are quantized to 8 or 16 bits using a codebook per order.
+// Word indices are those of the vocab of the LM it was built from.
+//
+class TrieNgramLM {
+protected:
+    SharedPtr<MappedFile> _mappedFile;  // Declared first to outlive its views
+    size_t               _order;
+    size_t               _bits;
+    bool                 _denseUnigrams;
+    vector<PackedVector> _wordVectors;
+    vector<PackedVector> _childStarts;
+    vector<PackedVector> _probCodes;
+    vector<PackedVector> _bowCodes;
+    vector<FloatVector>  _probCodebooks;
+    vector<FloatVector>  _bowCodebooks;
+
+public:
+    static const NgramIndex Invalid; // = (NgramIndex)-1;
+    static const size_t     MaxLloydIters = 32;
+
+    TrieNgramLM() : _order(0), _bits(0), _denseUnigrams(false) { }
+    void   Build(const NgramLMBase &lm, size_t bits = 8);
+    LProb  LogProb(const VocabIndex *words, size_t numWords) const;
+    NgramIndex Find(const VocabIndex *words, size_t numWords) const;
+    void   Serialize(FILE *outFile) const;
+    void   Deserialize(FILE *inFile);
+    void   DeserializeMapped(const SharedPtr<MappedFile> &inFile);
+    size_t MemoryUsage() const;
+
+    size_t order() const         { return _order; }
+    size_t bits() const          { return _bits; }
+    size_t sizes(size_t o) const { return _wordVectors[o].length(); }
+    LProb  logProb(size_t o, NgramIndex i) const
+    { return _probCodebooks[o][_probCodes[o][i]]; }
+    LProb  logBow(size_t o, NgramIndex i) const
+    { return _bowCodebooks[o][_bowCodes[o][i]]; }
+
+protected:
+    NgramIndex _FindChild(size_t o, NgramIndex hist, VocabIndex word) const;
+    static void _Quantize(const ProbVector &values,
+                          const IndexVector &ngramOrder, size_t bits,
+                          PackedVector &codes, FloatVector &codebook,
+                          const BitVector *mask = NULL);
+};
+
+#endif // TRIENGRAMLM_H
@@ -126,28 +126,21 @@ Vocab::Reserve(size_t capacity) {
 // Sort the vocabulary and output the mapping from original to new index.
 bool
 Vocab::Sort(VocabVector &sortMap) {
-    // Sort indices using vocab index comparison function.
-    // - Skip the first two words: </s> (and optionally <unk>).
-    int               numFixedWords = (_unkIndex == Invalid) ? 1 : 2;
-    VocabIndexCompare compare(*this);
-    VocabVector       sortIndices = Range(size());
-    if (!sortIndices[Range(numFixedWords, size())].sort(compare)) {
-        sortMap = Range(size());
+    if (!GetSortMap(sortMap))
         return false;
-    }
+    VocabVector sortIndices(size());
+    for (VocabIndex i = 0; i < (VocabIndex)size(); ++i)
+        sortIndices[sortMap[i]] = i;
 
     // Build new string buffer for the sorted words.
     // Change offsets to refer to new string buffer.
-    // Build sort mapping that maps old to new indices.
     std::string     newBuffer;
     OffsetLenVector newOffsetLens(size());
     newBuffer.reserve(_buffer.size());
-    sortMap.reset(size());
     for (VocabIndex i = 0; i < (VocabIndex)size(); ++i) {
         const OffsetLen &offsetLen = _offsetLens[sortIndices[i]];
         newOffsetLens[i] = OffsetLen(newBuffer.length(), offsetLen.Len);
         newBuffer.append(&_buffer[offsetLen.Offset], offsetLen.Len + 1);
-        sortMap[sortIndices[i]] = i;
     }
     _buffer.swap(newBuffer);
     _offsetLens.swap(newOffsetLens);
@@ -158,6 +151,25 @@ Vocab::Sort(VocabVector &sortMap) {
     return true;
 }
 
+// Build the mapping from old to new indices that Sort() would apply, without
+// sorting.  Return false if the words are already sorted.
+bool
+Vocab::GetSortMap(VocabVector &sortMap) const {
+    // Sort indices using vocab index comparison function.
+    // - Skip the first two words: </s> (and optionally <unk>).
+    int               numFixedWords = (_unkIndex == Invalid) ? 1 : 2;
+    VocabIndexCompare compare(*this);
+    VocabVector       sortIndices = Range(size());
+    if (!sortIndices[Range(numFixedWords, size())].sort(compare)) {
+        sortMap = Range(size());
+        return false;
+    }
+    sortMap.reset(size());
+    for (VocabIndex i = 0; i < (VocabIndex)size(); ++i)
+        sortMap[sortIndices[i]] = i;
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Loads vocabulary from file where each word appears on a non-# line.
@@ -223,6 +235,28 @@ Vocab::Deserialize(FILE *inFile) {
     _Reindex(nextPowerOf2(_length + _length/4));
 }
 
+// Unlike Serialize(), also store the offsets and index table, so that
+// DeserializeMapped() can use them in place rather than rebuild them.
+void
+Vocab::SerializeMapped(FILE *outFile) const {
+    WriteHeader(outFile, "Vocab");
+    WriteString(outFile, _buffer);
+    WriteVector(outFile, _offsetLens[Range(_length)]);
+    WriteVector(outFile, _indices);
+}
+
+void
+Vocab::DeserializeMapped(MappedFile &inFile) {
+    inFile.VerifyHeader("Vocab");
+    inFile.ReadString(_buffer);
+    MapVector(inFile, _offsetLens);
+    MapVector(inFile, _indices);
+    _length   = _offsetLens.length();
+    _hashMask = _indices.length() - 1;
+    if (_indices.length() <= _length || !isPowerOf2(_indices.length()))
+        throw std::runtime_error("Invalid file format.");
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Return the iterator to the position of the word.
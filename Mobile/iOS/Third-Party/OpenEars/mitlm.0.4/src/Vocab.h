@@ -80,10 +80,13 @@ public:
     VocabIndex Add(const char *word) { return Add(word, strlen(word)); }
     void       Reserve(size_t capacity);
     bool       Sort(VocabVector &sortMap);
+    bool       GetSortMap(VocabVector &sortMap) const;
     void       LoadVocab(ZFile &vocabFile);
     void       SaveVocab(ZFile &vocabFile, bool asBinary=false) const;
     void       Serialize(FILE *outFile) const;
     void       Deserialize(FILE *inFile);
+    void       SerializeMapped(FILE *outFile) const;
+    void       DeserializeMapped(MappedFile &inFile);
 
     bool        IsFixedVocab() const        { return _fixedVocab; }
     size_t      size() const                { return _length; }
@@ -39,18 +39,14 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
-WordErrorRateOptimizer::~WordErrorRateOptimizer() {
-    for (size_t l = 0; l < _lattices.size(); ++l)
-        delete _lattices[l];
-}
-
 void
 WordErrorRateOptimizer::LoadLattices(ZFile &latticesFile) {
     if (ReadUInt64(latticesFile) == MITLMv1) {
-        _lattices.resize(ReadUInt64(latticesFile));
-        for (size_t l = 0; l < _lattices.size(); ++l) {
-            _lattices[l] = new Lattice(_lm);
-            _lattices[l]->Deserialize(latticesFile);
+        size_t numLattices = ReadUInt64(latticesFile);
+        for (size_t l = 0; l < numLattices; ++l) {
+            Lattice *pLattice = new Lattice(_lm);
+            _lattices.Add(pLattice);
+            pLattice->Deserialize(latticesFile);
         }
     } else {
         latticesFile.ReOpen();
@@ -68,30 +64,18 @@ WordErrorRateOptimizer::LoadLattices(ZFile &latticesFile) {
             ZFile zfile(file, "r");
             Logger::Log(2, "Loading lattice %s...\n", line);
             Lattice *pLattice = new Lattice(_lm);
+            _lattices.Add(pLattice);
             pLattice->SetTag(line);
             pLattice->LoadLattice(zfile);
             pLattice->SetReferenceText(trans);
-            _lattices.push_back(pLattice);
         }
     }
+    _lattices.Compile();
 
     // Compute prob/bow masks.
-    vector<BitVector> probMaskVectors(_order + 1);
-    vector<BitVector> bowMaskVectors(_order);
-    for (size_t o = 0; o <= _order; o++)
-        probMaskVectors[o].reset(_lm.sizes(o), false);
-    for (size_t o = 0; o < _order; o++)
-        bowMaskVectors[o].reset(_lm.sizes(o), false);
-    for (size_t l = 0; l < _lattices.size(); ++l) {
-        const Lattice::ArcNgramIndexVector &arcProbs(_lattices[l]->_arcProbs);
-        for (size_t i = 0; i < arcProbs.length(); ++i)
-            probMaskVectors[arcProbs[i].order][arcProbs[i].ngramIndex] = true;
-
-        const Lattice::ArcNgramIndexVector &arcBows(_lattices[l]->_arcBows);
-        for (size_t i = 0; i < arcBows.length(); ++i) {
-            bowMaskVectors[arcBows[i].order][arcBows[i].ngramIndex] = true;
-        }
-    }
+    vector<BitVector> probMaskVectors;
+    vector<BitVector> bowMaskVectors;
+    _lattices.GetMasks(probMaskVectors, bowMaskVectors);
     _mask = _lm.GetMask(probMaskVectors, bowMaskVectors);
 }
 
@@ -100,7 +84,7 @@ WordErrorRateOptimizer::SaveLattices(ZFile &latticesFile) {
     WriteUInt64(latticesFile, MITLMv1);
     WriteUInt64(latticesFile, _lattices.size());
     for (size_t l = 0; l < _lattices.size(); ++l)
-        _lattices[l]->Serialize(latticesFile);
+        _lattices[l].Serialize(latticesFile);
 }
 
 void
@@ -108,15 +92,15 @@ WordErrorRateOptimizer::SaveTranscript(ZFile &transcriptFile) {
     string             line;
     vector<VocabIndex> bestPath;
     for (size_t l = 0; l < _lattices.size(); ++l) {
-        const Lattice *lattice = _lattices[l];
-        lattice->GetBestPath(bestPath);
+        const Lattice &lattice = _lattices[l];
+        lattice.GetBestPath(bestPath);
 
         line = "";
         for (size_t i = 0; i < bestPath.size(); ++i) {
             line += _lm.vocab()[bestPath[i]];
             line += " ";
         }
-        line += string("(") + lattice->tag() + ")";
+        line += string("(") + lattice.tag() + ")";
 
         fwrite(line.c_str(), sizeof(char), line.length(), transcriptFile);
         fputc('\n', transcriptFile);
@@ -126,19 +110,19 @@ WordErrorRateOptimizer::SaveTranscript(ZFile &transcriptFile) {
 void
 WordErrorRateOptimizer::SaveUttConfidence(ZFile &confidenceFile) {
     for (size_t l = 0; l < _lattices.size(); ++l) {
-        Lattice *lattice = _lattices[l];
+        const Lattice &lattice = _lattices[l];
         fprintf(confidenceFile, "%s\t%f\n",
-                lattice->tag(), lattice->BuildConfusionNetwork());
+                lattice.tag(), lattice.BuildConfusionNetwork());
     }
 }
 
 void
 WordErrorRateOptimizer::SaveWER(ZFile &werFile) {
     for (size_t l = 0; l < _lattices.size(); ++l) {
-        Lattice *lattice = _lattices[l];
-        fprintf(werFile, "%s\t%lu\t%i\n", lattice->tag(),
-                (unsigned long)lattice->refWords().length(),
-                lattice->ComputeWER());
+        const Lattice &lattice = _lattices[l];
+        fprintf(werFile, "%s\t%lu\t%i\n", lattice.tag(),
+                (unsigned long)lattice.refWords().length(),
+                lattice.ComputeWER());
     }
 }
 
@@ -148,20 +132,23 @@ WordErrorRateOptimizer::ComputeWER(const ParamVector &params) {
     if (!_lm.Estimate(params, _mask))
         return 100;  // Out of bounds.
 
+    IntVector wers;
+    _lattices.UpdateWeights();
+    _lattices.ComputeWER(wers);
+
     size_t numErrors = 0;
     size_t totWords  = 0;
     for (size_t l = 0; l < _lattices.size(); ++l) {
-        _lattices[l]->UpdateWeights();
-        int wer = _lattices[l]->ComputeWER();
+        int wer = wers[l];
         if (Logger::GetVerbosity() > 2) {
             Logger::Log(3, "Lattice %lu: (%lu / %lu)\n", 
-                        l, wer, _lattices[l]->refWords().length());
-            for (size_t i = 0; i < _lattices[l]->refWords().length(); ++i)
-                Logger::Log(3, "%s ", _lm.vocab()[_lattices[l]->refWords()[i]]);
+                        l, wer, _lattices[l].refWords().length());
+            for (size_t i = 0; i < _lattices[l].refWords().length(); ++i)
+                Logger::Log(3, "%s ", _lm.vocab()[_lattices[l].refWords()[i]]);
             Logger::Log(3, "\n");
         }
         numErrors += wer;
-        totWords  += _lattices[l]->refWords().length();
+        totWords  += _lattices[l].refWords().length();
     }
     double wer = (double)numErrors / totWords * 100;
     if (Logger::GetVerbosity() > 2) {
@@ -177,8 +164,8 @@ WordErrorRateOptimizer::ComputeOracleWER() const {
     size_t numErrors = 0;
     size_t totWords  = 0;
     for (size_t l = 0; l < _lattices.size(); ++l) {
-        numErrors += _lattices[l]->oracleWER();
-        totWords  += _lattices[l]->refWords().length();
+        numErrors += _lattices[l].oracleWER();
+        totWords  += _lattices[l].refWords().length();
     }
     return (double)numErrors / totWords * 100;
 }
@@ -189,11 +176,13 @@ WordErrorRateOptimizer::ComputeMargin(const ParamVector &params) {
     if (!_lm.Estimate(params, _mask))
         return _worstMargin - 10;  // Out of bounds.
 
+    FloatVector margins;
+    _lattices.UpdateWeights();
+    _lattices.ComputeMargin(margins);
+
     double totMargin = 0;
-    for (size_t l = 0; l < _lattices.size(); ++l) {
-        _lattices[l]->UpdateWeights();
-        totMargin += _lattices[l]->ComputeMargin();
-    }
+    for (size_t l = 0; l < _lattices.size(); ++l)
+        totMargin += margins[l];
 
     totMargin /= _lattices.size();
     if (Logger::GetVerbosity() > 2)
@@ -217,12 +206,12 @@ WordErrorRateOptimizer::OptimizeMargin(ParamVector &params,
     case PowellOptimization:
         minMargin = -MinimizePowell(func, params, numIter);
         break;
-//    case LBFGSOptimization: /**Removed for OpenEars -- HLW*/
-//        minMargin = -MinimizeLBFGS(func, params, numIter);/**Removed for OpenEars -- HLW*/
-//        break;/**Removed for OpenEars -- HLW*/
-//    case LBFGSBOptimization:/**Removed for OpenEars -- HLW*/
-//        minMargin = -MinimizeLBFGSB(func, params, numIter);/**Removed for OpenEars -- HLW*/
-//        break;/**Removed for OpenEars -- HLW*/
+    case LBFGSOptimization:
+        minMargin = -MinimizeLBFGS(func, params, numIter);
+        break;
+    case LBFGSBOptimization:
+        minMargin = -MinimizeLBFGSB(func, params, numIter);
+        break;
     default:
         throw std::runtime_error("Unsupported optimization technique.");
     }
@@ -252,12 +241,12 @@ WordErrorRateOptimizer::OptimizeWER(ParamVector &params,
     case PowellOptimization:
         minWER = MinimizePowell(func, params, numIter);
         break;
-//    case LBFGSOptimization:/**Removed for OpenEars -- HLW*/
-//        minWER = MinimizeLBFGS(func, params, numIter);/**Removed for OpenEars -- HLW*/
-//        break;/**Removed for OpenEars -- HLW*/
-//    case LBFGSBOptimization:/**Removed for OpenEars -- HLW*/
-//        minWER = MinimizeLBFGSB(func, params, numIter);/**Removed for OpenEars -- HLW*/
-//        break;/**Removed for OpenEars -- HLW*/
+    case LBFGSOptimization:
+        minWER = MinimizeLBFGS(func, params, numIter);
+        break;
+    case LBFGSBOptimization:
+        minWER = MinimizeLBFGSB(func, params, numIter);
+        break;
     default:
         throw std::runtime_error("Unsupported optimization technique.");
     }
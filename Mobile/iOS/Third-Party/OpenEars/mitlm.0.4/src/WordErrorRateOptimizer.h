@@ -41,6 +41,7 @@
 #include "NgramLM.h"
 #include "Mask.h"
 #include "Lattice.h"
+#include "LatticeBatch.h"
 
 using std::vector;
 
@@ -50,7 +51,7 @@ class WordErrorRateOptimizer {
 protected:
     NgramLMBase &       _lm;
     size_t              _order;
-    vector<Lattice *>   _lattices;
+    LatticeBatch        _lattices;
     size_t              _numCalls;
     double              _worstMargin;
     SharedPtr<Mask>     _mask;
@@ -61,6 +62,8 @@ protected:
         ComputeMarginFunc(WordErrorRateOptimizer &obj) : _obj(obj) { }
         double operator()(const ParamVector &params)
         { _obj._numCalls++; return -_obj.ComputeMargin(params); }
+        bool Gradient(const ParamVector &params, ParamVector &gradient)
+        { return false; }  // Approximate by differences.
     };
 
     class ComputeWERFunc {
@@ -69,12 +72,13 @@ protected:
         ComputeWERFunc(WordErrorRateOptimizer &obj) : _obj(obj) { }
         double operator()(const ParamVector &params)
         { _obj._numCalls++; return _obj.ComputeWER(params); }
+        bool Gradient(const ParamVector &params, ParamVector &gradient)
+        { return false; }  // Approximate by differences.
     };
 
 public:
     WordErrorRateOptimizer(NgramLMBase &lm, size_t order=3)
-        : _lm(lm), _order(order), _worstMargin(-100) { }
-    ~WordErrorRateOptimizer();
+        : _lm(lm), _order(order), _lattices(lm), _worstMargin(-100) { }
 
     void   SetOrder(size_t order) { _order = order; }
     void   LoadLattices(ZFile &latticesFile);
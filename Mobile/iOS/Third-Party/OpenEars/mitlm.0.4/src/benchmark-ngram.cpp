@@ -0,0 +1,398 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+#include <sys/time.h>
+#include <vector>
+#include "util/CommandOptions.h"
+#include "util/Logger.h"
+#include "util/ZFile.h"
+#include "Types.h"
+#include "NgramVector.h"
+#include "NgramLM.h"
+#include "TrieNgramLM.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char *headerDesc_benchmark_ngram =
+"Usage: benchmark-ngram [Options]\n"
+"\n"
+"Measures the throughput of adding and finding random n-grams in the\n"
+"NgramVector hash table that backs each order of an n-gram model.  With -lm,\n"
+"also compares the memory and lookup speed of the LM against a TrieNgramLM\n"
+"built from it.  With -k, also compares the vector kernels that\n"
+"InterpolatedNgramLM uses evaluated element by element, as generic vector\n"
+"expressions are, against the SIMD kernels of DenseVector<double>.\n";
+
+const char *footerDesc_benchmark_ngram =
+"---------------------------------------------------------------\n"
+"| MIT Language Modeling Toolkit (v0.4)                        |\n"
+"| Copyright (C) 2009 Bo-June (Paul) Hsu                       |\n"
+"| MIT Computer Science and Artificial Intelligence Laboratory |\n"
+"---------------------------------------------------------------\n";
+
+////////////////////////////////////////////////////////////////////////////////
+
+static double
+WallTime() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void
+LogRate(const char *name, size_t n, double start) {
+    double elapsed = WallTime() - start;
+    Logger::Log(0, "\t%-12s\t%8.3f s\t%8.2f M/s\n",
+                name, elapsed, n / elapsed * 1e-6);
+}
+
+// Fill hists and words with n-grams as a corpus would produce them: histories
+// spread over a quarter as many lower order n-grams and a large vocabulary.
+static void
+RandomNgrams(size_t n, size_t vocabSize, uint32_t seed,
+             IndexVector &hists, VocabVector &words) {
+    hists.reset(n);
+    words.reset(n);
+    uint32_t x = seed | 1;
+    for (size_t i = 0; i < n; ++i) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        hists[i] = x % std::max((size_t)1, n / 4);
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        words[i] = x % vocabSize;
+    }
+}
+
+// Return the natural log probability of words[numWords-1] as looked up in the
+// NgramVector of each order, backing off as TrieNgramLM::LogProb() does.
+static double
+BackoffLogProb(const NgramLMBase &lm, const VocabIndex *words,
+               size_t numWords) {
+    const NgramModel &model(lm.model());
+    double logBows = 0;
+    for (size_t i = 0; i < numWords; ++i) {
+        size_t     histOrder = numWords - 1 - i;
+        NgramIndex hist = 0;
+        for (size_t o = 0; o < histOrder && hist != NgramVector::Invalid; ++o)
+            hist = model.vectors(o + 1).Find(hist, words[i + o]);
+        if (hist == NgramVector::Invalid)
+            continue;
+        NgramIndex index = model.vectors(histOrder + 1).Find(
+            hist, words[numWords - 1]);
+        if (index != NgramVector::Invalid)
+            return logBows + log(lm.probs(histOrder + 1)[index]);
+        logBows += log(lm.bows(histOrder)[hist]);
+    }
+    return logBows + log(lm.probs(0)[0]);
+}
+
+// Return the bytes taken by the n-gram data of lm, excluding the vocab.
+static size_t
+NgramLMBytes(const NgramLMBase &lm) {
+    size_t bytes = 0;
+    for (size_t o = 0; o <= lm.order(); ++o) {
+        bytes += lm.model().vectors(o).capacity() * sizeof(NgramSlot);
+        bytes += lm.sizes(o) * (sizeof(VocabIndex) + sizeof(NgramIndex));
+        bytes += lm.backoffs(o).length() * sizeof(NgramIndex);
+        bytes += lm.probs(o).length() * sizeof(Prob);
+        if (o < lm.order())
+            bytes += lm.bows(o).length() * sizeof(Prob);
+    }
+    return bytes;
+}
+
+// Fill queries with numQueries histories and target words of the top order:
+// half are n-grams of the LM, half have a random target word and mostly back
+// off.
+static void
+RandomQueries(const NgramLMBase &lm, size_t numQueries, uint32_t seed,
+              VocabVector &queries) {
+    size_t order = lm.order();
+    queries.reset(numQueries * order);
+    uint32_t x = seed | 1;
+    for (size_t q = 0; q < numQueries; ++q) {
+        VocabIndex *words = &queries[q * order];
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        NgramIndex index = x % lm.sizes(order);
+        for (size_t o = order; o > 0; --o) {
+            words[o - 1] = lm.words(o)[index];
+            index = lm.hists(o)[index];
+        }
+        if (q % 2 == 1) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            words[order - 1] = lm.words(1)[x % lm.sizes(1)];
+        }
+    }
+}
+
+static void
+BenchmarkLM(const NgramLMBase &lm, size_t bits, size_t numQueries,
+            uint32_t seed) {
+    size_t order = lm.order();
+    size_t numNgrams = 0;
+    for (size_t o = 1; o <= order; ++o)
+        numNgrams += lm.sizes(o);
+    if (numNgrams == 0 || lm.sizes(order) == 0)
+        throw std::runtime_error("LM has no n-grams of its order.");
+
+    double      start = WallTime();
+    TrieNgramLM trie;
+    trie.Build(lm, bits);
+    Logger::Log(1, "Built %lu-bit TrieNgramLM in %.3f s.\n",
+                (unsigned long)bits, WallTime() - start);
+
+    VocabVector queries;
+    RandomQueries(lm, numQueries, seed, queries);
+
+    Logger::Log(0, "LM with %lu n-grams:\n", (unsigned long)numNgrams);
+    Logger::Log(0, "\t%-12s\t%8.2f bytes/n-gram\n", "NgramLM",
+                (double)NgramLMBytes(lm) / numNgrams);
+    Logger::Log(0, "\t%-12s\t%8.2f bytes/n-gram\n", "TrieNgramLM",
+                (double)trie.MemoryUsage() / numNgrams);
+
+    vector<double> logProbs(numQueries);
+    start = WallTime();
+    for (size_t q = 0; q < numQueries; ++q)
+        logProbs[q] = BackoffLogProb(lm, &queries[q * order], order);
+    LogRate("NgramLM", numQueries, start);
+
+    double maxError = 0, totError = 0;
+    start = WallTime();
+    for (size_t q = 0; q < numQueries; ++q)
+        logProbs[q] -= trie.LogProb(&queries[q * order], order);
+    LogRate("TrieNgramLM", numQueries, start);
+    for (size_t q = 0; q < numQueries; ++q) {
+        double error = std::isfinite(logProbs[q]) ? fabs(logProbs[q]) : 0;
+        maxError  = std::max(maxError, error);
+        totError += error;
+    }
+    Logger::Log(0, "\tLog prob error: %.4f mean, %.4f max.\n",
+                totError / numQueries, maxError);
+}
+
+// Assign e to out element by element through the closure iterators, as
+// DenseVector does for expressions without a kernel.
+template <typename E>
+static void
+GenericAssign(const Vector<E> &e, DoubleVector &out) {
+    Copy(e.impl().begin(), out.begin(), out.end());
+}
+
+template <typename E>
+static void
+GenericMaskAssign(const BitVector &mask, const Vector<E> &e,
+                  DoubleVector &out) {
+    MaskAssign<BitVector, E, DoubleVector>(mask, e.impl(), out);
+}
+
+static void
+LogKernel(const char *name, double genericTime, double simdTime,
+          const DoubleVector &generic, const DoubleVector &simd) {
+    double maxError = 0;
+    for (size_t i = 0; i < generic.length(); ++i) {
+        if (generic[i] == simd[i])
+            continue;
+        maxError = std::max(maxError, fabs(generic[i] - simd[i]) /
+                            std::max(fabs(generic[i]), fabs(simd[i])));
+    }
+    Logger::Log(0, "\t%-18s\t%8.3f s\t%8.3f s\t%6.2fx\t%8.2g\n", name,
+                genericTime, simdTime, genericTime / simdTime, maxError);
+}
+
+// Time the kernels of InterpolatedNgramLM::_EstimateProbs() on vectors of
+// length elements, evaluated generically and by DenseVector<double>.
+static void
+BenchmarkKernels(size_t length, uint32_t seed) {
+    DoubleVector feature(length), probs(length);
+    BitVector    mask(length);
+    uint32_t     x = seed | 1;
+    for (size_t i = 0; i < length; ++i) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        feature[i] = (x % 2000001) * 1e-5 - 10;
+        probs[i] = (x % 1000000 + 1) * 1e-6;
+        mask[i] = (x % 4 != 0);
+    }
+    Param        param = 0.37;
+    size_t       reps = std::max((size_t)1, (size_t)50000000 / length);
+    DoubleVector generic(length), simd(length);
+    double       start, genericTime;
+
+    Logger::Log(0, "Vector kernels on %lu doubles, %lu times:\n",
+                (unsigned long)length, (unsigned long)reps);
+    Logger::Log(0, "\t%-18s\t%10s\t%10s\t%7s\t%8s\n", "Kernel", "Generic",
+                "SIMD", "Speedup", "Error");
+
+    generic.set(0);
+    simd.set(0);
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        GenericAssign(generic + feature * param, generic);
+    genericTime = WallTime() - start;
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        simd += feature * param;
+    LogKernel("w += f * c", genericTime, WallTime() - start, generic, simd);
+
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        GenericAssign(exp(feature), generic);
+    genericTime = WallTime() - start;
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        simd = exp(feature);
+    LogKernel("w = exp(w)", genericTime, WallTime() - start, generic, simd);
+
+    generic.set(0);
+    simd.set(0);
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        GenericAssign(generic + probs, generic);
+    genericTime = WallTime() - start;
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        simd += probs;
+    LogKernel("t += w", genericTime, WallTime() - start, generic, simd);
+
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        GenericAssign(log(probs), generic);
+    genericTime = WallTime() - start;
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        simd = log(probs);
+    LogKernel("p = log(p)", genericTime, WallTime() - start, generic, simd);
+
+    generic.set(0);
+    simd.set(0);
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        GenericMaskAssign(mask, generic + feature * param, generic);
+    genericTime = WallTime() - start;
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        simd.masked(mask) += feature * param;
+    LogKernel("w += f * c (masked)", genericTime, WallTime() - start,
+              generic, simd);
+
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        GenericMaskAssign(mask, exp(feature), generic);
+    genericTime = WallTime() - start;
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        simd.masked(mask) = exp(feature);
+    LogKernel("w = exp(w) (masked)", genericTime, WallTime() - start,
+              generic, simd);
+
+    generic.set(0);
+    simd.set(0);
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        GenericMaskAssign(mask, generic + probs, generic);
+    genericTime = WallTime() - start;
+    start = WallTime();
+    for (size_t r = 0; r < reps; ++r)
+        simd.masked(mask) += probs;
+    LogKernel("t += w (masked)", genericTime, WallTime() - start,
+              generic, simd);
+}
+
+int main_benchmark_ngram(int argc, char* argv[]) {
+    // Parse command line options.
+    CommandOptions opts(headerDesc_benchmark_ngram, footerDesc_benchmark_ngram);
+    opts.AddOption("h,help", "Print this message.");
+    opts.AddOption("verbose", "Set verbosity level.", "1");
+    opts.AddOption("n,ngrams", "Set the number of n-grams to add.", "10000000");
+    opts.AddOption("vs,vocab-size", "Set the vocabulary size.", "65536");
+    opts.AddOption("seed", "Set the random seed.", "1");
+    opts.AddOption("l,lm", "Load specified LM and compare it to a TrieNgramLM.");
+    opts.AddOption("o,order", "Set the n-gram order of the LM.", "3");
+    opts.AddOption("b,bits", "Set the bits of TrieNgramLM quantization.", "8");
+    opts.AddOption("q,queries", "Set the number of LM lookups.", "1000000");
+    opts.AddOption("k,kernels",
+                   "Compare vector kernels on vectors of specified length.");
+    if (!opts.ParseArguments(argc, (const char **)argv) ||
+        opts["help"] != NULL) {
+        std::cout << std::endl;
+        opts.PrintHelp();
+        return 1;
+    }
+    Logger::SetVerbosity(atoi(opts["verbose"]));
+    size_t   numNgrams = atoi(opts["ngrams"]);
+    size_t   vocabSize = std::max(1, atoi(opts["vocab-size"]));
+    uint32_t seed      = atoi(opts["seed"]);
+
+    IndexVector hists, missHists, indices;
+    VocabVector words, missWords;
+    RandomNgrams(numNgrams, vocabSize, seed, hists, words);
+    RandomNgrams(numNgrams, vocabSize, ~seed, missHists, missWords);
+
+    Logger::Log(0, "NgramVector with %lu n-grams:\n", (unsigned long)numNgrams);
+    NgramVector vector;
+    double      start = WallTime();
+    for (size_t i = 0; i < numNgrams; ++i)
+        vector.Add(hists[i], words[i]);
+    LogRate("Add", numNgrams, start);
+
+    // Look up in a different order than added, as backoff computation does.
+    start = WallTime();
+    size_t found = 0;
+    for (size_t i = numNgrams; i-- > 0;)
+        found += (vector.Find(hists[i], words[i]) != NgramVector::Invalid);
+    LogRate("Find", numNgrams, start);
+
+    start = WallTime();
+    for (size_t i = numNgrams; i-- > 0;)
+        found += (vector.Find(missHists[i], missWords[i]) != NgramVector::Invalid);
+    LogRate("Find (miss)", numNgrams, start);
+
+    start = WallTime();
+    vector.Find(hists, words, indices);
+    LogRate("Find (batch)", numNgrams, start);
+    found += sum(indices != NgramVector::Invalid);
+
+    Logger::Log(1, "%lu distinct n-grams, %lu found, %lu slots.\n",
+                (unsigned long)vector.size(), (unsigned long)found,
+                (unsigned long)vector.capacity());
+
+    if (opts["lm"]) {
+        ArpaNgramLM lm(atoi(opts["order"]));
+        Logger::Log(1, "Loading LM %s...\n", opts["lm"]);
+        ZFile lmZFile(opts["lm"], "r");
+        lm.LoadLM(lmZFile);
+        BenchmarkLM(lm, atoi(opts["bits"]), atoi(opts["queries"]), seed);
+    }
+    if (opts["kernels"])
+        BenchmarkKernels(std::max(1, atoi(opts["kernels"])), seed);
+    return 0;
+}
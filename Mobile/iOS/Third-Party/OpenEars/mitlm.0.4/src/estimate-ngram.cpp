@@ -33,6 +33,8 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include <vector>
+#include <cctype>
+#include <cerrno>
 #include "util/CommandOptions.h"
 #include "util/ZFile.h"
 #include "util/Logger.h"
@@ -76,6 +78,9 @@ int main_estimate_ngram(int argc, char* argv[]) {
     opts.AddOption("u,unk", "Replace all out of vocab words with <unk>.");
     opts.AddOption("t,text", "Add counts from text files.");
     opts.AddOption("c,counts", "Add counts from counts files.");
+    opts.AddOption("j,threads", "Count text files and estimate the LM using the specified number of threads.", "1");
+    opts.AddOption("m,memory", "Count text files in sorted runs on disk, using at most the specified MB for each run.  "
+                   "This bounds counting only; the merged counts and the LM are still built in memory.");
     opts.AddOption("s,smoothing", "Specify smoothing algorithms.  "
                    "(ML, FixKN, FixModKN, FixKN#, KN, ModKN, KN#)", "ModKN");
     opts.AddOption("wf,weight-features", "Specify n-gram weighting features.");
@@ -113,11 +118,27 @@ int main_estimate_ngram(int argc, char* argv[]) {
         exit(1);
     }
 
+    size_t memoryBudget = 0;
+    if (opts["memory"]) {
+        const char *memory = opts["memory"];
+        char *end;
+        errno = 0;
+        unsigned long mb = strtoul(memory, &end, 10);
+        if (!isdigit((unsigned char)memory[0]) || *end != '\0' ||
+            errno == ERANGE || mb == 0 || mb > (~(size_t)0 >> 20)) {
+            Logger::Error(1, "Invalid -memory %s.  Specify a positive number of MB.\n",
+                          memory);
+            exit(1);
+        }
+        memoryBudget = (size_t)mb << 20;
+    }
+
     // Build language model.
     NgramLM lm(order);
     lm.Initialize(opts["vocab"], AsBoolean(opts["unk"]), 
                   opts["text"], opts["counts"], 
-                  opts["smoothing"], opts["weight-features"]);
+                  opts["smoothing"], opts["weight-features"],
+                  atoi(opts["threads"]), memoryBudget);
 
     // Estimate LM.
     ParamVector params(lm.defParams());
@@ -73,6 +73,7 @@ int main_evaluate_ngram(int argc, char* argv[]) {
     opts.AddOption("o,order", "Set the n-gram order of the estimated LM.", "3");
     opts.AddOption("v,vocab", "Fix the vocab to only words from the specified file.");
     opts.AddOption("l,lm", "Load specified LM.");
+    opts.AddOption("j,threads", "Evaluate lattices using the specified number of threads.", "1");
     opts.AddOption("cl,compile-lattices", "[SLS] Compiles lattices into a binary format.");
     opts.AddOption("ep,eval-perp", "Compute test set perplexity.");
     opts.AddOption("ew,eval-wer", "Compute test set lattice word error rate.");
@@ -106,6 +107,7 @@ int main_evaluate_ngram(int argc, char* argv[]) {
     Logger::Log(1, "Loading LM %s...\n", opts["lm"]);
     ZFile lmZFile(opts["lm"], "r");
     lm.LoadLM(lmZFile);
+    lm.SetNumThreads(atoi(opts["threads"]));
 
     // Compile lattices.
     if (opts["compile-lattices"]) {
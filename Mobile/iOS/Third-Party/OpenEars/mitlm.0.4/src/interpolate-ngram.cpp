@@ -79,6 +79,7 @@ int main_interpolate_ngram(int argc, char* argv[]) {
     opts.AddOption("l,lm", "Interpolate specified LM files.");
     opts.AddOption("t,text", "Interpolate models trained from text files.");
     opts.AddOption("c,counts", "Interpolate models trained from counts files.");
+    opts.AddOption("j,threads", "Count text files and estimate the LM using the specified number of threads.", "1");
     opts.AddOption("s,smoothing", "Specify smoothing algorithms.", "ModKN");
     opts.AddOption("wf,weight-features", "Specify n-gram weighting features.");
     opts.AddOption("i,interpolation", "Specify interpolation mode.  "
@@ -141,7 +142,8 @@ int main_interpolate_ngram(int argc, char* argv[]) {
             pLM->Initialize(opts["vocab"], AsBoolean(opts["unk"]), 
                             fromText ? corpusFiles[i].c_str() : NULL, 
                             fromText ? NULL : corpusFiles[i].c_str(), 
-                            GetItem(smoothings, i), GetItem(features, i));
+                            GetItem(smoothings, i), GetItem(features, i),
+                            atoi(opts["threads"]));
             lms.push_back((SharedPtr<NgramLMBase>)pLM);
         }
     }
@@ -177,6 +179,7 @@ int main_interpolate_ngram(int argc, char* argv[]) {
     InterpolatedNgramLM ilm(order, AsBoolean(opts["tie-param-order"]), 
                             AsBoolean(opts["tie-param-lm"]));
     ilm.LoadLMs(lms);
+    ilm.SetNumThreads(atoi(opts["threads"]));
     
     // Process features.
     vector<vector<string> > lmFeatures;
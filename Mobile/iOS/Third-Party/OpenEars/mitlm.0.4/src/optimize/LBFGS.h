@@ -32,49 +32,215 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
 ////////////////////////////////////////////////////////////////////////////
 
+
 #ifndef LBFGS_H
 #define LBFGS_H
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include "../Types.h"
 
 ////////////////////////////////////////////////////////////////////////////////
+// Limited-memory BFGS, after Nocedal (1980) and Liu & Nocedal (1989), with a
+// backtracking line search.  Function provides operator()(x) and
+// Gradient(x, g), which is called right after operator()(x) and may return
+// false to have the gradient approximated by forward differences.  With its
+// own gradient, an iteration usually costs one evaluation and one gradient;
+// otherwise it costs n + 1 evaluations.
 
-extern "C" {
-    void lbfgs_(int *n, int *m, double *x, double *f, double *g,
-                int *diagco, double *diag, int *iprint,
-                double *eps, double *xtol, double *w, int *iflag);
+// Approximate the gradient g of func at x, where f = func(x).  Entries that
+// a step would take above upper, if given, are differenced backwards.
+template <class Function>
+void
+ApproxGradient(Function &func, DoubleVector &x, double f, DoubleVector &g,
+               double step, const DoubleVector *upper = NULL) {
+    for (size_t i = 0; i < x.length(); ++i) {
+        double xi = x[i];
+        x[i] += (upper != NULL && xi + step > (*upper)[i]) ? -step : step;
+        g[i] = (func(x) - f) / (x[i] - xi);
+        x[i] = xi;
+    }
 }
 
+// Set g to the gradient of func at x, where f = func(x) was the last call.
+template <class Function>
+void
+ComputeGradient(Function &func, DoubleVector &x, double f, DoubleVector &g,
+                double step, const DoubleVector *upper = NULL) {
+    if (!func.Gradient(x, g))
+        ApproxGradient(func, x, f, g, step, upper);
+}
+
+// The last m steps s and gradient changes y, from which LBFGSMemory applies
+// an approximation of the inverse Hessian to the gradient.
+class LBFGSMemory {
+    std::vector<DoubleVector> _s;
+    std::vector<DoubleVector> _y;
+    DoubleVector              _rho;
+    DoubleVector              _alpha;
+    size_t                    _size;
+    size_t                    _next;
+
+public:
+    LBFGSMemory(size_t n, size_t m)
+        : _s(m), _y(m), _rho(m), _alpha(m), _size(0), _next(0) {
+        for (size_t k = 0; k < m; ++k) {
+            _s[k].reset(n);
+            _y[k].reset(n);
+        }
+    }
+
+    size_t size() const { return _size; }
+    void   Reset()      { _size = _next = 0; }
+
+    // Remember the step from x to xNew and the change from g to gNew, unless
+    // the curvature along it is not positive.
+    bool Update(const DoubleVector &x, const DoubleVector &xNew,
+                const DoubleVector &g, const DoubleVector &gNew) {
+        DoubleVector &s(_s[_next]);
+        DoubleVector &y(_y[_next]);
+        double        sy = 0, yy = 0;
+        for (size_t i = 0; i < x.length(); ++i) {
+            s[i] = xNew[i] - x[i];
+            y[i] = gNew[i] - g[i];
+            sy += s[i] * y[i];
+            yy += y[i] * y[i];
+        }
+        if (!(sy > 1e-10 * yy))
+            return false;
+        _rho[_next] = 1 / sy;
+        _next = (_next + 1) % _s.size();
+        if (_size < _s.size()) ++_size;
+        return true;
+    }
+
+    // Set d = -H g by the two-loop recursion, with H scaled by the latest
+    // s'y / y'y.  Entries where free is 0, if given, are held at zero.
+    void Direction(const DoubleVector &g, DoubleVector &d,
+                   const BitVector *free = NULL) {
+        size_t n = g.length(), m = _s.size();
+        for (size_t i = 0; i < n; ++i)
+            d[i] = (free == NULL || (*free)[i]) ? -g[i] : 0;
+        for (size_t j = 0; j < _size; ++j) {
+            size_t k = (_next + m - 1 - j) % m;
+            double a = 0;
+            for (size_t i = 0; i < n; ++i)
+                a += _s[k][i] * d[i];
+            _alpha[k] = a *= _rho[k];
+            for (size_t i = 0; i < n; ++i)
+                d[i] -= a * _y[k][i];
+        }
+        if (_size > 0) {
+            size_t k = (_next + m - 1) % m;
+            double yy = 0;
+            for (size_t i = 0; i < n; ++i)
+                yy += _y[k][i] * _y[k][i];
+            double gamma = 1 / (_rho[k] * yy);
+            for (size_t i = 0; i < n; ++i)
+                d[i] *= gamma;
+        }
+        for (size_t j = _size; j-- > 0;) {
+            size_t k = (_next + m - 1 - j) % m;
+            double b = 0;
+            for (size_t i = 0; i < n; ++i)
+                b += _y[k][i] * d[i];
+            b = _alpha[k] - _rho[k] * b;
+            for (size_t i = 0; i < n; ++i)
+                d[i] += b * _s[k][i];
+        }
+        if (free != NULL)
+            for (size_t i = 0; i < n; ++i)
+                if (!(*free)[i]) d[i] = 0;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Search along d from x, where f = func(x), for xNew = x + alpha d satisfying
+// the Armijo condition, shrinking alpha by quadratic interpolation.  Return
+// false if none is found in maxIter tries.  If lower and upper are given,
+// each xNew is projected into the box they define.
+template <class Function>
+bool
+BacktrackLineSearch(Function &func, const DoubleVector &x, double f,
+                    const DoubleVector &g, const DoubleVector &d,
+                    double alpha, DoubleVector &xNew, double &fNew,
+                    const DoubleVector *lower = NULL,
+                    const DoubleVector *upper = NULL, int maxIter = 20) {
+    const double c1 = 1e-4;
+    for (int iter = 0; iter < maxIter; ++iter) {
+        double gs = 0;  // Directional derivative along the projected step.
+        for (size_t i = 0; i < x.length(); ++i) {
+            xNew[i] = x[i] + alpha * d[i];
+            if (lower != NULL && xNew[i] < (*lower)[i]) xNew[i] = (*lower)[i];
+            if (upper != NULL && xNew[i] > (*upper)[i]) xNew[i] = (*upper)[i];
+            gs += g[i] * (xNew[i] - x[i]);
+        }
+        if (gs >= 0)
+            return false;
+        fNew = func(xNew);
+        if (fNew <= f + c1 * gs)
+            return true;
+
+        // Minimize the quadratic through f, gs and fNew, within limits.
+        double t = -gs / (2 * (fNew - f - gs));
+        alpha *= (t != t || t < 0.1) ? 0.1 : (t > 0.5) ? 0.5 : t;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 template <class Function>
 double
 MinimizeLBFGS(Function &func, DoubleVector &x, int &numIter, double step=1e-8,
               double eps=1e-5, double xtol=1e-16, int maxIter=0) {
     if (maxIter == 0) maxIter = 15000;
 
-    int          n = x.length();
-    int          m = 10;
-    double       f;
-    DoubleVector g(n);
-    int          diagco = false;
-    DoubleVector diag(n, 0);
-    int          iprint[2] = {-1, 0};
-    DoubleVector w(n*(2*m+1) + 2*m);
-    int          iflag = 0;
-
-    numIter = 0;
-    while (true) {
-        f = func(x);
-        // Approximate gradient.
-        for (int i = 0; i < n; ++i) {
-            x[i] += step;
-            g[i] = (func(x) - f) / step;
-            x[i] -= step;
+    size_t       n = x.length();
+    LBFGSMemory  memory(n, 10);
+    DoubleVector g(n), gNew(n), d(n), xNew(n);
+    double       f = func(x), fNew;
+    ComputeGradient(func, x, f, g, step);
+
+    for (numIter = 0; numIter < maxIter; ++numIter) {
+        // Converged if the gradient is small relative to x.
+        double xNorm = 0, gNorm = 0;
+        for (size_t i = 0; i < n; ++i) {
+            xNorm += x[i] * x[i];
+            gNorm += g[i] * g[i];
+        }
+        xNorm = sqrt(xNorm);
+        gNorm = sqrt(gNorm);
+        if (gNorm <= eps * std::max(1.0, xNorm))
+            break;
+
+        // Step along -H g, taking a unit step once H is scaled to the
+        // problem, or 1 / |g| before.  Fall back to steepest descent once.
+        memory.Direction(g, d);
+        double alpha = (memory.size() > 0) ? 1 : 1 / gNorm;
+        if (!BacktrackLineSearch(func, x, f, g, d, alpha, xNew, fNew)) {
+            if (memory.size() == 0)
+                break;
+            memory.Reset();
+            --numIter;
+            continue;
+        }
+
+        // Stop once steps no longer move x.
+        double sNorm = 0;
+        for (size_t i = 0; i < n; ++i)
+            sNorm += (xNew[i] - x[i]) * (xNew[i] - x[i]);
+        ComputeGradient(func, xNew, fNew, gNew, step);
+        memory.Update(x, xNew, g, gNew);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = xNew[i];
+            g[i] = gNew[i];
         }
-        lbfgs_(&n, &m, x.data(), &f, g.data(), &diagco, diag.data(), iprint,
-               &eps, &xtol, w.data(), &iflag);
-        if (iflag <= 0)
+        f = fNew;
+        if (sqrt(sNorm) <= xtol * std::max(1.0, xNorm))
             break;
-        if (++numIter > maxIter) break;
     }
     return f;
 }
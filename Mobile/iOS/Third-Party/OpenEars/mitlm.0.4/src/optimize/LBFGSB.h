@@ -32,64 +32,90 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
 ////////////////////////////////////////////////////////////////////////////
 
+
 #ifndef LBFGSB_H
 #define LBFGSB_H
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include "../Types.h"
+#include "LBFGS.h"
 
 ////////////////////////////////////////////////////////////////////////////////
-
-extern "C" {
-    void setulb_(int *n, int *m, double *x, double *l, double *u, int *nbd,
-                 double *f, double *g, double *factr, double *pgtol,
-                 double *wa, int *iwa, char *task, int *iprint,
-                 char *csave, int *lsave, int *isave, double *dsave);
-}
+// L-BFGS with bounds, as a projected quasi-Newton method in the spirit of
+// Byrd, Lu, Nocedal & Zhu (1995) but without their generalized Cauchy point:
+// variables at a bound that the gradient pushes against are held fixed, the
+// rest take an L-BFGS step, and the line search projects each trial point
+// into the box.  Stops when the projected gradient is below pgtol or when an
+// iteration reduces f by less than factr times the machine precision.
 
 template <class Function>
 double
-MinimizeLBFGSB(Function &func, DoubleVector &x, int &numIter, double step=1e-8,
+MinimizeLBFGSB(Function &func, DoubleVector &x, const DoubleVector &lower,
+               const DoubleVector &upper, int &numIter, double step=1e-8,
                double factr=1e7, double pgtol=1e-5, int maxIter=0) {
     if (maxIter == 0) maxIter = 15000;
 
-    int          n = x.length();
-    int          m = 10;
-    DoubleVector l(n);
-    DoubleVector u(n);
-    IntVector    nbd(n, 0);
-    double       f;
-    DoubleVector g(n);
-    DoubleVector wa(2*m*n + 4*n + 12*m*m + 12*m);
-    IntVector    iwa(3*n);
-    char         task[60];
-    int          iprint = -1;
-    char         csave[60];
-    IntVector    lsave(4);
-    IntVector    isave(44);
-    DoubleVector dsave(29);
+    size_t       n = x.length();
+    LBFGSMemory  memory(n, 10);
+    DoubleVector g(n), gNew(n), d(n), xNew(n);
+    BitVector    free(n);
+    for (size_t i = 0; i < n; ++i)
+        x[i] = std::min(std::max(x[i], lower[i]), upper[i]);
+    double f = func(x), fNew;
+    ComputeGradient(func, x, f, g, step, &upper);
+
+    for (numIter = 0; numIter < maxIter; ++numIter) {
+        // Converged if the projected gradient is small.
+        double pgNorm = 0, gNorm = 0;
+        for (size_t i = 0; i < n; ++i) {
+            double p = std::min(std::max(x[i] - g[i], lower[i]), upper[i]);
+            pgNorm = std::max(pgNorm, fabs(p - x[i]));
+            free[i] = !((x[i] <= lower[i] && g[i] > 0) ||
+                        (x[i] >= upper[i] && g[i] < 0));
+            if (free[i]) gNorm += g[i] * g[i];
+        }
+        if (pgNorm <= pgtol)
+            break;
+
+        // Step the free variables along -H g, falling back to steepest
+        // descent once, as in MinimizeLBFGS.
+        memory.Direction(g, d, &free);
+        double alpha = (memory.size() > 0) ? 1 : 1 / sqrt(gNorm);
+        if (!BacktrackLineSearch(func, x, f, g, d, alpha, xNew, fNew,
+                                 &lower, &upper)) {
+            if (memory.size() == 0)
+                break;
+            memory.Reset();
+            --numIter;
+            continue;
+        }
 
-    numIter = 0;
-    memset(task, ' ', 60);
-    strncpy(task, "START", 5);
-    while (true) {
-        setulb_(&n, &m, x.data(), l.data(), u.data(), nbd.data(),
-                &f, g.data(), &factr, &pgtol, wa.data(), iwa.data(), &task[0],
-                &iprint, &csave[0], lsave.data(), isave.data(), dsave.data());
-        if (strncmp(task, "FG", 2) == 0) {
-            f = func(x);
-            // Approximate gradient.
-            for (int i = 0; i < n; ++i) {
-                x[i] += step;
-                g[i] = (func(x) - f) / step;
-                x[i] -= step;
-            }
-        } else if (strncmp(task, "NEW_X", 5) == 0) {
-            if (++numIter >= maxIter)
-                strcpy(task, "STOP: TOTAL NO. ITERATIONS EXCEEDS LIMIT");
-        } else
+        ComputeGradient(func, xNew, fNew, gNew, step, &upper);
+        memory.Update(x, xNew, g, gNew);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = xNew[i];
+            g[i] = gNew[i];
+        }
+        double fPrev = f;
+        f = fNew;
+        if (fPrev - f <= factr * DBL_EPSILON *
+            std::max(std::max(fabs(fPrev), fabs(f)), 1.0))
             break;
     }
     return f;
 }
 
+// Minimize without bounds, as the optimizers do.
+template <class Function>
+double
+MinimizeLBFGSB(Function &func, DoubleVector &x, int &numIter, double step=1e-8,
+               double factr=1e7, double pgtol=1e-5, int maxIter=0) {
+    DoubleVector lower(x.length(), -HUGE_VAL);
+    DoubleVector upper(x.length(), HUGE_VAL);
+    return MinimizeLBFGSB(func, x, lower, upper, numIter, step, factr, pgtol,
+                          maxIter);
+}
+
 #endif // LBFGSB_H
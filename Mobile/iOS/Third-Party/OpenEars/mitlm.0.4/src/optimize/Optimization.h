@@ -36,8 +36,8 @@
 #define OPTIMIZATION_H
 
 #include "Powell.h"
-//#include "LBFGS.h"
-//#include "LBFGSB.h" /**I commented these out for OpenEars -- HLW */
+#include "LBFGS.h"
+#include "LBFGSB.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
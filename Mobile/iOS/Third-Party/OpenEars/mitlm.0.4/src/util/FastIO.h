@@ -47,6 +47,8 @@
 // Use date as version ID.
 #define MITLMv1a 0x20080901  // Bug: Vocab did not store length
 #define MITLMv1 0x20081201
+#define MITLMv2 0x20261017   // Adds index tables and backoffs for MappedFile
+#define MITLMv3 0x20261018   // Index table slots hold the n-gram keys inline
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////
+// MappedFile maps the rest of a binary file into memory and reads it front to
+// back, like the FastIO readers do with a FILE *, expecting each item padded to
+// 8 bytes as the writers leave it.  Vectors read with MapVector() are views
+// into the mapping, so it must outlive them.  The mapping is private: its pages
+// are shared with every other process mapping the file until written to.
+// Streams that cannot be mapped, such as compressed files, are read into
+// memory instead.
+//
+class MappedFile {
+protected:
+    char * _data;
+    size_t _size;
+    size_t _pos;
+    bool   _mapped;
+
+public:
+    MappedFile(FILE *file) : _data(NULL), _size(0), _pos(0), _mapped(false) {
+        struct stat st;
+        long        pos = ftell(file);
+        if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) &&
+            pos >= 0 && pos % 8 == 0 && st.st_size > pos) {
+            void *p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE, fileno(file), 0);
+            if (p != MAP_FAILED) {
+                _data   = static_cast<char *>(p);
+                _size   = st.st_size;
+                _pos    = pos;
+                _mapped = true;
+                return;
+            }
+        }
+        size_t capacity = 1 << 20;
+        _data = static_cast<char *>(malloc(capacity));
+        while (_data != NULL) {
+            _size += fread(_data + _size, 1, capacity - _size, file);
+            if (_size < capacity)
+                break;
+            char *data = static_cast<char *>(realloc(_data, capacity *= 2));
+            if (data == NULL)
+                free(_data);
+            _data = data;
+        }
+        if (_data == NULL)
+            throw std::runtime_error("Read failed.");
+    }
+    ~MappedFile() {
+        if (_mapped)
+            munmap(_data, _size);
+        else
+            free(_data);
+    }
+
+    // Return the next len bytes and move past them and their padding.
+    char *Read(size_t len) {
+        size_t padded = (len + 7) & ~(size_t)7;
+        if (padded < len || padded > _size - _pos)
+            throw std::runtime_error("Read failed.");
+        char *p = _data + _pos;
+        _pos += padded;
+        return p;
+    }
+
+    uint64_t ReadUInt64() {
+        uint64_t v;
+        memcpy(&v, Read(sizeof(uint64_t)), sizeof(uint64_t));
+        return v;
+    }
+
+    void ReadString(std::string &str) {
+        size_t len = ReadUInt64();
+        str.assign(Read(len), len);
+    }
+
+    void VerifyHeader(const char *header) {
+        size_t len = strlen(header);
+        if (len > _size - _pos || strncmp(_data + _pos, header, len) != 0)
+            throw std::runtime_error("Invalid file format.");
+        Read(len);
+    }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+};
+
+#endif // MAPPEDFILE_H
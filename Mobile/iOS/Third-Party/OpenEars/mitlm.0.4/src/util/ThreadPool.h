@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <cstddef>
+#include <vector>
+#include <pthread.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// ThreadPool runs a task on a fixed set of threads and waits for all of them,
+// so that a kernel called many times, such as by the optimizers, does not pay
+// to create its threads on every call.  The calling thread is slot 0 and takes
+// part in each run.  Tasks must not throw.
+//
+class ThreadPool {
+public:
+    typedef void (*Task)(void *arg, size_t slot);
+
+protected:
+    pthread_mutex_t        _mutex;
+    pthread_cond_t         _start;
+    pthread_cond_t         _done;
+    std::vector<pthread_t> _threads;
+    Task                   _task;
+    void *                 _arg;
+    size_t                 _numStarted;
+    size_t                 _numBusy;
+    size_t                 _generation;
+    bool                   _stopping;
+
+public:
+    // Start numThreads - 1 threads.  If some cannot be created, the pool runs
+    // tasks on fewer slots.
+    ThreadPool(size_t numThreads)
+        : _task(NULL), _arg(NULL), _numStarted(0), _numBusy(0),
+          _generation(0), _stopping(false) {
+        pthread_mutex_init(&_mutex, NULL);
+        pthread_cond_init(&_start, NULL);
+        pthread_cond_init(&_done, NULL);
+        for (size_t t = 1; t < numThreads; ++t) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, &_Work, this) != 0)
+                break;
+            _threads.push_back(thread);
+        }
+    }
+    ~ThreadPool() {
+        pthread_mutex_lock(&_mutex);
+        _stopping = true;
+        pthread_cond_broadcast(&_start);
+        pthread_mutex_unlock(&_mutex);
+        for (size_t t = 0; t < _threads.size(); ++t)
+            pthread_join(_threads[t], NULL);
+        pthread_cond_destroy(&_done);
+        pthread_cond_destroy(&_start);
+        pthread_mutex_destroy(&_mutex);
+    }
+
+    size_t size() const { return _threads.size() + 1; }
+
+    // Call task(arg, slot) once for each slot in [0, size()) and return when
+    // all calls have.
+    void Run(Task task, void *arg) {
+        if (_threads.empty()) {
+            task(arg, 0);
+            return;
+        }
+        pthread_mutex_lock(&_mutex);
+        _task    = task;
+        _arg     = arg;
+        _numBusy = _threads.size();
+        ++_generation;
+        pthread_cond_broadcast(&_start);
+        pthread_mutex_unlock(&_mutex);
+
+        task(arg, 0);
+
+        pthread_mutex_lock(&_mutex);
+        while (_numBusy > 0)
+            pthread_cond_wait(&_done, &_mutex);
+        pthread_mutex_unlock(&_mutex);
+    }
+
+private:
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    static void *_Work(void *p) {
+        ThreadPool &pool = *static_cast<ThreadPool *>(p);
+        pthread_mutex_lock(&pool._mutex);
+        size_t slot = ++pool._numStarted;
+        size_t generation = 0;  // A run may have begun before we started.
+        while (true) {
+            while (pool._generation == generation && !pool._stopping)
+                pthread_cond_wait(&pool._start, &pool._mutex);
+            if (pool._stopping)
+                break;
+            generation = pool._generation;
+            Task  task = pool._task;
+            void *arg  = pool._arg;
+            pthread_mutex_unlock(&pool._mutex);
+
+            task(arg, slot);
+
+            pthread_mutex_lock(&pool._mutex);
+            if (--pool._numBusy == 0)
+                pthread_cond_signal(&pool._done);
+        }
+        pthread_mutex_unlock(&pool._mutex);
+        return NULL;
+    }
+};
+
+#endif // THREADPOOL_H
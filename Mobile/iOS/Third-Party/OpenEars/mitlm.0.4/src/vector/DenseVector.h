@@ -41,6 +41,8 @@
 #include "VectorClosures.h"
 #include "Range.h"
 #include "Traits.h"
+#include "VectorKernels.h"
+#include "util/MappedFile.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -96,6 +98,7 @@ public:
     void swap(DenseVector<T> &v);
     void set(T value);
     void attach(const DenseVector<T> &v);
+    void attach(T *data, size_t length);
     template <typename Compare> bool sort(Compare compare);
 
     size_t        length() const { return _length; }
@@ -138,6 +141,9 @@ void WriteVector(FILE *out, const DenseVector<T> &x);
 template <typename T>
 void ReadVector(FILE *in, DenseVector<T> &x);
 
+template <typename T>
+void MapVector(MappedFile &in, DenseVector<T> &x);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "DenseVector.tcc"
@@ -33,6 +33,7 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include <cassert>
+#include <cstdlib>
 #include <algorithm>
 #include "util/RefCounter.h"
 #include "util/Logger.h"
@@ -54,6 +55,103 @@
 //   View into memory managed elsewhere.
 //   No specific action on attach or detach.
 
+////////////////////////////////////////////////////////////////////////////////
+// Evaluation
+
+// Assign the elements of rhs to out, which has the length of rhs.  Closures
+// over whole double vectors are evaluated by the kernels in VectorKernels.h;
+// all others element by element through the closure iterators.
+template <typename T, typename RHS>
+inline void
+Assign(const RHS &rhs, DenseVector<T> &out) {
+    Copy(rhs.begin(), out.begin(), out.end());
+}
+
+inline void
+Assign(const VectorClosure<OpAdd, DenseVector<double>,
+                           DenseVector<double> > &rhs,
+       DenseVector<double> &out) {
+    assert(rhs.left().length() == rhs.right().length());
+    VecAdd(rhs.left().data(), rhs.right().data(), out.data(), out.length());
+}
+
+inline void
+Assign(const VectorClosure<OpMult, DenseVector<double>,
+                           DenseVector<double> > &rhs,
+       DenseVector<double> &out) {
+    assert(rhs.left().length() == rhs.right().length());
+    VecMult(rhs.left().data(), rhs.right().data(), out.data(), out.length());
+}
+
+inline void
+Assign(const VectorClosure<OpAdd, DenseVector<double>, Scalar<double> > &rhs,
+       DenseVector<double> &out) {
+    VecAdd(rhs.left().data(), (double)rhs.right(), out.data(), out.length());
+}
+
+inline void
+Assign(const VectorClosure<OpMult, DenseVector<double>, Scalar<double> > &rhs,
+       DenseVector<double> &out) {
+    VecMult(rhs.left().data(), (double)rhs.right(), out.data(), out.length());
+}
+
+inline void
+Assign(const UnaryVectorClosure<OpExp, DenseVector<double> > &rhs,
+       DenseVector<double> &out) {
+    VecExp(rhs.operand().data(), out.data(), out.length());
+}
+
+inline void
+Assign(const UnaryVectorClosure<OpLog, DenseVector<double> > &rhs,
+       DenseVector<double> &out) {
+    VecLog(rhs.operand().data(), out.data(), out.length());
+}
+
+// out += rhs
+template <typename T, typename RHS>
+inline void
+AddAssign(const RHS &rhs, DenseVector<T> &out) {
+    assert(out.length() == rhs.length());
+    typename RHS::ConstIterator q = rhs.begin();
+    for (typename DenseVector<T>::Iterator p = out.begin(); p != out.end();
+         ++p, ++q)
+        *p += *q;
+}
+
+inline void
+AddAssign(const DenseVector<double> &rhs, DenseVector<double> &out) {
+    assert(out.length() == rhs.length());
+    VecAdd(out.data(), rhs.data(), out.data(), out.length());
+}
+
+inline void
+AddAssign(const VectorClosure<OpMult, DenseVector<double>,
+                              Scalar<double> > &rhs,
+          DenseVector<double> &out) {
+    assert(out.length() == rhs.length());
+    VecMultAdd(rhs.left().data(), (double)rhs.right(), out.data(),
+               out.length());
+}
+
+// out *= rhs
+template <typename T, typename RHS>
+inline void
+MultAssign(const RHS &rhs, DenseVector<T> &out) {
+    assert(out.length() == rhs.length());
+    typename RHS::ConstIterator q = rhs.begin();
+    for (typename DenseVector<T>::Iterator p = out.begin(); p != out.end();
+         ++p, ++q)
+        *p *= *q;
+}
+
+inline void
+MultAssign(const DenseVector<double> &rhs, DenseVector<double> &out) {
+    assert(out.length() == rhs.length());
+    VecMult(out.data(), rhs.data(), out.data(), out.length());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 template <typename T>
 DenseVector<T>::DenseVector(size_t length)
     : _length(length), _data(0), _storage(0)
@@ -102,7 +200,7 @@ DenseVector<T>::DenseVector(const Vector<RHS> &rhs)
     : _length(rhs.impl().length()), _data(0), _storage(0)
 {
     _allocate();
-    Copy(rhs.impl().begin(), begin(), end());
+    Assign(rhs.impl(), *this);
 }
 
 template <typename T>
@@ -160,8 +258,8 @@ template <typename RHS>
 DenseVector<T> &
 DenseVector<T>::operator=(const Vector<RHS> &rhs)
 {
-	reset(rhs.impl().length());
-	Copy(rhs.impl().begin(), begin(), end());
+    reset(rhs.impl().length());
+    Assign(rhs.impl(), *this);
     return *this;
 }
 
@@ -170,10 +268,7 @@ template <typename RHS>
 DenseVector<T> &
 DenseVector<T>::operator+=(const Vector<RHS> &rhs)
 {
-    assert(length() == rhs.impl().length());
-    typename RHS::ConstIterator q = rhs.impl().begin();
-    for (Iterator p = begin(); p != end(); ++p, ++q)
-        *p += *q;
+    AddAssign(rhs.impl(), *this);
     return *this;
 }
 
@@ -194,10 +289,7 @@ template <typename RHS>
 DenseVector<T> &
 DenseVector<T>::operator*=(const Vector<RHS> &rhs)
 {
-    assert(length() == rhs.impl().length());
-    typename RHS::ConstIterator q = rhs.impl().begin();
-    for (Iterator p = begin(); p != end(); ++p, ++q)
-        *p *= *q;
+    MultAssign(rhs.impl(), *this);
     return *this;
 }
 
@@ -308,7 +400,7 @@ void
 DenseVector<T>::reset(size_t length)
 {
     if (length != _length) {
-        assert(_data == _storage);
+        assert(_data == _storage || _storage == NULL);
         _release();
         _length = length;
         _allocate();
@@ -328,7 +420,7 @@ void
 DenseVector<T>::resize(size_t length)
 {
     if (length != _length) {
-        assert(_data == _storage);
+        assert(_data == _storage || _storage == NULL);
         DenseVector<T> v(length);
         Copy(begin(), v.begin(), v.begin() + std::min(length, _length));
         swap(v);
@@ -340,7 +432,7 @@ void
 DenseVector<T>::resize(size_t length, T value)
 {
     if (length != _length) {
-        assert(_data == _storage);
+        assert(_data == _storage || _storage == NULL);
         DenseVector<T> v(length);
         Copy(begin(), v.begin(), v.begin() + std::min(length, _length));
         if (length > _length)
@@ -378,6 +470,17 @@ DenseVector<T>::attach(const DenseVector<T> &rhs)
         RefCounter.attach(_storage);
 }
 
+// Attach as a view into memory managed elsewhere.
+template <typename T>
+void
+DenseVector<T>::attach(T *data, size_t length)
+{
+    _release();
+    _length  = length;
+    _data    = data;
+    _storage = NULL;
+}
+
 template <typename T>
 template <typename Compare> 
 bool
@@ -402,7 +505,12 @@ DenseVector<T>::_allocate()
     assert(!_data && !_storage);
     if (length() == 0)
         return;
-    _storage = _data = static_cast<T *>(malloc(_length * sizeof(T)));
+    // Align for the SIMD kernels, so loads of whole vectors do not split
+    // cache lines.
+    void *storage = NULL;
+    if (posix_memalign(&storage, SimdAlignment, _length * sizeof(T)) != 0)
+        storage = NULL;
+    _storage = _data = static_cast<T *>(storage);
     assert(_data);
 }
 
@@ -463,3 +571,12 @@ ReadVector(FILE *in, DenseVector<T> &x) {
         throw std::runtime_error("Read failed.");
     ReadAlignPad(in, x.length() * sizeof(T));
 }
+
+template <typename T>
+void
+MapVector(MappedFile &in, DenseVector<T> &x) {
+    size_t length = in.ReadUInt64();
+    if (length > (size_t)-1 / sizeof(T))
+        throw std::runtime_error("Read failed.");
+    x.attach(reinterpret_cast<T *>(in.Read(length * sizeof(T))), length);
+}
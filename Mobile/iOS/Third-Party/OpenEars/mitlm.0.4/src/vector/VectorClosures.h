@@ -113,6 +113,7 @@ public:
     ConstIterator begin() const  { return ConstIterator(_v.begin()); }
     ConstIterator end() const    { return ConstIterator(_v.end()); }
     ElementType   operator[](size_t i) const { return Op::Eval(_v[i]); }
+    typename Ref<typename V::Impl>::Type operand() const { return _v; }
 
     template <typename I>
     const IndirectVectorClosure<SelfT, I> operator[](const Vector<I> &x) const
@@ -178,6 +179,8 @@ public:
     ConstIterator begin() const { return ConstIterator(_l.begin(),_r.begin()); }
     ConstIterator end() const   { return ConstIterator(_l.end(), _r.end()); }
     ElementType   operator[](size_t i) const { return Op::Eval(_l[i], _r[i]); }
+    typename Ref<typename L::Impl>::Type left() const  { return _l; }
+    typename Ref<typename R::Impl>::Type right() const { return _r; }
 
     template <typename I>
     const IndirectVectorClosure<SelfT, I> operator[](const Vector<I> &x) const
@@ -266,6 +269,8 @@ public:
 
     template <typename RHS>
     void operator=(const Vector<RHS> &rhs) { MaskAssign(_m, rhs.impl(), _v); }
+    template <typename RHS>
+    void operator+=(const Vector<RHS> &rhs) { MaskAdd(_m, rhs.impl(), _v); }
     void set(typename V::ElementType value)
       { for (size_t i = 0; i < _v.length(); i++) if (_m[i]) _v[i] = 0; }
 
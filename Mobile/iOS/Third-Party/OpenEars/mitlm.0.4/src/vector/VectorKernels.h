@@ -0,0 +1,411 @@
+////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2008, Massachusetts Institute of Technology              //
+// All rights reserved.                                                   //
+//                                                                        //
+// Redistribution and use in source and binary forms, with or without     //
+// modification, are permitted provided that the following conditions are //
+// met:                                                                   //
+//                                                                        //
+//     * Redistributions of source code must retain the above copyright   //
+//       notice, this list of conditions and the following disclaimer.    //
+//                                                                        //
+//     * Redistributions in binary form must reproduce the above          //
+//       copyright notice, this list of conditions and the following      //
+//       disclaimer in the documentation and/or other materials provided  //
+//       with the distribution.                                           //
+//                                                                        //
+//     * Neither the name of the Massachusetts Institute of Technology    //
+//       nor the names of its contributors may be used to endorse or      //
+//       promote products derived from this software without specific     //
+//       prior written permission.                                        //
+//                                                                        //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS    //
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT      //
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR  //
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT   //
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,  //
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT       //
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  //
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY  //
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT    //
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.   //
+////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef VECTORKERNELS_H
+#define VECTORKERNELS_H
+
+#include <cmath>
+#include <cfloat>
+#include <cstddef>
+
+//#define VECTOR_GENERIC  // Uncomment to use CPU independent implementation.
+
+#if !defined(VECTOR_GENERIC) && defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR_SIMD_SSE2
+#elif !defined(VECTOR_GENERIC) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VECTOR_SIMD_NEON
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernels over contiguous double arrays, evaluated two elements at a time
+// with SSE2 on x86 and NEON on ARM64, and one at a time otherwise.  Arrays
+// may overlap only if they are the same array.  DenseVector allocates its
+// data with SimdAlignment, but views start anywhere, so loads are unaligned.
+
+static const size_t SimdAlignment = 32;
+
+#if defined(VECTOR_SIMD_SSE2) || defined(VECTOR_SIMD_NEON)
+#define VECTOR_SIMD
+
+static const size_t SimdWidth = 2;
+
+#ifdef VECTOR_SIMD_SSE2
+
+typedef __m128d SimdVector;
+
+inline SimdVector SimdLoad(const double *p)         { return _mm_loadu_pd(p); }
+inline void       SimdStore(double *p, SimdVector v) { _mm_storeu_pd(p, v); }
+inline SimdVector SimdSet(double c)                 { return _mm_set1_pd(c); }
+inline SimdVector SimdAdd(SimdVector a, SimdVector b)
+{ return _mm_add_pd(a, b); }
+inline SimdVector SimdSub(SimdVector a, SimdVector b)
+{ return _mm_sub_pd(a, b); }
+inline SimdVector SimdMul(SimdVector a, SimdVector b)
+{ return _mm_mul_pd(a, b); }
+inline SimdVector SimdDiv(SimdVector a, SimdVector b)
+{ return _mm_div_pd(a, b); }
+inline SimdVector SimdAnd(SimdVector m, SimdVector a)
+{ return _mm_and_pd(m, a); }
+inline SimdVector SimdGreater(SimdVector a, SimdVector b)
+{ return _mm_cmpgt_pd(a, b); }
+
+// Return a with the lanes of b where m is set.
+inline SimdVector SimdSelect(SimdVector m, SimdVector b, SimdVector a)
+{ return _mm_or_pd(_mm_and_pd(m, b), _mm_andnot_pd(m, a)); }
+
+// Return a lane mask set where mask[i] is nonzero.
+inline SimdVector SimdMask(const unsigned char *mask) {
+    __m128i m = _mm_set_epi32(0, mask[1], 0, mask[0]);
+    return _mm_castsi128_pd(_mm_cmpgt_epi32(
+        _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 2, 0, 0)), _mm_setzero_si128()));
+}
+
+// Return true if lo <= a <= hi in every lane, which fails for NaN.
+inline bool SimdInRange(SimdVector a, double lo, double hi) {
+    return _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(a, _mm_set1_pd(lo)),
+                                      _mm_cmple_pd(a, _mm_set1_pd(hi)))) == 3;
+}
+
+// Return 2^n for integral n in [-1022, 1023].
+inline SimdVector SimdPow2(SimdVector n) {
+    __m128i e = _mm_add_epi32(_mm_cvtpd_epi32(n), _mm_set1_epi32(1023));
+    e = _mm_unpacklo_epi32(e, _mm_setzero_si128());
+    return _mm_castsi128_pd(_mm_slli_epi64(e, 52));
+}
+
+// Return a rounded to the nearest integer.
+inline SimdVector SimdRound(SimdVector a)
+{ return _mm_cvtepi32_pd(_mm_cvtpd_epi32(a)); }
+
+// Split positive normal a into mantissa in [1, 2), returned, and exponent e.
+inline SimdVector SimdSplit(SimdVector a, SimdVector &e) {
+    __m128i bits = _mm_castpd_si128(a);
+    e = _mm_sub_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(
+            _mm_srli_epi64(bits, 52), _MM_SHUFFLE(3, 3, 2, 0))),
+        _mm_set1_pd(1023));
+    return _mm_or_pd(
+        _mm_and_pd(a, _mm_castsi128_pd(_mm_set_epi32(0x000fffff, -1,
+                                                     0x000fffff, -1))),
+        _mm_set1_pd(1.0));
+}
+
+#else // VECTOR_SIMD_NEON
+
+typedef float64x2_t SimdVector;
+
+inline SimdVector SimdLoad(const double *p)         { return vld1q_f64(p); }
+inline void       SimdStore(double *p, SimdVector v) { vst1q_f64(p, v); }
+inline SimdVector SimdSet(double c)                 { return vdupq_n_f64(c); }
+inline SimdVector SimdAdd(SimdVector a, SimdVector b)
+{ return vaddq_f64(a, b); }
+inline SimdVector SimdSub(SimdVector a, SimdVector b)
+{ return vsubq_f64(a, b); }
+inline SimdVector SimdMul(SimdVector a, SimdVector b)
+{ return vmulq_f64(a, b); }
+inline SimdVector SimdDiv(SimdVector a, SimdVector b)
+{ return vdivq_f64(a, b); }
+inline SimdVector SimdAnd(SimdVector m, SimdVector a) {
+    return vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(m),
+                                           vreinterpretq_u64_f64(a)));
+}
+inline SimdVector SimdGreater(SimdVector a, SimdVector b)
+{ return vreinterpretq_f64_u64(vcgtq_f64(a, b)); }
+
+// Return a with the lanes of b where m is set.
+inline SimdVector SimdSelect(SimdVector m, SimdVector b, SimdVector a)
+{ return vbslq_f64(vreinterpretq_u64_f64(m), b, a); }
+
+// Return a lane mask set where mask[i] is nonzero.
+inline SimdVector SimdMask(const unsigned char *mask) {
+    uint64x2_t m = vcombine_u64(vcreate_u64(mask[0]), vcreate_u64(mask[1]));
+    return vreinterpretq_f64_u64(vtstq_u64(m, m));
+}
+
+// Return true if lo <= a <= hi in every lane, which fails for NaN.
+inline bool SimdInRange(SimdVector a, double lo, double hi) {
+    uint64x2_t in = vandq_u64(vcgeq_f64(a, vdupq_n_f64(lo)),
+                              vcleq_f64(a, vdupq_n_f64(hi)));
+    return (vgetq_lane_u64(in, 0) & vgetq_lane_u64(in, 1)) != 0;
+}
+
+// Return 2^n for integral n in [-1022, 1023].
+inline SimdVector SimdPow2(SimdVector n) {
+    int64x2_t e = vaddq_s64(vcvtq_s64_f64(n), vdupq_n_s64(1023));
+    return vreinterpretq_f64_s64(vshlq_n_s64(e, 52));
+}
+
+// Return a rounded to the nearest integer.
+inline SimdVector SimdRound(SimdVector a) { return vrndnq_f64(a); }
+
+// Split positive normal a into mantissa in [1, 2), returned, and exponent e.
+inline SimdVector SimdSplit(SimdVector a, SimdVector &e) {
+    uint64x2_t bits = vreinterpretq_u64_f64(a);
+    e = vsubq_f64(vcvtq_f64_u64(vshrq_n_u64(bits, 52)), vdupq_n_f64(1023));
+    bits = vorrq_u64(vandq_u64(bits, vdupq_n_u64(0x000fffffffffffffULL)),
+                     vreinterpretq_u64_f64(vdupq_n_f64(1.0)));
+    return vreinterpretq_f64_u64(bits);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a * b + c
+inline SimdVector SimdMulAdd(SimdVector a, SimdVector b, SimdVector c)
+{ return SimdAdd(SimdMul(a, b), c); }
+
+// exp(x) for x in [SimdExpMin, SimdExpMax], where exp(x) and 2^n are normal.
+// Reduces x = n ln(2) + r with |r| <= ln(2)/2 and evaluates exp(r) with the
+// Pade approximant of Cephes, 1 + 2 r P(r^2) / (Q(r^2) - r P(r^2)).
+static const double SimdExpMin = -708.0;
+static const double SimdExpMax = 709.0;
+
+inline SimdVector
+SimdExp(SimdVector x) {
+    SimdVector n = SimdRound(SimdMul(x, SimdSet(1.44269504088896340736)));
+    SimdVector r = SimdSub(x, SimdMul(n, SimdSet(6.93147180369123816490e-1)));
+    r = SimdSub(r, SimdMul(n, SimdSet(1.90821492927058770002e-10)));
+
+    SimdVector z = SimdMul(r, r);
+    SimdVector p = SimdSet(1.26177193074810590878e-4);
+    p = SimdMulAdd(p, z, SimdSet(3.02994407707441961300e-2));
+    p = SimdMulAdd(p, z, SimdSet(9.99999999999999999910e-1));
+    p = SimdMul(p, r);
+    SimdVector q = SimdSet(3.00198505138664455042e-6);
+    q = SimdMulAdd(q, z, SimdSet(2.52448340349684104192e-3));
+    q = SimdMulAdd(q, z, SimdSet(2.27265548208155028766e-1));
+    q = SimdMulAdd(q, z, SimdSet(2.00000000000000000009e0));
+    SimdVector y = SimdMulAdd(SimdSet(2.0), SimdDiv(p, SimdSub(q, p)),
+                              SimdSet(1.0));
+    return SimdMul(y, SimdPow2(n));
+}
+
+// log(x) for positive normal x.  Splits x = m 2^e with m in [sqrt(1/2),
+// sqrt(2)) and evaluates log(1 + f), f = m - 1, with the rational
+// approximation of Cephes, f - f^2/2 + f^3 P(f) / Q(f).
+inline SimdVector
+SimdLog(SimdVector x) {
+    SimdVector e;
+    SimdVector m = SimdSplit(x, e);
+    SimdVector big = SimdGreater(m, SimdSet(1.41421356237309504880));
+    m = SimdSelect(big, SimdMul(m, SimdSet(0.5)), m);
+    e = SimdAdd(e, SimdAnd(big, SimdSet(1.0)));
+
+    SimdVector f = SimdSub(m, SimdSet(1.0));
+    SimdVector z = SimdMul(f, f);
+    SimdVector p = SimdSet(1.01875663804580931796e-4);
+    p = SimdMulAdd(p, f, SimdSet(4.97494994976747001425e-1));
+    p = SimdMulAdd(p, f, SimdSet(4.70579119878881725854e0));
+    p = SimdMulAdd(p, f, SimdSet(1.44989225341610930846e1));
+    p = SimdMulAdd(p, f, SimdSet(1.79368678507819816313e1));
+    p = SimdMulAdd(p, f, SimdSet(7.70838733755885391666e0));
+    SimdVector q = SimdAdd(f, SimdSet(1.12873587189167450590e1));
+    q = SimdMulAdd(q, f, SimdSet(4.52279145837532221105e1));
+    q = SimdMulAdd(q, f, SimdSet(8.29875266912776603211e1));
+    q = SimdMulAdd(q, f, SimdSet(7.11544750618563894466e1));
+    q = SimdMulAdd(q, f, SimdSet(2.31251620126765340583e1));
+
+    // ln(2) = 0.693359375 - 2.121944400546905827679e-4, the first exactly.
+    SimdVector y = SimdMul(f, SimdDiv(SimdMul(z, p), q));
+    y = SimdSub(y, SimdMul(e, SimdSet(2.121944400546905827679e-4)));
+    y = SimdSub(y, SimdMul(z, SimdSet(0.5)));
+    return SimdAdd(SimdAdd(f, y), SimdMul(e, SimdSet(0.693359375)));
+}
+
+#endif // VECTOR_SIMD
+
+////////////////////////////////////////////////////////////////////////////////
+
+// out = x + y
+inline void
+VecAdd(const double *x, const double *y, double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    for (; i + SimdWidth <= n; i += SimdWidth)
+        SimdStore(out + i, SimdAdd(SimdLoad(x + i), SimdLoad(y + i)));
+#endif
+    for (; i < n; ++i)
+        out[i] = x[i] + y[i];
+}
+
+// out = x * y
+inline void
+VecMult(const double *x, const double *y, double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    for (; i + SimdWidth <= n; i += SimdWidth)
+        SimdStore(out + i, SimdMul(SimdLoad(x + i), SimdLoad(y + i)));
+#endif
+    for (; i < n; ++i)
+        out[i] = x[i] * y[i];
+}
+
+// out = x + c
+inline void
+VecAdd(const double *x, double c, double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    SimdVector vc = SimdSet(c);
+    for (; i + SimdWidth <= n; i += SimdWidth)
+        SimdStore(out + i, SimdAdd(SimdLoad(x + i), vc));
+#endif
+    for (; i < n; ++i)
+        out[i] = x[i] + c;
+}
+
+// out = x * c
+inline void
+VecMult(const double *x, double c, double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    SimdVector vc = SimdSet(c);
+    for (; i + SimdWidth <= n; i += SimdWidth)
+        SimdStore(out + i, SimdMul(SimdLoad(x + i), vc));
+#endif
+    for (; i < n; ++i)
+        out[i] = x[i] * c;
+}
+
+// out += x * c
+inline void
+VecMultAdd(const double *x, double c, double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    SimdVector vc = SimdSet(c);
+    for (; i + SimdWidth <= n; i += SimdWidth)
+        SimdStore(out + i, SimdAdd(SimdLoad(out + i),
+                                   SimdMul(SimdLoad(x + i), vc)));
+#endif
+    for (; i < n; ++i)
+        out[i] += x[i] * c;
+}
+
+// out = exp(x)
+inline void
+VecExp(const double *x, double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    for (; i + SimdWidth <= n; i += SimdWidth) {
+        SimdVector v = SimdLoad(x + i);
+        if (SimdInRange(v, SimdExpMin, SimdExpMax)) {
+            SimdStore(out + i, SimdExp(v));
+        } else {
+            // Results that overflow, are subnormal, or are NaN.
+            out[i] = exp(x[i]);
+            out[i + 1] = exp(x[i + 1]);
+        }
+    }
+#endif
+    for (; i < n; ++i)
+        out[i] = exp(x[i]);
+}
+
+// out = log(x)
+inline void
+VecLog(const double *x, double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    for (; i + SimdWidth <= n; i += SimdWidth) {
+        SimdVector v = SimdLoad(x + i);
+        if (SimdInRange(v, DBL_MIN, DBL_MAX)) {
+            SimdStore(out + i, SimdLog(v));
+        } else {
+            // Zero, negative, subnormal, infinite, or NaN arguments.
+            out[i] = log(x[i]);
+            out[i + 1] = log(x[i + 1]);
+        }
+    }
+#endif
+    for (; i < n; ++i)
+        out[i] = log(x[i]);
+}
+
+// out[i] += x[i] where mask[i]
+inline void
+VecAddMasked(const double *x, const unsigned char *mask, double *out,
+             size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    for (; i + SimdWidth <= n; i += SimdWidth)
+        SimdStore(out + i, SimdAdd(SimdLoad(out + i),
+                                   SimdAnd(SimdMask(mask + i),
+                                           SimdLoad(x + i))));
+#endif
+    for (; i < n; ++i)
+        if (mask[i]) out[i] += x[i];
+}
+
+// out[i] += x[i] * c where mask[i]
+inline void
+VecMultAddMasked(const double *x, double c, const unsigned char *mask,
+                 double *out, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    SimdVector vc = SimdSet(c);
+    for (; i + SimdWidth <= n; i += SimdWidth)
+        SimdStore(out + i, SimdAdd(SimdLoad(out + i),
+                                   SimdAnd(SimdMask(mask + i),
+                                           SimdMul(SimdLoad(x + i), vc))));
+#endif
+    for (; i < n; ++i)
+        if (mask[i]) out[i] += x[i] * c;
+}
+
+// out[i] = exp(x[i]) where mask[i]
+inline void
+VecExpMasked(const double *x, const unsigned char *mask, double *out,
+             size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_SIMD
+    for (; i + SimdWidth <= n; i += SimdWidth) {
+        if (!mask[i] && !mask[i + 1])
+            continue;
+        SimdVector v = SimdLoad(x + i);
+        if (SimdInRange(v, SimdExpMin, SimdExpMax)) {
+            SimdStore(out + i, SimdSelect(SimdMask(mask + i), SimdExp(v),
+                                          SimdLoad(out + i)));
+        } else {
+            if (mask[i])     out[i] = exp(x[i]);
+            if (mask[i + 1]) out[i + 1] = exp(x[i + 1]);
+        }
+    }
+#endif
+    for (; i < n; ++i)
+        if (mask[i]) out[i] = exp(x[i]);
+}
+
+#endif // VECTORKERNELS_H
@@ -352,4 +352,44 @@ void MaskAssign(const Vector<M> &mask, const Vector<I> &input,
         if (*pM) output.impl()[i] = input.impl()[i];
 }
 
+template <typename M, typename I, typename O>
+void MaskAdd(const Vector<M> &mask, const Vector<I> &input,
+             Vector<O> &output) {
+    assert(input.impl().length() == output.impl().length());
+    assert(mask.impl().length() == input.impl().length());
+    typename M::ConstIterator pM    = mask.impl().begin();
+    typename M::ConstIterator pMEnd = mask.impl().end();
+    for (size_t i = 0; pM != pMEnd; ++pM, ++i)
+        if (*pM) output.impl()[i] += input.impl()[i];
+}
+
+// Masked operations on whole double vectors, evaluated by VectorKernels.h.
+inline void MaskAssign(const DenseVector<unsigned char> &mask,
+                       const UnaryVectorClosure<OpExp,
+                                                DenseVector<double> > &input,
+                       DenseVector<double> &output) {
+    assert(input.length() == output.length());
+    assert(mask.length() == input.length());
+    VecExpMasked(input.operand().data(), mask.data(), output.data(),
+                 output.length());
+}
+
+inline void MaskAdd(const DenseVector<unsigned char> &mask,
+                    const DenseVector<double> &input,
+                    DenseVector<double> &output) {
+    assert(input.length() == output.length());
+    assert(mask.length() == input.length());
+    VecAddMasked(input.data(), mask.data(), output.data(), output.length());
+}
+
+inline void MaskAdd(const DenseVector<unsigned char> &mask,
+                    const VectorClosure<OpMult, DenseVector<double>,
+                                        Scalar<double> > &input,
+                    DenseVector<double> &output) {
+    assert(input.length() == output.length());
+    assert(mask.length() == input.length());
+    VecMultAddMasked(input.left().data(), (double)input.right(), mask.data(),
+                     output.data(), output.length());
+}
+
 #endif // VECTOROPS_H
@@ -0,0 +1,24 @@
+#!/bin/sh
+
+# Times build/zxingbench over the blackbox corpus and prints one JSON line
+# per image category and one for the whole run. Build with
+#   scons bench STAGE_TIMING=1
+# to get a per-stage breakdown of each decode.
+
+blackboxpath="../core/test/data/blackbox"
+
+if [ "$*" != "" ]; then
+	formats="$*"
+else
+	formats="ean13 ean8 upce upca qrcode aztec"
+fi
+
+files="";
+
+for format in $formats; do
+	for pic in `ls ${blackboxpath}/${format}-*/*.{jpg,JPG,gif,GIF,png,PNG} 2>/dev/null | sort -n`; do
+		files="$files $pic";
+	done
+done
+
+$VALGRIND build/zxingbench --iterations=${ITERATIONS:-10} $files
@@ -0,0 +1,291 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  ReedSolomonBenchmark.cpp
+ *  zxing
+ *
+ *  Copyright 2013 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Times ReedSolomonDecoder, with either algorithm, against the decoder it
+ * replaced, which worked on GenericGFPoly objects and is reproduced below.
+ * Blocks are sized like real QR, Data Matrix and Aztec blocks, and are
+ * decoded clean (syndromes only) and with half their correctable errors.
+ * Every decoded block is checked against the codeword it was made from.
+ *
+ * Usage: rsbench [iterations]
+ */
+
+#include <zxing/common/reedsolomon/ReedSolomonDecoder.h>
+#include <zxing/common/reedsolomon/ReedSolomonException.h>
+#include <zxing/common/reedsolomon/GenericGFPoly.h>
+#include <zxing/common/IllegalArgumentException.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <sys/time.h>
+
+using namespace zxing;
+using std::vector;
+
+namespace {
+
+class LegacyReedSolomonDecoder {
+private:
+  Ref<GenericGF> field;
+
+  vector<Ref<GenericGFPoly> > runEuclideanAlgorithm(Ref<GenericGFPoly> a, Ref<GenericGFPoly> b, int R) {
+    if (a->getDegree() < b->getDegree()) {
+      Ref<GenericGFPoly> tmp = a;
+      a = b;
+      b = tmp;
+    }
+    Ref<GenericGFPoly> rLast(a);
+    Ref<GenericGFPoly> r(b);
+    Ref<GenericGFPoly> tLast(field->getZero());
+    Ref<GenericGFPoly> t(field->getOne());
+    while (r->getDegree() >= R / 2) {
+      Ref<GenericGFPoly> rLastLast(rLast);
+      Ref<GenericGFPoly> tLastLast(tLast);
+      rLast = r;
+      tLast = t;
+      if (rLast->isZero()) {
+        throw ReedSolomonException("r_{i-1} was zero");
+      }
+      r = rLastLast;
+      Ref<GenericGFPoly> q(field->getZero());
+      int denominatorLeadingTerm = rLast->getCoefficient(rLast->getDegree());
+      int dltInverse = field->inverse(denominatorLeadingTerm);
+      while (r->getDegree() >= rLast->getDegree() && !r->isZero()) {
+        int degreeDiff = r->getDegree() - rLast->getDegree();
+        int scale = field->multiply(r->getCoefficient(r->getDegree()), dltInverse);
+        q = q->addOrSubtract(field->buildMonomial(degreeDiff, scale));
+        r = r->addOrSubtract(rLast->multiplyByMonomial(degreeDiff, scale));
+      }
+      t = q->multiply(tLast)->addOrSubtract(tLastLast);
+    }
+    int sigmaTildeAtZero = t->getCoefficient(0);
+    if (sigmaTildeAtZero == 0) {
+      throw ReedSolomonException("sigmaTilde(0) was zero");
+    }
+    int inverse = field->inverse(sigmaTildeAtZero);
+    vector<Ref<GenericGFPoly> > result(2);
+    result[0] = t->multiply(inverse);
+    result[1] = r->multiply(inverse);
+    return result;
+  }
+
+  ArrayRef<int> findErrorLocations(Ref<GenericGFPoly> errorLocator) {
+    int numErrors = errorLocator->getDegree();
+    if (numErrors == 1) {
+      ArrayRef<int> result(new Array<int>(1));
+      result[0] = errorLocator->getCoefficient(1);
+      return result;
+    }
+    ArrayRef<int> result(new Array<int>(numErrors));
+    int e = 0;
+    for (int i = 1; i < field->getSize() && e < numErrors; i++) {
+      if (errorLocator->evaluateAt(i) == 0) {
+        result[e] = field->inverse(i);
+        e++;
+      }
+    }
+    if (e != numErrors) {
+      throw ReedSolomonException("Error locator degree does not match number of roots");
+    }
+    return result;
+  }
+
+  ArrayRef<int> findErrorMagnitudes(Ref<GenericGFPoly> errorEvaluator, ArrayRef<int> errorLocations,
+                                    bool dataMatrix) {
+    int s = errorLocations.size();
+    ArrayRef<int> result(new Array<int>(s));
+    for (int i = 0; i < s; i++) {
+      int xiInverse = field->inverse(errorLocations[i]);
+      int denominator = 1;
+      for (int j = 0; j < s; j++) {
+        if (i != j) {
+          denominator = field->multiply(denominator,
+                                        GenericGF::addOrSubtract(1, field->multiply(errorLocations[j], xiInverse)));
+        }
+      }
+      result[i] = field->multiply(errorEvaluator->evaluateAt(xiInverse), field->inverse(denominator));
+      if (dataMatrix) {
+        result[i] = field->multiply(result[i], xiInverse);
+      }
+    }
+    return result;
+  }
+
+public:
+  LegacyReedSolomonDecoder(Ref<GenericGF> fld) : field(fld) {
+  }
+
+  void decode(ArrayRef<int> received, int twoS) {
+    Ref<GenericGFPoly> poly(new GenericGFPoly(field, received));
+    ArrayRef<int> syndromeCoefficients(new Array<int>(twoS));
+    bool dataMatrix = (field.object_ == GenericGF::DATA_MATRIX_FIELD_256.object_);
+    bool noError = true;
+    for (int i = 0; i < twoS; i++) {
+      int eval = poly->evaluateAt(field->exp(dataMatrix ? i + 1 : i));
+      syndromeCoefficients[syndromeCoefficients->size() - 1 - i] = eval;
+      if (eval != 0) {
+        noError = false;
+      }
+    }
+    if (noError) {
+      return;
+    }
+    Ref<GenericGFPoly> syndrome(new GenericGFPoly(field, syndromeCoefficients));
+    Ref<GenericGFPoly> monomial = field->buildMonomial(twoS, 1);
+    vector<Ref<GenericGFPoly> > sigmaOmega = runEuclideanAlgorithm(monomial, syndrome, twoS);
+    ArrayRef<int> errorLocations = findErrorLocations(sigmaOmega[0]);
+    ArrayRef<int> errorMagnitudes = findErrorMagnitudes(sigmaOmega[1], errorLocations, dataMatrix);
+    for (unsigned i = 0; i < errorLocations->size(); i++) {
+      int position = received->size() - 1 - field->log(errorLocations[i]);
+      if (position < 0 || (size_t)position >= received.size()) {
+        throw IllegalArgumentException("Invalid position (ReedSolomonDecoder)");
+      }
+      received[position] = GenericGF::addOrSubtract(received[position], errorMagnitudes[i]);
+    }
+  }
+};
+
+struct Case {
+  const char* name;
+  Ref<GenericGF> field;
+  int length;
+  int twoS;
+};
+
+double now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*
+ * Systematically encodes random data with the generator whose roots are the
+ * points the decoder evaluates syndromes at: a^1.. for Data Matrix, a^0..
+ * for the other fields.
+ */
+ArrayRef<int> makeCodeword(Case const& c) {
+  bool dataMatrix = (c.field.object_ == GenericGF::DATA_MATRIX_FIELD_256.object_);
+  ArrayRef<int> one(new Array<int>(1));
+  one[0] = 1;
+  Ref<GenericGFPoly> generator(new GenericGFPoly(c.field, one));
+  for (int i = 0; i < c.twoS; i++) {
+    ArrayRef<int> factor(new Array<int>(2));
+    factor[0] = 1;
+    factor[1] = c.field->exp(dataMatrix ? i + 1 : i);
+    generator = generator->multiply(Ref<GenericGFPoly>(new GenericGFPoly(c.field, factor)));
+  }
+  ArrayRef<int> data(new Array<int>(c.length - c.twoS));
+  for (size_t i = 0; i < data->size(); i++) {
+    data[i] = random() % c.field->getSize();
+  }
+  data[0] = 1 + random() % (c.field->getSize() - 1);
+  Ref<GenericGFPoly> info(new GenericGFPoly(c.field, data));
+  Ref<GenericGFPoly> remainder(info->multiplyByMonomial(c.twoS, 1)->divide(generator)[1]);
+  ArrayRef<int> codeword(new Array<int>(c.length));
+  for (size_t i = 0; i < data->size(); i++) {
+    codeword[i] = data[i];
+  }
+  for (int i = 0; i <= remainder->getDegree(); i++) {
+    codeword[c.length - 1 - i] = remainder->getCoefficient(i);
+  }
+  return codeword;
+}
+
+struct Block {
+  ArrayRef<int> codeword;
+  ArrayRef<int> received;
+};
+
+vector<Block> makeBlocks(Case const& c, int errors, int count) {
+  vector<Block> blocks;
+  for (int b = 0; b < count; b++) {
+    Block block;
+    block.codeword = makeCodeword(c);
+    block.received = new Array<int>(block.codeword->values());
+    for (int e = 0; e < errors; e++) {
+      int location = random() % c.length;
+      if (block.received[location] != block.codeword[location]) {
+        e--;
+      } else {
+        block.received[location] ^= 1 + random() % (c.field->getSize() - 1);
+      }
+    }
+    blocks.push_back(block);
+  }
+  return blocks;
+}
+
+template<typename Decoder>
+double timeDecoder(Decoder& decoder, vector<Block>& blocks, int twoS, int iterations) {
+  ArrayRef<int> received(new Array<int>(blocks[0].received->size()));
+  double start = now();
+  for (int i = 0; i < iterations; i++) {
+    Block& block = blocks[i % blocks.size()];
+    received->values() = block.received->values();
+    decoder.decode(received, twoS);
+    for (size_t j = 0; j < received->size(); j++) {
+      if (received[j] != block.codeword[j]) {
+        fprintf(stderr, "block %d decoded wrongly\n", i);
+        exit(1);
+      }
+    }
+  }
+  return (now() - start) / iterations * 1e6;
+}
+
+}
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+  Case cases[] = {
+    { "qr-5-Q", GenericGF::QR_CODE_FIELD_256, 33, 18 },
+    { "qr-40-H", GenericGF::QR_CODE_FIELD_256, 45, 30 },
+    { "qr-40-L", GenericGF::QR_CODE_FIELD_256, 148, 30 },
+    { "datamatrix-52", GenericGF::DATA_MATRIX_FIELD_256, 144, 42 },
+    { "datamatrix-144", GenericGF::DATA_MATRIX_FIELD_256, 218, 62 },
+    { "aztec-param", GenericGF::AZTEC_PARAM, 7, 5 },
+    { "aztec-compact-2", GenericGF::AZTEC_DATA_6, 40, 18 },
+    { "aztec-full-16", GenericGF::AZTEC_DATA_10, 440, 150 },
+    { "aztec-full-32", GenericGF::AZTEC_DATA_12, 1437, 400 }
+  };
+  srandom(1);
+  printf("%-16s %6s %6s %7s %12s %12s %12s\n", "case", "length", "twoS", "errors", "legacy_us",
+         "euclid_us", "bm_us");
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    Case const& c = cases[i];
+    LegacyReedSolomonDecoder legacy(c.field);
+    ReedSolomonDecoder euclidean(c.field);
+    ReedSolomonDecoder berlekampMassey(c.field, ReedSolomonDecoder::BERLEKAMP_MASSEY);
+    int errorCounts[] = { 0, c.twoS / 4 };
+    for (int e = 0; e < 2; e++) {
+      vector<Block> blocks(makeBlocks(c, errorCounts[e], 64));
+      // Fewer rounds for the big Aztec blocks, which take far longer each.
+      int rounds = iterations * 148 / (c.length > 148 ? c.length : 148);
+      double legacyTime = timeDecoder(legacy, blocks, c.twoS, rounds);
+      double euclideanTime = timeDecoder(euclidean, blocks, c.twoS, rounds);
+      double berlekampMasseyTime = timeDecoder(berlekampMassey, blocks, c.twoS, rounds);
+      printf("%-16s %6d %6d %7d %12.2f %12.2f %12.2f\n", c.name, c.length, c.twoS, errorCounts[e],
+             legacyTime, euclideanTime, berlekampMasseyTime);
+    }
+  }
+  return 0;
+}
@@ -52,10 +52,14 @@ const DecodeHints DecodeHints::DEFAULT_HINT(
 
 DecodeHints::DecodeHints() {
   hints = 0;
+  maxWorkers = 1;
+  timeLimit = 0;
 }
 
 DecodeHints::DecodeHints(DecodeHintType init) {
   hints = init;
+  maxWorkers = 1;
+  timeLimit = 0;
 }
 
 void DecodeHints::addFormat(BarcodeFormat toadd) {
@@ -112,4 +116,34 @@ Ref<ResultPointCallback> DecodeHints::getResultPointCallback() const {
     return callback;
 }
 
+void DecodeHints::setMaxWorkers(int workers) {
+  maxWorkers = workers < 1 ? 1 : workers;
+}
+
+int DecodeHints::getMaxWorkers() const {
+  return maxWorkers;
+}
+
+void DecodeHints::setTimeLimit(int milliseconds) {
+  timeLimit = milliseconds < 0 ? 0 : milliseconds;
+}
+
+int DecodeHints::getTimeLimit() const {
+  return timeLimit;
+}
+
+void DecodeHints::setDeadline(Ref<Deadline> const& _deadline) {
+  deadline = _deadline;
+}
+
+Ref<Deadline> DecodeHints::getDeadline() const {
+  return deadline;
+}
+
+void DecodeHints::checkDeadline() const {
+  if (!deadline.empty()) {
+    deadline->check();
+  }
+}
+
 } /* namespace */
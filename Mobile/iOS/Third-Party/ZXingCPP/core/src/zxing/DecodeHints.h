@@ -21,6 +21,7 @@
 
 #include <zxing/BarcodeFormat.h>
 #include <zxing/ResultPointCallback.h>
+#include <zxing/common/Deadline.h>
 
 namespace zxing {
 
@@ -34,6 +35,12 @@ class DecodeHints {
 
   Ref<ResultPointCallback> callback;
 
+  int maxWorkers;
+
+  int timeLimit;
+
+  Ref<Deadline> deadline;
+
  public:
 
   static const DecodeHintType BARCODEFORMAT_QR_CODE_HINT = 1 << BarcodeFormat_QR_CODE;
@@ -64,6 +71,22 @@ class DecodeHints {
   void setResultPointCallback(Ref<ResultPointCallback> const&);
   Ref<ResultPointCallback> getResultPointCallback() const;
 
+  // Lets MultiFormatReader run its format readers on up to this many
+  // threads at once. 1, the default, keeps decoding on the calling thread.
+  void setMaxWorkers(int workers);
+  int getMaxWorkers() const;
+
+  // Milliseconds MultiFormatReader may spend on one image before giving up;
+  // 0, the default, means no limit.
+  void setTimeLimit(int milliseconds);
+  int getTimeLimit() const;
+
+  // The deadline readers poll while scanning. MultiFormatReader installs one
+  // per decode; readers used directly may be handed one too.
+  void setDeadline(Ref<Deadline> const&);
+  Ref<Deadline> getDeadline() const;
+  void checkDeadline() const;
+
 };
 
 }
@@ -30,6 +30,14 @@ LuminanceSource::LuminanceSource() {
 LuminanceSource::~LuminanceSource() {
 }
 
+bool LuminanceSource::isViewSupported() const {
+  return false;
+}
+
+LuminanceView LuminanceSource::getView() const {
+  throw IllegalArgumentException("This luminance source does not support views.");
+}
+
 bool LuminanceSource::isCropSupported() const {
   return false;
 }
@@ -25,6 +25,38 @@
 
 namespace zxing {
 
+/*
+ * A borrowed, read-only window onto luminance bytes owned by someone else,
+ * typically a camera frame or the Y plane of a YUV buffer. Pixel (x, y) lives
+ * at data[y * rowStride + x * pixelStride]; either stride may be negative,
+ * which is how crops and rotations are described without copying.
+ */
+struct LuminanceView {
+  const unsigned char* data;
+  int width;
+  int height;
+  int pixelStride;
+  int rowStride;
+
+  LuminanceView() :
+      data(0), width(0), height(0), pixelStride(1), rowStride(0) {
+  }
+  LuminanceView(const unsigned char* d, int w, int h, int ps, int rs) :
+      data(d), width(w), height(h), pixelStride(ps), rowStride(rs) {
+  }
+
+  // True when every row is a run of adjacent bytes and can be read in place.
+  bool isContiguous() const {
+    return pixelStride == 1;
+  }
+  const unsigned char* row(int y) const {
+    return data + y * rowStride;
+  }
+  unsigned char get(int x, int y) const {
+    return data[y * rowStride + x * pixelStride];
+  }
+};
+
 class LuminanceSource : public Counted {
 public:
   LuminanceSource();
@@ -37,6 +69,11 @@ public:
   virtual unsigned char* getRow(int y, unsigned char* row) = 0;
   virtual unsigned char* getMatrix() = 0;
 
+  // Sources backed by caller-owned memory can expose it directly. The view
+  // is only valid while both this source and the underlying buffer are.
+  virtual bool isViewSupported() const;
+  virtual LuminanceView getView() const;
+
   virtual bool isCropSupported() const;
   virtual Ref<LuminanceSource> crop(int left, int top, int width, int height);
 
@@ -26,8 +26,64 @@
 #include <zxing/oned/MultiFormatUPCEANReader.h>
 #include <zxing/oned/MultiFormatOneDReader.h>
 #include <zxing/ReaderException.h>
+#include <zxing/common/IllegalArgumentException.h>
+
+#include <string>
 
 namespace zxing {
+  namespace {
+    // State shared by the readers of one parallel decode.
+    struct ParallelDecode {
+      Ref<BinaryBitmap> image;
+      DecodeHints hints;
+      pthread_mutex_t mutex;
+      Ref<Result> result;
+      bool failed;
+      bool illegalArgument;
+      std::string error;
+    };
+
+    class ReaderTask : public WorkerPool::Task {
+    private:
+      Reader* reader_;
+      ParallelDecode* decode_;
+
+      void fail(bool illegalArgument, const char* error) {
+        pthread_mutex_lock(&decode_->mutex);
+        if (!decode_->failed) {
+          decode_->failed = true;
+          decode_->illegalArgument = illegalArgument;
+          decode_->error = error;
+        }
+        pthread_mutex_unlock(&decode_->mutex);
+      }
+
+    public:
+      ReaderTask(Reader* reader, ParallelDecode* decode) :
+          reader_(reader), decode_(decode) {
+      }
+
+      void run() {
+        try {
+          Ref<Result> result(reader_->decode(decode_->image, decode_->hints));
+          pthread_mutex_lock(&decode_->mutex);
+          if (decode_->result.empty()) {
+            decode_->result = result;
+          }
+          pthread_mutex_unlock(&decode_->mutex);
+          // First one wins; the other readers give up at their next check.
+          decode_->hints.getDeadline()->expire();
+        } catch (ReaderException const& re) {
+          // another reader may still find it
+        } catch (IllegalArgumentException const& iae) {
+          fail(true, iae.what());
+        } catch (Exception const& e) {
+          fail(false, e.what());
+        }
+      }
+    };
+  }
+
   MultiFormatReader::MultiFormatReader() {
 
   }
@@ -90,15 +146,79 @@ namespace zxing {
   }
 
   Ref<Result> MultiFormatReader::decodeInternal(Ref<BinaryBitmap> image) {
+    DecodeHints hints(hints_);
+    bool parallel = hints.getMaxWorkers() > 1 && readers_.size() > 1;
+    if (parallel || hints.getTimeLimit() > 0) {
+      hints.setDeadline(Ref<Deadline>(new Deadline(hints.getTimeLimit())));
+    }
+    if (parallel) {
+      // Binarize once, up front, so the readers only ever read the shared
+      // matrix. If that fails let the readers deal with it one at a time,
+      // as the one-dimensional readers may still manage row by row.
+      bool binarized = false;
+      try {
+        image->getBlackMatrix();
+        binarized = true;
+      } catch (Exception const& e) {
+        // fall through to the serial path
+      }
+      if (binarized) {
+        return decodeParallel(image, hints);
+      }
+    }
     for (unsigned int i = 0; i < readers_.size(); i++) {
       try {
-        return readers_[i]->decode(image, hints_);
+        return readers_[i]->decode(image, hints);
       } catch (ReaderException const& re) {
         // continue
       }
     }
     throw ReaderException("No code detected");
   }
+
+  /*
+   * Runs every reader at once on the shared, already binarized image. The
+   * first reader to succeed expires the deadline, which the others poll
+   * between scan rows, so a frame without a barcode costs about as much as
+   * its slowest reader instead of all of them together.
+   */
+  Ref<Result> MultiFormatReader::decodeParallel(Ref<BinaryBitmap> image, DecodeHints const& hints) {
+    int threads = hints.getMaxWorkers();
+    if (threads > (int)readers_.size()) {
+      threads = readers_.size();
+    }
+    if (pool_.empty() || pool_->getThreads() != threads) {
+      pool_ = new WorkerPool(threads);
+    }
+
+    ParallelDecode decode;
+    decode.image = image;
+    decode.hints = hints;
+    decode.failed = false;
+    decode.illegalArgument = false;
+    pthread_mutex_init(&decode.mutex, 0);
+
+    std::vector<ReaderTask> tasks;
+    tasks.reserve(readers_.size());
+    std::vector<WorkerPool::Task*> taskPointers;
+    for (unsigned int i = 0; i < readers_.size(); i++) {
+      tasks.push_back(ReaderTask(readers_[i], &decode));
+      taskPointers.push_back(&tasks.back());
+    }
+    pool_->run(taskPointers);
+    pthread_mutex_destroy(&decode.mutex);
+
+    if (!decode.result.empty()) {
+      return decode.result;
+    }
+    if (decode.failed) {
+      if (decode.illegalArgument) {
+        throw IllegalArgumentException(decode.error.c_str());
+      }
+      throw Exception(decode.error.c_str());
+    }
+    throw ReaderException("No code detected");
+  }
   
   MultiFormatReader::~MultiFormatReader() {
 
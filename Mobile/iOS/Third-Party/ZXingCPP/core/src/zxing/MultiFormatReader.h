@@ -25,15 +25,18 @@
 #include <zxing/common/BitArray.h>
 #include <zxing/Result.h>
 #include <zxing/DecodeHints.h>
+#include <zxing/common/WorkerPool.h>
 
 namespace zxing {
   class MultiFormatReader : public Reader {
     
   private:
     Ref<Result> decodeInternal(Ref<BinaryBitmap> image);
+    Ref<Result> decodeParallel(Ref<BinaryBitmap> image, DecodeHints const& hints);
   
     std::vector<Ref<Reader> > readers_;
     DecodeHints hints_;
+    Ref<WorkerPool> pool_;
 
   public:
     MultiFormatReader();
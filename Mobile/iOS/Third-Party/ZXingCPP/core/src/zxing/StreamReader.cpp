@@ -0,0 +1,210 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  StreamReader.cpp
+ *  ZXing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/StreamReader.h>
+#include <zxing/Exception.h>
+#include <zxing/ResultPoint.h>
+#include <zxing/ResultPointCallback.h>
+#include <zxing/common/DecodeArena.h>
+#include <zxing/common/DetectorResult.h>
+#include <zxing/qrcode/detector/Detector.h>
+#include <zxing/qrcode/detector/FinderPattern.h>
+#include <zxing/qrcode/detector/FinderPatternInfo.h>
+#include <algorithm>
+
+namespace zxing {
+
+using namespace std;
+
+namespace {
+
+// Passes points found in a region on to the caller's callback in frame
+// coordinates, the coordinates results are returned in.
+class RegionResultPointCallback : public ResultPointCallback {
+private:
+  Ref<ResultPointCallback> callback_;
+  int left_;
+  int top_;
+
+public:
+  RegionResultPointCallback(Ref<ResultPointCallback> callback, int left, int top) :
+      callback_(callback), left_(left), top_(top) {
+  }
+
+  void foundPossibleResultPoint(ResultPoint const& point) {
+    callback_->foundPossibleResultPoint(ResultPoint(point.getX() + left_, point.getY() + top_));
+  }
+};
+
+}
+
+StreamReader::StreamReader(Reader& delegate) :
+    delegate_(delegate), qrDecoder_(), tracking_(false), format_(BarcodeFormat_None),
+    left_(0), top_(0), right_(0), bottom_(0) {
+}
+
+StreamReader::~StreamReader() {
+}
+
+Ref<Result> StreamReader::decode(Ref<BinaryBitmap> image) {
+  return decode(image, DecodeHints::DEFAULT_HINT);
+}
+
+Ref<Result> StreamReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
+  if (tracking_) {
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+    bool cropped = cropRegion(image, left, top, width, height);
+    Ref<BinaryBitmap> region(image);
+    DecodeHints regionHints(hints);
+    if (cropped) {
+      region = image->crop(left, top, width, height);
+      if (!hints.getResultPointCallback().empty()) {
+        regionHints.setResultPointCallback(Ref<ResultPointCallback>(
+            new RegionResultPointCallback(hints.getResultPointCallback(), left, top)));
+      }
+    } else {
+      left = 0;
+      top = 0;
+    }
+
+    if (format_ == BarcodeFormat_QR_CODE && points_.size() >= 3 &&
+        hints.containsFormat(BarcodeFormat_QR_CODE)) {
+      try {
+        return track(decodeTrackedQRCode(region, regionHints, left, top), left, top);
+      } catch (Exception const&) {
+        // The symbol has moved too far to resample it in place.
+      }
+    }
+    if (cropped) {
+      try {
+        return track(delegate_.decode(region, regionHints), left, top);
+      } catch (Exception const&) {
+        // It is no longer near where it was.
+      }
+    }
+  }
+
+  tracking_ = false;
+  return track(delegate_.decode(image, hints), 0, 0);
+}
+
+bool StreamReader::isTracking() const {
+  return tracking_;
+}
+
+void StreamReader::reset() {
+  tracking_ = false;
+  format_ = BarcodeFormat_None;
+  points_.clear();
+}
+
+bool StreamReader::cropRegion(Ref<BinaryBitmap> image, int& left, int& top, int& width, int& height) const {
+  if (!image->isCropSupported()) {
+    return false;
+  }
+  int imageWidth = image->getWidth();
+  int imageHeight = image->getHeight();
+  // Leave room for the symbol to move by half its size between frames.
+  // A 1D symbol's points lie on one row, so its region is a wide band.
+  int margin = max(right_ - left_, bottom_ - top_) / 2 + MIN_MARGIN;
+  left = max(0, left_ - margin);
+  top = max(0, top_ - margin);
+  int right = min(imageWidth, right_ + margin + 1);
+  int bottom = min(imageHeight, bottom_ + margin + 1);
+  width = right - left;
+  height = bottom - top;
+  if (width <= 0 || height <= 0) {
+    return false;
+  }
+  // A region not much smaller than the frame saves little, and decoding it
+  // before the frame would repeat most of the work if it fails.
+  return (long)width * height * 5 < (long)imageWidth * imageHeight * 3;
+}
+
+/*
+ * TRY_HARDER only widens the finder pattern search, which this skips; the
+ * delegate gets it when resampling fails. As in QRCodeReader, points handed
+ * to a ResultPointCallback must outlive the decode, so no arena is used then.
+ */
+Ref<Result> StreamReader::decodeTrackedQRCode(Ref<BinaryBitmap> image, DecodeHints const& hints,
+                                              int left, int top) {
+  Ref<BitMatrix> matrix(image->getBlackMatrix());
+  DecodeArena::Scope arena(hints.getResultPointCallback().empty());
+
+  // Result points of a QR Code are its bottom left, top left and top right
+  // finder pattern centers, the order FinderPatternInfo takes them in. The
+  // detector re-estimates module size from the image, so 1 will do here.
+  vector<Ref<qrcode::FinderPattern> > patterns;
+  for (int i = 0; i < 3; i++) {
+    patterns.push_back(Ref<qrcode::FinderPattern>(
+        new qrcode::FinderPattern(points_[i]->getX() - left, points_[i]->getY() - top, 1.0f)));
+  }
+  Ref<qrcode::FinderPatternInfo> info(new qrcode::FinderPatternInfo(patterns));
+
+  qrcode::Detector detector(matrix);
+  Ref<DetectorResult> detectorResult(detector.processFinderPatternInfo(info, hints));
+  Ref<DecoderResult> decoderResult(qrDecoder_.decode(detectorResult->getBits()));
+  Ref<Result> result(new Result(decoderResult->getText(), decoderResult->getRawBytes(),
+                                detectorResult->getPoints(), BarcodeFormat_QR_CODE));
+  return arena.keep(result);
+}
+
+Ref<Result> StreamReader::track(Ref<Result> result, int left, int top) {
+  vector<Ref<ResultPoint> >& points(result->getResultPoints());
+  if (points.empty()) {
+    // Nothing to follow into the next frame.
+    tracking_ = false;
+    return result;
+  }
+
+  vector<Ref<ResultPoint> > framePoints;
+  float minX = points[0]->getX() + left;
+  float minY = points[0]->getY() + top;
+  float maxX = minX;
+  float maxY = minY;
+  for (size_t i = 0; i < points.size(); i++) {
+    float x = points[i]->getX() + left;
+    float y = points[i]->getY() + top;
+    framePoints.push_back(Ref<ResultPoint>(new ResultPoint(x, y)));
+    minX = min(minX, x);
+    minY = min(minY, y);
+    maxX = max(maxX, x);
+    maxY = max(maxY, y);
+  }
+
+  tracking_ = true;
+  format_ = result->getBarcodeFormat();
+  points_ = framePoints;
+  left_ = (int)minX;
+  top_ = (int)minY;
+  right_ = (int)(maxX + 0.5f);
+  bottom_ = (int)(maxY + 0.5f);
+
+  if (left == 0 && top == 0) {
+    return result;
+  }
+  return Ref<Result>(new Result(result->getText(), result->getRawBytes(), framePoints,
+                                result->getBarcodeFormat()));
+}
+
+}
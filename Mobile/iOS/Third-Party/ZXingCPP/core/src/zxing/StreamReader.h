@@ -0,0 +1,78 @@
+#ifndef __STREAM_READER_H__
+#define __STREAM_READER_H__
+
+/*
+ *  StreamReader.h
+ *  ZXing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/Reader.h>
+#include <zxing/Result.h>
+#include <zxing/DecodeHints.h>
+#include <zxing/qrcode/decoder/Decoder.h>
+#include <vector>
+
+namespace zxing {
+
+/*
+ * Decodes successive frames of a video stream, carrying what was found in
+ * one frame over to the next. After a frame decodes, the next one is tried
+ * in a region around the previous symbol first: a QR Code is resampled
+ * with the previous frame's finder patterns, skipping the finder search,
+ * and any other symbol (or a QR Code that has moved too far) is decoded by
+ * the delegate in the region alone. Only when that fails is the whole frame
+ * given to the delegate, and only when that fails too is tracking lost.
+ *
+ * A StreamReader keeps per-stream state, so use one per camera and call it
+ * from one thread at a time. The region is cropped from the BinaryBitmap,
+ * so frames whose luminance source cannot crop are always decoded whole.
+ */
+class StreamReader : public Reader {
+private:
+  Reader& delegate_;
+  qrcode::Decoder qrDecoder_;
+
+  bool tracking_;
+  BarcodeFormat format_;
+  std::vector<Ref<ResultPoint> > points_;
+  int left_;
+  int top_;
+  int right_;
+  int bottom_;
+
+  static const int MIN_MARGIN = 16;
+
+  bool cropRegion(Ref<BinaryBitmap> image, int& left, int& top, int& width, int& height) const;
+  Ref<Result> decodeTrackedQRCode(Ref<BinaryBitmap> image, DecodeHints const& hints, int left, int top);
+  Ref<Result> track(Ref<Result> result, int left, int top);
+
+public:
+  StreamReader(Reader& delegate);
+  virtual ~StreamReader();
+
+  virtual Ref<Result> decode(Ref<BinaryBitmap> image);
+  virtual Ref<Result> decode(Ref<BinaryBitmap> image, DecodeHints hints);
+
+  // True if the last frame decoded, so the next one will be tried near it.
+  bool isTracking() const;
+  // Forgets the previous frame, e.g. when the camera is switched.
+  void reset();
+};
+
+}
+
+#endif // __STREAM_READER_H__
@@ -47,8 +47,9 @@ namespace zxing {
       return result;
     }
         
-    Ref<Result> AztecReader::decode(Ref<BinaryBitmap> image, DecodeHints) {
+    Ref<Result> AztecReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
       //cout << "decoding with hints not supported for aztec" << "\n" << flush;
+      hints.checkDeadline();
       return this->decode(image);
     }
         
@@ -29,6 +29,7 @@
 #include <zxing/common/reedsolomon/ReedSolomonException.h>
 #include <zxing/common/reedsolomon/GenericGF.h>
 #include <zxing/common/IllegalArgumentException.h>
+#include <zxing/common/StageTimer.h>
 
 using zxing::aztec::Decoder;
 using zxing::DecoderResult;
@@ -174,6 +175,7 @@ Ref<DecoderResult> Decoder::decode(Ref<zxing::aztec::AztecDetectorResult> detect
 }
         
 Ref<String> Decoder::getEncodedData(Ref<zxing::BitArray> correctedBits) {
+  StageTimer timer(StageTimer::PARSE);
   int endIndex = codewordSize_ * ddata_->getNBDatablocks() - invertedBitCount_;
   if (endIndex > (int)correctedBits->getSize()) {
     // std::printf("invalid input\n");
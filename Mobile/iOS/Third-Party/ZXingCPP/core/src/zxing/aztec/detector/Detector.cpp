@@ -28,6 +28,7 @@
 #include <iostream>
 #include <zxing/common/detector/math_utils.h>
 #include <zxing/NotFoundException.h>
+#include <zxing/common/StageTimer.h>
 
 using zxing::aztec::Detector;
 using zxing::aztec::Point;
@@ -47,6 +48,7 @@ Detector::Detector(Ref<BitMatrix> image):
 }
         
 Ref<AztecDetectorResult> Detector::detect() {
+  StageTimer timer(StageTimer::DETECT);
   Ref<Point> pCenter = getMatrixCenter();
             
   std::vector<Ref<Point> > bullEyeCornerPoints = getBullEyeCornerPoints(pCenter);
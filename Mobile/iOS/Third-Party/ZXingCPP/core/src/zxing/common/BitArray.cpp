@@ -38,6 +38,45 @@ size_t BitArray::getSize() {
   return size_;
 }
 
+int BitArray::getNextSet(int from) {
+  if (from < 0) {
+    from = 0;
+  }
+  if ((size_t)from >= size_) {
+    return size_;
+  }
+  size_t word = from >> logBits_;
+  // Mask off the bits before from
+  unsigned int currentBits = bits_[word] & (~0u << (from & bitsMask_));
+  while (currentBits == 0) {
+    if (++word == bits_.size()) {
+      return size_;
+    }
+    currentBits = bits_[word];
+  }
+  size_t result = (word << logBits_) + __builtin_ctz(currentBits);
+  return result > size_ ? size_ : result;
+}
+
+int BitArray::getNextUnset(int from) {
+  if (from < 0) {
+    from = 0;
+  }
+  if ((size_t)from >= size_) {
+    return size_;
+  }
+  size_t word = from >> logBits_;
+  unsigned int currentBits = ~bits_[word] & (~0u << (from & bitsMask_));
+  while (currentBits == 0) {
+    if (++word == bits_.size()) {
+      return size_;
+    }
+    currentBits = ~bits_[word];
+  }
+  size_t result = (word << logBits_) + __builtin_ctz(currentBits);
+  return result > size_ ? size_ : result;
+}
+
 void BitArray::setBulk(size_t i, unsigned int newBits) {
   bits_[i >> logBits_] = newBits;
 }
@@ -57,6 +57,12 @@ public:
     bits_[i >> logBits_] |= 1 << (i & bitsMask_);
   }
 
+  // Index of the first set (or unset) bit at or after from, or getSize()
+  // if there is none. Scans a word at a time, so callers can step over a
+  // whole run of black or white pixels in one call.
+  int getNextSet(int from);
+  int getNextUnset(int from);
+
   void setBulk(size_t i, unsigned int newBits);
   void setRange(int start, int end);
   void clear();
@@ -92,32 +92,29 @@ void BitMatrix::setRegion(size_t left, size_t top, size_t width, size_t height)
 Ref<BitArray> BitMatrix::getRow(int y, Ref<BitArray> row) {
   if (row.empty() || row->getSize() < width_) {
     row = new BitArray(width_);
-  } else {
-    row->clear();
   }
+  // Rows are packed end to end, so each word of the row straddles two
+  // words of the matrix unless the row happens to start on a boundary.
   size_t start = y * width_;
-  size_t end = start + width_ - 1; // end is inclusive
   size_t firstWord = start >> logBits;
-  size_t lastWord = end >> logBits;
   size_t bitOffset = start & bitsMask;
-  for (size_t i = firstWord; i <= lastWord; i++) {
-    size_t firstBit = i > firstWord ? 0 : start & bitsMask;
-    size_t lastBit = i < lastWord ? bitsPerWord - 1 : end & bitsMask;
-    unsigned int mask;
-    if (firstBit == 0 && lastBit == logBits) {
-      mask = std::numeric_limits<unsigned int>::max();
-    } else {
-      mask = 0;
-      for (size_t j = firstBit; j <= lastBit; j++) {
-        mask |= 1 << j;
-      }
-    }
-    row->setBulk((i - firstWord) << logBits, (bits_[i] & mask) >> bitOffset);
-    if (firstBit == 0 && bitOffset != 0) {
-      unsigned int prevBulk = row->getBitArray()[i - firstWord - 1];
-      prevBulk |= (bits_[i] & mask) << (bitsPerWord - bitOffset);
-      row->setBulk((i - firstWord - 1) << logBits, prevBulk);
+  size_t rowWords = (width_ + bitsPerWord - 1) >> logBits;
+  std::vector<unsigned int>& rowBits = row->getBitArray();
+  for (size_t i = 0; i < rowWords; i++) {
+    unsigned int bits = bits_[firstWord + i] >> bitOffset;
+    if (bitOffset != 0 && firstWord + i + 1 < words_) {
+      bits |= bits_[firstWord + i + 1] << (bitsPerWord - bitOffset);
     }
+    rowBits[i] = bits;
+  }
+  // Clear what followed the row in the matrix, and anything left over in a
+  // longer row from an earlier call.
+  size_t lastBits = width_ & bitsMask;
+  if (lastBits != 0) {
+    rowBits[rowWords - 1] &= (1u << lastBits) - 1;
+  }
+  for (size_t i = rowWords; i < rowBits.size(); i++) {
+    rowBits[i] = 0;
   }
   return row;
 }
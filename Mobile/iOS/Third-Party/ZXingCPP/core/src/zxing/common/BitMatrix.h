@@ -63,6 +63,17 @@ public:
     bits_[offset >> logBits] |= 1 << (offset & bitsMask);
   }
 
+  // ORs a word of packed pixels into row y, starting at column x. Bits past
+  // the end of the row must be zero.
+  void setBulk(size_t x, size_t y, unsigned int newBits) {
+    size_t offset = x + width_ * y;
+    size_t shift = offset & bitsMask;
+    bits_[offset >> logBits] |= newBits << shift;
+    if (shift != 0 && (newBits >> (bitsPerWord - shift)) != 0) {
+      bits_[(offset >> logBits) + 1] |= newBits >> (bitsPerWord - shift);
+    }
+  }
+
   void flip(size_t x, size_t y);
   void clear();
   void setRegion(size_t left, size_t top, size_t width, size_t height);
@@ -21,6 +21,7 @@
 //#define DEBUG_COUNTING
 
 #include <iostream>
+#include <cstddef>
 
 #ifdef DEBUG_COUNTING
 #include <typeinfo>
@@ -28,13 +29,40 @@
 
 namespace zxing {
 
-/* base class for reference-counted objects */
+/*
+ * base class for reference-counted objects. Counts are updated atomically so that objects shared by readers running
+ * on different threads (see MultiFormatReader's parallel mode) can be
+ * retained and released concurrently. Define ZXING_SINGLE_THREADED to use
+ * plain increments when the library is only ever used from one thread.
+ *
+ * Define ZXING_DECODE_ARENA to let readers allocate from a DecodeArena:
+ * objects created while a DecodeArena::Scope is open on the thread are
+ * owned by the arena, never counted, and all freed when the scope closes.
+ */
 class Counted {
 private:
-  unsigned int count_;
+  volatile unsigned int count_;
+#ifdef ZXING_DECODE_ARENA
+  static const unsigned int ARENA_OWNED = 0xA7E4A0u;
+  // Defined in DecodeArena.cpp; true if the arena allocated this object.
+  bool adoptedByArena();
+  bool ownedByArena() const {
+#ifdef ZXING_SINGLE_THREADED
+    return count_ == ARENA_OWNED;
+#else
+    // Other threads may be counting a heap object while we look.
+    return __atomic_load_n(&count_, __ATOMIC_RELAXED) == ARENA_OWNED;
+#endif
+  }
+#endif
 public:
   Counted() :
       count_(0) {
+#ifdef ZXING_DECODE_ARENA
+    if (adoptedByArena()) {
+      count_ = ARENA_OWNED;
+    }
+#endif
 #ifdef DEBUG_COUNTING
     cout << "instantiating " << typeid(*this).name() << " " << this <<
          " @ " << count_ << "\n";
@@ -42,33 +70,66 @@ public:
   }
   virtual ~Counted() {
   }
+#ifdef ZXING_DECODE_ARENA
+  // A copy is a new object: its count and owner are its own.
+  Counted(const Counted&) :
+      count_(0) {
+    if (adoptedByArena()) {
+      count_ = ARENA_OWNED;
+    }
+  }
+  Counted& operator=(const Counted&) {
+    return *this;
+  }
+  static void* operator new(size_t size);
+  static void operator delete(void* object, size_t size);
+#endif
   Counted *retain() {
+#ifdef ZXING_DECODE_ARENA
+    if (ownedByArena()) {
+      return this;
+    }
+#endif
 #ifdef DEBUG_COUNTING
     cout << "retaining " << typeid(*this).name() << " " << this <<
          " @ " << count_;
 #endif
+#ifdef ZXING_SINGLE_THREADED
     count_++;
+#else
+    __sync_add_and_fetch(&count_, 1);
+#endif
 #ifdef DEBUG_COUNTING
     cout << "->" << count_ << "\n";
 #endif
     return this;
   }
   void release() {
+#ifdef ZXING_DECODE_ARENA
+    if (ownedByArena()) {
+      return;
+    }
+#endif
 #ifdef DEBUG_COUNTING
     cout << "releasing " << typeid(*this).name() << " " << this <<
          " @ " << count_;
 #endif
-    if (count_ == 0 || count_ == 54321) {
+#ifdef ZXING_SINGLE_THREADED
+    unsigned int count = count_--;
+#else
+    unsigned int count = __sync_fetch_and_sub(&count_, 1);
+#endif
+    if (count == 0 || count == 54321) {
 #ifdef DEBUG_COUNTING
       cout << "\nOverreleasing already-deleted object " << this << "!!!\n";
 #endif
       throw 4711;
     }
-    count_--;
+    count--;
 #ifdef DEBUG_COUNTING
-    cout << "->" << count_ << "\n";
+    cout << "->" << count << "\n";
 #endif
-    if (count_ == 0) {
+    if (count == 0) {
 #ifdef DEBUG_COUNTING
       cout << "deleting " << typeid(*this).name() << " " << this << "\n";
 #endif
@@ -0,0 +1,59 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  Deadline.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Deadline.h>
+#include <zxing/ReaderException.h>
+
+#include <sys/time.h>
+
+using zxing::Deadline;
+
+namespace {
+  long long now() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+  }
+}
+
+Deadline::Deadline(int milliseconds) :
+    limit_(milliseconds > 0 ? now() + (long long)milliseconds * 1000 : 0), expired_(0) {
+}
+
+void Deadline::expire() {
+  __sync_lock_test_and_set(&expired_, 1);
+}
+
+bool Deadline::hasExpired() {
+  if (__sync_fetch_and_or(&expired_, 0) != 0) {
+    return true;
+  }
+  if (limit_ != 0 && now() >= limit_) {
+    expire();
+    return true;
+  }
+  return false;
+}
+
+void Deadline::check() {
+  if (hasExpired()) {
+    throw ReaderException("Decode deadline expired");
+  }
+}
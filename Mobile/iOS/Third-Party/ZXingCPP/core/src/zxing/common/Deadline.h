@@ -0,0 +1,50 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __DEADLINE_H__
+#define __DEADLINE_H__
+
+/*
+ *  Deadline.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Counted.h>
+
+namespace zxing {
+
+/*
+ * A point in time after which a decode attempt should give up. Readers poll
+ * it between rows of their scans through check(), which throws a
+ * ReaderException once the time is up. expire() ends it early; that is how
+ * the first reader to succeed stops the others.
+ */
+class Deadline : public Counted {
+private:
+  long long limit_; // microseconds since the epoch, 0 for no time limit
+  volatile int expired_;
+
+public:
+  // A milliseconds value of 0 means the deadline only ends through expire().
+  Deadline(int milliseconds);
+
+  void expire();
+  bool hasExpired();
+  void check();
+};
+
+}
+
+#endif // __DEADLINE_H__
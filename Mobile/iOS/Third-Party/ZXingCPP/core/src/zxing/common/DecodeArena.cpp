@@ -0,0 +1,237 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  DecodeArena.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/DecodeArena.h>
+#include <zxing/Result.h>
+#include <new>
+
+namespace zxing {
+
+// Zero-initialized before any constructor runs, so Counted objects built
+// during static initialization never look for an arena.
+pthread_key_t DecodeArena::threadKey_;
+bool DecodeArena::threadKeyCreated_ = DecodeArena::createThreadKey();
+
+bool DecodeArena::createThreadKey() {
+  return pthread_key_create(&threadKey_, &DecodeArena::destroy) == 0;
+}
+
+DecodeArena* DecodeArena::forThread() {
+  if (!threadKeyCreated_) {
+    return 0;
+  }
+  DecodeArena* arena = static_cast<DecodeArena*>(pthread_getspecific(threadKey_));
+  if (arena == 0) {
+    arena = new DecodeArena();
+    pthread_setspecific(threadKey_, arena);
+  }
+  return arena;
+}
+
+void DecodeArena::destroy(void* arena) {
+  delete static_cast<DecodeArena*>(arena);
+}
+
+DecodeArena* DecodeArena::current() {
+  if (!threadKeyCreated_) {
+    return 0;
+  }
+  DecodeArena* arena = static_cast<DecodeArena*>(pthread_getspecific(threadKey_));
+  return arena != 0 && arena->active_ ? arena : 0;
+}
+
+DecodeArena::DecodeArena() :
+    block_(0), next_(0), open_(false), active_(false) {
+}
+
+DecodeArena::~DecodeArena() {
+  reset();
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    delete[] blocks_[i].begin;
+  }
+}
+
+void* DecodeArena::allocate(size_t size) {
+  // Keep every object aligned as operator new would.
+  size = (size + 15) & ~(size_t)15;
+  char* p;
+  if (size > BLOCK_SIZE / 4) {
+    p = static_cast<char*>(::operator new(size));
+    large_.push_back(p);
+  } else {
+    if (blocks_.empty() || next_ + size > blocks_[block_].end) {
+      if (blocks_.empty() || block_ + 1 == blocks_.size()) {
+        Block block;
+        block.begin = new char[BLOCK_SIZE];
+        block.end = block.begin + BLOCK_SIZE;
+        blocks_.push_back(block);
+        block_ = blocks_.size() - 1;
+      } else {
+        block_++;
+      }
+      next_ = blocks_[block_].begin;
+    }
+    p = next_;
+    next_ += size;
+  }
+  Block allocation;
+  allocation.begin = p;
+  allocation.end = p + size;
+  unadopted_.push_back(allocation);
+  return p;
+}
+
+bool DecodeArena::deallocate(void* p, size_t size) {
+  char* begin = static_cast<char*>(p);
+  bool owned = false;
+  for (size_t i = 0; i < large_.size() && !owned; i++) {
+    owned = large_[i] == begin;
+  }
+  for (size_t i = 0; i <= block_ && i < blocks_.size() && !owned; i++) {
+    owned = begin >= blocks_[i].begin && begin < blocks_[i].end;
+  }
+  if (!owned) {
+    return false;
+  }
+  char* end = begin + size;
+  for (size_t i = unadopted_.size(); i-- > 0;) {
+    if (unadopted_[i].begin == begin) {
+      unadopted_.erase(unadopted_.begin() + i);
+    }
+  }
+  for (size_t i = objects_.size(); i-- > 0;) {
+    char* object = reinterpret_cast<char*>(objects_[i]);
+    if (object >= begin && object < end) {
+      objects_.erase(objects_.begin() + i);
+    }
+  }
+  return true;
+}
+
+bool DecodeArena::adopt(Counted* object) {
+  // Searching newest first finds the allocation a new-expression has just
+  // made; members of an object adopted already find nothing.
+  char* p = reinterpret_cast<char*>(object);
+  for (size_t i = unadopted_.size(); i-- > 0;) {
+    if (p >= unadopted_[i].begin && p < unadopted_[i].end) {
+      unadopted_.erase(unadopted_.begin() + i);
+      objects_.push_back(object);
+      return true;
+    }
+  }
+  return false;
+}
+
+void DecodeArena::reset() {
+  bool active = active_;
+  active_ = false;
+  // Destructors may release heap objects; those go back to the heap.
+  for (size_t i = objects_.size(); i-- > 0;) {
+    objects_[i]->~Counted();
+  }
+  objects_.clear();
+  unadopted_.clear();
+  for (size_t i = 0; i < large_.size(); i++) {
+    ::operator delete(large_[i]);
+  }
+  large_.clear();
+  block_ = 0;
+  next_ = blocks_.empty() ? 0 : blocks_[0].begin;
+  active_ = active;
+}
+
+DecodeArena::Scope::Scope(bool enabled) :
+    arena_(0) {
+#ifdef ZXING_DECODE_ARENA
+  if (enabled) {
+    DecodeArena* arena = forThread();
+    if (arena != 0 && !arena->open_) {
+      arena->open_ = true;
+      arena->active_ = true;
+      arena_ = arena;
+    }
+  }
+#else
+  (void)enabled;
+#endif
+}
+
+DecodeArena::Scope::~Scope() {
+  if (arena_ != 0) {
+    arena_->active_ = false;
+    arena_->reset();
+    arena_->open_ = false;
+  }
+}
+
+Ref<Result> DecodeArena::Scope::keep(Ref<Result> result) {
+  if (arena_ == 0 || result.empty()) {
+    return result;
+  }
+  Suspend suspend;
+  std::vector<Ref<ResultPoint> >& points(result->getResultPoints());
+  std::vector<Ref<ResultPoint> > keptPoints;
+  for (size_t i = 0; i < points.size(); i++) {
+    keptPoints.push_back(Ref<ResultPoint>(new ResultPoint(points[i]->getX(), points[i]->getY())));
+  }
+  ArrayRef<unsigned char> rawBytes(result->getRawBytes());
+  ArrayRef<unsigned char> keptRawBytes;
+  if (rawBytes.array_ != 0) {
+    keptRawBytes = new Array<unsigned char>(rawBytes->values());
+  }
+  Ref<String> keptText(new String(result->getText()->getText()));
+  return Ref<Result>(new Result(keptText, keptRawBytes, keptPoints, result->getBarcodeFormat()));
+}
+
+DecodeArena::Suspend::Suspend() :
+    arena_(current()) {
+  if (arena_ != 0) {
+    arena_->active_ = false;
+  }
+}
+
+DecodeArena::Suspend::~Suspend() {
+  if (arena_ != 0) {
+    arena_->active_ = true;
+  }
+}
+
+#ifdef ZXING_DECODE_ARENA
+
+bool Counted::adoptedByArena() {
+  DecodeArena* arena = DecodeArena::current();
+  return arena != 0 && arena->adopt(this);
+}
+
+void* Counted::operator new(size_t size) {
+  DecodeArena* arena = DecodeArena::current();
+  return arena != 0 ? arena->allocate(size) : ::operator new(size);
+}
+
+void Counted::operator delete(void* object, size_t size) {
+  DecodeArena* arena = DecodeArena::current();
+  if (arena == 0 || !arena->deallocate(object, size)) {
+    ::operator delete(object);
+  }
+}
+
+#endif
+
+}
@@ -0,0 +1,123 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __DECODE_ARENA_H__
+#define __DECODE_ARENA_H__
+
+/*
+ *  DecodeArena.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Counted.h>
+#include <pthread.h>
+#include <vector>
+#include <cstddef>
+
+namespace zxing {
+
+class Result;
+
+/*
+ * Per-thread bump allocator for the Counted objects a single decode
+ * creates. With ZXING_DECODE_ARENA defined, every Counted object allocated
+ * while a Scope is open on the thread comes from the arena, skips reference
+ * counting, and is destroyed when the outermost Scope closes; the arena's
+ * memory is kept for the next decode. Without the define, Scope does
+ * nothing and objects are heap allocated and counted as usual.
+ *
+ * Nothing created inside a Scope may be referenced after it closes, so a
+ * reader that opens one hands its Result out through Scope::keep(), and
+ * must get its black matrix (which BinaryBitmap caches) before opening it.
+ */
+class DecodeArena {
+public:
+  class Scope {
+  public:
+    // A disabled Scope, or one nested in another, does nothing.
+    explicit Scope(bool enabled = true);
+    ~Scope();
+
+    // Returns a heap-allocated copy of result when this Scope owns the
+    // arena, and result itself otherwise.
+    Ref<Result> keep(Ref<Result> result);
+
+  private:
+    DecodeArena* arena_;
+
+    Scope(const Scope&);
+    Scope& operator =(const Scope&);
+  };
+
+  // Allocates from the heap while a Scope is open, for objects that must
+  // outlive it.
+  class Suspend {
+  public:
+    Suspend();
+    ~Suspend();
+
+  private:
+    DecodeArena* arena_;
+
+    Suspend(const Suspend&);
+    Suspend& operator =(const Suspend&);
+  };
+
+  ~DecodeArena();
+
+  // The calling thread's arena when a Scope is open on it, otherwise 0.
+  static DecodeArena* current();
+
+  void* allocate(size_t size);
+  // Returns false if p is not from this arena. Otherwise forgets the
+  // object there, whose constructor threw; its memory is reused on reset.
+  bool deallocate(void* p, size_t size);
+  // True if object lies in memory allocated and not yet adopted.
+  bool adopt(Counted* object);
+  // Destroys every adopted object, newest first, and rewinds the blocks.
+  void reset();
+
+private:
+  struct Block {
+    char* begin;
+    char* end;
+  };
+
+  static const size_t BLOCK_SIZE = 64 * 1024;
+
+  std::vector<Block> blocks_;
+  std::vector<char*> large_;
+  size_t block_;
+  char* next_;
+  std::vector<Block> unadopted_;
+  std::vector<Counted*> objects_;
+  bool open_;
+  bool active_;
+
+  static pthread_key_t threadKey_;
+  static bool threadKeyCreated_;
+
+  DecodeArena();
+  DecodeArena(const DecodeArena&);
+  DecodeArena& operator =(const DecodeArena&);
+
+  static bool createThreadKey();
+  static DecodeArena* forThread();
+  static void destroy(void* arena);
+};
+
+}
+
+#endif // __DECODE_ARENA_H__
@@ -20,7 +20,6 @@
 
 #include <zxing/common/GlobalHistogramBinarizer.h>
 #include <zxing/common/IllegalArgumentException.h>
-#include <zxing/common/Array.h>
 
 namespace zxing {
 using namespace std;
@@ -38,6 +37,27 @@ GlobalHistogramBinarizer::~GlobalHistogramBinarizer() {
 }
 
 
+/*
+ * Returns row y of the source, read in place when the source exposes a
+ * contiguous view and otherwise copied into the reusable row buffer.
+ */
+const unsigned char* GlobalHistogramBinarizer::getLuminanceRow(LuminanceSource& source, int y) {
+  if (source.isViewSupported()) {
+    LuminanceView view = source.getView();
+    if (view.isContiguous()) {
+      if (y < 0 || y >= view.height) {
+        throw IllegalArgumentException("Requested row is outside the image.");
+      }
+      return view.row(y);
+    }
+  }
+  int width = source.getWidth();
+  if (static_cast<int>(luminances_.size()) < width) {
+    luminances_.resize(width);
+  }
+  return source.getRow(y, &luminances_[0]);
+}
+
 Ref<BitArray> GlobalHistogramBinarizer::getBlackRow(int y, Ref<BitArray> row) {
   if (y == cached_row_num_) {
     if (cached_row_ != NULL) {
@@ -56,11 +76,8 @@ Ref<BitArray> GlobalHistogramBinarizer::getBlackRow(int y, Ref<BitArray> row) {
     row->clear();
   }
 
-  //TODO(flyashi): cache this instead of allocating and deleting per row
-  unsigned char* row_pixels = NULL;
   try {
-    row_pixels = new unsigned char[width];
-    row_pixels = source.getRow(y, row_pixels);
+    const unsigned char* row_pixels = getLuminanceRow(source, y);
     for (int x = 0; x < width; x++) {
       histogram[row_pixels[x] >> LUMINANCE_SHIFT]++;
     }
@@ -82,13 +99,11 @@ Ref<BitArray> GlobalHistogramBinarizer::getBlackRow(int y, Ref<BitArray> row) {
 
     cached_row_ = row;
     cached_row_num_ = y;
-    delete [] row_pixels;
     return row;
   } catch (IllegalArgumentException const& iae) {
     // Cache the fact that this row failed.
     cached_row_ = NULL;
     cached_row_num_ = y;
-    delete [] row_pixels;
     throw iae;
   }
 }
@@ -107,12 +122,10 @@ Ref<BitMatrix> GlobalHistogramBinarizer::getBlackMatrix() {
   // Quickly calculates the histogram by sampling four rows from the image.
   // This proved to be more robust on the blackbox tests than sampling a
   // diagonal as we used to do.
-  ArrayRef<unsigned char> ref (width);
-  unsigned char* row = &ref[0];
   for (int y = 1; y < 5; y++) {
     int rownum = height * y / 5;
     int right = (width << 2) / 5;
-    row = source.getRow(rownum, row);
+    const unsigned char* row = getLuminanceRow(source, rownum);
     for (int x = width / 5; x < right; x++) {
       histogram[row[x] >> LUMINANCE_SHIFT]++;
     }
@@ -123,7 +136,7 @@ Ref<BitMatrix> GlobalHistogramBinarizer::getBlackMatrix() {
   Ref<BitMatrix> matrix_ref(new BitMatrix(width, height));
   BitMatrix& matrix = *matrix_ref;
   for (int y = 0; y < height; y++) {
-    row = source.getRow(y, row);
+    const unsigned char* row = getLuminanceRow(source, y);
     for (int x = 0; x < width; x++) {
       if (row[x] < blackPoint)
         matrix.set(x, y);
@@ -131,7 +144,6 @@ Ref<BitMatrix> GlobalHistogramBinarizer::getBlackMatrix() {
   }
 
   cached_matrix_ = matrix_ref;
-  // delete [] row;
   return matrix_ref;
 }
 
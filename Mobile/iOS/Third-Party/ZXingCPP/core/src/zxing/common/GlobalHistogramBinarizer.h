@@ -31,6 +31,7 @@ namespace zxing {
     Ref<BitMatrix> cached_matrix_;
 	  Ref<BitArray> cached_row_;
 	  int cached_row_num_;
+    std::vector<unsigned char> luminances_;
 
 	public:
 		GlobalHistogramBinarizer(Ref<LuminanceSource> source);
@@ -40,6 +41,8 @@ namespace zxing {
 		virtual Ref<BitMatrix> getBlackMatrix();
 		static int estimate(std::vector<int> &histogram);
 		Ref<Binarizer> createBinarizer(Ref<LuminanceSource> source);
+  protected:
+    const unsigned char* getLuminanceRow(LuminanceSource& source, int y);
 	};
 	
 }
@@ -60,6 +60,19 @@ unsigned char* GreyscaleLuminanceSource::getMatrix() {
   return result;
 }
 
+LuminanceView GreyscaleLuminanceSource::getView() const {
+  return LuminanceView(greyData_ + top_ * dataWidth_ + left_, width_, height_, 1, dataWidth_);
+}
+
+Ref<LuminanceSource> GreyscaleLuminanceSource::crop(int left, int top, int width, int height) {
+  if (left < 0 || top < 0 || width < 0 || height < 0 ||
+      left + width > width_ || top + height > height_) {
+    throw IllegalArgumentException("Crop rectangle does not fit within image data.");
+  }
+  return Ref<LuminanceSource> (new GreyscaleLuminanceSource(greyData_, dataWidth_,
+      dataHeight_, left_ + left, top_ + top, width, height));
+}
+
 Ref<LuminanceSource> GreyscaleLuminanceSource::rotateCounterClockwise() {
   // Intentionally flip the left, top, width, and height arguments as needed. dataWidth and
   // dataHeight are always kept unrotated.
@@ -41,6 +41,18 @@ class GreyscaleLuminanceSource : public LuminanceSource {
   unsigned char* getRow(int y, unsigned char* row);
   unsigned char* getMatrix();
 
+  bool isViewSupported() const {
+    return true;
+  }
+
+  LuminanceView getView() const;
+
+  bool isCropSupported() const {
+    return true;
+  }
+
+  Ref<LuminanceSource> crop(int left, int top, int width, int height);
+
   bool isRotateSupported() const {
     return true;
   }
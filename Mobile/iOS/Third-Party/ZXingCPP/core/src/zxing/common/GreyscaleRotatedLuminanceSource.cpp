@@ -27,11 +27,11 @@ namespace zxing {
 // greyData correctly, which does not get rotated.
 GreyscaleRotatedLuminanceSource::GreyscaleRotatedLuminanceSource(unsigned char* greyData,
     int dataWidth, int dataHeight, int left, int top, int width, int height) : greyData_(greyData),
-    dataWidth_(dataWidth), left_(left), top_(top), width_(width),
+    dataWidth_(dataWidth), dataHeight_(dataHeight), left_(left), top_(top), width_(width),
     height_(height) {
 
   // Intentionally comparing to the opposite dimension since we're rotated.
-  if (left + width > dataHeight || top + height > dataWidth) {
+  if (left + width > dataHeight || top + height > dataWidth || top < 0 || left < 0) {
     throw IllegalArgumentException("Crop rectangle does not fit within image data.");
   }
 }
@@ -53,6 +53,23 @@ unsigned char* GreyscaleRotatedLuminanceSource::getRow(int y, unsigned char* row
   return row;
 }
 
+// Walking along a rotated row moves down a column of greyData, and moving to
+// the next rotated row steps one column to the left.
+LuminanceView GreyscaleRotatedLuminanceSource::getView() const {
+  return LuminanceView(greyData_ + left_ * dataWidth_ + (dataWidth_ - 1 - top_),
+      width_, height_, dataWidth_, -1);
+}
+
+Ref<LuminanceSource> GreyscaleRotatedLuminanceSource::crop(int left, int top, int width,
+    int height) {
+  if (left < 0 || top < 0 || width < 0 || height < 0 ||
+      left + width > width_ || top + height > height_) {
+    throw IllegalArgumentException("Crop rectangle does not fit within image data.");
+  }
+  return Ref<LuminanceSource> (new GreyscaleRotatedLuminanceSource(greyData_, dataWidth_,
+      dataHeight_, left_ + left, top_ + top, width, height));
+}
+
 unsigned char* GreyscaleRotatedLuminanceSource::getMatrix() {
   unsigned char* result = new unsigned char[width_ * height_];
   // This depends on getRow() honoring its second parameter.
@@ -28,6 +28,7 @@ class GreyscaleRotatedLuminanceSource : public LuminanceSource {
  private:
   unsigned char* greyData_;
   int dataWidth_;
+  int dataHeight_;
   int left_;
   int top_;
   int width_;
@@ -40,6 +41,18 @@ public:
   unsigned char* getRow(int y, unsigned char* row);
   unsigned char* getMatrix();
 
+  bool isViewSupported() const {
+    return true;
+  }
+
+  LuminanceView getView() const;
+
+  bool isCropSupported() const {
+    return true;
+  }
+
+  Ref<LuminanceSource> crop(int left, int top, int width, int height);
+
   bool isRotateSupported() const {
     return false;
   }
@@ -21,9 +21,17 @@
 #include <zxing/common/GridSampler.h>
 #include <zxing/common/PerspectiveTransform.h>
 #include <zxing/ReaderException.h>
+#include <zxing/common/StageTimer.h>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace zxing {
 using namespace std;
 
@@ -33,45 +41,145 @@ GridSampler::GridSampler() {
 }
 
 Ref<BitMatrix> GridSampler::sampleGrid(Ref<BitMatrix> image, int dimension, Ref<PerspectiveTransform> transform) {
+  StageTimer timer(StageTimer::SAMPLE);
   Ref<BitMatrix> bits(new BitMatrix(dimension));
-  vector<float> points(dimension << 1, (const float)0.0f);
   for (int y = 0; y < dimension; y++) {
-    int max = points.size();
-    float yValue = (float)y + 0.5f;
-    for (int x = 0; x < max; x += 2) {
-      points[x] = (float)(x >> 1) + 0.5f;
-      points[x + 1] = yValue;
-    }
-    transform->transformPoints(points);
-    checkAndNudgePoints(image, points);
-    for (int x = 0; x < max; x += 2) {
-      if (image->get((int)points[x], (int)points[x + 1])) {
-        bits->set(x >> 1, y);
-      }
-    }
+    sampleRow(*image, *transform, y, dimension, *bits);
   }
   return bits;
 }
 
 Ref<BitMatrix> GridSampler::sampleGrid(Ref<BitMatrix> image, int dimensionX, int dimensionY, Ref<PerspectiveTransform> transform) {
+  StageTimer timer(StageTimer::SAMPLE);
   Ref<BitMatrix> bits(new BitMatrix(dimensionX, dimensionY));
-  vector<float> points(dimensionX << 1, (const float)0.0f);
   for (int y = 0; y < dimensionY; y++) {
-    int max = points.size();
-    float yValue = (float)y + 0.5f;
-    for (int x = 0; x < max; x += 2) {
-      points[x] = (float)(x >> 1) + 0.5f;
-      points[x + 1] = yValue;
+    sampleRow(*image, *transform, y, dimensionX, *bits);
+  }
+  return bits;
+}
+
+/*
+ * Samples row y of the grid straight into bits, a word at a time. The
+ * transform is evaluated for several module centers at once, with the
+ * terms in y hoisted out of the row, and each point is checked and nudged
+ * as checkAndNudgePoints does. The arithmetic is done in the same order as
+ * PerspectiveTransform::transformPoints, so every module is read from the
+ * same pixel.
+ */
+void GridSampler::sampleRow(const BitMatrix& image, const PerspectiveTransform& t, int y, int dimension,
+                            BitMatrix& bits) {
+  const int width = image.getWidth();
+  const int height = image.getHeight();
+  const float yValue = (float)y + 0.5f;
+  const float xNumeratorY = t.a21 * yValue;
+  const float yNumeratorY = t.a22 * yValue;
+  const float denominatorY = t.a23 * yValue;
+#if defined(__AVX2__)
+  const int* imageWords = reinterpret_cast<const int*>(image.getBits());
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i minusOne = _mm256_set1_epi32(-1);
+  const __m256i widthV = _mm256_set1_epi32(width);
+  const __m256i heightV = _mm256_set1_epi32(height);
+  const __m256i bitMask = _mm256_set1_epi32(31);
+#elif defined(__SSE2__)
+  const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+  const __m128i minusOne = _mm_set1_epi32(-1);
+  const __m128i widthV = _mm_set1_epi32(width);
+  const __m128i heightV = _mm_set1_epi32(height);
+#endif
+
+  for (int start = 0; start < dimension; start += 32) {
+    int count = std::min(32, dimension - start);
+    unsigned int word = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+      __m256 xValue = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(start + i), lanes)),
+                                    _mm256_set1_ps(0.5f));
+      __m256 denominator = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t.a13), xValue),
+                                                       _mm256_set1_ps(denominatorY)), _mm256_set1_ps(t.a33));
+      __m256 xNumerator = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t.a11), xValue),
+                                                      _mm256_set1_ps(xNumeratorY)), _mm256_set1_ps(t.a31));
+      __m256 yNumerator = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t.a12), xValue),
+                                                      _mm256_set1_ps(yNumeratorY)), _mm256_set1_ps(t.a32));
+      __m256i px = _mm256_cvttps_epi32(_mm256_div_ps(xNumerator, denominator));
+      __m256i py = _mm256_cvttps_epi32(_mm256_div_ps(yNumerator, denominator));
+      __m256i outside = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpgt_epi32(minusOne, px), _mm256_cmpgt_epi32(px, widthV)),
+          _mm256_or_si256(_mm256_cmpgt_epi32(minusOne, py), _mm256_cmpgt_epi32(py, heightV)));
+      if (!_mm256_testz_si256(outside, outside)) {
+        // Let the scalar loop find the first bad point and report it.
+        break;
+      }
+      // Subtracting or adding a compare mask moves -1 to 0 and width to width - 1.
+      px = _mm256_add_epi32(_mm256_sub_epi32(px, _mm256_cmpeq_epi32(px, minusOne)), _mm256_cmpeq_epi32(px, widthV));
+      py = _mm256_add_epi32(_mm256_sub_epi32(py, _mm256_cmpeq_epi32(py, minusOne)), _mm256_cmpeq_epi32(py, heightV));
+      __m256i offset = _mm256_add_epi32(px, _mm256_mullo_epi32(py, widthV));
+      __m256i words = _mm256_i32gather_epi32(imageWords, _mm256_srli_epi32(offset, 5), 4);
+      // Move each pixel's bit up to the sign bit, where movemask finds it.
+      __m256i pixels = _mm256_sllv_epi32(words, _mm256_sub_epi32(bitMask, _mm256_and_si256(offset, bitMask)));
+      word |= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(pixels)) << i;
     }
-    transform->transformPoints(points);
-    checkAndNudgePoints(image, points);
-    for (int x = 0; x < max; x += 2) {
-      if (image->get((int)points[x], (int)points[x + 1])) {
-        bits->set(x >> 1, y);
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+      __m128 xValue = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(start + i), lanes)), _mm_set1_ps(0.5f));
+      __m128 denominator = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.a13), xValue), _mm_set1_ps(denominatorY)),
+                                      _mm_set1_ps(t.a33));
+      __m128 xNumerator = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.a11), xValue), _mm_set1_ps(xNumeratorY)),
+                                     _mm_set1_ps(t.a31));
+      __m128 yNumerator = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.a12), xValue), _mm_set1_ps(yNumeratorY)),
+                                     _mm_set1_ps(t.a32));
+      __m128i px = _mm_cvttps_epi32(_mm_div_ps(xNumerator, denominator));
+      __m128i py = _mm_cvttps_epi32(_mm_div_ps(yNumerator, denominator));
+      __m128i outside = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(px, minusOne), _mm_cmpgt_epi32(px, widthV)),
+                                     _mm_or_si128(_mm_cmplt_epi32(py, minusOne), _mm_cmpgt_epi32(py, heightV)));
+      if (_mm_movemask_epi8(outside) != 0) {
+        // Let the scalar loop find the first bad point and report it.
+        break;
+      }
+      // Subtracting or adding a compare mask moves -1 to 0 and width to width - 1.
+      px = _mm_add_epi32(_mm_sub_epi32(px, _mm_cmpeq_epi32(px, minusOne)), _mm_cmpeq_epi32(px, widthV));
+      py = _mm_add_epi32(_mm_sub_epi32(py, _mm_cmpeq_epi32(py, minusOne)), _mm_cmpeq_epi32(py, heightV));
+      int xs[4];
+      int ys[4];
+      _mm_storeu_si128((__m128i*)xs, px);
+      _mm_storeu_si128((__m128i*)ys, py);
+      // Modules are as likely dark as light; OR them in without branching.
+      for (int lane = 0; lane < 4; lane++) {
+        word |= (unsigned int)image.get(xs[lane], ys[lane]) << (i + lane);
+      }
+    }
+#endif
+    for (; i < count; i++) {
+      float xValue = (float)(start + i) + 0.5f;
+      float denominator = t.a13 * xValue + denominatorY + t.a33;
+      int px = (int)((t.a11 * xValue + xNumeratorY + t.a31) / denominator);
+      int py = (int)((t.a12 * xValue + yNumeratorY + t.a32) / denominator);
+      if (px < -1 || px > width || py < -1 || py > height) {
+        throwOutOfBounds(px, py);
+      }
+      if (px == -1) {
+        px = 0;
+      } else if (px == width) {
+        px = width - 1;
       }
+      if (py == -1) {
+        py = 0;
+      } else if (py == height) {
+        py = height - 1;
+      }
+      word |= (unsigned int)image.get(px, py) << i;
+    }
+    if (word != 0) {
+      bits.setBulk(start, y, word);
     }
   }
-  return bits;
+}
+
+void GridSampler::throwOutOfBounds(int x, int y) {
+  ostringstream s;
+  s << "Transformed point out of bounds at " << x << "," << y;
+  throw ReaderException(s.str().c_str());
 }
 
 Ref<BitMatrix> GridSampler::sampleGrid(Ref<BitMatrix> image, int dimension, float p1ToX, float p1ToY, float p2ToX,
@@ -97,9 +205,7 @@ void GridSampler::checkAndNudgePoints(Ref<BitMatrix> image, vector<float> &point
     int x = (int)points[offset];
     int y = (int)points[offset + 1];
     if (x < -1 || x > width || y < -1 || y > height) {
-      ostringstream s;
-      s << "Transformed point out of bounds at " << x << "," << y;
-      throw ReaderException(s.str().c_str());
+      throwOutOfBounds(x, y);
     }
 
     if (x == -1) {
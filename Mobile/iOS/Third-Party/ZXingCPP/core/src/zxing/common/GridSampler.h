@@ -30,6 +30,10 @@ private:
   static GridSampler gridSampler;
   GridSampler();
 
+  static void sampleRow(const BitMatrix& image, const PerspectiveTransform& transform, int y, int dimension,
+                        BitMatrix& bits);
+  static void throwOutOfBounds(int x, int y);
+
 public:
   Ref<BitMatrix> sampleGrid(Ref<BitMatrix> image, int dimension, Ref<PerspectiveTransform> transform);
   Ref<BitMatrix> sampleGrid(Ref<BitMatrix> image, int dimensionX, int dimensionY, Ref<PerspectiveTransform> transform);
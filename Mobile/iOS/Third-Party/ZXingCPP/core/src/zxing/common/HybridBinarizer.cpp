@@ -22,6 +22,14 @@
 
 #include <zxing/common/IllegalArgumentException.h>
 
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 using namespace zxing;
 
@@ -30,10 +38,132 @@ namespace {
   const int BLOCK_SIZE = 1 << BLOCK_SIZE_POWER; // ...0100...00
   const int BLOCK_SIZE_MASK = BLOCK_SIZE - 1;   // ...0011...11
   const int MINIMUM_DIMENSION = BLOCK_SIZE * 5;
+
+  /*
+   * Reduces BLOCK_SIZE consecutive rows to per-column minimum, maximum and
+   * sum. The per-block statistics are then a short horizontal reduction over
+   * BLOCK_SIZE columns, and the vertical pass, which touches every pixel,
+   * runs on whole vectors regardless of where the blocks start. Views whose
+   * pixels are not adjacent, such as rotated frames, take the scalar path.
+   */
+  void columnStats(const unsigned char* luminances,
+                   int pixelStride,
+                   int stride,
+                   int width,
+                   unsigned char* columnMin,
+                   unsigned char* columnMax,
+                   unsigned short* columnSum) {
+    int x = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    for (; pixelStride == 1 && x + 32 <= width; x += 32) {
+      __m256i pixels =
+        _mm256_loadu_si256((const __m256i*)(luminances + x));
+      __m256i min = pixels;
+      __m256i max = pixels;
+      __m256i sumLo = _mm256_unpacklo_epi8(pixels, zero);
+      __m256i sumHi = _mm256_unpackhi_epi8(pixels, zero);
+      for (int y = 1; y < BLOCK_SIZE; y++) {
+        pixels = _mm256_loadu_si256((const __m256i*)(luminances + y * stride + x));
+        min = _mm256_min_epu8(min, pixels);
+        max = _mm256_max_epu8(max, pixels);
+        sumLo = _mm256_add_epi16(sumLo, _mm256_unpacklo_epi8(pixels, zero));
+        sumHi = _mm256_add_epi16(sumHi, _mm256_unpackhi_epi8(pixels, zero));
+      }
+      _mm256_storeu_si256((__m256i*)(columnMin + x), min);
+      _mm256_storeu_si256((__m256i*)(columnMax + x), max);
+      // unpack works within 128-bit lanes; put the columns back in order.
+      _mm256_storeu_si256((__m256i*)(columnSum + x),
+                          _mm256_permute2x128_si256(sumLo, sumHi, 0x20));
+      _mm256_storeu_si256((__m256i*)(columnSum + x + 16),
+                          _mm256_permute2x128_si256(sumLo, sumHi, 0x31));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; pixelStride == 1 && x + 16 <= width; x += 16) {
+      __m128i pixels = _mm_loadu_si128((const __m128i*)(luminances + x));
+      __m128i min = pixels;
+      __m128i max = pixels;
+      __m128i sumLo = _mm_unpacklo_epi8(pixels, zero);
+      __m128i sumHi = _mm_unpackhi_epi8(pixels, zero);
+      for (int y = 1; y < BLOCK_SIZE; y++) {
+        pixels = _mm_loadu_si128((const __m128i*)(luminances + y * stride + x));
+        min = _mm_min_epu8(min, pixels);
+        max = _mm_max_epu8(max, pixels);
+        sumLo = _mm_add_epi16(sumLo, _mm_unpacklo_epi8(pixels, zero));
+        sumHi = _mm_add_epi16(sumHi, _mm_unpackhi_epi8(pixels, zero));
+      }
+      _mm_storeu_si128((__m128i*)(columnMin + x), min);
+      _mm_storeu_si128((__m128i*)(columnMax + x), max);
+      _mm_storeu_si128((__m128i*)(columnSum + x), sumLo);
+      _mm_storeu_si128((__m128i*)(columnSum + x + 8), sumHi);
+    }
+#endif
+    for (; x < width; x++) {
+      const unsigned char* column = luminances + x * pixelStride;
+      int min = column[0];
+      int max = min;
+      int sum = min;
+      for (int y = 1; y < BLOCK_SIZE; y++) {
+        int pixel = column[y * stride];
+        sum += pixel;
+        if (pixel < min) {
+          min = pixel;
+        }
+        if (pixel > max) {
+          max = pixel;
+        }
+      }
+      columnMin[x] = (unsigned char)min;
+      columnMax[x] = (unsigned char)max;
+      columnSum[x] = (unsigned short)sum;
+    }
+  }
+
+  /*
+   * Packs up to 32 pixels into a BitMatrix word, setting bit i when
+   * luminances[i * pixelStride] <= thresholds[i].
+   */
+  inline unsigned int thresholdWord(const unsigned char* luminances,
+                                    int pixelStride,
+                                    const unsigned char* thresholds,
+                                    int count) {
+    unsigned int bits = 0;
+    int x = 0;
+    if (count == 32 && pixelStride == 1) {
+#if defined(__AVX2__)
+      __m256i pixels = _mm256_loadu_si256((const __m256i*)luminances);
+      __m256i threshold = _mm256_loadu_si256((const __m256i*)thresholds);
+      __m256i black =
+        _mm256_cmpeq_epi8(_mm256_max_epu8(pixels, threshold), threshold);
+      return (unsigned int)_mm256_movemask_epi8(black);
+#elif defined(__SSE2__)
+      for (; x < 32; x += 16) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(luminances + x));
+        __m128i threshold = _mm_loadu_si128((const __m128i*)(thresholds + x));
+        __m128i black = _mm_cmpeq_epi8(_mm_max_epu8(pixels, threshold), threshold);
+        bits |= (unsigned int)_mm_movemask_epi8(black) << x;
+      }
+      return bits;
+#endif
+    }
+    for (; x < count; x++) {
+      if (luminances[x * pixelStride] <= thresholds[x]) {
+        bits |= 1u << x;
+      }
+    }
+    return bits;
+  }
 }
 
 HybridBinarizer::HybridBinarizer(Ref<LuminanceSource> source) :
-  GlobalHistogramBinarizer(source), matrix_(NULL), cached_row_(NULL) {
+  GlobalHistogramBinarizer(source), matrix_(NULL), cached_row_(NULL),
+  scratch_(new Scratch()) {
+}
+
+HybridBinarizer::HybridBinarizer(Ref<LuminanceSource> source, Ref<Scratch> scratch) :
+  GlobalHistogramBinarizer(source), matrix_(NULL), cached_row_(NULL),
+  scratch_(scratch) {
 }
 
 HybridBinarizer::~HybridBinarizer() {
@@ -42,7 +172,7 @@ HybridBinarizer::~HybridBinarizer() {
 
 Ref<Binarizer>
 HybridBinarizer::createBinarizer(Ref<LuminanceSource> source) {
-  return Ref<Binarizer> (new HybridBinarizer(source));
+  return Ref<Binarizer> (new HybridBinarizer(source, scratch_));
 }
 
 
@@ -59,7 +189,20 @@ Ref<BitMatrix> HybridBinarizer::getBlackMatrix() {
   int width = source.getWidth();
   int height = source.getHeight();
   if (width >= MINIMUM_DIMENSION && height >= MINIMUM_DIMENSION) {
-    unsigned char* luminances = source.getMatrix();
+    // Read caller-owned frames in place, rotated ones included; sources
+    // without a view are copied into the scratch buffer once.
+    LuminanceView view;
+    if (source.isViewSupported()) {
+      view = source.getView();
+    } else {
+      Scratch& scratch = *scratch_;
+      scratch.luminances.resize(width * height);
+      unsigned char* copy = &scratch.luminances[0];
+      for (int y = 0; y < height; y++) {
+        source.getRow(y, copy + y * width);
+      }
+      view = LuminanceView(copy, width, height, 1, width);
+    }
     int subWidth = width >> BLOCK_SIZE_POWER;
     if ((width & BLOCK_SIZE_MASK) != 0) {
       subWidth++;
@@ -68,25 +211,16 @@ Ref<BitMatrix> HybridBinarizer::getBlackMatrix() {
     if ((height & BLOCK_SIZE_MASK) != 0) {
       subHeight++;
     }
-    int* blackPoints =
-      calculateBlackPoints(luminances, subWidth, subHeight, width, height);
+    calculateBlackPoints(view, subWidth, subHeight, width, height);
 
-    Ref<BitMatrix> newMatrix (new BitMatrix(width, height));
-    calculateThresholdForBlock(luminances,
+    Ref<BitMatrix> matrix = newMatrix(width, height);
+    calculateThresholdForBlock(view,
                                subWidth,
                                subHeight,
                                width,
                                height,
-                               blackPoints,
-                               newMatrix);
-    matrix_ = newMatrix;
-
-    // N.B.: these deletes are inadequate if anything between the new
-    // and this point can throw.  As of this writing, it doesn't look
-    // like they do.
-
-    delete [] blackPoints;
-    delete [] luminances;
+                               matrix);
+    matrix_ = matrix;
   } else {
     // If the image is too small, fall back to the global histogram approach.
     matrix_ = GlobalHistogramBinarizer::getBlackMatrix();
@@ -94,20 +228,45 @@ Ref<BitMatrix> HybridBinarizer::getBlackMatrix() {
   return matrix_;
 }
 
+/**
+ * Hands out the scratch matrix again once nobody but the scratch holds it,
+ * i.e. once the results of the previous frame have been dropped.
+ */
+Ref<BitMatrix> HybridBinarizer::newMatrix(int width, int height) {
+  Ref<BitMatrix>& matrix = scratch_->matrix;
+  if (!matrix.empty() && matrix->count() == 1 &&
+      (int)matrix->getWidth() == width && (int)matrix->getHeight() == height) {
+    matrix->clear();
+  } else {
+    matrix = new BitMatrix(width, height);
+  }
+  return matrix;
+}
+
 namespace {
   inline int cap(int value, int min, int max) {
     return value < min ? min : value > max ? max : value;
   }
 }
 
+/**
+ * Every pixel is compared against the threshold of each block covering it.
+ * Blocks only overlap at the right and bottom edges, where the last block is
+ * pulled back inside the image; a pixel there is black if it is at or below
+ * either threshold, so the row of thresholds keeps the larger one and rows
+ * are ORed into the matrix.
+ */
 void
-HybridBinarizer::calculateThresholdForBlock(unsigned char* luminances,
+HybridBinarizer::calculateThresholdForBlock(LuminanceView const& view,
                                             int subWidth,
                                             int subHeight,
                                             int width,
                                             int height,
-                                            int blackPoints[],
                                             Ref<BitMatrix> const& matrix) {
+  int* blackPoints = &scratch_->blackPoints[0];
+  scratch_->thresholds.resize(width);
+  unsigned char* thresholds = &scratch_->thresholds[0];
+  BitMatrix& bits = *matrix;
   for (int y = 0; y < subHeight; y++) {
     int yoffset = y << BLOCK_SIZE_POWER;
     int maxYOffset = height - BLOCK_SIZE;
@@ -131,25 +290,26 @@ HybridBinarizer::calculateThresholdForBlock(unsigned char* luminances,
         sum += blackRow[left + 1];
         sum += blackRow[left + 2];
       }
-      int average = sum / 25;
-      thresholdBlock(luminances, xoffset, yoffset, average, width, matrix);
+      unsigned char average = (unsigned char)(sum / 25);
+      // Only the part of a pulled-back block that overlaps its left
+      // neighbour needs the max; the rest is fresh for this block row.
+      int overlap = (x << BLOCK_SIZE_POWER) - xoffset;
+      for (int xx = 0; xx < overlap; xx++) {
+        if (thresholds[xoffset + xx] < average) {
+          thresholds[xoffset + xx] = average;
+        }
+      }
+      memset(thresholds + xoffset + overlap, average, BLOCK_SIZE - overlap);
     }
-  }
-}
-
-void HybridBinarizer::thresholdBlock(unsigned char* luminances,
-                                     int xoffset,
-                                     int yoffset,
-                                     int threshold,
-                                     int stride,
-                                     Ref<BitMatrix> const& matrix) {
-  for (int y = 0, offset = yoffset * stride + xoffset;
-       y < BLOCK_SIZE;
-       y++,  offset += stride) {
-    for (int x = 0; x < BLOCK_SIZE; x++) {
-      int pixel = luminances[offset + x] & 0xff;
-      if (pixel <= threshold) {
-        matrix->set(xoffset + x, yoffset + y);
+    for (int yy = yoffset; yy < yoffset + BLOCK_SIZE; yy++) {
+      const unsigned char* row = view.row(yy);
+      for (int x = 0; x < width; x += 32) {
+        int count = width - x < 32 ? width - x : 32;
+        unsigned int word = thresholdWord(row + x * view.pixelStride, view.pixelStride,
+                                          thresholds + x, count);
+        if (word != 0) {
+          bits.setBulk(x, yy, word);
+        }
       }
     }
   }
@@ -164,20 +324,30 @@ namespace {
 }
 
 
-int* HybridBinarizer::calculateBlackPoints(unsigned char* luminances,
+void HybridBinarizer::calculateBlackPoints(LuminanceView const& view,
                                            int subWidth,
                                            int subHeight,
                                            int width,
                                            int height) {
   const int minDynamicRange = 24;
 
-  int *blackPoints = new int[subHeight * subWidth];
+  Scratch& scratch = *scratch_;
+  scratch.blackPoints.resize(subHeight * subWidth);
+  scratch.columnMin.resize(width);
+  scratch.columnMax.resize(width);
+  scratch.columnSum.resize(width);
+  int* blackPoints = &scratch.blackPoints[0];
+  unsigned char* columnMin = &scratch.columnMin[0];
+  unsigned char* columnMax = &scratch.columnMax[0];
+  unsigned short* columnSum = &scratch.columnSum[0];
   for (int y = 0; y < subHeight; y++) {
     int yoffset = y << BLOCK_SIZE_POWER;
     int maxYOffset = height - BLOCK_SIZE;
     if (yoffset > maxYOffset) {
       yoffset = maxYOffset;
     }
+    columnStats(view.row(yoffset), view.pixelStride, view.rowStride, width,
+                columnMin, columnMax, columnSum);
     for (int x = 0; x < subWidth; x++) {
       int xoffset = x << BLOCK_SIZE_POWER;
       int maxXOffset = width - BLOCK_SIZE;
@@ -187,30 +357,13 @@ int* HybridBinarizer::calculateBlackPoints(unsigned char* luminances,
       int sum = 0;
       int min = 0xFF;
       int max = 0;
-      for (int yy = 0, offset = yoffset * width + xoffset;
-           yy < BLOCK_SIZE;
-           yy++, offset += width) {
-        for (int xx = 0; xx < BLOCK_SIZE; xx++) {
-          int pixel = luminances[offset + xx] & 0xFF;
-          sum += pixel;
-          // still looking for good contrast
-          if (pixel < min) {
-            min = pixel;
-          }
-          if (pixel > max) {
-            max = pixel;
-          }
+      for (int xx = xoffset; xx < xoffset + BLOCK_SIZE; xx++) {
+        sum += columnSum[xx];
+        if (columnMin[xx] < min) {
+          min = columnMin[xx];
         }
-
-        // short-circuit min/max tests once dynamic range is met
-        if (max - min > minDynamicRange) {
-          // finish the rest of the rows quickly
-          for (yy++, offset += width; yy < BLOCK_SIZE; yy++, offset += width) {
-            for (int xx = 0; xx < BLOCK_SIZE; xx += 2) {
-              sum += luminances[offset + xx] & 0xFF;
-              sum += luminances[offset + xx + 1] & 0xFF;
-            }
-          }
+        if (columnMax[xx] > max) {
+          max = columnMax[xx];
         }
       }
       // See
@@ -228,6 +381,4 @@ int* HybridBinarizer::calculateBlackPoints(unsigned char* luminances,
       blackPoints[y * subWidth + x] = average;
     }
   }
-  return blackPoints;
 }
-
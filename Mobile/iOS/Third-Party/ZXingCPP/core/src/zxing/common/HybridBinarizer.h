@@ -30,8 +30,24 @@ namespace zxing {
 	
 	class HybridBinarizer : public GlobalHistogramBinarizer {
 	 private:
+    // Working memory for getBlackMatrix(). It is shared by every binarizer
+    // created through createBinarizer(), so a binarizer that is re-created
+    // for each camera frame keeps reusing the same buffers instead of
+    // allocating them again.
+    class Scratch : public Counted {
+    public:
+      std::vector<unsigned char> luminances;
+      std::vector<int> blackPoints;
+      std::vector<unsigned char> columnMin;
+      std::vector<unsigned char> columnMax;
+      std::vector<unsigned short> columnSum;
+      std::vector<unsigned char> thresholds;
+      Ref<BitMatrix> matrix;
+    };
+
     Ref<BitMatrix> matrix_;
 	  Ref<BitArray> cached_row_;
+    Ref<Scratch> scratch_;
 
 	public:
 		HybridBinarizer(Ref<LuminanceSource> source);
@@ -40,26 +56,20 @@ namespace zxing {
 		virtual Ref<BitMatrix> getBlackMatrix();
 		Ref<Binarizer> createBinarizer(Ref<LuminanceSource> source);
   private:
-    // We'll be using one-D arrays because C++ can't dynamically allocate 2D
-    // arrays
-    int* calculateBlackPoints(unsigned char* luminances,
+    HybridBinarizer(Ref<LuminanceSource> source, Ref<Scratch> scratch);
+
+    Ref<BitMatrix> newMatrix(int width, int height);
+    void calculateBlackPoints(LuminanceView const& view,
                               int subWidth,
                               int subHeight,
                               int width,
                               int height);
-    void calculateThresholdForBlock(unsigned char* luminances,
+    void calculateThresholdForBlock(LuminanceView const& view,
                                     int subWidth,
                                     int subHeight,
                                     int width,
                                     int height,
-                                    int blackPoints[],
                                     Ref<BitMatrix> const& matrix);
-    void thresholdBlock(unsigned char* luminances,
-                        int xoffset,
-                        int yoffset,
-                        int threshold,
-                        int stride,
-                        Ref<BitMatrix> const& matrix);
 	};
 
 }
@@ -43,6 +43,8 @@ public:
   void transformPoints(std::vector<float> &points);
 
   friend std::ostream& operator<<(std::ostream& out, const PerspectiveTransform &pt);
+  // Evaluates the transform a row of module centers at a time.
+  friend class GridSampler;
 };
 }
 
@@ -0,0 +1,134 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  StageTimer.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/StageTimer.h>
+
+#ifdef ZXING_STAGE_TIMING
+#include <sys/time.h>
+#endif
+
+namespace zxing {
+
+namespace {
+  const char* const STAGE_NAMES[StageTimer::STAGE_COUNT] = {
+    "detect", "sample", "reed_solomon", "parse"
+  };
+}
+
+#ifdef ZXING_STAGE_TIMING
+
+struct StageTimer::Totals {
+  long long micros[STAGE_COUNT];
+  StageTimer* current;
+};
+
+namespace {
+  long long now() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+  }
+}
+
+pthread_key_t StageTimer::threadKey_;
+bool StageTimer::threadKeyCreated_ = StageTimer::createThreadKey();
+
+bool StageTimer::createThreadKey() {
+  return pthread_key_create(&threadKey_, &StageTimer::destroyTotals) == 0;
+}
+
+void StageTimer::destroyTotals(void* totals) {
+  delete static_cast<Totals*>(totals);
+}
+
+StageTimer::Totals* StageTimer::totalsForThread() {
+  if (!threadKeyCreated_) {
+    return 0;
+  }
+  Totals* totals = static_cast<Totals*>(pthread_getspecific(threadKey_));
+  if (totals == 0) {
+    totals = new Totals();
+    pthread_setspecific(threadKey_, totals);
+  }
+  return totals;
+}
+
+StageTimer::StageTimer(Stage stage) :
+    stage_(stage), parent_(0), start_(now()), nested_(0), totals_(totalsForThread()) {
+  if (totals_ != 0) {
+    parent_ = totals_->current;
+    totals_->current = this;
+  }
+}
+
+StageTimer::~StageTimer() {
+  if (totals_ == 0) {
+    return;
+  }
+  long long elapsed = now() - start_;
+  totals_->micros[stage_] += elapsed - nested_;
+  if (parent_ != 0) {
+    parent_->nested_ += elapsed;
+  }
+  totals_->current = parent_;
+}
+
+bool StageTimer::isEnabled() {
+  return threadKeyCreated_;
+}
+
+void StageTimer::getTotals(long long totals[STAGE_COUNT]) {
+  Totals* threadTotals = totalsForThread();
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    totals[i] = threadTotals != 0 ? threadTotals->micros[i] : 0;
+  }
+}
+
+void StageTimer::reset() {
+  Totals* threadTotals = totalsForThread();
+  if (threadTotals != 0) {
+    for (int i = 0; i < STAGE_COUNT; i++) {
+      threadTotals->micros[i] = 0;
+    }
+  }
+}
+
+#else
+
+bool StageTimer::isEnabled() {
+  return false;
+}
+
+void StageTimer::getTotals(long long totals[STAGE_COUNT]) {
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    totals[i] = 0;
+  }
+}
+
+void StageTimer::reset() {
+}
+
+#endif
+
+const char* StageTimer::getName(Stage stage) {
+  return STAGE_NAMES[stage];
+}
+
+}
@@ -0,0 +1,90 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __STAGE_TIMER_H__
+#define __STAGE_TIMER_H__
+
+/*
+ *  StageTimer.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef ZXING_STAGE_TIMING
+#include <pthread.h>
+#endif
+
+namespace zxing {
+
+/*
+ * Times the stages of a decode for benchmarking. A StageTimer placed at the
+ * top of a function charges the time until it goes out of scope to its
+ * stage, less the time spent in stages nested within it, so a detector that
+ * samples its grid is only charged for finding the symbol. Totals are kept
+ * per thread.
+ *
+ * The timers cost nothing unless ZXING_STAGE_TIMING is defined; without it
+ * getTotals() reports zeros and isEnabled() is false.
+ */
+class StageTimer {
+public:
+  enum Stage {
+    DETECT,
+    SAMPLE,
+    REED_SOLOMON,
+    PARSE,
+    STAGE_COUNT
+  };
+
+#ifdef ZXING_STAGE_TIMING
+  explicit StageTimer(Stage stage);
+  ~StageTimer();
+#else
+  explicit StageTimer(Stage) {
+  }
+#endif
+
+  static bool isEnabled();
+  static const char* getName(Stage stage);
+
+  // Microseconds the calling thread has spent in each stage since the
+  // last reset().
+  static void getTotals(long long totals[STAGE_COUNT]);
+  static void reset();
+
+private:
+#ifdef ZXING_STAGE_TIMING
+  struct Totals;
+
+  static pthread_key_t threadKey_;
+  static bool threadKeyCreated_;
+
+  static bool createThreadKey();
+  static void destroyTotals(void* totals);
+  static Totals* totalsForThread();
+
+  Stage stage_;
+  StageTimer* parent_;
+  long long start_;
+  long long nested_;
+  Totals* totals_;
+#endif
+
+  StageTimer(const StageTimer&);
+  StageTimer& operator =(const StageTimer&);
+};
+
+}
+
+#endif // __STAGE_TIMER_H__
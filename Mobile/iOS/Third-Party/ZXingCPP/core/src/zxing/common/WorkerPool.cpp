@@ -0,0 +1,113 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  WorkerPool.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/WorkerPool.h>
+#include <zxing/common/IllegalArgumentException.h>
+
+using std::vector;
+using zxing::WorkerPool;
+
+WorkerPool::WorkerPool(int threads) :
+    tasks_(0), next_(0), finished_(0), stopping_(false) {
+  if (threads < 1) {
+    throw IllegalArgumentException("A worker pool needs at least one thread");
+  }
+  pthread_mutex_init(&mutex_, 0);
+  pthread_cond_init(&work_, 0);
+  pthread_cond_init(&done_, 0);
+  for (int i = 1; i < threads; i++) {
+    pthread_t thread;
+    if (pthread_create(&thread, 0, &WorkerPool::workerMain, this) != 0) {
+      // Carry on with fewer threads; run() still completes on the caller.
+      break;
+    }
+    threads_.push_back(thread);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  pthread_mutex_lock(&mutex_);
+  stopping_ = true;
+  pthread_cond_broadcast(&work_);
+  pthread_mutex_unlock(&mutex_);
+  for (size_t i = 0; i < threads_.size(); i++) {
+    pthread_join(threads_[i], 0);
+  }
+  pthread_cond_destroy(&done_);
+  pthread_cond_destroy(&work_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+int WorkerPool::getThreads() const {
+  return (int)threads_.size() + 1;
+}
+
+void WorkerPool::run(vector<Task*> const& tasks) {
+  if (tasks.empty()) {
+    return;
+  }
+  pthread_mutex_lock(&mutex_);
+  tasks_ = &tasks;
+  next_ = 0;
+  finished_ = 0;
+  pthread_cond_broadcast(&work_);
+  pthread_mutex_unlock(&mutex_);
+
+  work(true);
+
+  pthread_mutex_lock(&mutex_);
+  while (finished_ < tasks.size()) {
+    pthread_cond_wait(&done_, &mutex_);
+  }
+  tasks_ = 0;
+  pthread_mutex_unlock(&mutex_);
+}
+
+void* WorkerPool::workerMain(void* pool) {
+  static_cast<WorkerPool*>(pool)->work(false);
+  return 0;
+}
+
+/*
+ * Takes tasks until there are none left. Pool threads then sleep until the
+ * next run() or until the pool is destroyed; the caller of run() returns.
+ */
+void WorkerPool::work(bool untilIdle) {
+  pthread_mutex_lock(&mutex_);
+  while (!stopping_) {
+    if (tasks_ != 0 && next_ < tasks_->size()) {
+      Task* task = (*tasks_)[next_++];
+      pthread_mutex_unlock(&mutex_);
+      try {
+        task->run();
+      } catch (...) {
+      }
+      pthread_mutex_lock(&mutex_);
+      if (++finished_ == tasks_->size()) {
+        pthread_cond_signal(&done_);
+      }
+    } else if (untilIdle) {
+      break;
+    } else {
+      pthread_cond_wait(&work_, &mutex_);
+    }
+  }
+  pthread_mutex_unlock(&mutex_);
+}
@@ -0,0 +1,73 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+/*
+ *  WorkerPool.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Counted.h>
+#include <pthread.h>
+#include <vector>
+
+namespace zxing {
+
+/*
+ * A fixed set of threads that is kept around between decodes, so that
+ * decoding a stream of camera frames in parallel does not pay for thread
+ * creation on every frame.
+ */
+class WorkerPool : public Counted {
+public:
+  class Task {
+  public:
+    virtual ~Task() {}
+    // Must not throw; anything that escapes is swallowed.
+    virtual void run() = 0;
+  };
+
+  // The thread calling run() also works, so threads - 1 are started.
+  WorkerPool(int threads);
+  ~WorkerPool();
+
+  int getThreads() const;
+
+  // Runs every task and returns once all of them have finished. Only one
+  // thread may be inside run() at a time.
+  void run(std::vector<Task*> const& tasks);
+
+private:
+  pthread_mutex_t mutex_;
+  pthread_cond_t work_;
+  pthread_cond_t done_;
+  std::vector<pthread_t> threads_;
+  std::vector<Task*> const* tasks_;
+  size_t next_;
+  size_t finished_;
+  bool stopping_;
+
+  static void* workerMain(void* pool);
+  void work(bool untilIdle);
+
+  WorkerPool(const WorkerPool&);
+  WorkerPool& operator =(const WorkerPool&);
+};
+
+}
+
+#endif // __WORKER_POOL_H__
@@ -37,24 +37,22 @@ Ref<GenericGF> GenericGF::AZTEC_DATA_10(new GenericGF(0x409, 1024));
 Ref<GenericGF> GenericGF::AZTEC_DATA_12(new GenericGF(0x1069, 4096));
   
   
-static int INITIALIZATION_THRESHOLD = 0;
-  
+// The tables are built up front rather than on first use: the fields are
+// shared statics, and readers may run on several threads at once.
 GenericGF::GenericGF(int primitive, int size)
   : size_(size), primitive_(primitive), initialized_(false) {
-  if (size <= INITIALIZATION_THRESHOLD) {
-    initialize();
-  }
+  initialize();
 }
   
 void GenericGF::initialize() {
   //expTable_ = std::vector<int>(size_, (const int) 0);
   //logTable_ = std::vector<int>(size_, (const int) 0);
-  expTable_.resize(size_);
+  expTable_.resize(2 * size_);
   logTable_.resize(size_);
     
   int x = 1;
     
-  for (int i = 0; i < size_; i++) {
+  for (int i = 0; i < 2 * size_; i++) {
     expTable_[i] = x;
     x <<= 1; // x = x * 2; we're assuming the generator alpha is 2
     if (x >= size_) {
@@ -139,7 +137,7 @@ int GenericGF::multiply(int a, int b) {
     return 0;
   }
     
-  return expTable_[(logTable_[a] + logTable_[b]) % (size_ - 1)];
+  return expTable_[logTable_[a] + logTable_[b]];
   }
     
 int GenericGF::getSize() {
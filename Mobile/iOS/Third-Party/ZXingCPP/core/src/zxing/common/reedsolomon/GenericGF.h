@@ -63,6 +63,16 @@ namespace zxing {
     int log(int a);
     int inverse(int a);
     int multiply(int a, int b);
+
+    // The raw tables, for inner loops that cannot afford a call per
+    // multiplication. The exponent table covers twice the field size, so
+    // exp[log[a] + log[b]] needs no modulo.
+    const int* getExpTable() const {
+      return &expTable_[0];
+    }
+    const int* getLogTable() const {
+      return &logTable_[0];
+    }
       
     bool operator==(GenericGF other) {
       return (other.getSize() == this->size_ &&
@@ -21,178 +21,387 @@
 #include <iostream>
 
 #include <memory>
+#include <cstring>
 #include <zxing/common/reedsolomon/ReedSolomonDecoder.h>
 #include <zxing/common/reedsolomon/ReedSolomonException.h>
 #include <zxing/common/IllegalArgumentException.h>
+#include <zxing/common/StageTimer.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
 namespace zxing {
 
-ReedSolomonDecoder::ReedSolomonDecoder(Ref<GenericGF> fld) :
-    field(fld) {
-}
-
-ReedSolomonDecoder::~ReedSolomonDecoder() {
-}
-
-void ReedSolomonDecoder::decode(ArrayRef<int> received, int twoS) {
+/*
+ * Polynomials below are flat arrays of coefficients, lowest degree first,
+ * with every entry above the degree kept at zero. The zero polynomial has
+ * degree 0, as GenericGFPoly's does.
+ */
+namespace {
+  inline int multiply(const int* exp, const int* log, int a, int b) {
+    if (a == 0 || b == 0) {
+      return 0;
+    }
+    return exp[log[a] + log[b]];
+  }
 
-  Ref<GenericGFPoly> poly(new GenericGFPoly(field, received));
+  inline int degreeOf(const int* poly, int degree) {
+    while (degree > 0 && poly[degree] == 0) {
+      degree--;
+    }
+    return degree;
+  }
 
+  inline bool isZero(const int* poly, int degree) {
+    return degree == 0 && poly[0] == 0;
+  }
 
-/*
-#ifdef DEBUG
-  cout << "decoding with poly " << *poly << endl;
-#endif
-*/
+  int evaluateAt(const int* exp, const int* log, const int* poly, int degree, int a) {
+    int result = poly[degree];
+    for (int i = degree - 1; i >= 0; i--) {
+      result = multiply(exp, log, a, result) ^ poly[i];
+    }
+    return result;
+  }
+}
 
-  ArrayRef<int> syndromeCoefficients(new Array<int> (twoS));
+ReedSolomonDecoder::ReedSolomonDecoder(Ref<GenericGF> fld) :
+    field(fld), algorithm_(EUCLIDEAN) {
+}
 
+ReedSolomonDecoder::ReedSolomonDecoder(Ref<GenericGF> fld, Algorithm algorithm) :
+    field(fld), algorithm_(algorithm) {
+}
 
-#ifdef DEBUG
-  cout << "syndromeCoefficients array = " <<
-      syndromeCoefficients.array_ << endl;
-#endif
+ReedSolomonDecoder::~ReedSolomonDecoder() {
+}
 
+void ReedSolomonDecoder::decode(ArrayRef<int> received, int twoS) {
+  StageTimer timer(StageTimer::REED_SOLOMON);
+  if (twoS <= 0) {
+    return;
+  }
   bool dataMatrix = (field.object_ == GenericGF::DATA_MATRIX_FIELD_256.object_);
-  bool noError = true;
-  for (int i = 0; i < twoS; i++) {
-    int eval = poly->evaluateAt(field->exp(dataMatrix ? i + 1 : i));
-    syndromeCoefficients[syndromeCoefficients->size() - 1 - i] = eval;
-    if (eval != 0) {
-      noError = false;
-    }
+
+  int length = twoS + 1;
+  size_t needed = twoS + 7 * length + 2 * twoS;
+  if (workspace_.size() < needed) {
+    workspace_.resize(needed);
   }
-  if (noError) {
+  int* syndromes = &workspace_[0];
+  int* sigma = syndromes + twoS;
+  int* omega = sigma + length;
+  int* buffers = omega + length;
+  int* errorLocations = buffers + 5 * length;
+  int* errorMagnitudes = errorLocations + twoS;
+
+  if (received->size() == 0 ||
+      !computeSyndromes(&received->values()[0], received->size(), twoS, dataMatrix ? 1 : 0, syndromes)) {
     return;
   }
 
-  Ref<GenericGFPoly> syndrome(new GenericGFPoly(field, syndromeCoefficients));
-  Ref<GenericGFPoly> monomial = field->buildMonomial(twoS, 1);
-  vector<Ref<GenericGFPoly> > sigmaOmega = runEuclideanAlgorithm(monomial, syndrome, twoS);
-  ArrayRef<int> errorLocations = findErrorLocations(sigmaOmega[0]);
-  ArrayRef<int> errorMagitudes = findErrorMagnitudes(sigmaOmega[1], errorLocations, dataMatrix);
-  for (unsigned i = 0; i < errorLocations->size(); i++) {
+  int omegaDegree;
+  int numErrors = algorithm_ == BERLEKAMP_MASSEY ?
+    runBerlekampMassey(syndromes, twoS, buffers, sigma, omega, omegaDegree) :
+    runEuclideanAlgorithm(syndromes, twoS, buffers, sigma, omega, omegaDegree);
+  findErrorLocations(sigma, numErrors, errorLocations);
+  findErrorMagnitudes(omega, omegaDegree, errorLocations, numErrors, dataMatrix, errorMagnitudes);
+  for (int i = 0; i < numErrors; i++) {
     int position = received->size() - 1 - field->log(errorLocations[i]);
     //TODO: check why the position would be invalid
     if (position < 0 || (size_t)position >= received.size())
       throw IllegalArgumentException("Invalid position (ReedSolomonDecoder)");
-    received[position] = GenericGF::addOrSubtract(received[position], errorMagitudes[i]);
+    received[position] = GenericGF::addOrSubtract(received[position], errorMagnitudes[i]);
   }
 }
 
-vector<Ref<GenericGFPoly> > ReedSolomonDecoder::runEuclideanAlgorithm(Ref<GenericGFPoly> a,
-                                                                      Ref<GenericGFPoly> b,
-                                                                      int R) {
-  // Assume a's degree is >= b's
-  if (a->getDegree() < b->getDegree()) {
-    Ref<GenericGFPoly> tmp = a;
-    a = b;
-    b = tmp;
+/*
+ * Evaluates the received polynomial at alpha^(i + generatorBase) for each of
+ * the twoS syndromes, returning false if they are all zero. The n received
+ * codewords are its coefficients, highest degree first.
+ */
+bool ReedSolomonDecoder::computeSyndromes(const int* codewords, int n, int twoS, int generatorBase,
+                                          int* syndromes) {
+  const int* exp = field->getExpTable();
+  const int* log = field->getLogTable();
+  int order = field->getSize() - 1;
+  int i = 0;
+
+#if defined(__AVX2__)
+  // Eight syndromes at a time, as sums of exp[log(c_k) + (i + base) * (n-1-k)].
+  // The exponents of each lane step down by (i + base) per codeword, so they
+  // are kept in range with a compare instead of a modulo, and the lookups
+  // are gathers from the doubled exponent table.
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i orders = _mm256_set1_epi32(order);
+  for (; i + 8 <= twoS; i += 8) {
+    __m256i steps = _mm256_add_epi32(lanes, _mm256_set1_epi32(i + generatorBase));
+    int firstPowers[8];
+    for (int lane = 0; lane < 8; lane++) {
+      firstPowers[lane] = (int) ((long long) (i + generatorBase + lane) * (n - 1) % order);
+    }
+    __m256i powers = _mm256_loadu_si256((const __m256i*) firstPowers);
+    __m256i sums = _mm256_setzero_si256();
+    for (int k = 0; k < n; k++) {
+      int codeword = codewords[k];
+      if (codeword != 0) {
+        __m256i indices = _mm256_add_epi32(powers, _mm256_set1_epi32(log[codeword]));
+        sums = _mm256_xor_si256(sums, _mm256_i32gather_epi32(exp, indices, 4));
+      }
+      powers = _mm256_sub_epi32(powers, steps);
+      powers = _mm256_add_epi32(powers, _mm256_and_si256(orders, _mm256_cmpgt_epi32(_mm256_setzero_si256(), powers)));
+    }
+    int values[8];
+    _mm256_storeu_si256((__m256i*) values, sums);
+    for (int lane = 0; lane < 8; lane++) {
+      syndromes[i + lane] = values[lane];
+    }
   }
+#endif
 
-  Ref<GenericGFPoly> rLast(a);
-  Ref<GenericGFPoly> r(b);
-  Ref<GenericGFPoly> tLast(field->getZero());
-  Ref<GenericGFPoly> t(field->getOne());
+  // Horner's rule for the rest, with the codeword loop outermost so that
+  // the syndromes form independent chains the CPU can overlap.
+  int remaining = twoS - i;
+  if (remaining > 0) {
+    int* tail = syndromes + i;
+    for (int j = 0; j < remaining; j++) {
+      tail[j] = 0;
+    }
+    for (int k = 0; k < n; k++) {
+      int codeword = codewords[k];
+      for (int j = 0; j < remaining; j++) {
+        int value = tail[j];
+        tail[j] = (value == 0 ? 0 : exp[log[value] + (i + j + generatorBase) % order]) ^ codeword;
+      }
+    }
+  }
+
+  bool noError = true;
+  for (int j = 0; j < twoS; j++) {
+    if (syndromes[j] != 0) {
+      noError = false;
+      break;
+    }
+  }
+  return !noError;
+}
+
+/*
+ * Sugiyama's form of the extended Euclidean algorithm on x^twoS and the
+ * syndrome polynomial. Returns the degree of the error locator sigma and
+ * leaves the error evaluator in omega.
+ */
+int ReedSolomonDecoder::runEuclideanAlgorithm(const int* syndromes, int twoS, int* buffers, int* sigma,
+                                              int* omega, int& omegaDegree) {
+  const int* exp = field->getExpTable();
+  const int* log = field->getLogTable();
+  int R = twoS;
+  int length = R + 1;
+  int* rLast = buffers;
+  int* r = rLast + length;
+  int* tLast = r + length;
+  int* t = tLast + length;
+  int* q = t + length;
+  memset(buffers, 0, 5 * length * sizeof(int));
 
+  rLast[R] = 1;
+  int rLastDegree = R;
+  memcpy(r, syndromes, R * sizeof(int));
+  int rDegree = degreeOf(r, R - 1);
+  int tLastDegree = 0;
+  t[0] = 1;
+  int tDegree = 0;
 
   // Run Euclidean algorithm until r's degree is less than R/2
-  while (r->getDegree() >= R / 2) {
-    Ref<GenericGFPoly> rLastLast(rLast);
-    Ref<GenericGFPoly> tLastLast(tLast);
+  while (rDegree >= R / 2) {
+    // The old rLast becomes the dividend, reduced in place into the new r,
+    // and the old tLast is kept in t until q * tLast is added to it.
+    int* swap = rLast;
     rLast = r;
+    r = swap;
+    int swapDegree = rLastDegree;
+    rLastDegree = rDegree;
+    rDegree = swapDegree;
+    swap = tLast;
     tLast = t;
-
+    t = swap;
+    swapDegree = tLastDegree;
+    tLastDegree = tDegree;
+    tDegree = swapDegree;
 
     // Divide rLastLast by rLast, with quotient q and remainder r
-    if (rLast->isZero()) {
+    if (isZero(rLast, rLastDegree)) {
       // Oops, Euclidean algorithm already terminated?
       throw ReedSolomonException("r_{i-1} was zero");
     }
-    r = rLastLast;
-    Ref<GenericGFPoly> q(field->getZero());
-    int denominatorLeadingTerm = rLast->getCoefficient(rLast->getDegree());
-    int dltInverse = field->inverse(denominatorLeadingTerm);
-    while (r->getDegree() >= rLast->getDegree() && !r->isZero()) {
-      int degreeDiff = r->getDegree() - rLast->getDegree();
-      int scale = field->multiply(r->getCoefficient(r->getDegree()), dltInverse);
-      q = q->addOrSubtract(field->buildMonomial(degreeDiff, scale));
-      r = r->addOrSubtract(rLast->multiplyByMonomial(degreeDiff, scale));
+    memset(q, 0, length * sizeof(int));
+    int qDegree = 0;
+    int dltInverse = field->inverse(rLast[rLastDegree]);
+    while (rDegree >= rLastDegree && !isZero(r, rDegree)) {
+      int degreeDiff = rDegree - rLastDegree;
+      int scale = multiply(exp, log, r[rDegree], dltInverse);
+      q[degreeDiff] ^= scale;
+      if (degreeDiff > qDegree) {
+        qDegree = degreeDiff;
+      }
+      for (int j = 0; j <= rLastDegree; j++) {
+        r[j + degreeDiff] ^= multiply(exp, log, rLast[j], scale);
+      }
+      rDegree = degreeOf(r, rDegree);
     }
+    qDegree = degreeOf(q, qDegree);
 
-    t = q->multiply(tLast)->addOrSubtract(tLastLast);
-
+    for (int i = 0; i <= qDegree; i++) {
+      if (q[i] != 0) {
+        for (int j = 0; j <= tLastDegree; j++) {
+          t[i + j] ^= multiply(exp, log, q[i], tLast[j]);
+        }
+      }
+    }
+    int productDegree = qDegree + tLastDegree;
+    tDegree = degreeOf(t, productDegree > tDegree ? productDegree : tDegree);
   }
 
-  int sigmaTildeAtZero = t->getCoefficient(0);
+  int sigmaTildeAtZero = t[0];
   if (sigmaTildeAtZero == 0) {
     throw ReedSolomonException("sigmaTilde(0) was zero");
   }
 
   int inverse = field->inverse(sigmaTildeAtZero);
-  Ref<GenericGFPoly> sigma(t->multiply(inverse));
-  Ref<GenericGFPoly> omega(r->multiply(inverse));
-
+  for (int i = 0; i <= tDegree; i++) {
+    sigma[i] = multiply(exp, log, t[i], inverse);
+  }
+  for (int i = 0; i <= rDegree; i++) {
+    omega[i] = multiply(exp, log, r[i], inverse);
+  }
+  omegaDegree = rDegree;
+  return tDegree;
+}
 
 /*
-#ifdef DEBUG
-  cout << "t = " << *t << endl;
-  cout << "r = " << *r << "\n";
-  cout << "sigma = " << *sigma << endl;
-  cout << "omega = " << *omega << endl;
-#endif
-*/
+ * Berlekamp-Massey: builds the shortest LFSR that generates the syndromes,
+ * whose connection polynomial is the error locator, without any division
+ * of polynomials. The evaluator is then sigma * S mod x^twoS.
+ */
+int ReedSolomonDecoder::runBerlekampMassey(const int* syndromes, int twoS, int* buffers, int* sigma,
+                                           int* omega, int& omegaDegree) {
+  const int* exp = field->getExpTable();
+  const int* log = field->getLogTable();
+  int length = twoS + 1;
+  int* previous = buffers;
+  int* saved = previous + length;
+  memset(sigma, 0, length * sizeof(int));
+  memset(previous, 0, length * sizeof(int));
+  sigma[0] = 1;
+  previous[0] = 1;
+  int errors = 0;
+  int shift = 1;
+  int lastDiscrepancy = 1;
 
-  vector<Ref<GenericGFPoly> > result(2);
-  result[0] = sigma;
-  result[1] = omega;
-  return result;
+  for (int n = 0; n < twoS; n++) {
+    int discrepancy = syndromes[n];
+    for (int i = 1; i <= errors; i++) {
+      discrepancy ^= multiply(exp, log, sigma[i], syndromes[n - i]);
+    }
+    if (discrepancy == 0) {
+      shift++;
+      continue;
+    }
+    int scale = multiply(exp, log, discrepancy, field->inverse(lastDiscrepancy));
+    if (2 * errors <= n) {
+      memcpy(saved, sigma, length * sizeof(int));
+      for (int i = 0; i + shift < length; i++) {
+        sigma[i + shift] ^= multiply(exp, log, scale, previous[i]);
+      }
+      errors = n + 1 - errors;
+      int* swap = previous;
+      previous = saved;
+      saved = swap;
+      lastDiscrepancy = discrepancy;
+      shift = 1;
+    } else {
+      for (int i = 0; i + shift < length; i++) {
+        sigma[i + shift] ^= multiply(exp, log, scale, previous[i]);
+      }
+      shift++;
+    }
+  }
+
+  if (2 * errors > twoS || degreeOf(sigma, twoS) != errors) {
+    throw ReedSolomonException("Error locator degree does not match number of roots");
+  }
+
+  for (int k = 0; k < twoS; k++) {
+    int value = 0;
+    for (int i = 0; i <= errors && i <= k; i++) {
+      value ^= multiply(exp, log, sigma[i], syndromes[k - i]);
+    }
+    omega[k] = value;
+  }
+  omegaDegree = degreeOf(omega, twoS - 1);
+  return errors;
 }
 
-ArrayRef<int> ReedSolomonDecoder::findErrorLocations(Ref<GenericGFPoly> errorLocator) {
+void ReedSolomonDecoder::findErrorLocations(const int* errorLocator, int numErrors, int* locations) {
   // This is a direct application of Chien's search
-  int numErrors = errorLocator->getDegree();
   if (numErrors == 1) { // shortcut
-    ArrayRef<int> result(new Array<int>(1));
-    result[0] = errorLocator->getCoefficient(1);
-    return result;
+    locations[0] = errorLocator[1];
+    return;
+  }
+  const int* exp = field->getExpTable();
+  const int* log = field->getLogTable();
+  int order = field->getSize() - 1;
+  // Evaluates the locator at alpha^k for every k. Term j is kept as the log
+  // of its value, which grows by j from one k to the next.
+  int* terms = locations + numErrors;
+  for (int j = 1; j <= numErrors; j++) {
+    terms[j - 1] = errorLocator[j] == 0 ? -1 : log[errorLocator[j]];
   }
-  ArrayRef<int> result(new Array<int>(numErrors));
   int e = 0;
-  for (int i = 1; i < field->getSize() && e < numErrors; i++) {
-    // cout << "errorLocator(" << i << ") == " << errorLocator->evaluateAt(i) << endl;
-    if (errorLocator->evaluateAt(i) == 0) {
-      result[e] = field->inverse(i);
+  for (int k = 0; k < order && e < numErrors; k++) {
+    int value = errorLocator[0];
+    for (int j = 1; j <= numErrors; j++) {
+      int term = terms[j - 1];
+      if (term >= 0) {
+        value ^= exp[term];
+        term += j;
+        terms[j - 1] = term >= order ? term - order : term;
+      }
+    }
+    if (value == 0) {
+      locations[e] = exp[k == 0 ? 0 : order - k];
       e++;
     }
   }
   if (e != numErrors) {
     throw ReedSolomonException("Error locator degree does not match number of roots");
   }
-  return result;
 }
 
-ArrayRef<int> ReedSolomonDecoder::findErrorMagnitudes(Ref<GenericGFPoly> errorEvaluator, ArrayRef<int> errorLocations, bool dataMatrix) {
+void ReedSolomonDecoder::findErrorMagnitudes(const int* errorEvaluator, int evaluatorDegree,
+                                             const int* errorLocations, int numErrors, bool dataMatrix,
+                                             int* magnitudes) {
   // This is directly applying Forney's Formula
-  int s = errorLocations.size();
-  ArrayRef<int> result(new Array<int>(s));
-  for (int i = 0; i < s; i++) {
+  const int* exp = field->getExpTable();
+  const int* log = field->getLogTable();
+  for (int i = 0; i < numErrors; i++) {
     int xiInverse = field->inverse(errorLocations[i]);
     int denominator = 1;
-    for (int j = 0; j < s; j++) {
+    for (int j = 0; j < numErrors; j++) {
       if (i != j) {
-        denominator = field->multiply(denominator, GenericGF::addOrSubtract(1, field->multiply(errorLocations[j],
-                                     xiInverse)));
+        denominator = multiply(exp, log, denominator,
+                               GenericGF::addOrSubtract(1, multiply(exp, log, errorLocations[j], xiInverse)));
       }
     }
-    result[i] = field->multiply(errorEvaluator->evaluateAt(xiInverse), field->inverse(denominator));
+    magnitudes[i] = multiply(exp, log, evaluateAt(exp, log, errorEvaluator, evaluatorDegree, xiInverse),
+                             field->inverse(denominator));
 
     if (dataMatrix) {
-      result[i] = field->multiply(result[i], xiInverse);
-	}
+      magnitudes[i] = multiply(exp, log, magnitudes[i], xiInverse);
+    }
   }
-  return result;
 }
 }
@@ -31,17 +31,39 @@ namespace zxing {
 class GenericGFPoly;
 class GenericGF;
 
+/*
+ * Corrects errors in place in a block of codewords. The whole decode runs
+ * on flat coefficient arrays in a workspace the decoder keeps between
+ * calls, so a decoder that is reused does not allocate once warmed up.
+ */
 class ReedSolomonDecoder {
+public:
+  // How the error locator is found from the syndromes. Both give the same
+  // corrections for any correctable block.
+  enum Algorithm {
+    EUCLIDEAN,
+    BERLEKAMP_MASSEY
+  };
+
 private:
   Ref<GenericGF> field;
+  Algorithm algorithm_;
+  std::vector<int> workspace_;
+
 public:
   ReedSolomonDecoder(Ref<GenericGF> fld);
+  ReedSolomonDecoder(Ref<GenericGF> fld, Algorithm algorithm);
   ~ReedSolomonDecoder();
   void decode(ArrayRef<int> received, int twoS);
 private:
-  std::vector<Ref<GenericGFPoly> > runEuclideanAlgorithm(Ref<GenericGFPoly> a, Ref<GenericGFPoly> b, int R);
-  ArrayRef<int> findErrorLocations(Ref<GenericGFPoly> errorLocator);
-  ArrayRef<int> findErrorMagnitudes(Ref<GenericGFPoly> errorEvaluator, ArrayRef<int> errorLocations, bool dataMatrix);
+  bool computeSyndromes(const int* codewords, int n, int twoS, int generatorBase, int* syndromes);
+  int runEuclideanAlgorithm(const int* syndromes, int twoS, int* buffers, int* sigma, int* omega,
+                            int& omegaDegree);
+  int runBerlekampMassey(const int* syndromes, int twoS, int* buffers, int* sigma, int* omega,
+                         int& omegaDegree);
+  void findErrorLocations(const int* errorLocator, int numErrors, int* locations);
+  void findErrorMagnitudes(const int* errorEvaluator, int evaluatorDegree, const int* errorLocations,
+                           int numErrors, bool dataMatrix, int* magnitudes);
 };
 }
 
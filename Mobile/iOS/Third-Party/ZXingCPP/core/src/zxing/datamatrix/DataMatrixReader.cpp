@@ -21,6 +21,7 @@
 
 #include <zxing/datamatrix/DataMatrixReader.h>
 #include <zxing/datamatrix/detector/Detector.h>
+#include <zxing/common/DecodeArena.h>
 #include <iostream>
 
 namespace zxing {
@@ -33,12 +34,15 @@ DataMatrixReader::DataMatrixReader() :
 }
 
 Ref<Result> DataMatrixReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
-  (void)hints;
+  hints.checkDeadline();
 #ifdef DEBUG
   cout << "decoding image " << image.object_ << ":\n" << flush;
 #endif
 
-  Detector detector(image->getBlackMatrix());
+  Ref<BitMatrix> matrix(image->getBlackMatrix());
+  // Detection and decoding allocate only scratch objects; see QRCodeReader.
+  DecodeArena::Scope arena(hints.getResultPointCallback().empty());
+  Detector detector(matrix);
 
 
 #ifdef DEBUG
@@ -63,6 +67,7 @@ Ref<Result> DataMatrixReader::decode(Ref<BinaryBitmap> image, DecodeHints hints)
   cout << *(detectorResult->getBits()) << "\n";
 #endif
 
+  hints.checkDeadline();
   Ref<DecoderResult> decoderResult(decoder_.decode(detectorResult->getBits()));
 #ifdef DEBUG
   cout << "(4) decoded, have decoderResult " << decoderResult.object_ << "\n" << flush;
@@ -74,7 +79,7 @@ Ref<Result> DataMatrixReader::decode(Ref<BinaryBitmap> image, DecodeHints hints)
   cout << "(5) created result " << result.object_ << ", returning\n" << flush;
 #endif
 
-  return result;
+  return arena.keep(result);
 }
 
 DataMatrixReader::~DataMatrixReader() {
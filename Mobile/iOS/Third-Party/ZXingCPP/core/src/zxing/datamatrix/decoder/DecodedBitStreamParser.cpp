@@ -23,6 +23,7 @@
 #include <zxing/datamatrix/decoder/DecodedBitStreamParser.h>
 #include <iostream>
 #include <zxing/common/DecoderResult.h>
+#include <zxing/common/StageTimer.h>
 
 namespace zxing {
 namespace datamatrix {
@@ -52,6 +53,7 @@ const char DecodedBitStreamParser::TEXT_SHIFT3_SET_CHARS[] = {
 };
 
 Ref<DecoderResult> DecodedBitStreamParser::decode(ArrayRef<unsigned char> bytes) {
+  StageTimer timer(StageTimer::PARSE);
   Ref<BitSource> bits(new BitSource(bytes));
   ostringstream result;
   ostringstream resultTrailer;
@@ -25,6 +25,7 @@
 #include <zxing/datamatrix/detector/Detector.h>
 #include <zxing/common/detector/math_utils.h>
 #include <zxing/NotFoundException.h>
+#include <zxing/common/StageTimer.h>
 #include <sstream>
 #include <cstdlib>
 
@@ -80,6 +81,7 @@ Ref<BitMatrix> Detector::getImage() {
 }
 
 Ref<DetectorResult> Detector::detect() {
+  StageTimer timer(StageTimer::DETECT);
   Ref<WhiteRectangleDetector> rectangleDetector_(new WhiteRectangleDetector(image_));
   std::vector<Ref<ResultPoint> > ResultPoints = rectangleDetector_->detect();
   Ref<ResultPoint> pointA = ResultPoints[0];
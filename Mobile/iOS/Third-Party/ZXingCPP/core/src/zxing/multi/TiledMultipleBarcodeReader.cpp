@@ -0,0 +1,510 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  Copyright 2011 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/TiledMultipleBarcodeReader.h>
+#include <zxing/multi/qrcode/detector/MultiFinderPatternFinder.h>
+#include <zxing/qrcode/detector/Detector.h>
+#include <zxing/qrcode/decoder/Decoder.h>
+#include <zxing/aztec/detector/Detector.h>
+#include <zxing/aztec/decoder/Decoder.h>
+#include <zxing/datamatrix/detector/Detector.h>
+#include <zxing/datamatrix/decoder/Decoder.h>
+#include <zxing/oned/MultiFormatOneDReader.h>
+#include <zxing/oned/OneDResultPoint.h>
+#include <zxing/common/Deadline.h>
+#include <zxing/common/GlobalHistogramBinarizer.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <zxing/ReaderException.h>
+#include <zxing/ResultPoint.h>
+
+#include <cmath>
+
+namespace zxing {
+namespace multi {
+
+namespace {
+  typedef TiledMultipleBarcodeReader::Region Region;
+
+  // Rows between bullseye scan lines; the same as the QR finder's minimum.
+  const int BULLSEYE_ROW_SKIP = 3;
+
+  // Half the side of the largest Aztec symbol (151 modules), in modules.
+  const float AZTEC_MAX_HALF_SIZE = 76.0f;
+
+  // Results found so far, shared by the tasks of one decodeMultiple().
+  struct Collector {
+    pthread_mutex_t mutex;
+    std::vector<Ref<Result> > results;
+
+    void add(Ref<Result> result) {
+      pthread_mutex_lock(&mutex);
+      bool alreadyFound = false;
+      for (size_t i = 0; i < results.size(); i++) {
+        if (results[i]->getBarcodeFormat() == result->getBarcodeFormat() &&
+            results[i]->getText()->getText() == result->getText()->getText()) {
+          alreadyFound = true;
+          break;
+        }
+      }
+      if (!alreadyFound) {
+        results.push_back(result);
+      }
+      pthread_mutex_unlock(&mutex);
+    }
+  };
+
+  Ref<Result> translateResultPoints(Ref<Result> result, int xOffset, int yOffset) {
+    const std::vector<Ref<ResultPoint> > oldResultPoints = result->getResultPoints();
+    if (oldResultPoints.empty() || (xOffset == 0 && yOffset == 0)) {
+      return result;
+    }
+    std::vector<Ref<ResultPoint> > newResultPoints;
+    for (size_t i = 0; i < oldResultPoints.size(); i++) {
+      Ref<ResultPoint> oldPoint = oldResultPoints[i];
+      newResultPoints.push_back(Ref<ResultPoint>(new ResultPoint(oldPoint->getX() + xOffset, oldPoint->getY() + yOffset)));
+    }
+    return Ref<Result>(new Result(result->getText(), result->getRawBytes(), newResultPoints, result->getBarcodeFormat()));
+  }
+
+  Ref<BitMatrix> cropMatrix(Ref<BitMatrix> image, Region const& region) {
+    Ref<BitMatrix> tile(new BitMatrix(region.width, region.height));
+    for (int y = 0; y < region.height; y++) {
+      for (int x = 0; x < region.width; x++) {
+        if (image->get(region.left + x, region.top + y)) {
+          tile->set(x, y);
+        }
+      }
+    }
+    return tile;
+  }
+
+  // True if the nine runs look like a line through the middle of an Aztec
+  // bullseye: a black centre module inside two black rings. The outer runs
+  // may run on into the mode message, so only their inner edge is checked.
+  bool isBullseyeRuns(const int runs[9], float& moduleSize) {
+    int total = 0;
+    for (int i = 1; i < 8; i++) {
+      total += runs[i];
+    }
+    moduleSize = total / 7.0f;
+    float maxVariance = moduleSize / 2.0f;
+    for (int i = 1; i < 8; i++) {
+      if (std::abs(moduleSize - runs[i]) >= maxVariance) {
+        return false;
+      }
+    }
+    return runs[0] > maxVariance && runs[8] > maxVariance;
+  }
+
+  // BitMatrix::get() does not check its arguments, and crossCheck() steps
+  // along diagonals in either x direction.
+  bool isInside(int x, int y, int width, int height) {
+    return x >= 0 && x < width && y >= 0 && y < height;
+  }
+
+  /*
+   * Measures the nine runs centred on the black pixel (x, y) stepping by
+   * (dx, dy), and returns how many steps from (x, y) the middle of the centre
+   * run lies. Along a diagonal a bullseye still shows its rings, while
+   * checkerboard-like data, which can pass the row and column checks, does
+   * not.
+   */
+  bool crossCheck(Ref<BitMatrix> image, int x, int y, int dx, int dy, int& centerOffset) {
+    int width = image->getWidth();
+    int height = image->getHeight();
+    int runs[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    int back = 0;
+    while (isInside(x - back * dx, y - back * dy, width, height) &&
+           image->get(x - back * dx, y - back * dy)) {
+      runs[4]++;
+      back++;
+    }
+    int forward = 1;
+    while (isInside(x + forward * dx, y + forward * dy, width, height) &&
+           image->get(x + forward * dx, y + forward * dy)) {
+      runs[4]++;
+      forward++;
+    }
+    centerOffset = (forward - back) / 2;
+    bool black = false;
+    for (int i = 3; i >= 0; i--, black = !black) {
+      while (isInside(x - back * dx, y - back * dy, width, height) &&
+             image->get(x - back * dx, y - back * dy) == black) {
+        runs[i]++;
+        back++;
+      }
+    }
+    black = false;
+    for (int i = 5; i < 9; i++, black = !black) {
+      while (isInside(x + forward * dx, y + forward * dy, width, height) &&
+             image->get(x + forward * dx, y + forward * dy) == black) {
+        runs[i]++;
+        forward++;
+      }
+    }
+    float moduleSize;
+    return isBullseyeRuns(runs, moduleSize);
+  }
+
+  class CandidateTask : public WorkerPool::Task {
+  protected:
+    Ref<BitMatrix> image_;
+    DecodeHints const& hints_;
+    Collector& collector_;
+
+    virtual void decode() = 0;
+
+  public:
+    CandidateTask(Ref<BitMatrix> image, DecodeHints const& hints, Collector& collector) :
+        image_(image), hints_(hints), collector_(collector) {
+    }
+
+    void run() {
+      try {
+        hints_.checkDeadline();
+        decode();
+      } catch (Exception const& e) {
+        // a candidate that does not decode is dropped
+      }
+    }
+  };
+
+  class QRCodeTask : public CandidateTask {
+  private:
+    Ref<qrcode::FinderPatternInfo> info_;
+
+  protected:
+    void decode() {
+      qrcode::Detector detector(image_);
+      Ref<DetectorResult> detectorResult(detector.processFinderPatternInfo(info_));
+      qrcode::Decoder decoder;
+      Ref<DecoderResult> decoderResult(decoder.decode(detectorResult->getBits()));
+      collector_.add(Ref<Result>(new Result(decoderResult->getText(), decoderResult->getRawBytes(),
+                                            detectorResult->getPoints(), BarcodeFormat_QR_CODE)));
+    }
+
+  public:
+    QRCodeTask(Ref<BitMatrix> image, DecodeHints const& hints, Collector& collector,
+               Ref<qrcode::FinderPatternInfo> info) :
+        CandidateTask(image, hints, collector), info_(info) {
+    }
+  };
+
+  class AztecTask : public CandidateTask {
+  private:
+    Region region_;
+
+  protected:
+    void decode() {
+      aztec::Detector detector(cropMatrix(image_, region_));
+      Ref<aztec::AztecDetectorResult> detectorResult(detector.detect());
+      aztec::Decoder decoder;
+      Ref<DecoderResult> decoderResult(decoder.decode(detectorResult));
+      Ref<Result> result(new Result(decoderResult->getText(), decoderResult->getRawBytes(),
+                                    detectorResult->getPoints(), BarcodeFormat_AZTEC));
+      collector_.add(translateResultPoints(result, region_.left, region_.top));
+    }
+
+  public:
+    AztecTask(Ref<BitMatrix> image, DecodeHints const& hints, Collector& collector, Region const& region) :
+        CandidateTask(image, hints, collector), region_(region) {
+    }
+  };
+
+  class DataMatrixTask : public CandidateTask {
+  private:
+    Region region_;
+
+  protected:
+    void decode() {
+      datamatrix::Detector detector(cropMatrix(image_, region_));
+      Ref<DetectorResult> detectorResult(detector.detect());
+      datamatrix::Decoder decoder;
+      Ref<DecoderResult> decoderResult(decoder.decode(detectorResult->getBits()));
+      Ref<Result> result(new Result(decoderResult->getText(), decoderResult->getRawBytes(),
+                                    detectorResult->getPoints(), BarcodeFormat_DATA_MATRIX));
+      collector_.add(translateResultPoints(result, region_.left, region_.top));
+    }
+
+  public:
+    DataMatrixTask(Ref<BitMatrix> image, DecodeHints const& hints, Collector& collector, Region const& region) :
+        CandidateTask(image, hints, collector), region_(region) {
+    }
+  };
+
+  /*
+   * Runs the 1D readers over every rowStep-th row, starting at firstRow. Rows
+   * come from a GlobalHistogramBinarizer of the task's own, as they would for
+   * OneDReader, since a per-row threshold suits bars better than the matrix.
+   * After each symbol the row is blanked up to its end guard and scanned
+   * again, so several barcodes side by side are all found.
+   */
+  class OneDTask : public CandidateTask {
+  private:
+    Ref<LuminanceSource> source_;
+    int firstRow_;
+    int rowStep_;
+
+    void scanRow(oned::MultiFormatOneDReader& reader, Ref<BitArray> row, int rowNumber, bool reversed) {
+      int width = row->getSize();
+      while (true) {
+        Ref<Result> result(reader.decodeRow(rowNumber, row));
+        if (result.empty()) {
+          return;
+        }
+        std::vector<Ref<ResultPoint> > points(result->getResultPoints());
+        float end = 0;
+        for (size_t i = 0; i < points.size(); i++) {
+          if (points[i]->getX() > end) {
+            end = points[i]->getX();
+          }
+        }
+        if (reversed) {
+          for (size_t i = 0; i < points.size(); i++) {
+            points[i] = new oned::OneDResultPoint(width - points[i]->getX() - 1, points[i]->getY());
+          }
+          result = new Result(result->getText(), result->getRawBytes(), points, result->getBarcodeFormat());
+        }
+        collector_.add(result);
+
+        int next = (int) end + 1;
+        if (points.empty() || next >= width) {
+          return;
+        }
+        Ref<BitArray> rest(new BitArray(width));
+        for (int x = next; x < width; x++) {
+          if (row->get(x)) {
+            rest->set(x);
+          }
+        }
+        row = rest;
+      }
+    }
+
+  protected:
+    void decode() {
+      oned::MultiFormatOneDReader reader(hints_);
+      Ref<Binarizer> binarizer(new GlobalHistogramBinarizer(source_));
+      int height = image_->getHeight();
+      Ref<BitArray> row(new BitArray(image_->getWidth()));
+      for (int y = firstRow_; y < height; y += rowStep_) {
+        hints_.checkDeadline();
+        try {
+          row = binarizer->getBlackRow(y, row);
+        } catch (IllegalArgumentException const& iae) {
+          continue;
+        }
+        scanRow(reader, row, y, false);
+        row->reverse();
+        scanRow(reader, row, y, true);
+      }
+    }
+
+  public:
+    OneDTask(Ref<BitMatrix> image, DecodeHints const& hints, Collector& collector,
+             Ref<LuminanceSource> source, int firstRow, int rowStep) :
+        CandidateTask(image, hints, collector), source_(source), firstRow_(firstRow), rowStep_(rowStep) {
+    }
+  };
+
+  // Owns the tasks of one decodeMultiple(), however it is left.
+  class TaskList {
+  public:
+    std::vector<WorkerPool::Task*> tasks;
+
+    ~TaskList() {
+      for (size_t i = 0; i < tasks.size(); i++) {
+        delete tasks[i];
+      }
+    }
+  };
+
+  Region makeRegion(int left, int top, int width, int height) {
+    Region region;
+    region.left = left;
+    region.top = top;
+    region.width = width;
+    region.height = height;
+    return region;
+  }
+}
+
+TiledMultipleBarcodeReader::TiledMultipleBarcodeReader() {}
+
+TiledMultipleBarcodeReader::~TiledMultipleBarcodeReader() {}
+
+std::vector<Ref<Result> > TiledMultipleBarcodeReader::decodeMultiple(Ref<BinaryBitmap> image,
+  DecodeHints hints)
+{
+  if (hints.getTimeLimit() > 0) {
+    hints.setDeadline(Ref<Deadline>(new Deadline(hints.getTimeLimit())));
+  }
+  Ref<BitMatrix> matrix(image->getBlackMatrix());
+  int width = matrix->getWidth();
+  int height = matrix->getHeight();
+
+  Collector collector;
+  TaskList list;
+
+  if (hints.containsFormat(BarcodeFormat_QR_CODE)) {
+    std::vector<Ref<qrcode::FinderPatternInfo> > infos;
+    try {
+      MultiFinderPatternFinder finder(matrix, hints.getResultPointCallback());
+      infos = finder.findMulti(hints);
+    } catch (ReaderException const& re) {
+      // no QR codes
+    }
+    for (size_t i = 0; i < infos.size(); i++) {
+      list.tasks.push_back(new QRCodeTask(matrix, hints, collector, infos[i]));
+    }
+  }
+
+  if (hints.containsFormat(BarcodeFormat_AZTEC)) {
+    std::vector<Region> regions(findBullseyes(matrix, BULLSEYE_ROW_SKIP));
+    for (size_t i = 0; i < regions.size(); i++) {
+      list.tasks.push_back(new AztecTask(matrix, hints, collector, regions[i]));
+    }
+  }
+
+  if (hints.containsFormat(BarcodeFormat_DATA_MATRIX)) {
+    int halfWidth = width / 2;
+    int halfHeight = height / 2;
+    list.tasks.push_back(new DataMatrixTask(matrix, hints, collector, makeRegion(0, 0, width, height)));
+    if (halfWidth >= MIN_TILE_DIMENSION && halfHeight >= MIN_TILE_DIMENSION) {
+      list.tasks.push_back(new DataMatrixTask(matrix, hints, collector,
+                                              makeRegion(0, 0, halfWidth, halfHeight)));
+      list.tasks.push_back(new DataMatrixTask(matrix, hints, collector,
+                                              makeRegion(halfWidth, 0, width - halfWidth, halfHeight)));
+      list.tasks.push_back(new DataMatrixTask(matrix, hints, collector,
+                                              makeRegion(0, halfHeight, halfWidth, height - halfHeight)));
+      list.tasks.push_back(new DataMatrixTask(matrix, hints, collector,
+                                              makeRegion(halfWidth, halfHeight, width - halfWidth, height - halfHeight)));
+      list.tasks.push_back(new DataMatrixTask(matrix, hints, collector,
+                                              makeRegion(halfWidth / 2, halfHeight / 2, halfWidth, halfHeight)));
+    }
+  }
+
+  bool oneD = hints.containsFormat(BarcodeFormat_UPC_E) ||
+              hints.containsFormat(BarcodeFormat_UPC_A) ||
+              hints.containsFormat(BarcodeFormat_EAN_8) ||
+              hints.containsFormat(BarcodeFormat_EAN_13) ||
+              hints.containsFormat(BarcodeFormat_CODE_128) ||
+              hints.containsFormat(BarcodeFormat_CODE_39) ||
+              hints.containsFormat(BarcodeFormat_ITF);
+  int threads = hints.getMaxWorkers() < 1 ? 1 : hints.getMaxWorkers();
+  if (oneD) {
+    int rowStep = height >> (hints.getTryHarder() ? 8 : 5);
+    if (rowStep < 1) {
+      rowStep = 1;
+    }
+    // Interleave the rows over a few tasks per thread so they share the
+    // work evenly whatever part of the image the barcodes are in.
+    int bands = 2 * threads;
+    for (int band = 0; band < bands; band++) {
+      list.tasks.push_back(new OneDTask(matrix, hints, collector, image->getLuminanceSource(),
+                                        rowStep / 2 + band * rowStep, bands * rowStep));
+    }
+  }
+
+  if (threads > (int)list.tasks.size()) {
+    threads = list.tasks.size();
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+  if (pool_.empty() || pool_->getThreads() != threads) {
+    pool_ = new WorkerPool(threads);
+  }
+  pthread_mutex_init(&collector.mutex, 0);
+  pool_->run(list.tasks);
+  pthread_mutex_destroy(&collector.mutex);
+
+  if (collector.results.empty()) {
+    throw ReaderException("No code detected");
+  }
+  return collector.results;
+}
+
+std::vector<TiledMultipleBarcodeReader::Region> TiledMultipleBarcodeReader::findBullseyes(Ref<BitMatrix> image,
+  int rowStep)
+{
+  int width = image->getWidth();
+  int height = image->getHeight();
+  std::vector<Region> regions;
+  std::vector<int> centers;
+  for (int y = rowStep / 2; y < height; y += rowStep) {
+    // The last nine runs along the row, oldest first.
+    int runs[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    bool color = image->get(0, y);
+    int length = 0;
+    for (int x = 0; x <= width; x++) {
+      bool black = x < width && image->get(x, y);
+      if (x < width && black == color) {
+        length++;
+        continue;
+      }
+      for (int i = 0; i < 8; i++) {
+        runs[i] = runs[i + 1];
+      }
+      runs[8] = length;
+      bool endedBlack = color;
+      color = black;
+      length = 1;
+
+      // The middle run is black when the one that just ended is.
+      float moduleSize;
+      if (!endedBlack || !isBullseyeRuns(runs, moduleSize)) {
+        continue;
+      }
+      int centerX = x - runs[8] - runs[7] - runs[6] - runs[5] - (runs[4] + 1) / 2;
+      int offset;
+      if (!crossCheck(image, centerX, y, 0, 1, offset)) {
+        continue;
+      }
+      int centerY = y + offset;
+      if (!crossCheck(image, centerX, centerY, 1, 1, offset) ||
+          !crossCheck(image, centerX, centerY, -1, 1, offset)) {
+        continue;
+      }
+      bool alreadyFound = false;
+      float minDistance = 7 * moduleSize;
+      for (size_t i = 0; i < centers.size(); i += 2) {
+        if (std::abs((float)(centers[i] - centerX)) < minDistance &&
+            std::abs((float)(centers[i + 1] - centerY)) < minDistance) {
+          alreadyFound = true;
+          break;
+        }
+      }
+      if (alreadyFound) {
+        continue;
+      }
+      centers.push_back(centerX);
+      centers.push_back(centerY);
+
+      int half = (int) (moduleSize * AZTEC_MAX_HALF_SIZE);
+      int left = centerX - half < 0 ? 0 : centerX - half;
+      int top = centerY - half < 0 ? 0 : centerY - half;
+      int right = centerX + half > width ? width : centerX + half;
+      int bottom = centerY + half > height ? height : centerY + half;
+      regions.push_back(makeRegion(left, top, right - left, bottom - top));
+    }
+  }
+  return regions;
+}
+
+} // End zxing::multi namespace
+} // End zxing namespace
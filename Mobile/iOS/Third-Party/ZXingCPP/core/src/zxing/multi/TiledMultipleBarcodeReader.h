@@ -0,0 +1,64 @@
+#ifndef __TILED_MULTIPLE_BARCODE_READER_H__
+#define __TILED_MULTIPLE_BARCODE_READER_H__
+
+/*
+ *  Copyright 2011 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/MultipleBarcodeReader.h>
+#include <zxing/common/BitMatrix.h>
+#include <zxing/common/WorkerPool.h>
+
+namespace zxing {
+namespace multi {
+
+/*
+ * Finds every barcode in an image without re-running detection on crops.
+ * The image is binarized once; a single pass over the matrix then collects
+ * candidates (QR finder pattern triples, Aztec bullseyes, bands of rows for
+ * the 1D readers, and quadrant tiles for Data Matrix, which has no finder
+ * pattern to search for), and the candidates are decoded on up to
+ * DecodeHints::getMaxWorkers() threads. Results are deduplicated by format
+ * and text, like GenericMultipleBarcodeReader's.
+ */
+class TiledMultipleBarcodeReader : public MultipleBarcodeReader {
+  public:
+    struct Region {
+      int left;
+      int top;
+      int width;
+      int height;
+    };
+
+  private:
+    Ref<WorkerPool> pool_;
+
+    static const int MIN_TILE_DIMENSION = 100;
+
+  public:
+    TiledMultipleBarcodeReader();
+    virtual ~TiledMultipleBarcodeReader();
+    virtual std::vector<Ref<Result> > decodeMultiple(Ref<BinaryBitmap> image,
+                                                     DecodeHints hints);
+
+    // Returns a square around each Aztec bullseye found by scanning every
+    // rowStep-th row, sized to hold the largest symbol at that module size.
+    static std::vector<Region> findBullseyes(Ref<BitMatrix> image, int rowStep);
+};
+
+} // End zxing::multi namespace
+} // End zxing namespace
+
+#endif // __TILED_MULTIPLE_BARCODE_READER_H__
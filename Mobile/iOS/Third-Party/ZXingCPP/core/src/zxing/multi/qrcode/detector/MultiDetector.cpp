@@ -17,6 +17,7 @@
 #include <zxing/multi/qrcode/detector/MultiDetector.h>
 #include <zxing/multi/qrcode/detector/MultiFinderPatternFinder.h>
 #include <zxing/ReaderException.h>
+#include <zxing/common/StageTimer.h>
 
 namespace zxing {
 namespace multi {
@@ -27,6 +28,7 @@ MultiDetector::MultiDetector(Ref<BitMatrix> image) : Detector(image) {}
 MultiDetector::~MultiDetector(){}
 
 std::vector<Ref<DetectorResult> > MultiDetector::detectMulti(DecodeHints hints){
+  StageTimer timer(StageTimer::DETECT);
   Ref<BitMatrix> image = getImage();
   MultiFinderPatternFinder finder = MultiFinderPatternFinder(image, hints.getResultPointCallback());
   std::vector<Ref<FinderPatternInfo> > info = finder.findMulti(hints);
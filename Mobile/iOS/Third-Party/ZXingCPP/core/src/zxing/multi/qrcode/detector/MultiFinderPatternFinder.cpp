@@ -62,6 +62,8 @@ std::vector<Ref<FinderPatternInfo> > MultiFinderPatternFinder::findMulti(DecodeH
   }
 
   int stateCount[5];
+  Ref<BitArray> rowRef(new BitArray(maxJ));
+  BitArray& row = *rowRef;
   for (int i = iSkip - 1; i < maxI; i += iSkip) {
     // Get a row of black/white values
     stateCount[0] = 0;
@@ -70,8 +72,10 @@ std::vector<Ref<FinderPatternInfo> > MultiFinderPatternFinder::findMulti(DecodeH
     stateCount[3] = 0;
     stateCount[4] = 0;
     int currentState = 0;
+    image->getRow(i, rowRef);
     for (int j = 0; j < maxJ; j++) {
-      if (image->get(j, i)) {
+      bool black = row.get(j);
+      if (black) {
         // Black pixel
         if ((currentState & 1) == 1) { // Counting white pixels
           currentState++;
@@ -83,10 +87,8 @@ std::vector<Ref<FinderPatternInfo> > MultiFinderPatternFinder::findMulti(DecodeH
             if (foundPatternCross(stateCount)) { // Yes
               bool confirmed = handlePossibleCenter(stateCount, i, j);
               if (!confirmed) {
-                do { // Advance to next black pixel
-                  j++;
-                } while (j < maxJ && !image->get(j, i));
-                  j--; // back up to that last white pixel
+                // Advance to the last white pixel before the next black one
+                j = row.getNextSet(j + 1) - 1;
               }
               // Clear state to start looking again
               currentState = 0;
@@ -110,6 +112,12 @@ std::vector<Ref<FinderPatternInfo> > MultiFinderPatternFinder::findMulti(DecodeH
             stateCount[currentState]++;
         }
       }
+      // Skip the rest of the run, as FinderPatternFinder::find() does.
+      if (j + 1 < maxJ && ((currentState & 1) == 0) == black) {
+        int runEnd = black ? row.getNextUnset(j + 1) : row.getNextSet(j + 1);
+        stateCount[currentState] += runEnd - j - 1;
+        j = runEnd - 1;
+      }
     } // for j=...
 
     if (foundPatternCross(stateCount)) {
@@ -144,13 +144,7 @@ namespace zxing {
 
 		int* Code128Reader::findStartPattern(Ref<BitArray> row){
 			int width = row->getSize();
-			int rowOffset = 0;
-			while (rowOffset < width) {
-				if (row->get(rowOffset)) {
-					break;
-				}
-				rowOffset++;
-			}
+			int rowOffset = row->getNextSet(0);
 
 			int counterPosition = 0;
 			int counters[countersLength] = {0,0,0,0,0,0};
@@ -161,7 +155,11 @@ namespace zxing {
 			for (int i = rowOffset; i < width; i++) {
 				bool pixel = row->get(i);
 				if (pixel ^ isWhite) {
-					counters[counterPosition]++;
+					// Count the whole run at once; the loop resumes at the
+					// first pixel of the next one.
+					int runEnd = isWhite ? row->getNextSet(i) : row->getNextUnset(i);
+					counters[counterPosition] += runEnd - i;
+					i = runEnd - 1;
 				} else {
 					if (counterPosition == patternLength - 1) {
 						unsigned int bestVariance = MAX_AVG_VARIANCE;
@@ -424,9 +422,7 @@ namespace zxing {
         // we fudged decoding CODE_STOP since it actually has 7 bars, not 6. There is a black bar left
         // to read off. Would be slightly better to properly read. Here we just skip it:
         int width = row->getSize();
-        while (nextStart < width && row->get(nextStart)) {
-          nextStart++;
-        }
+        nextStart = row->getNextUnset(nextStart);
         if (!row->isRange(nextStart,
                           std::min(width, nextStart + (nextStart - lastStart) / 2),
                           false)) {
@@ -86,9 +86,7 @@ namespace oned {
       int end = row->getSize();
 
       // Read off white space
-      while (nextStart < end && !row->get(nextStart)) {
-        nextStart++;
-      }
+      nextStart = row->getNextSet(nextStart);
 
       std::string tmpResultString;
 
@@ -114,9 +112,7 @@ namespace oned {
           nextStart += counters[i];
         }
         // Read off white space
-        while (nextStart < end && !row->get(nextStart)) {
-          nextStart++;
-        }
+        nextStart = row->getNextSet(nextStart);
       } while (decodedChar != '*');
       tmpResultString.erase(tmpResultString.length()-1, 1);// remove asterisk
 
@@ -180,13 +176,7 @@ namespace oned {
 
   int* Code39Reader::findAsteriskPattern(Ref<BitArray> row){
     int width = row->getSize();
-    int rowOffset = 0;
-    while (rowOffset < width) {
-      if (row->get(rowOffset)) {
-        break;
-      }
-      rowOffset++;
-    }
+    int rowOffset = row->getNextSet(0);
 
     int counterPosition = 0;
     const int countersLen = 9;
@@ -201,7 +191,11 @@ namespace oned {
     for (int i = rowOffset; i < width; i++) {
       bool pixel = row->get(i);
       if (pixel ^ isWhite) {
-        counters[counterPosition]++;
+        // Count the whole run at once; the loop resumes at the
+        // first pixel of the next one.
+        int runEnd = isWhite ? row->getNextSet(i) : row->getNextUnset(i);
+        counters[counterPosition] += runEnd - i;
+        i = runEnd - 1;
       } else {
         if (counterPosition == patternLength - 1) {
           // Look for whitespace before start pattern, >= 50% of width of
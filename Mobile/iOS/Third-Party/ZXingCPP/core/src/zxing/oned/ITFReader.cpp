@@ -264,13 +264,7 @@ namespace zxing {
      */
     int ITFReader::skipWhiteSpace(Ref<BitArray> row) {
       int width = row->getSize();
-      int endStart = 0;
-      while (endStart < width) {
-        if (row->get(endStart)) {
-          break;
-        }
-        endStart++;
-      }
+      int endStart = row->getNextSet(0);
       if (endStart == width) {
         throw ReaderException("");
       }
@@ -303,7 +297,11 @@ namespace zxing {
       for (int x = rowOffset; x < width; x++) {
         bool pixel = row->get(x);
         if (pixel ^ isWhite) {
-          counters[counterPosition]++;
+          // Count the whole run at once; the loop resumes at the
+          // first pixel of the next one.
+          int runEnd = isWhite ? row->getNextSet(x) : row->getNextUnset(x);
+          counters[counterPosition] += runEnd - x;
+          x = runEnd - 1;
         } else {
           if (counterPosition == patternLength - 1) {
             if (patternMatchVariance(counters, patternLength, pattern,
@@ -21,6 +21,7 @@
 #include "OneDReader.h"
 #include <zxing/ReaderException.h>
 #include <zxing/oned/OneDResultPoint.h>
+#include <zxing/common/StageTimer.h>
 #include <math.h>
 #include <limits.h>
 
@@ -32,6 +33,7 @@ namespace zxing {
     }
 
     Ref<Result> OneDReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
+      StageTimer timer(StageTimer::DETECT);
       Ref<Result> result = doDecode(image, hints);
       if (result.empty() && hints.getTryHarder() && image->isRotateSupported()) {
         Ref<BinaryBitmap> rotatedImage(image->rotateCounterClockwise());
@@ -86,6 +88,8 @@ namespace zxing {
           break;
         }
 
+        hints.checkDeadline();
+
         // Estimate black point for this row and load it:
         try {
           row = image->getBlackRow(rowNumber, row);
@@ -179,19 +183,18 @@ namespace zxing {
       int counterPosition = 0;
       int i = start;
       while (i < end) {
-        bool pixel = row->get(i);
-        if (pixel ^ isWhite) { // that is, exactly one is true
-          counters[counterPosition]++;
-        } else {
-          counterPosition++;
-          if (counterPosition == numCounters) {
-            break;
-          } else {
-            counters[counterPosition] = 1;
-            isWhite ^= true; // isWhite = !isWhite;
-          }
+        // Count the whole run of this color at once
+        int runEnd = isWhite ? row->getNextSet(i) : row->getNextUnset(i);
+        counters[counterPosition] += runEnd - i;
+        i = runEnd;
+        if (i == end) {
+          break;
+        }
+        counterPosition++;
+        if (counterPosition == numCounters) {
+          break;
         }
-        i++;
+        isWhite ^= true; // isWhite = !isWhite;
       }
       // If we read fully the last section of pixels and filled up our counters -- or filled
       // the last counter but ran off the side of the image, OK. Otherwise, a problem.
@@ -172,21 +172,19 @@ namespace zxing {
         counters[i] = 0;
       }
       int width = row->getSize();
-      bool isWhite = false;
-      while (rowOffset < width) {
-        isWhite = !row->get(rowOffset);
-        if (whiteFirst == isWhite) {
-          break;
-        }
-        rowOffset++;
-      }
+      rowOffset = whiteFirst ? row->getNextUnset(rowOffset) : row->getNextSet(rowOffset);
+      bool isWhite = whiteFirst;
 
       int counterPosition = 0;
       int patternStart = rowOffset;
       for (int x = rowOffset; x < width; x++) {
         bool pixel = row->get(x);
         if (pixel ^ isWhite) {
-          counters[counterPosition]++;
+          // Count the whole run at once; the loop resumes at the
+          // first pixel of the next one.
+          int runEnd = isWhite ? row->getNextSet(x) : row->getNextUnset(x);
+          counters[counterPosition] += runEnd - x;
+          x = runEnd - 1;
         } else {
           if (counterPosition == patternLength - 1) {
             if (patternMatchVariance(counters, countersCount, pattern,
@@ -21,6 +21,7 @@
 
 #include <zxing/qrcode/QRCodeReader.h>
 #include <zxing/qrcode/detector/Detector.h>
+#include <zxing/common/DecodeArena.h>
 
 #include <iostream>
 
@@ -37,7 +38,12 @@ namespace zxing {
 			cout << "decoding image " << image.object_ << ":\n" << flush;
 #endif
 			
-			Detector detector(image->getBlackMatrix());
+			Ref<BitMatrix> matrix(image->getBlackMatrix());
+			// Everything below is scratch except the Result, which keep()
+			// copies out. A callback could hold on to result points, so
+			// the arena is only used without one.
+			DecodeArena::Scope arena(hints.getResultPointCallback().empty());
+			Detector detector(matrix);
 			
 			
 #ifdef DEBUG
@@ -73,7 +79,7 @@ namespace zxing {
 			cout << "(5) created result " << result.object_ << ", returning\n" << flush;
 #endif
 			
-			return result;
+			return arena.keep(result);
 		}
 		
 		QRCodeReader::~QRCodeReader() {
@@ -23,6 +23,7 @@
 #include <zxing/common/CharacterSetECI.h>
 #include <zxing/FormatException.h>
 #include <zxing/common/StringUtils.h>
+#include <zxing/common/StageTimer.h>
 #include <iostream>
 #ifndef NO_ICONV
 #include <iconv.h>
@@ -339,6 +340,7 @@ DecodedBitStreamParser::decode(ArrayRef<unsigned char> bytes,
                                Version* version,
                                ErrorCorrectionLevel const& ecLevel,
                                Hashtable const& hints) {
+  StageTimer timer(StageTimer::PARSE);
   Ref<BitSource> bits_ (new BitSource(bytes));
   BitSource& bits (*bits_);
   string result;
@@ -28,6 +28,7 @@
 #include <zxing/common/GridSampler.h>
 #include <zxing/DecodeHints.h>
 #include <zxing/common/detector/math_utils.h>
+#include <zxing/common/StageTimer.h>
 #include <sstream>
 #include <cstdlib>
 
@@ -58,12 +59,19 @@ Ref<ResultPointCallback> Detector::getResultPointCallback() const {
 }
 
 Ref<DetectorResult> Detector::detect(DecodeHints const& hints) {
+  StageTimer timer(StageTimer::DETECT);
   callback_ = hints.getResultPointCallback();
   FinderPatternFinder finder(image_, hints.getResultPointCallback());
   Ref<FinderPatternInfo> info(finder.find(hints));
   return processFinderPatternInfo(info);
 }
 
+Ref<DetectorResult> Detector::processFinderPatternInfo(Ref<FinderPatternInfo> info,
+                                                       DecodeHints const& hints) {
+  callback_ = hints.getResultPointCallback();
+  return processFinderPatternInfo(info);
+}
+
 Ref<DetectorResult> Detector::processFinderPatternInfo(Ref<FinderPatternInfo> info){
   Ref<FinderPattern> topLeft(info->getTopLeft());
   Ref<FinderPattern> topRight(info->getTopRight());
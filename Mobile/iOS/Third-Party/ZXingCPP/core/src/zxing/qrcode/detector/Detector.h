@@ -53,13 +53,17 @@ protected:
   float sizeOfBlackWhiteBlackRun(int fromX, int fromY, int toX, int toY);
   Ref<AlignmentPattern> findAlignmentInRegion(float overallEstModuleSize, int estAlignmentX, int estAlignmentY,
       float allowanceFactor);
-  Ref<DetectorResult> processFinderPatternInfo(Ref<FinderPatternInfo> info);
 public:
   virtual Ref<PerspectiveTransform> createTransform(Ref<ResultPoint> topLeft, Ref<ResultPoint> topRight, Ref <
       ResultPoint > bottomLeft, Ref<ResultPoint> alignmentPattern, int dimension);
 
   Detector(Ref<BitMatrix> image);
   Ref<DetectorResult> detect(DecodeHints const& hints);
+  // Samples the symbol framed by finder patterns that were found elsewhere,
+  // e.g. in an earlier frame of the same scene. The second form reports the
+  // alignment pattern to the hints' ResultPointCallback, as detect() does.
+  Ref<DetectorResult> processFinderPatternInfo(Ref<FinderPatternInfo> info);
+  Ref<DetectorResult> processFinderPatternInfo(Ref<FinderPatternInfo> info, DecodeHints const& hints);
 
 
 };
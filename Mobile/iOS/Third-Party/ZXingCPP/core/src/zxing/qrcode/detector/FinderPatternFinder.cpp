@@ -441,10 +441,14 @@ Ref<FinderPatternInfo> FinderPatternFinder::find(DecodeHints const& hints) {
       iSkip = MIN_SKIP;
   }
 
-  // This is slightly faster than using the Ref. Efficiency is important here
-  BitMatrix& matrix = *image_;
+  // Each scanned row is copied out once, so runs can be skipped a word at
+  // a time. This is slightly faster than using the Ref.
+  Ref<BitArray> rowRef(new BitArray(maxJ));
+  BitArray& row = *rowRef;
 
   for (size_t i = iSkip - 1; i < maxI && !done; i += iSkip) {
+    hints.checkDeadline();
+
     // Get a row of black/white values
 
     stateCount[0] = 0;
@@ -453,8 +457,10 @@ Ref<FinderPatternInfo> FinderPatternFinder::find(DecodeHints const& hints) {
     stateCount[3] = 0;
     stateCount[4] = 0;
     int currentState = 0;
+    image_->getRow(i, rowRef);
     for (size_t j = 0; j < maxJ; j++) {
-      if (matrix.get(j, i)) {
+      bool black = row.get(j);
+      if (black) {
         // Black pixel
         if ((currentState & 1) == 1) { // Counting white pixels
           currentState++;
@@ -518,6 +524,13 @@ Ref<FinderPatternInfo> FinderPatternFinder::find(DecodeHints const& hints) {
           stateCount[currentState]++;
         }
       }
+      // The rest of a run only adds to the count of its color, so when that
+      // is the count being kept, add it in one go.
+      if (j + 1 < maxJ && ((currentState & 1) == 0) == black) {
+        size_t runEnd = black ? row.getNextUnset(j + 1) : row.getNextSet(j + 1);
+        stateCount[currentState] += runEnd - j - 1;
+        j = runEnd - 1;
+      }
     }
     if (foundPatternCross(stateCount)) {
       bool confirmed = handlePossibleCenter(stateCount, i, maxJ);
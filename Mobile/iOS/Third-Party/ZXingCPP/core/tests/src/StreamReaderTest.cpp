@@ -0,0 +1,194 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  StreamReaderTest.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StreamReaderTest.h"
+#include <zxing/StreamReader.h>
+#include <zxing/NotFoundException.h>
+#include <zxing/ResultPointCallback.h>
+#include <zxing/common/GreyscaleLuminanceSource.h>
+#include <zxing/common/GlobalHistogramBinarizer.h>
+#include <cstring>
+
+namespace zxing {
+using namespace std;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StreamReaderTest);
+
+namespace {
+
+// Stands in for a real reader: "decodes" the dark pixels of an image by
+// returning the corners of their bounding box, and remembers how much of
+// the frame it was given.
+class SquareReader : public Reader {
+public:
+  int calls;
+  int lastWidth;
+  int lastHeight;
+  DecodeHints lastHints;
+
+  SquareReader() :
+      calls(0), lastWidth(0), lastHeight(0) {
+  }
+
+  Ref<Result> decode(Ref<BinaryBitmap> image, DecodeHints hints) {
+    calls++;
+    lastHints = hints;
+    lastWidth = image->getWidth();
+    lastHeight = image->getHeight();
+    Ref<LuminanceSource> source(image->getLuminanceSource());
+    unsigned char* row = new unsigned char[lastWidth];
+    int minX = lastWidth, minY = lastHeight, maxX = -1, maxY = -1;
+    for (int y = 0; y < lastHeight; y++) {
+      source->getRow(y, row);
+      for (int x = 0; x < lastWidth; x++) {
+        if (row[x] < 128) {
+          minX = min(minX, x);
+          minY = min(minY, y);
+          maxX = max(maxX, x);
+          maxY = max(maxY, y);
+        }
+      }
+    }
+    delete[] row;
+    if (maxX < 0) {
+      throw NotFoundException();
+    }
+    vector<Ref<ResultPoint> > points;
+    points.push_back(Ref<ResultPoint>(new ResultPoint((float)minX, (float)minY)));
+    points.push_back(Ref<ResultPoint>(new ResultPoint((float)maxX, (float)maxY)));
+    if (!hints.getResultPointCallback().empty()) {
+      hints.getResultPointCallback()->foundPossibleResultPoint(*points[0]);
+    }
+    return Ref<Result>(new Result(Ref<String>(new String("square")), ArrayRef<unsigned char>(),
+                                  points, BarcodeFormat_DATA_MATRIX));
+  }
+};
+
+class PointRecorder : public ResultPointCallback {
+public:
+  vector<ResultPoint> points;
+
+  void foundPossibleResultPoint(ResultPoint const& point) {
+    points.push_back(point);
+  }
+};
+
+void checkPoint(Ref<Result> result, int i, float x, float y) {
+  CPPUNIT_ASSERT_EQUAL(x, result->getResultPoints()[i]->getX());
+  CPPUNIT_ASSERT_EQUAL(y, result->getResultPoints()[i]->getY());
+}
+
+}
+
+StreamReaderTest::StreamReaderTest() {
+  memset(frame_, 0, sizeof(frame_));
+}
+
+void StreamReaderTest::testTracksRegion() {
+  SquareReader squares;
+  StreamReader stream(squares);
+
+  Ref<Result> result(stream.decode(drawFrame(40, 30)));
+  CPPUNIT_ASSERT(stream.isTracking());
+  CPPUNIT_ASSERT_EQUAL(1, squares.calls);
+  CPPUNIT_ASSERT_EQUAL((int)frameWidth, squares.lastWidth);
+  checkPoint(result, 0, 40, 30);
+
+  // The square has moved a little: only the region around it is decoded,
+  // and the points come back in frame coordinates.
+  result = stream.decode(drawFrame(44, 32));
+  CPPUNIT_ASSERT(stream.isTracking());
+  CPPUNIT_ASSERT_EQUAL(2, squares.calls);
+  CPPUNIT_ASSERT(squares.lastWidth < frameWidth);
+  CPPUNIT_ASSERT(squares.lastHeight < frameHeight);
+  checkPoint(result, 0, 44, 32);
+  checkPoint(result, 1, 44 + squareSize - 1, 32 + squareSize - 1);
+}
+
+void StreamReaderTest::testPassesHints() {
+  SquareReader squares;
+  StreamReader stream(squares);
+  Ref<PointRecorder> recorder(new PointRecorder());
+  DecodeHints hints(DecodeHints::BARCODEFORMAT_DATA_MATRIX_HINT);
+  hints.setTryHarder(true);
+  hints.setResultPointCallback(recorder);
+
+  stream.decode(drawFrame(40, 30), hints);
+  stream.decode(drawFrame(44, 32), hints);
+  CPPUNIT_ASSERT_EQUAL(2, squares.calls);
+  CPPUNIT_ASSERT(squares.lastWidth < frameWidth);
+  CPPUNIT_ASSERT(squares.lastHints.getTryHarder());
+  CPPUNIT_ASSERT(squares.lastHints.containsFormat(BarcodeFormat_DATA_MATRIX));
+  CPPUNIT_ASSERT(!squares.lastHints.containsFormat(BarcodeFormat_QR_CODE));
+  // Points found in the region reach the callback in frame coordinates.
+  CPPUNIT_ASSERT_EQUAL((size_t)2, recorder->points.size());
+  CPPUNIT_ASSERT_EQUAL(40.0f, recorder->points[0].getX());
+  CPPUNIT_ASSERT_EQUAL(44.0f, recorder->points[1].getX());
+  CPPUNIT_ASSERT_EQUAL(32.0f, recorder->points[1].getY());
+}
+
+void StreamReaderTest::testFallsBackToFrame() {
+  SquareReader squares;
+  StreamReader stream(squares);
+  stream.decode(drawFrame(40, 30));
+
+  // Too far from the previous region: found in the whole frame instead.
+  Ref<Result> result(stream.decode(drawFrame(150, 100)));
+  CPPUNIT_ASSERT(stream.isTracking());
+  CPPUNIT_ASSERT_EQUAL(3, squares.calls);
+  CPPUNIT_ASSERT_EQUAL((int)frameWidth, squares.lastWidth);
+  checkPoint(result, 0, 150, 100);
+}
+
+void StreamReaderTest::testLosesTrack() {
+  SquareReader squares;
+  StreamReader stream(squares);
+  stream.decode(drawFrame(40, 30));
+
+  CPPUNIT_ASSERT_THROW(stream.decode(drawBlankFrame()), NotFoundException);
+  CPPUNIT_ASSERT(!stream.isTracking());
+  CPPUNIT_ASSERT_EQUAL(3, squares.calls);
+
+  // With nothing to track, the next frame is decoded whole.
+  stream.decode(drawFrame(44, 32));
+  CPPUNIT_ASSERT_EQUAL(4, squares.calls);
+  CPPUNIT_ASSERT_EQUAL((int)frameWidth, squares.lastWidth);
+}
+
+Ref<BinaryBitmap> StreamReaderTest::drawFrame(int x, int y) {
+  memset(frame_, 255, sizeof(frame_));
+  for (int i = y; i < y + squareSize; i++) {
+    memset(&frame_[i * frameWidth + x], 0, squareSize);
+  }
+  return bitmap();
+}
+
+Ref<BinaryBitmap> StreamReaderTest::drawBlankFrame() {
+  memset(frame_, 255, sizeof(frame_));
+  return bitmap();
+}
+
+Ref<BinaryBitmap> StreamReaderTest::bitmap() {
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(frame_, frameWidth, frameHeight,
+      0, 0, frameWidth, frameHeight));
+  return Ref<BinaryBitmap>(new BinaryBitmap(Ref<Binarizer>(new GlobalHistogramBinarizer(source))));
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef __STREAM_READER_TEST_H__
+#define __STREAM_READER_TEST_H__
+
+/*
+ *  StreamReaderTest.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <zxing/BinaryBitmap.h>
+
+namespace zxing {
+class StreamReaderTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(StreamReaderTest);
+  CPPUNIT_TEST(testTracksRegion);
+  CPPUNIT_TEST(testPassesHints);
+  CPPUNIT_TEST(testFallsBackToFrame);
+  CPPUNIT_TEST(testLosesTrack);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  StreamReaderTest();
+
+protected:
+  void testTracksRegion();
+  void testPassesHints();
+  void testFallsBackToFrame();
+  void testLosesTrack();
+
+private:
+  static const int frameWidth = 200;
+  static const int frameHeight = 150;
+  static const int squareSize = 20;
+  unsigned char frame_[frameWidth * frameHeight];
+
+  // A white frame with a black square whose top left corner is at (x, y).
+  Ref<BinaryBitmap> drawFrame(int x, int y);
+  Ref<BinaryBitmap> drawBlankFrame();
+  Ref<BinaryBitmap> bitmap();
+};
+}
+
+#endif // __STREAM_READER_TEST_H__
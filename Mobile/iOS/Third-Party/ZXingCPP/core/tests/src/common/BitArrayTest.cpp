@@ -94,6 +94,41 @@ void BitArrayTest::testIsRange() {
   CPPUNIT_ASSERT_EQUAL(false, array.isRange(0, 64, false));
 }
 
+void BitArrayTest::testGetNextSet() {
+  size_t bits = numeric_limits<unsigned int>::digits;
+  BitArray array(3 * bits + 5);
+  CPPUNIT_ASSERT_EQUAL((int)array.getSize(), array.getNextSet(0));
+  CPPUNIT_ASSERT_EQUAL(0, array.getNextUnset(0));
+  array.setRange(3, 2 * bits + 1);
+  CPPUNIT_ASSERT_EQUAL(3, array.getNextSet(0));
+  CPPUNIT_ASSERT_EQUAL(3, array.getNextSet(3));
+  CPPUNIT_ASSERT_EQUAL(bits, (size_t)array.getNextSet(bits));
+  CPPUNIT_ASSERT_EQUAL(2 * bits + 1, (size_t)array.getNextUnset(3));
+  CPPUNIT_ASSERT_EQUAL((int)array.getSize(), array.getNextSet(2 * bits + 1));
+  CPPUNIT_ASSERT_EQUAL((int)array.getSize(), array.getNextSet(array.getSize()));
+  array.setRange(2 * bits + 2, array.getSize());
+  CPPUNIT_ASSERT_EQUAL((int)array.getSize(), array.getNextUnset(2 * bits + 2));
+}
+
+void BitArrayTest::testGetNextSweep() {
+  size_t bits = numeric_limits<unsigned int>::digits * 5 + 7;
+  BitArray test(bits);
+  BitArray reference(bits);
+  fillRandom(test, reference);
+  for (size_t from = 0; from <= bits; ++from) {
+    size_t nextSet = from;
+    while (nextSet < bits && !reference.get(nextSet)) {
+      nextSet++;
+    }
+    size_t nextUnset = from;
+    while (nextUnset < bits && reference.get(nextUnset)) {
+      nextUnset++;
+    }
+    CPPUNIT_ASSERT_EQUAL(nextSet, (size_t)test.getNextSet(from));
+    CPPUNIT_ASSERT_EQUAL(nextUnset, (size_t)test.getNextUnset(from));
+  }
+}
+
 // fills the two arrays with identical random bits
 void BitArrayTest::fillRandom(BitArray& test, BitArray& reference) {
   srandom(0xDEADBEEFL + test.getSize());
@@ -32,6 +32,8 @@ class BitArrayTest : public CPPUNIT_NS::TestFixture {
   CPPUNIT_TEST(testClear);
   CPPUNIT_TEST(testGetArray);
   CPPUNIT_TEST(testIsRange);
+  CPPUNIT_TEST(testGetNextSet);
+  CPPUNIT_TEST(testGetNextSweep);
   CPPUNIT_TEST(testReverseHalves);
   CPPUNIT_TEST(testReverseEven);
   CPPUNIT_TEST(testReverseOdd);
@@ -47,6 +49,8 @@ protected:
   void testClear();
   void testGetArray();
   void testIsRange();
+  void testGetNextSet();
+  void testGetNextSweep();
   void testReverseHalves();
   void testReverseEven();
   void testReverseOdd();
@@ -0,0 +1,140 @@
+/*
+ *  DecodeArenaTest.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DecodeArenaTest.h"
+#include <zxing/Result.h>
+#include <zxing/common/Array.h>
+
+namespace zxing {
+using namespace std;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DecodeArenaTest);
+
+namespace {
+
+class Tracked : public Counted {
+private:
+  int* destroyed_;
+  ArrayRef<int> payload_;
+public:
+  Tracked(int* destroyed, bool fail = false) :
+      destroyed_(destroyed), payload_(new Array<int>(16)) {
+    if (fail) {
+      throw 1;
+    }
+  }
+  ~Tracked() {
+    (*destroyed_)++;
+  }
+  ArrayRef<int> getPayload() {
+    return payload_;
+  }
+};
+
+}
+
+// These hold with and without ZXING_DECODE_ARENA: only when objects are
+// destroyed inside a Scope differs, and no test looks there.
+
+void DecodeArenaTest::testScopeDestroysObjects() {
+  int destroyed = 0;
+  {
+    DecodeArena::Scope arena;
+    for (int i = 0; i < 1000; i++) {
+      Ref<Tracked> tracked(new Tracked(&destroyed));
+      tracked->getPayload()[15] = i;
+      CPPUNIT_ASSERT_EQUAL(i, tracked->getPayload()[15]);
+    }
+  }
+  CPPUNIT_ASSERT_EQUAL(1000, destroyed);
+}
+
+void DecodeArenaTest::testNestedScope() {
+  int destroyed = 0;
+  {
+    DecodeArena::Scope outer;
+    Ref<Tracked> tracked(new Tracked(&destroyed));
+    {
+      DecodeArena::Scope inner;
+      Ref<Tracked> other(new Tracked(&destroyed));
+    }
+    tracked->getPayload()[0] = 7;
+    CPPUNIT_ASSERT_EQUAL(7, tracked->getPayload()[0]);
+    CPPUNIT_ASSERT(destroyed <= 1);
+  }
+  CPPUNIT_ASSERT_EQUAL(2, destroyed);
+}
+
+void DecodeArenaTest::testHeapObjectsInScope() {
+  int destroyed = 0;
+  Ref<Tracked> outside(new Tracked(&destroyed));
+  {
+    DecodeArena::Scope arena;
+    Ref<Tracked> copy(outside);
+    CPPUNIT_ASSERT_EQUAL(2, outside->count());
+    Ref<Tracked> kept;
+    {
+      DecodeArena::Suspend suspend;
+      kept = new Tracked(&destroyed);
+    }
+    CPPUNIT_ASSERT_EQUAL(1, kept->count());
+  }
+  CPPUNIT_ASSERT_EQUAL(1, destroyed);
+  CPPUNIT_ASSERT_EQUAL(1, outside->count());
+}
+
+void DecodeArenaTest::testThrowingConstructor() {
+  int destroyed = 0;
+  {
+    DecodeArena::Scope arena;
+    Ref<Tracked> before(new Tracked(&destroyed));
+    try {
+      Ref<Tracked> failed(new Tracked(&destroyed, true));
+      CPPUNIT_FAIL("constructor should have thrown");
+    } catch (int) {
+    }
+    Ref<Tracked> after(new Tracked(&destroyed));
+  }
+  // The failed object's destructor never ran; its members were destroyed
+  // during unwinding and must not be destroyed a second time.
+  CPPUNIT_ASSERT_EQUAL(2, destroyed);
+}
+
+void DecodeArenaTest::testKeep() {
+  Ref<Result> kept;
+  {
+    DecodeArena::Scope arena;
+    vector<Ref<ResultPoint> > points;
+    points.push_back(Ref<ResultPoint>(new ResultPoint(1.5f, 2.5f)));
+    ArrayRef<unsigned char> rawBytes(new Array<unsigned char>(3));
+    rawBytes[2] = 42;
+    Ref<Result> result(new Result(Ref<String>(new String("text")), rawBytes, points,
+                                  BarcodeFormat_QR_CODE));
+    kept = arena.keep(result);
+  }
+  CPPUNIT_ASSERT_EQUAL(string("text"), kept->getText()->getText());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, kept->getRawBytes().size());
+  CPPUNIT_ASSERT_EQUAL((unsigned char)42, kept->getRawBytes()[2]);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, kept->getResultPoints().size());
+  CPPUNIT_ASSERT_EQUAL(2.5f, kept->getResultPoints()[0]->getY());
+  CPPUNIT_ASSERT_EQUAL(BarcodeFormat_QR_CODE, kept->getBarcodeFormat());
+  CPPUNIT_ASSERT_EQUAL(1, kept->count());
+}
+
+}
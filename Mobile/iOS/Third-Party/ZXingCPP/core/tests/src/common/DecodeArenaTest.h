@@ -0,0 +1,46 @@
+#ifndef __DECODE_ARENA_TEST_H__
+#define __DECODE_ARENA_TEST_H__
+
+/*
+ *  DecodeArenaTest.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <zxing/common/DecodeArena.h>
+
+namespace zxing {
+class DecodeArenaTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(DecodeArenaTest);
+  CPPUNIT_TEST(testScopeDestroysObjects);
+  CPPUNIT_TEST(testNestedScope);
+  CPPUNIT_TEST(testHeapObjectsInScope);
+  CPPUNIT_TEST(testThrowingConstructor);
+  CPPUNIT_TEST(testKeep);
+  CPPUNIT_TEST_SUITE_END();
+
+protected:
+  void testScopeDestroysObjects();
+  void testNestedScope();
+  void testHeapObjectsInScope();
+  void testThrowingConstructor();
+  void testKeep();
+};
+}
+
+#endif // __DECODE_ARENA_TEST_H__
@@ -0,0 +1,129 @@
+/*
+ *  GreyscaleLuminanceSourceTest.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GreyscaleLuminanceSourceTest.h"
+#include <zxing/common/GreyscaleLuminanceSource.h>
+#include <zxing/common/HybridBinarizer.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <vector>
+
+namespace zxing {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GreyscaleLuminanceSourceTest);
+
+GreyscaleLuminanceSourceTest::GreyscaleLuminanceSourceTest() {
+  for (int i = 0; i < dataWidth * dataHeight; i++) {
+    data_[i] = (unsigned char)(i * 7);
+  }
+}
+
+void GreyscaleLuminanceSourceTest::testView() {
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(data_, dataWidth, dataHeight,
+      0, 0, dataWidth, dataHeight));
+  CPPUNIT_ASSERT(source->isViewSupported());
+  LuminanceView view = source->getView();
+  CPPUNIT_ASSERT(view.isContiguous());
+  CPPUNIT_ASSERT(view.data == data_);
+  checkViewMatchesRows(source);
+}
+
+void GreyscaleLuminanceSourceTest::testCroppedView() {
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(data_, dataWidth, dataHeight,
+      1, 2, 10, 4));
+  Ref<LuminanceSource> cropped = source->crop(3, 1, 5, 2);
+  CPPUNIT_ASSERT_EQUAL(5, cropped->getWidth());
+  CPPUNIT_ASSERT_EQUAL(2, cropped->getHeight());
+  CPPUNIT_ASSERT(cropped->getView().data == &data_[3 * dataWidth + 4]);
+  checkViewMatchesRows(cropped);
+}
+
+void GreyscaleLuminanceSourceTest::testRotatedView() {
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(data_, dataWidth, dataHeight,
+      0, 0, dataWidth, dataHeight));
+  Ref<LuminanceSource> rotated = source->rotateCounterClockwise();
+  CPPUNIT_ASSERT(rotated->isViewSupported());
+  CPPUNIT_ASSERT(!rotated->getView().isContiguous());
+  // The top-left corner of a counter-clockwise rotation is the top-right
+  // corner of the original.
+  CPPUNIT_ASSERT_EQUAL(data_[dataWidth - 1], rotated->getView().get(0, 0));
+  checkViewMatchesRows(rotated);
+}
+
+void GreyscaleLuminanceSourceTest::testRotatedCroppedView() {
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(data_, dataWidth, dataHeight,
+      0, 0, dataWidth, dataHeight));
+  Ref<LuminanceSource> cropped = source->rotateCounterClockwise()->crop(2, 3, 4, 6);
+  CPPUNIT_ASSERT_EQUAL(4, cropped->getWidth());
+  CPPUNIT_ASSERT_EQUAL(6, cropped->getHeight());
+  checkViewMatchesRows(cropped);
+}
+
+void GreyscaleLuminanceSourceTest::testCropOutsideSource() {
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(data_, dataWidth, dataHeight,
+      1, 2, 10, 4));
+  Ref<LuminanceSource> rotated = source->rotateCounterClockwise();
+  // Both lie inside the data, but not inside the source being cropped.
+  CPPUNIT_ASSERT_THROW(source->crop(-1, 0, 5, 2), IllegalArgumentException);
+  CPPUNIT_ASSERT_THROW(source->crop(0, -1, 5, 2), IllegalArgumentException);
+  CPPUNIT_ASSERT_THROW(source->crop(6, 0, 5, 2), IllegalArgumentException);
+  CPPUNIT_ASSERT_THROW(source->crop(0, 3, 5, 2), IllegalArgumentException);
+  CPPUNIT_ASSERT_THROW(rotated->crop(-1, 0, 2, 5), IllegalArgumentException);
+  CPPUNIT_ASSERT_THROW(rotated->crop(0, -1, 2, 5), IllegalArgumentException);
+  CPPUNIT_ASSERT_THROW(rotated->crop(3, 0, 2, 5), IllegalArgumentException);
+  CPPUNIT_ASSERT_THROW(rotated->crop(0, 6, 2, 5), IllegalArgumentException);
+}
+
+void GreyscaleLuminanceSourceTest::testBinarizeRotatedView() {
+  // Large enough for HybridBinarizer's block thresholds, and not a whole
+  // number of blocks or BitMatrix words.
+  const int width = 70;
+  const int height = 45;
+  std::vector<unsigned char> frame(width * height);
+  for (int i = 0; i < width * height; i++) {
+    frame[i] = (unsigned char)((i * 37 + (i / width) * 11) % 251);
+  }
+  Ref<LuminanceSource> rotated = Ref<LuminanceSource>(new GreyscaleLuminanceSource(&frame[0],
+      width, height, 0, 0, width, height))->rotateCounterClockwise()->crop(3, 5, 40, 62);
+  unsigned char* copy = rotated->getMatrix();
+  Ref<LuminanceSource> copied(new GreyscaleLuminanceSource(copy, 40, 62, 0, 0, 40, 62));
+  Ref<BitMatrix> expected = Ref<Binarizer>(new HybridBinarizer(copied))->getBlackMatrix();
+  Ref<BitMatrix> actual = Ref<Binarizer>(new HybridBinarizer(rotated))->getBlackMatrix();
+  for (int y = 0; y < 62; y++) {
+    for (int x = 0; x < 40; x++) {
+      CPPUNIT_ASSERT_EQUAL(expected->get(x, y), actual->get(x, y));
+    }
+  }
+  delete [] copy;
+}
+
+void GreyscaleLuminanceSourceTest::checkViewMatchesRows(Ref<LuminanceSource> source) {
+  LuminanceView view = source->getView();
+  CPPUNIT_ASSERT_EQUAL(source->getWidth(), view.width);
+  CPPUNIT_ASSERT_EQUAL(source->getHeight(), view.height);
+  unsigned char* row = new unsigned char[view.width];
+  for (int y = 0; y < view.height; y++) {
+    source->getRow(y, row);
+    for (int x = 0; x < view.width; x++) {
+      CPPUNIT_ASSERT_EQUAL(row[x], view.get(x, y));
+    }
+  }
+  delete [] row;
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef __GREYSCALE_LUMINANCE_SOURCE_TEST_H__
+#define __GREYSCALE_LUMINANCE_SOURCE_TEST_H__
+
+/*
+ *  GreyscaleLuminanceSourceTest.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <zxing/LuminanceSource.h>
+
+namespace zxing {
+class GreyscaleLuminanceSourceTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(GreyscaleLuminanceSourceTest);
+  CPPUNIT_TEST(testView);
+  CPPUNIT_TEST(testCroppedView);
+  CPPUNIT_TEST(testRotatedView);
+  CPPUNIT_TEST(testRotatedCroppedView);
+  CPPUNIT_TEST(testCropOutsideSource);
+  CPPUNIT_TEST(testBinarizeRotatedView);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  GreyscaleLuminanceSourceTest();
+
+protected:
+  void testView();
+  void testCroppedView();
+  void testRotatedView();
+  void testRotatedCroppedView();
+  void testCropOutsideSource();
+  void testBinarizeRotatedView();
+
+private:
+  static const int dataWidth = 13;
+  static const int dataHeight = 7;
+  unsigned char data_[dataWidth * dataHeight];
+
+  void checkViewMatchesRows(Ref<LuminanceSource> source);
+};
+}
+
+#endif // __GREYSCALE_LUMINANCE_SOURCE_TEST_H__
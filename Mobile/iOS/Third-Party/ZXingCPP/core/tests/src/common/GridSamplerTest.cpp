@@ -0,0 +1,104 @@
+/*
+ *  GridSamplerTest.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GridSamplerTest.h"
+#include <zxing/ReaderException.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace zxing {
+using namespace std;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GridSamplerTest);
+
+Ref<BitMatrix> GridSamplerTest::randomImage(int width, int height) {
+  Ref<BitMatrix> image(new BitMatrix(width, height));
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (random() & 0x1) {
+        image->set(x, y);
+      }
+    }
+  }
+  return image;
+}
+
+// Samples the grid one point at a time, the way GridSampler used to.
+void GridSamplerTest::assertSamplesAsTransformPoints(Ref<BitMatrix> image, int dimensionX, int dimensionY,
+                                                     Ref<PerspectiveTransform> transform) {
+  Ref<BitMatrix> bits(GridSampler::getInstance().sampleGrid(image, dimensionX, dimensionY, transform));
+  vector<float> points(dimensionX << 1, 0.0f);
+  for (int y = 0; y < dimensionY; y++) {
+    for (int x = 0; x < dimensionX; x++) {
+      points[x << 1] = (float)x + 0.5f;
+      points[(x << 1) + 1] = (float)y + 0.5f;
+    }
+    transform->transformPoints(points);
+    GridSampler::checkAndNudgePoints(image, points);
+    for (int x = 0; x < dimensionX; x++) {
+      CPPUNIT_ASSERT_EQUAL(image->get((int)points[x << 1], (int)points[(x << 1) + 1]), bits->get(x, y));
+    }
+  }
+}
+
+void GridSamplerTest::testSampleSquare() {
+  srandom(0xDEADBEEFL);
+  Ref<BitMatrix> image(randomImage(640, 480));
+  // A version 40 QR Code, seen at an angle.
+  Ref<PerspectiveTransform> transform(PerspectiveTransform::quadrilateralToQuadrilateral(
+      3.5f, 3.5f, 173.5f, 3.5f, 170.5f, 170.5f, 3.5f, 173.5f,
+      112.0f, 41.0f, 547.0f, 78.0f, 521.0f, 452.0f, 87.0f, 430.0f));
+  Ref<BitMatrix> bits(GridSampler::getInstance().sampleGrid(image, 177, transform));
+  CPPUNIT_ASSERT_EQUAL((size_t)177, bits->getDimension());
+  assertSamplesAsTransformPoints(image, 177, 177, transform);
+
+  // Small enough that no row fills a vector.
+  assertSamplesAsTransformPoints(image, 3, 3, transform);
+}
+
+void GridSamplerTest::testSampleRectangle() {
+  srandom(0xDEADBEEFL);
+  Ref<BitMatrix> image(randomImage(333, 201));
+  // A rectangular Data Matrix, rotated.
+  Ref<PerspectiveTransform> transform(PerspectiveTransform::quadrilateralToQuadrilateral(
+      0.0f, 0.0f, 48.0f, 0.0f, 48.0f, 16.0f, 0.0f, 16.0f,
+      60.0f, 20.0f, 300.0f, 80.0f, 270.0f, 190.0f, 30.0f, 130.0f));
+  assertSamplesAsTransformPoints(image, 48, 16, transform);
+}
+
+void GridSamplerTest::testNudgeEdges() {
+  srandom(0xDEADBEEFL);
+  Ref<BitMatrix> image(randomImage(70, 70));
+  // Module centers on the first row and column land just outside the image
+  // and on the last ones just past its far edge.
+  Ref<PerspectiveTransform> transform(PerspectiveTransform::quadrilateralToQuadrilateral(
+      0.5f, 0.5f, 69.5f, 0.5f, 69.5f, 69.5f, 0.5f, 69.5f,
+      -0.5f, -0.5f, 70.5f, -0.5f, 70.5f, 70.5f, -0.5f, 70.5f));
+  assertSamplesAsTransformPoints(image, 70, 70, transform);
+}
+
+void GridSamplerTest::testOutOfBounds() {
+  Ref<BitMatrix> image(new BitMatrix(100, 100));
+  Ref<PerspectiveTransform> transform(PerspectiveTransform::quadrilateralToQuadrilateral(
+      0.0f, 0.0f, 40.0f, 0.0f, 40.0f, 40.0f, 0.0f, 40.0f,
+      10.0f, 10.0f, 150.0f, 10.0f, 150.0f, 90.0f, 10.0f, 90.0f));
+  CPPUNIT_ASSERT_THROW(GridSampler::getInstance().sampleGrid(image, 40, transform), ReaderException);
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef __GRID_SAMPLER_TEST_H__
+#define __GRID_SAMPLER_TEST_H__
+
+/*
+ *  GridSamplerTest.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <zxing/common/GridSampler.h>
+
+namespace zxing {
+class GridSamplerTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(GridSamplerTest);
+  CPPUNIT_TEST(testSampleSquare);
+  CPPUNIT_TEST(testSampleRectangle);
+  CPPUNIT_TEST(testNudgeEdges);
+  CPPUNIT_TEST(testOutOfBounds);
+  CPPUNIT_TEST_SUITE_END();
+
+protected:
+  void testSampleSquare();
+  void testSampleRectangle();
+  void testNudgeEdges();
+  void testOutOfBounds();
+
+private:
+  static Ref<BitMatrix> randomImage(int width, int height);
+  static void assertSamplesAsTransformPoints(Ref<BitMatrix> image, int dimensionX, int dimensionY,
+                                             Ref<PerspectiveTransform> transform);
+};
+}
+
+#endif // __GRID_SAMPLER_TEST_H__
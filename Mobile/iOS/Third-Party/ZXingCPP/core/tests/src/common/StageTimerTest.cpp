@@ -0,0 +1,68 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  StageTimerTest.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StageTimerTest.h"
+#include <string>
+#include <unistd.h>
+
+namespace zxing {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StageTimerTest);
+
+void StageTimerTest::testNestedStages() {
+  StageTimer::reset();
+  {
+    StageTimer detect(StageTimer::DETECT);
+    usleep(2000);
+    {
+      StageTimer sample(StageTimer::SAMPLE);
+      usleep(20000);
+    }
+  }
+  long long totals[StageTimer::STAGE_COUNT];
+  StageTimer::getTotals(totals);
+  CPPUNIT_ASSERT_EQUAL(0LL, totals[StageTimer::PARSE]);
+  if (!StageTimer::isEnabled()) {
+    CPPUNIT_ASSERT_EQUAL(0LL, totals[StageTimer::DETECT]);
+    CPPUNIT_ASSERT_EQUAL(0LL, totals[StageTimer::SAMPLE]);
+    return;
+  }
+  // Sampling is not charged to the detector it ran inside.
+  CPPUNIT_ASSERT(totals[StageTimer::SAMPLE] >= 20000);
+  CPPUNIT_ASSERT(totals[StageTimer::DETECT] >= 2000);
+  CPPUNIT_ASSERT(totals[StageTimer::DETECT] < totals[StageTimer::SAMPLE]);
+}
+
+void StageTimerTest::testReset() {
+  {
+    StageTimer parse(StageTimer::PARSE);
+    usleep(1000);
+  }
+  StageTimer::reset();
+  long long totals[StageTimer::STAGE_COUNT];
+  StageTimer::getTotals(totals);
+  for (int i = 0; i < StageTimer::STAGE_COUNT; i++) {
+    CPPUNIT_ASSERT_EQUAL(0LL, totals[i]);
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("reed_solomon"),
+                       std::string(StageTimer::getName(StageTimer::REED_SOLOMON)));
+}
+
+}
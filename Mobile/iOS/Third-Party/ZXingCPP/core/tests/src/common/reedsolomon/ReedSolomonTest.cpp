@@ -55,9 +55,12 @@ void ReedSolomonTest::setUp() {
     (qrCodeTestWithEc_->size() - qrCodeTest_->size()) / 2;
 
   qrRSDecoder_ = new ReedSolomonDecoder(GenericGF::QR_CODE_FIELD_256);
+  qrRSDecoderBM_ = new ReedSolomonDecoder(GenericGF::QR_CODE_FIELD_256, ReedSolomonDecoder::BERLEKAMP_MASSEY);
 }
 
 void ReedSolomonTest::tearDown() {
+  delete qrRSDecoder_;
+  delete qrRSDecoderBM_;
 }
 
 void ReedSolomonTest::testNoError() {
@@ -102,16 +105,72 @@ void ReedSolomonTest::testTooManyErrors() {
   }
 }
 
+void ReedSolomonTest::testBerlekampMassey() {
+  ArrayRef<int> received(new Array<int>(qrCodeTestWithEc_->size()));
+  srandom(0xDEADBEEFL);
+  for (unsigned i = 0; i < qrCodeTest_->size(); i++) {
+    *received = *qrCodeTestWithEc_;
+    corrupt(received, qrCodeCorrectable_);
+    checkQRRSDecode(qrRSDecoderBM_, received);
+  }
+  *received = *qrCodeTestWithEc_;
+  try {
+    corrupt(received, qrCodeCorrectable_ + 1);
+    checkQRRSDecode(qrRSDecoderBM_, received);
+    CPPUNIT_FAIL("should not happen!");
+  } catch (ReedSolomonException const& e) {
+    // expected
+  }
+}
+
+void ReedSolomonTest::testOtherFields() {
+  // Lengths that leave a partial group of syndromes as well as full ones.
+  checkZeroCodeword(GenericGF::DATA_MATRIX_FIELD_256, 30, 12);
+  checkZeroCodeword(GenericGF::DATA_MATRIX_FIELD_256, 200, 68);
+  checkZeroCodeword(GenericGF::AZTEC_PARAM, 7, 5);
+  checkZeroCodeword(GenericGF::AZTEC_DATA_6, 40, 18);
+  checkZeroCodeword(GenericGF::AZTEC_DATA_10, 300, 60);
+  checkZeroCodeword(GenericGF::AZTEC_DATA_12, 1000, 200);
+}
 
 void ReedSolomonTest::checkQRRSDecode(ArrayRef<int> &received) {
+  checkQRRSDecode(qrRSDecoder_, received);
+}
+
+void ReedSolomonTest::checkQRRSDecode(ReedSolomonDecoder *decoder, ArrayRef<int> &received) {
   int twoS = 2 * qrCodeCorrectable_;
-  qrRSDecoder_->decode(received, twoS);
+  decoder->decode(received, twoS);
   for (unsigned i = 0; i < qrCodeTest_->size(); i++) {
     CPPUNIT_ASSERT_EQUAL(qrCodeTest_[i], received[i]);
   }
 }
 
+// All zeros is a codeword of any Reed-Solomon code, whatever its field and
+// generator, so it can be corrupted and checked without an encoder.
+void ReedSolomonTest::checkZeroCodeword(Ref<GenericGF> field, int length, int twoS) {
+  ReedSolomonDecoder euclidean(field);
+  ReedSolomonDecoder berlekampMassey(field, ReedSolomonDecoder::BERLEKAMP_MASSEY);
+  ArrayRef<int> received(new Array<int>(length));
+  srandom(0xDEADBEEFL);
+  for (int errors = 1; errors <= twoS / 2; errors++) {
+    for (int pass = 0; pass < 2; pass++) {
+      for (int i = 0; i < length; i++) {
+        received[i] = 0;
+      }
+      corrupt(received, errors, field->getSize());
+      (pass == 0 ? euclidean : berlekampMassey).decode(received, twoS);
+      for (int i = 0; i < length; i++) {
+        CPPUNIT_ASSERT_EQUAL(0, received[i]);
+      }
+    }
+  }
+}
+
 void ReedSolomonTest::corrupt(ArrayRef<int> &received, int howMany) {
+  corrupt(received, howMany, 256);
+}
+
+void ReedSolomonTest::corrupt(ArrayRef<int> &received, int howMany, int fieldSize) {
   vector<bool> corrupted(received->size());
   for (int j = 0; j < howMany; j++) {
     int location = floor(received->size() * ((double)(random() >> 1) / (double)((RAND_MAX >> 1) + 1)));
@@ -119,7 +178,7 @@ void ReedSolomonTest::corrupt(ArrayRef<int> &received, int howMany) {
       j--;
     } else {
       corrupted[location] = true;
-      int newByte = random() % 256;
+      int newByte = random() % fieldSize;
       received[location] = newByte;
     }
   }
@@ -30,6 +30,7 @@
 
 namespace zxing {
 class ReedSolomonDecoder;
+class GenericGF;
 
 class ReedSolomonTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(ReedSolomonTest);
@@ -37,6 +38,8 @@ class ReedSolomonTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testOneError);
   CPPUNIT_TEST(testMaxErrors);
   CPPUNIT_TEST(testTooManyErrors);
+  CPPUNIT_TEST(testBerlekampMassey);
+  CPPUNIT_TEST(testOtherFields);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -48,14 +51,20 @@ protected:
   void testOneError();
   void testMaxErrors();
   void testTooManyErrors();
+  void testBerlekampMassey();
+  void testOtherFields();
 
 private:
   ArrayRef<int> qrCodeTest_;
   ArrayRef<int> qrCodeTestWithEc_;
   int qrCodeCorrectable_;
   ReedSolomonDecoder *qrRSDecoder_;
+  ReedSolomonDecoder *qrRSDecoderBM_;
   void checkQRRSDecode(ArrayRef<int> &received);
+  void checkQRRSDecode(ReedSolomonDecoder *decoder, ArrayRef<int> &received);
+  void checkZeroCodeword(Ref<GenericGF> field, int length, int twoS);
   static void corrupt(ArrayRef<int> &received, int howMany);
+  static void corrupt(ArrayRef<int> &received, int howMany, int fieldSize);
 };
 }
 
@@ -0,0 +1,95 @@
+/*
+ *  TiledMultipleBarcodeReaderTest.cpp
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TiledMultipleBarcodeReaderTest.h"
+#include <zxing/multi/TiledMultipleBarcodeReader.h>
+#include <cstdlib>
+
+namespace zxing {
+namespace multi {
+using namespace std;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TiledMultipleBarcodeReaderTest);
+
+typedef TiledMultipleBarcodeReader::Region Region;
+
+void TiledMultipleBarcodeReaderTest::drawBullseye(Ref<BitMatrix> image, int x, int y) {
+  int half = moduleSize / 2;
+  for (int j = -4 * moduleSize - half; j <= 4 * moduleSize + half; j++) {
+    for (int i = -4 * moduleSize - half; i <= 4 * moduleSize + half; i++) {
+      int ring = (max(abs(i), abs(j)) + half) / moduleSize;
+      if (ring % 2 == 0 && x + i >= 0 && x + i < image->getWidth() &&
+          y + j >= 0 && y + j < image->getHeight()) {
+        image->set(x + i, y + j);
+      }
+    }
+  }
+}
+
+void TiledMultipleBarcodeReaderTest::drawLine(Ref<BitMatrix> image, int x, int y, int dx, int dy) {
+  while (x >= 0 && x < image->getWidth() && y >= 0 && y < image->getHeight()) {
+    image->set(x, y);
+    x += dx;
+    y += dy;
+  }
+}
+
+void TiledMultipleBarcodeReaderTest::testFindsBullseye() {
+  Ref<BitMatrix> image(new BitMatrix(64, 64));
+  drawBullseye(image, 32, 32);
+  vector<Region> regions = TiledMultipleBarcodeReader::findBullseyes(image, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, regions.size());
+  CPPUNIT_ASSERT(regions[0].left < 32 && regions[0].left + regions[0].width > 32);
+  CPPUNIT_ASSERT(regions[0].top < 32 && regions[0].top + regions[0].height > 32);
+}
+
+void TiledMultipleBarcodeReaderTest::testBullseyeAtEdge() {
+  // The outer ring is cut off by the right and bottom edges, which still
+  // leaves it wider than half a module.
+  Ref<BitMatrix> image(new BitMatrix(64, 64));
+  drawBullseye(image, 64 - 4 * moduleSize - 1, 64 - 4 * moduleSize - 1);
+  vector<Region> regions = TiledMultipleBarcodeReader::findBullseyes(image, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, regions.size());
+  CPPUNIT_ASSERT_EQUAL(64, regions[0].left + regions[0].width);
+  CPPUNIT_ASSERT_EQUAL(64, regions[0].top + regions[0].height);
+}
+
+// A line from the centre of a bullseye to the image edge along the
+// anti-diagonal passes the row, column and diagonal checks. The
+// anti-diagonal centre run then reaches the edge, where it must stop:
+// BitMatrix::get() would read the neighbouring row's bits.
+
+void TiledMultipleBarcodeReaderTest::testAntiDiagonalToRightEdge() {
+  Ref<BitMatrix> image(new BitMatrix(64, 64));
+  drawBullseye(image, 48, 24);
+  drawLine(image, 48, 24, 1, -1);
+  vector<Region> regions = TiledMultipleBarcodeReader::findBullseyes(image, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, regions.size());
+}
+
+void TiledMultipleBarcodeReaderTest::testAntiDiagonalToLeftEdge() {
+  Ref<BitMatrix> image(new BitMatrix(64, 64));
+  drawBullseye(image, 16, 40);
+  drawLine(image, 16, 40, -1, 1);
+  vector<Region> regions = TiledMultipleBarcodeReader::findBullseyes(image, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, regions.size());
+}
+
+}
+}
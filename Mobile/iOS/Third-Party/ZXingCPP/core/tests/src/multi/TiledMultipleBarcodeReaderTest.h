@@ -0,0 +1,55 @@
+#ifndef __TILED_MULTIPLE_BARCODE_READER_TEST_H__
+#define __TILED_MULTIPLE_BARCODE_READER_TEST_H__
+
+/*
+ *  TiledMultipleBarcodeReaderTest.h
+ *  zxing
+ *
+ *  Copyright 2010 ZXing authors All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <zxing/common/BitMatrix.h>
+
+namespace zxing {
+namespace multi {
+class TiledMultipleBarcodeReaderTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(TiledMultipleBarcodeReaderTest);
+  CPPUNIT_TEST(testFindsBullseye);
+  CPPUNIT_TEST(testBullseyeAtEdge);
+  CPPUNIT_TEST(testAntiDiagonalToRightEdge);
+  CPPUNIT_TEST(testAntiDiagonalToLeftEdge);
+  CPPUNIT_TEST_SUITE_END();
+
+protected:
+  void testFindsBullseye();
+  void testBullseyeAtEdge();
+  void testAntiDiagonalToRightEdge();
+  void testAntiDiagonalToLeftEdge();
+
+private:
+  static const int moduleSize = 3;
+
+  // Draws a bullseye (a black centre module inside two black rings) centred
+  // on (x, y).
+  static void drawBullseye(Ref<BitMatrix> image, int x, int y);
+  // Draws black pixels from (x, y) stepping by (dx, dy) to the image edge.
+  static void drawLine(Ref<BitMatrix> image, int x, int y, int dx, int dy);
+};
+}
+}
+
+#endif // __TILED_MULTIPLE_BARCODE_READER_TEST_H__
@@ -0,0 +1,58 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  Copyright 2010-2011 ZXing authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+// Kept in its own file so the compiler never inlines these into code that
+// also sees the standard library's allocation functions.
+
+static unsigned long allocations = 0;
+
+#if __cplusplus >= 201103L
+#define THROWS_BAD_ALLOC
+#else
+#define THROWS_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+void* operator new(size_t size) THROWS_BAD_ALLOC {
+  __sync_add_and_fetch(&allocations, 1);
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == 0) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) throw() {
+  free(p);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t) throw() {
+  free(p);
+}
+#endif
+
+namespace zxing {
+
+unsigned long allocationCount() {
+  return __sync_add_and_fetch(&allocations, 0);
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef __ALLOCATION_COUNTER_H_
+#define __ALLOCATION_COUNTER_H_
+/*
+ *  Copyright 2010-2011 ZXing authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace zxing {
+
+// Number of times operator new has been called in this process. Linking
+// AllocationCounter.cpp replaces the global operator new to count them.
+unsigned long allocationCount();
+
+}
+
+#endif /* __ALLOCATION_COUNTER_H_ */
@@ -0,0 +1,410 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  Copyright 2010-2011 ZXing authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Decodes a corpus of images repeatedly and reports how long each stage of
+ * decoding took, for catching performance regressions. Images are grouped
+ * into categories by the directory they are in, as blackboxtest.sh does,
+ * and each category is reported as one line of JSON on stdout, followed by
+ * a line for the whole run:
+ *
+ *   {"category": "qrcode-2", "binarizer": "reused", "images": 31,
+ *    "decodes": 310, "passed": 29, "images_per_sec": 212.4, "allocations_per_decode": 153.2,
+ *    "total_ms": {"mean": 4.71, "p50": 3.9, "p90": 8.2, "p99": 12.0, "max": 12.6},
+ *    "stages_ms": {"luminance": {...}, "binarize": {...}, "detect": {...},
+ *                  "sample": {...}, "reed_solomon": {...}, "parse": {...},
+ *                  "other": {...}},
+ *    "formats": {"QR_CODE": {"decodes": 290, "images_per_sec": 221.0}, ...}}
+ *
+ * Luminance and binarize are timed here. The later stages come from the
+ * library's StageTimers, which are only compiled in with STAGE_TIMING=1
+ * (ZXING_STAGE_TIMING); without it they are reported as "other". 1D
+ * readers find and read their bars in one pass, so they only report detect.
+ * "passed" counts images whose first decode matched their .txt file.
+ *
+ * Each category is measured twice, with "binarizer" telling the runs apart.
+ * A "fresh" decode constructs its binarizer, as a one-off decode would. A
+ * "reused" decode gets it from createBinarizer() on one binarizer kept per
+ * image size, as a camera loop would, so HybridBinarizer's working memory
+ * carries over between decodes. The two runs take turns on each image.
+ * --binarizer=fresh or --binarizer=reused measures only one of them.
+ *
+ * Usage: zxingbench [--iterations=<n>] [--try-harder] [--global]
+ *                   [--binarizer=fresh|reused|both] <image> ...
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <Magick++.h>
+#include "MagickBitmapSource.h"
+#include "AllocationCounter.h"
+#include <zxing/BinaryBitmap.h>
+#include <zxing/DecodeHints.h>
+#include <zxing/Exception.h>
+#include <zxing/MultiFormatReader.h>
+#include <zxing/Result.h>
+#include <zxing/common/GlobalHistogramBinarizer.h>
+#include <zxing/common/GreyscaleLuminanceSource.h>
+#include <zxing/common/HybridBinarizer.h>
+#include <zxing/common/StageTimer.h>
+
+using namespace std;
+using namespace zxing;
+
+namespace {
+
+enum Stage {
+  LUMINANCE,
+  BINARIZE,
+  DETECT,
+  SAMPLE,
+  REED_SOLOMON,
+  PARSE,
+  OTHER,
+  STAGE_COUNT
+};
+
+const char* const STAGE_NAMES[STAGE_COUNT] = {
+  "luminance", "binarize", "detect", "sample", "reed_solomon", "parse", "other"
+};
+
+const int MAX_EXPECTED = 4096;
+
+enum BinarizerMode {
+  FRESH,
+  REUSED,
+  MODE_COUNT
+};
+
+const char* const MODE_NAMES[MODE_COUNT] = {
+  "fresh", "reused"
+};
+
+struct FormatStats {
+  int decodes;
+  double millis;
+
+  FormatStats() : decodes(0), millis(0) {
+  }
+};
+
+// Everything measured for one category of images.
+struct Stats {
+  int images;
+  int passed;
+  double allocations;
+  vector<double> total;
+  vector<double> stages[STAGE_COUNT];
+  map<string, FormatStats> formats;
+
+  Stats() : images(0), passed(0), allocations(0) {
+  }
+
+  void add(const Stats& other) {
+    images += other.images;
+    passed += other.passed;
+    allocations += other.allocations;
+    total.insert(total.end(), other.total.begin(), other.total.end());
+    for (int i = 0; i < STAGE_COUNT; i++) {
+      stages[i].insert(stages[i].end(), other.stages[i].begin(), other.stages[i].end());
+    }
+    for (map<string, FormatStats>::const_iterator it = other.formats.begin(); it != other.formats.end(); ++it) {
+      formats[it->first].decodes += it->second.decodes;
+      formats[it->first].millis += it->second.millis;
+    }
+  }
+};
+
+double nowMillis() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+string category(const string& filename) {
+  size_t slash = filename.rfind('/');
+  if (slash == string::npos) {
+    return ".";
+  }
+  size_t parent = filename.rfind('/', slash - 1);
+  return filename.substr(parent == string::npos ? 0 : parent + 1,
+                         slash - (parent == string::npos ? 0 : parent + 1));
+}
+
+string expectedText(const string& filename) {
+  string textfilename = filename;
+  size_t dotpos = textfilename.rfind(".");
+  if (dotpos == string::npos) {
+    return "";
+  }
+  textfilename.replace(dotpos + 1, string::npos, "txt");
+  FILE* fp = fopen(textfilename.c_str(), "rb");
+  if (!fp) {
+    return "";
+  }
+  char data[MAX_EXPECTED];
+  size_t nread = fread(data, 1, MAX_EXPECTED, fp);
+  fclose(fp);
+  return string(data, nread);
+}
+
+string quote(const string& s) {
+  string quoted("\"");
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '"' || s[i] == '\\') {
+      quoted += '\\';
+    }
+    quoted += s[i];
+  }
+  return quoted + "\"";
+}
+
+// Nearest-rank percentile of sorted values.
+double percentile(const vector<double>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+  return sorted[rank == 0 ? 0 : min(rank, sorted.size()) - 1];
+}
+
+void printSummary(vector<double> values) {
+  sort(values.begin(), values.end());
+  double sum = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    sum += values[i];
+  }
+  printf("{\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+         values.empty() ? 0 : sum / values.size(), percentile(values, 50),
+         percentile(values, 90), percentile(values, 99), values.empty() ? 0 : values.back());
+}
+
+void printStats(const string& name, BinarizerMode mode, const Stats& stats) {
+  double totalMillis = 0;
+  for (size_t i = 0; i < stats.total.size(); i++) {
+    totalMillis += stats.total[i];
+  }
+  size_t decodes = stats.total.size();
+  printf("{\"category\": %s, \"binarizer\": %s, \"images\": %d, \"decodes\": %lu, "
+         "\"passed\": %d, \"stage_timing\": %s, \"images_per_sec\": %.2f, "
+         "\"allocations_per_decode\": %.1f, ",
+         quote(name).c_str(), quote(MODE_NAMES[mode]).c_str(), stats.images, (unsigned long)decodes, stats.passed,
+         StageTimer::isEnabled() ? "true" : "false",
+         totalMillis > 0 ? decodes * 1000.0 / totalMillis : 0,
+         decodes > 0 ? stats.allocations / decodes : 0);
+  printf("\"total_ms\": ");
+  printSummary(stats.total);
+  printf(", \"stages_ms\": {");
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    printf("%s%s: ", i > 0 ? ", " : "", quote(STAGE_NAMES[i]).c_str());
+    printSummary(stats.stages[i]);
+  }
+  printf("}, \"formats\": {");
+  for (map<string, FormatStats>::const_iterator it = stats.formats.begin(); it != stats.formats.end(); ++it) {
+    printf("%s%s: {\"decodes\": %d, \"images_per_sec\": %.2f}",
+           it == stats.formats.begin() ? "" : ", ", quote(it->first).c_str(), it->second.decodes,
+           it->second.millis > 0 ? it->second.decodes * 1000.0 / it->second.millis : 0);
+  }
+  printf("}}\n");
+  fflush(stdout);
+}
+
+void printCategory(const string& name, map<string, Stats> categories[MODE_COUNT],
+                   const bool measure[MODE_COUNT]) {
+  for (int mode = 0; mode < MODE_COUNT; mode++) {
+    if (measure[mode]) {
+      printStats(name, (BinarizerMode)mode, categories[mode][name]);
+    }
+  }
+}
+
+// Decodes image once, adding its timings to stats. A null prototype means a
+// freshly constructed binarizer; otherwise the prototype makes one that
+// shares its working memory. Returns the decoded text, or an empty string
+// if nothing was found.
+string decodeOnce(Magick::Image& image, bool hybrid, Ref<Binarizer> prototype,
+                  DecodeHints const& hints, Stats& stats) {
+  double times[STAGE_COUNT];
+  long long before[StageTimer::STAGE_COUNT];
+  long long after[StageTimer::STAGE_COUNT];
+  unsigned long allocationsBefore = allocationCount();
+  string text;
+  string format("none");
+
+  StageTimer::getTotals(before);
+  double start = nowMillis();
+  Ref<MagickBitmapSource> magick(new MagickBitmapSource(image));
+  int width = magick->getWidth();
+  int height = magick->getHeight();
+  unsigned char* luminance = magick->getMatrix();
+  double luminanceDone = nowMillis();
+  double binarizeDone = 0;
+  try {
+    Ref<LuminanceSource> source(new GreyscaleLuminanceSource(luminance, width, height, 0, 0, width, height));
+    Ref<Binarizer> binarizer;
+    if (!prototype.empty()) {
+      binarizer = prototype->createBinarizer(source);
+    } else if (hybrid) {
+      binarizer = new HybridBinarizer(source);
+    } else {
+      binarizer = new GlobalHistogramBinarizer(source);
+    }
+    Ref<BinaryBitmap> binary(new BinaryBitmap(binarizer));
+    // The bitmap keeps the matrix, so the reader does not binarize again.
+    binary->getBlackMatrix();
+    binarizeDone = nowMillis();
+
+    MultiFormatReader reader;
+    Ref<Result> result(reader.decode(binary, hints));
+    text = result->getText()->getText();
+    format = barcodeFormatNames[result->getBarcodeFormat()];
+  } catch (zxing::Exception&) {
+    // Nothing found; the time is still counted.
+  }
+  double end = nowMillis();
+  double total = end - start;
+  StageTimer::getTotals(after);
+  delete[] luminance;
+
+  times[LUMINANCE] = luminanceDone - start;
+  times[BINARIZE] = (binarizeDone != 0 ? binarizeDone : end) - luminanceDone;
+  times[DETECT] = (after[StageTimer::DETECT] - before[StageTimer::DETECT]) / 1000.0;
+  times[SAMPLE] = (after[StageTimer::SAMPLE] - before[StageTimer::SAMPLE]) / 1000.0;
+  times[REED_SOLOMON] = (after[StageTimer::REED_SOLOMON] - before[StageTimer::REED_SOLOMON]) / 1000.0;
+  times[PARSE] = (after[StageTimer::PARSE] - before[StageTimer::PARSE]) / 1000.0;
+  times[OTHER] = total;
+  for (int i = 0; i < OTHER; i++) {
+    times[OTHER] -= times[i];
+  }
+  times[OTHER] = max(0.0, times[OTHER]);
+
+  stats.total.push_back(total);
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    stats.stages[i].push_back(times[i]);
+  }
+  stats.allocations += allocationCount() - allocationsBefore;
+  stats.formats[format].decodes++;
+  stats.formats[format].millis += total;
+  return text;
+}
+
+}
+
+int main(int argc, char** argv) {
+  int iterations = 10;
+  bool tryHarder = false;
+  bool hybrid = true;
+  bool measure[MODE_COUNT] = {true, true};
+  vector<string> files;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 13, "--iterations=") == 0) {
+      iterations = max(1, atoi(arg.c_str() + 13));
+    } else if (arg == "--try-harder") {
+      tryHarder = true;
+    } else if (arg == "--global") {
+      hybrid = false;
+    } else if (arg == "--binarizer=fresh" || arg == "--binarizer=reused" || arg == "--binarizer=both") {
+      measure[FRESH] = arg != "--binarizer=reused";
+      measure[REUSED] = arg != "--binarizer=fresh";
+    } else if (arg.compare(0, 2, "--") == 0) {
+      fprintf(stderr, "Unknown option %s\n", arg.c_str());
+      return 1;
+    } else if (arg.size() < 3 || arg.compare(arg.size() - 3, 3, "txt") != 0) {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty()) {
+    fprintf(stderr, "Usage: %s [--iterations=<n>] [--try-harder] [--global]\n"
+            "       [--binarizer=fresh|reused|both] <image> ...\n", argv[0]);
+    return 1;
+  }
+
+  DecodeHints hints(DecodeHints::DEFAULT_HINT);
+  hints.setTryHarder(tryHarder);
+
+  vector<string> order;
+  map<string, Stats> categories[MODE_COUNT];
+  // One binarizer per image size, so reused decodes keep their buffers.
+  map<pair<int, int>, Ref<Binarizer> > prototypes;
+  for (size_t i = 0; i < files.size(); i++) {
+    Magick::Image image;
+    try {
+      image.read(files[i]);
+    } catch (...) {
+      fprintf(stderr, "Unable to open %s, ignoring\n", files[i].c_str());
+      continue;
+    }
+    string name = category(files[i]);
+    if (find(order.begin(), order.end(), name) == order.end()) {
+      if (!order.empty()) {
+        printCategory(order.back(), categories, measure);
+      }
+      order.push_back(name);
+    }
+    pair<int, int> size((int)image.columns(), (int)image.rows());
+    Ref<Binarizer>& prototype = prototypes[size];
+    if (prototype.empty()) {
+      // Never binarized itself; it only hands out binarizers.
+      Ref<LuminanceSource> empty(new GreyscaleLuminanceSource(NULL, 0, 0, 0, 0, 0, 0));
+      if (hybrid) {
+        prototype = new HybridBinarizer(empty);
+      } else {
+        prototype = new GlobalHistogramBinarizer(empty);
+      }
+    }
+    string expected = expectedText(files[i]);
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+      if (measure[mode]) {
+        categories[mode][name].images++;
+      }
+    }
+    for (int k = 0; k < iterations; k++) {
+      for (int mode = 0; mode < MODE_COUNT; mode++) {
+        if (!measure[mode]) {
+          continue;
+        }
+        Stats& stats = categories[mode][name];
+        string text = decodeOnce(image, hybrid, mode == REUSED ? prototype : Ref<Binarizer>(),
+                                 hints, stats);
+        if (k == 0 && !text.empty() && text == expected) {
+          stats.passed++;
+        }
+      }
+    }
+  }
+  if (order.empty()) {
+    return 1;
+  }
+  printCategory(order.back(), categories, measure);
+
+  map<string, Stats> all[MODE_COUNT];
+  for (int mode = 0; mode < MODE_COUNT; mode++) {
+    for (size_t i = 0; i < order.size(); i++) {
+      all[mode]["all"].add(categories[mode][order[i]]);
+    }
+  }
+  printCategory("all", all, measure);
+  return 0;
+}
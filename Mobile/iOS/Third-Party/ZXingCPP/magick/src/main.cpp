@@ -18,6 +18,8 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdlib>
+#include <sys/time.h>
 #include <Magick++.h>
 #include "MagickBitmapSource.h"
 #include <zxing/common/Counted.h>
@@ -38,6 +40,7 @@
 #include <zxing/multi/ByQuadrantReader.h>
 #include <zxing/multi/MultipleBarcodeReader.h>
 #include <zxing/multi/GenericMultipleBarcodeReader.h>
+#include <zxing/multi/TiledMultipleBarcodeReader.h>
 
 //#include <zxing/qrcode/detector/Detector.h>
 //#include <zxing/qrcode/detector/QREdgeDetector.h>
@@ -54,6 +57,11 @@ static bool show_format = false;
 static bool tryHarder = false;
 static bool show_filename = false;
 static bool search_multi = false;
+static int workers = 1;
+
+// Totals over every decodeMultiple() call, for the codes/sec report.
+static int multi_codes = 0;
+static double multi_millis = 0;
 
 static const int MAX_EXPECTED = 4096;
 
@@ -62,14 +70,29 @@ Ref<Result> decode(Ref<BinaryBitmap> image, DecodeHints hints) {
   return reader->decode(image, hints);
 }
 
-vector<Ref<Result> > decodeMultiple(Ref<BinaryBitmap> image, DecodeHints hints){
-  MultiFormatReader delegate;
-//   MultiFormatReader mformat;
-//   ByQuadrantReader delegate(mformat);
+static double now_millis() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
 
-  GenericMultipleBarcodeReader reader(delegate);
+vector<Ref<Result> > decodeMultiple(Ref<BinaryBitmap> image, DecodeHints hints){
+  // Static so its worker threads are kept from one image to the next.
+  static TiledMultipleBarcodeReader reader;
+//   MultiFormatReader delegate;
+//   GenericMultipleBarcodeReader reader(delegate);
 //   QRCodeMultiReader reader;
-  return reader.decodeMultiple(image,hints);
+  hints.setMaxWorkers(workers);
+  double start = now_millis();
+  try {
+    vector<Ref<Result> > results = reader.decodeMultiple(image, hints);
+    multi_millis += now_millis() - start;
+    multi_codes += results.size();
+    return results;
+  } catch (...) {
+    multi_millis += now_millis() - start;
+    throw;
+  }
 }
 
 
@@ -236,7 +259,7 @@ string get_expected(string imagefilename) {
 
 int main(int argc, char** argv) {
   if (argc <= 1) {
-    cout << "Usage: " << argv[0] << " [--dump-raw] [--show-format] [--try-harder] [--search_multi] [--show-filename] <filename1> [<filename2> ...]" << endl;
+    cout << "Usage: " << argv[0] << " [--dump-raw] [--show-format] [--try-harder] [--search_multi] [--workers=<n>] [--show-filename] <filename1> [<filename2> ...]" << endl;
     return 1;
   }
 
@@ -273,6 +296,10 @@ int main(int argc, char** argv) {
       search_multi = true;
       continue;
     }
+    if (infilename.compare(0, 10, "--workers=") == 0){
+      workers = atoi(infilename.c_str() + 10);
+      continue;
+    }
     if (!raw_dump)
       cerr << "Processing: " << infilename << endl;
     if (show_filename)
@@ -322,6 +349,10 @@ int main(int argc, char** argv) {
     << " passed only hybrid, " << gonly << " passed only global, of " << total
     << " total." << endl;
 
+  if (search_multi && multi_millis > 0)
+    cout << multi_codes << " codes in " << multi_millis << " ms, "
+    << (multi_codes * 1000.0 / multi_millis) << " codes/sec." << endl;
+
   return 0;
 }
 